@@ -0,0 +1,499 @@
+#include "async_rpc_client.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include <boost/url.hpp>
+namespace urls = boost::urls;
+
+#include <plog/Log.h>
+#include <tinyformat.h>
+
+static std::string EncodeBase64(std::string_view str)
+{
+    static char const* SZ_CHARS = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string res;
+    res.reserve((str.size() + 2) / 3 * 4);
+    std::size_t i { 0 };
+    for (; i + 2 < str.size(); i += 3) {
+        uint32_t n = (static_cast<uint8_t>(str[i]) << 16) | (static_cast<uint8_t>(str[i + 1]) << 8) | static_cast<uint8_t>(str[i + 2]);
+        res.push_back(SZ_CHARS[(n >> 18) & 0x3f]);
+        res.push_back(SZ_CHARS[(n >> 12) & 0x3f]);
+        res.push_back(SZ_CHARS[(n >> 6) & 0x3f]);
+        res.push_back(SZ_CHARS[n & 0x3f]);
+    }
+    if (i + 1 == str.size()) {
+        uint32_t n = static_cast<uint8_t>(str[i]) << 16;
+        res.push_back(SZ_CHARS[(n >> 18) & 0x3f]);
+        res.push_back(SZ_CHARS[(n >> 12) & 0x3f]);
+        res.append("==");
+    } else if (i + 2 == str.size()) {
+        uint32_t n = (static_cast<uint8_t>(str[i]) << 16) | (static_cast<uint8_t>(str[i + 1]) << 8);
+        res.push_back(SZ_CHARS[(n >> 18) & 0x3f]);
+        res.push_back(SZ_CHARS[(n >> 12) & 0x3f]);
+        res.push_back(SZ_CHARS[(n >> 6) & 0x3f]);
+        res.push_back('=');
+    }
+    return res;
+}
+
+static std::string MakeBasicAuth(std::string_view user, std::string_view passwd)
+{
+    return "Basic " + EncodeBase64(std::string(user) + ":" + std::string(passwd));
+}
+
+static std::string MakeClientLabel(std::string_view url, std::string_view name)
+{
+    return MakeMetricLabel("node", url) + "," + MakeMetricLabel("client", name);
+}
+
+AsyncRPCClient::AsyncRPCClient(asio::io_context& ioc, std::string_view url, Options opts)
+    : strand_(asio::make_strand(ioc))
+    , resolver_(strand_)
+    , opts_(std::move(opts))
+    , url_(url)
+    , num_net_errors_(MetricsRegistry::GetInstance().GetCounter("timelord_rpc_net_errors_total", "The number of the RPC calls failed to reach the service", MakeClientLabel(url, opts_.name)))
+    , num_rejected_(MetricsRegistry::GetInstance().GetCounter("timelord_rpc_rejected_total", "The number of the RPC requests rejected by the circuit breaker", MakeClientLabel(url, opts_.name)))
+    , num_batches_(MetricsRegistry::GetInstance().GetCounter("timelord_rpc_batches_total", "The number of the batch requests sent to RPC service"))
+    , breaker_open_gauge_(MetricsRegistry::GetInstance().GetGauge("timelord_rpc_breaker_open", "1 when the circuit breaker of the RPC client is open", MakeClientLabel(url, opts_.name)))
+{
+    auto uri = urls::parse_uri(url);
+    if (!uri.has_value()) {
+        throw std::runtime_error(tinyformat::format("invalid RPC url: %s", url));
+    }
+    if (uri->scheme() != "http") {
+        throw std::runtime_error(tinyformat::format("only http is supported by the RPC client, url: %s", url));
+    }
+    host_ = uri->host();
+    port_ = std::to_string(uri->has_port() ? uri->port_number() : 80);
+    target_ = std::string(uri->encoded_path());
+    if (target_.empty()) {
+        target_ = "/";
+    }
+}
+
+AsyncRPCClient::AsyncRPCClient(asio::io_context& ioc, std::string_view url, std::string user, std::string passwd, Options opts)
+    : AsyncRPCClient(ioc, url, std::move(opts))
+{
+    auth_ = MakeBasicAuth(user, passwd);
+}
+
+AsyncRPCClient::AsyncRPCClient(asio::io_context& ioc, std::string_view url, std::string cookie_path, Options opts)
+    : AsyncRPCClient(ioc, url, std::move(opts))
+{
+    cookie_path_ = std::move(cookie_path);
+    try {
+        LoadCookie();
+    } catch (std::exception const& e) {
+        // the node might not be started yet, the cookie is read again before the next call
+        PLOGW << tinyformat::format("%s: %s", __func__, e.what());
+    }
+}
+
+void AsyncRPCClient::SetCacheTTL(std::string method, std::chrono::milliseconds ttl)
+{
+    asio::dispatch(strand_, [this, method = std::move(method), ttl]() {
+        GetMethodStats(method).cache_ttl = ttl;
+    });
+}
+
+void AsyncRPCClient::SetUnbatched(std::string method)
+{
+    asio::dispatch(strand_, [this, method = std::move(method)]() {
+        GetMethodStats(method).unbatched = true;
+    });
+}
+
+void AsyncRPCClient::SetChainHeight(int height)
+{
+    asio::dispatch(strand_, [this, height]() {
+        if (height != height_) {
+            height_ = height;
+            cache_.clear();
+        }
+    });
+}
+
+void AsyncRPCClient::AsyncCall(std::string method, UniValue params, Handler handler)
+{
+    asio::dispatch(strand_, [this, method = std::move(method), params = std::move(params), handler = std::move(handler)]() mutable {
+        StartCall(std::move(method), std::move(params), std::move(handler));
+    });
+}
+
+void AsyncRPCClient::Prefetch(std::vector<Request> reqs)
+{
+    // the calls are started in one turn, so they are sent in one batch
+    asio::dispatch(strand_, [this, reqs = std::move(reqs)]() mutable {
+        for (auto& req : reqs) {
+            StartCall(std::move(req.method), std::move(req.params), {});
+        }
+    });
+}
+
+AsyncRPCClient::MethodStats& AsyncRPCClient::GetMethodStats(std::string const& method)
+{
+    auto it = method_stats_.find(method);
+    if (it != std::end(method_stats_)) {
+        return it->second;
+    }
+    MethodStats stats;
+    auto& registry = MetricsRegistry::GetInstance();
+    char const* SZ_HELP = "The number of the RPC calls by how they are served";
+    stats.pnum_hits = &registry.GetCounter("timelord_rpc_cache_requests_total", SZ_HELP, MakeMetricLabel("method", method) + "," + MakeMetricLabel("result", "hit"));
+    stats.pnum_misses = &registry.GetCounter("timelord_rpc_cache_requests_total", SZ_HELP, MakeMetricLabel("method", method) + "," + MakeMetricLabel("result", "miss"));
+    stats.pnum_coalesced = &registry.GetCounter("timelord_rpc_cache_requests_total", SZ_HELP, MakeMetricLabel("method", method) + "," + MakeMetricLabel("result", "coalesced"));
+    return method_stats_.emplace(method, stats).first->second;
+}
+
+void AsyncRPCClient::StartCall(std::string method, UniValue params, Handler handler)
+{
+    auto& stats = GetMethodStats(method);
+    std::string key = method + params.write();
+    // served from the cache
+    if (stats.cache_ttl.count() > 0) {
+        auto it = cache_.find(key);
+        if (it != std::end(cache_)) {
+            if (it->second.height == height_ && std::chrono::steady_clock::now() < it->second.expires_at) {
+                stats.pnum_hits->Inc();
+                if (handler) {
+                    handler(nullptr, it->second.result);
+                }
+                return;
+            }
+            cache_.erase(it);
+        }
+    }
+    // merged into the identical call in flight, the one started before the height is changed might return the old result
+    auto it = inflight_calls_.find(key);
+    if (it != std::end(inflight_calls_) && it->second->height == height_) {
+        stats.pnum_coalesced->Inc();
+        if (handler) {
+            it->second->handlers.push_back(std::move(handler));
+        }
+        return;
+    }
+    stats.pnum_misses->Inc();
+    auto pcall = std::make_shared<PendingCall>();
+    pcall->id = ++next_id_;
+    pcall->key = std::move(key);
+    pcall->method = std::move(method);
+    pcall->height = height_;
+    pcall->pstats = &stats;
+    pcall->request = UniValue(UniValue::VOBJ);
+    pcall->request.pushKV("jsonrpc", "1.0");
+    pcall->request.pushKV("id", pcall->id);
+    pcall->request.pushKV("method", pcall->method);
+    pcall->request.pushKV("params", params);
+    if (handler) {
+        pcall->handlers.push_back(std::move(handler));
+    }
+    inflight_calls_[pcall->key] = pcall;
+    // the calls started in this turn of the strand are flushed together
+    if (queued_calls_.empty()) {
+        asio::post(strand_, [this]() {
+            Flush();
+        });
+    }
+    queued_calls_.push_back(std::move(pcall));
+}
+
+void AsyncRPCClient::Flush()
+{
+    std::vector<PendingCallPtr> calls;
+    calls.swap(queued_calls_);
+    std::vector<PendingCallPtr> batched_calls;
+    for (auto& pcall : calls) {
+        if (pcall->pstats->unbatched) {
+            SendExchange({ std::move(pcall) });
+        } else {
+            batched_calls.push_back(std::move(pcall));
+        }
+    }
+    for (std::size_t start = 0; start < batched_calls.size(); start += opts_.max_batch_size) {
+        auto end = std::min(batched_calls.size(), start + opts_.max_batch_size);
+        SendExchange(std::vector<PendingCallPtr>(std::begin(batched_calls) + start, std::begin(batched_calls) + end));
+    }
+}
+
+void AsyncRPCClient::SendExchange(std::vector<PendingCallPtr> calls)
+{
+    auto pexchange = std::make_shared<Exchange>();
+    pexchange->calls = std::move(calls);
+    pexchange->deadline = std::chrono::steady_clock::now() + opts_.timeout;
+    if (pexchange->calls.size() == 1) {
+        pexchange->body = pexchange->calls.front()->request.write();
+    } else {
+        UniValue batch(UniValue::VARR);
+        for (auto const& pcall : pexchange->calls) {
+            batch.push_back(pcall->request);
+        }
+        pexchange->body = batch.write();
+        num_batches_.Inc();
+    }
+    if (auth_.empty() && !cookie_path_.empty()) {
+        try {
+            LoadCookie();
+        } catch (std::exception const& e) {
+            FailAll(pexchange, std::make_exception_ptr(RPCNetError(e.what())));
+            return;
+        }
+    }
+    if (!AcquireBreaker(*pexchange)) {
+        FailAll(pexchange, std::make_exception_ptr(RPCNetError("the circuit breaker is open")));
+        return;
+    }
+    DoRequest(pexchange);
+}
+
+bool AsyncRPCClient::AcquireBreaker(Exchange& exchange)
+{
+    auto state = GetBreakerState();
+    if (state == BreakerState::CLOSED) {
+        return true;
+    }
+    if (state == BreakerState::OPEN) {
+        if (std::chrono::steady_clock::now() < open_until_) {
+            num_rejected_.Inc();
+            return false;
+        }
+        SetBreakerState(BreakerState::HALF_OPEN);
+    }
+    // only one request probes the service when the breaker is half-open
+    if (probing_) {
+        num_rejected_.Inc();
+        return false;
+    }
+    probing_ = true;
+    exchange.probe = true;
+    return true;
+}
+
+void AsyncRPCClient::DoRequest(ExchangePtr pexchange)
+{
+    auto& req = pexchange->req;
+    req = {};
+    req.method(http::verb::post);
+    req.target(target_);
+    req.version(11);
+    req.set(http::field::host, host_);
+    req.set(http::field::content_type, "application/json");
+    req.set(http::field::authorization, auth_);
+    req.keep_alive(true);
+    req.body() = pexchange->body;
+    req.prepare_payload();
+
+    if (!idle_conns_.empty()) {
+        auto pconn = idle_conns_.back();
+        idle_conns_.pop_back();
+        DoWrite(pexchange, pconn);
+        return;
+    }
+    DoConnect(pexchange, std::make_shared<Connection>(strand_));
+}
+
+void AsyncRPCClient::DoConnect(ExchangePtr pexchange, ConnectionPtr pconn)
+{
+    if (endpoints_.empty()) {
+        resolver_.async_resolve(host_, port_, [this, pexchange, pconn](error_code const& ec, tcp::resolver::results_type results) {
+            if (ec) {
+                HandleNetError(pexchange, pconn, "resolve", ec);
+                return;
+            }
+            endpoints_.assign(std::begin(results), std::end(results));
+            DoConnect(pexchange, pconn);
+        });
+        return;
+    }
+    pconn->stream.expires_at(pexchange->deadline);
+    pconn->stream.async_connect(endpoints_, [this, pexchange, pconn](error_code const& ec, tcp::endpoint const&) {
+        if (ec) {
+            // the address of the node might be changed
+            endpoints_.clear();
+            HandleNetError(pexchange, pconn, "connect", ec);
+            return;
+        }
+        DoWrite(pexchange, pconn);
+    });
+}
+
+void AsyncRPCClient::DoWrite(ExchangePtr pexchange, ConnectionPtr pconn)
+{
+    pconn->stream.expires_at(pexchange->deadline);
+    http::async_write(pconn->stream, pexchange->req, [this, pexchange, pconn](error_code const& ec, std::size_t) {
+        if (ec) {
+            HandleNetError(pexchange, pconn, "write", ec);
+            return;
+        }
+        auto& pparser = pexchange->pparser;
+        pparser = std::make_unique<http::response_parser<http::string_body>>();
+        if (opts_.max_response_bytes > 0) {
+            pparser->body_limit(opts_.max_response_bytes);
+        } else {
+            pparser->body_limit(boost::none);
+        }
+        http::async_read(pconn->stream, pconn->buf, *pparser, [this, pexchange, pconn](error_code const& ec, std::size_t) {
+            if (ec) {
+                HandleNetError(pexchange, pconn, "read", ec);
+                return;
+            }
+            pexchange->res = pexchange->pparser->release();
+            pexchange->pparser.reset();
+            HandleResponse(pexchange, pconn);
+        });
+    });
+}
+
+void AsyncRPCClient::HandleResponse(ExchangePtr pexchange, ConnectionPtr pconn)
+{
+    if (pexchange->probe) {
+        probing_ = false;
+    }
+    auto const& res = pexchange->res;
+    if (res.keep_alive() && idle_conns_.size() < opts_.max_idle_connections) {
+        pconn->reused = true;
+        idle_conns_.push_back(pconn);
+    } else {
+        error_code ignored_ec;
+        pconn->stream.socket().shutdown(tcp::socket::shutdown_both, ignored_ec);
+        pconn->stream.close();
+    }
+    // the node is too busy to handle the calls
+    if (res.result() == http::status::service_unavailable) {
+        RecordFailure(*pexchange);
+        FailAll(pexchange, std::make_exception_ptr(RPCNetError("the service is unavailable")));
+        return;
+    }
+    RecordSuccess();
+    if (res.result() == http::status::unauthorized) {
+        if (!cookie_path_.empty()) {
+            try {
+                LoadCookie();
+            } catch (std::exception const& e) {
+                PLOGE << tinyformat::format("%s: %s", __func__, e.what());
+            }
+        }
+        FailAll(pexchange, std::make_exception_ptr(RPCCallError("the login is rejected")));
+        return;
+    }
+    UniValue reply;
+    if (!reply.read(res.body())) {
+        FailAll(pexchange, std::make_exception_ptr(RPCCallError(tinyformat::format("invalid response, status=%d", res.result_int()))));
+        return;
+    }
+    // the replies of a batch are matched by the ids, a single call might be rejected with an object even if it is in a batch.
+    // All replies are parsed before any handler is invoked, a malformed reply fails the calls instead of the loop
+    std::vector<std::pair<std::exception_ptr, UniValue>> results;
+    try {
+        std::vector<UniValue> replies;
+        if (reply.isArray()) {
+            replies = reply.getValues();
+        } else {
+            replies.push_back(reply);
+        }
+        for (auto const& pcall : pexchange->calls) {
+            auto it = std::find_if(std::cbegin(replies), std::cend(replies), [&pcall, single = pexchange->calls.size() == 1](UniValue const& item) {
+                return single || (item["id"].isNum() && item["id"].getValStr() == std::to_string(pcall->id));
+            });
+            if (it == std::cend(replies) || !it->isObject()) {
+                results.emplace_back(std::make_exception_ptr(RPCCallError(tinyformat::format("%s: invalid response, status=%d", pcall->method, res.result_int()))), UniValue());
+                continue;
+            }
+            auto const& err = (*it)["error"];
+            if (!err.isNull()) {
+                std::string msg = err.isObject() && err["message"].isStr() ? err["message"].get_str() : err.write();
+                results.emplace_back(std::make_exception_ptr(RPCCallError(tinyformat::format("%s: %s", pcall->method, msg))), UniValue());
+                continue;
+            }
+            results.emplace_back(nullptr, (*it)["result"]);
+        }
+    } catch (std::exception const& e) {
+        FailAll(pexchange, std::make_exception_ptr(RPCCallError(tinyformat::format("malformed response: %s", e.what()))));
+        return;
+    }
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        Complete(pexchange->calls[i], results[i].first, results[i].second);
+    }
+}
+
+void AsyncRPCClient::HandleNetError(ExchangePtr pexchange, ConnectionPtr pconn, std::string_view stage, error_code const& ec)
+{
+    error_code ignored_ec;
+    pconn->stream.socket().close(ignored_ec);
+    // the idle connections might be closed by the node, try again once with a new connection
+    if (pconn->reused && !pexchange->retried && ec != beast::error::timeout) {
+        PLOGD << tinyformat::format("the idle connection is broken (%s), retry with a new connection", ec.message());
+        pexchange->retried = true;
+        idle_conns_.clear();
+        DoRequest(pexchange);
+        return;
+    }
+    if (pexchange->probe) {
+        probing_ = false;
+    }
+    num_net_errors_.Inc();
+    RecordFailure(*pexchange);
+    FailAll(pexchange, std::make_exception_ptr(RPCNetError(tinyformat::format("%s %s", stage, ec == beast::error::timeout ? "timeout" : ec.message()))));
+}
+
+void AsyncRPCClient::FailAll(ExchangePtr pexchange, std::exception_ptr perr)
+{
+    for (auto const& pcall : pexchange->calls) {
+        Complete(pcall, perr, UniValue());
+    }
+}
+
+void AsyncRPCClient::Complete(PendingCallPtr pcall, std::exception_ptr perr, UniValue const& result)
+{
+    auto it = inflight_calls_.find(pcall->key);
+    if (it != std::end(inflight_calls_) && it->second == pcall) {
+        inflight_calls_.erase(it);
+    }
+    // the result of an older height is never cached
+    if (!perr && pcall->pstats->cache_ttl.count() > 0 && pcall->height == height_) {
+        cache_[pcall->key] = CacheEntry { result, pcall->height, std::chrono::steady_clock::now() + pcall->pstats->cache_ttl };
+    }
+    for (auto const& handler : pcall->handlers) {
+        handler(perr, result);
+    }
+}
+
+void AsyncRPCClient::RecordSuccess()
+{
+    num_failures_ = 0;
+    if (GetBreakerState() != BreakerState::CLOSED) {
+        PLOGI << "the RPC service is back, the circuit breaker is closed";
+        SetBreakerState(BreakerState::CLOSED);
+    }
+}
+
+void AsyncRPCClient::RecordFailure(Exchange const& exchange)
+{
+    ++num_failures_;
+    if (exchange.probe || (GetBreakerState() == BreakerState::CLOSED && num_failures_ >= opts_.breaker_failures)) {
+        PLOGW << tinyformat::format("the circuit breaker is opened after %d failure(s), the RPC calls are rejected in %d ms", num_failures_, opts_.breaker_cooldown.count());
+        open_until_ = std::chrono::steady_clock::now() + opts_.breaker_cooldown;
+        SetBreakerState(BreakerState::OPEN);
+    }
+}
+
+void AsyncRPCClient::SetBreakerState(BreakerState state)
+{
+    breaker_state_ = static_cast<int>(state);
+    breaker_open_gauge_.Set(state == BreakerState::CLOSED ? 0 : 1);
+}
+
+void AsyncRPCClient::LoadCookie()
+{
+    std::ifstream in(cookie_path_);
+    if (!in.is_open()) {
+        throw std::runtime_error(tinyformat::format("cannot open the cookie file: %s", cookie_path_));
+    }
+    std::string cookie;
+    std::getline(in, cookie);
+    auto pos = cookie.find(':');
+    if (pos == std::string::npos) {
+        throw std::runtime_error(tinyformat::format("invalid cookie file: %s", cookie_path_));
+    }
+    auth_ = MakeBasicAuth(cookie.substr(0, pos), cookie.substr(pos + 1));
+}
@@ -0,0 +1,285 @@
+#ifndef TL_ASYNC_RPC_CLIENT_H
+#define TL_ASYNC_RPC_CLIENT_H
+
+#include <cstdint>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <string>
+#include <string_view>
+
+#include "asio_defs.hpp"
+
+#include <boost/beast.hpp>
+namespace beast = boost::beast;
+namespace http = beast::http;
+
+#include <univalue.h>
+
+#include "metrics.h"
+
+/**
+ * The RPC service cannot be reached: connection failures, timeouts and the calls rejected by the open circuit breaker
+ */
+class RPCNetError : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * The RPC service returns an error for the call
+ */
+class RPCCallError : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+inline void AppendRPCParams(UniValue& params) { }
+
+template <typename Arg, typename... Args> void AppendRPCParams(UniValue& params, Arg&& arg, Args&&... args)
+{
+    params.push_back(UniValue(std::forward<Arg>(arg)));
+    AppendRPCParams(params, std::forward<Args>(args)...);
+}
+
+template <typename... Args> UniValue MakeRPCParams(Args&&... args)
+{
+    UniValue params(UniValue::VARR);
+    AppendRPCParams(params, std::forward<Args>(args)...);
+    return params;
+}
+
+/**
+ * A JSON-RPC client over HTTP keep-alive connections, the calls are made on its own strand and the handlers are invoked
+ * from the strand, so it can be shared between the threads
+ *
+ * The identical calls in flight are merged into one, and the results of the methods set by `SetCacheTTL` are cached until
+ * the TTL is expired or the chain height is changed. A call belongs to the height when it is started, it is never merged
+ * or cached across a height change. The calls made in the same turn of the strand are sent in one batch request, except
+ * the methods set by `SetUnbatched`
+ *
+ * Each request has a deadline which covers connecting, writing and reading. The circuit breaker opens after a number of
+ * consecutive failures, the calls are rejected immediately until the cooldown is passed, then one request is allowed to
+ * probe the service and the breaker closes when it succeeds
+ */
+class AsyncRPCClient
+{
+public:
+    struct Result {
+        UniValue result;
+    };
+
+    struct Options {
+        std::chrono::milliseconds timeout { 10000 };
+        // the body of a response is limited to this size, 0 for no limit
+        std::size_t max_response_bytes { 8 * 1024 * 1024 };
+        std::size_t max_idle_connections { 4 };
+        std::size_t max_batch_size { 16 };
+        int breaker_failures { 5 };
+        std::chrono::milliseconds breaker_cooldown { 10000 };
+        // the metrics of the client are labeled by the url and the name, the clients of the same node have different names
+        std::string name { "default" };
+    };
+
+    struct Request {
+        std::string method;
+        UniValue params;
+    };
+
+    enum class BreakerState { CLOSED, OPEN, HALF_OPEN };
+
+    using Handler = std::function<void(std::exception_ptr perr, UniValue const& result)>;
+
+    AsyncRPCClient(asio::io_context& ioc, std::string_view url, std::string user, std::string passwd, Options opts);
+
+    /**
+     * Login with the cookie file generated by the node, the file is read again when the login is rejected
+     */
+    AsyncRPCClient(asio::io_context& ioc, std::string_view url, std::string cookie_path, Options opts);
+
+    /**
+     * Cache the results of the method for the TTL
+     */
+    void SetCacheTTL(std::string method, std::chrono::milliseconds ttl);
+
+    /**
+     * The calls of the method are always sent alone, so they are never delayed by the slow calls in the same batch
+     */
+    void SetUnbatched(std::string method);
+
+    /**
+     * The cached results are dropped when the height is changed
+     */
+    void SetChainHeight(int height);
+
+    void AsyncCall(std::string method, UniValue params, Handler handler);
+
+    /**
+     * Make the calls without waiting for them, they are sent in one batch and the results are cached for the later calls
+     */
+    void Prefetch(std::vector<Request> reqs);
+
+    /**
+     * Make the call and wait for the result, it cannot be called from the loop of the client
+     */
+    template <typename... Args> Result Call(std::string method, Args&&... args)
+    {
+        if (strand_.running_in_this_thread()) {
+            throw std::logic_error("the RPC call cannot be waited on the loop of the RPC client");
+        }
+        std::promise<UniValue> promise;
+        auto future = promise.get_future();
+        AsyncCall(std::move(method), MakeRPCParams(std::forward<Args>(args)...), [&promise](std::exception_ptr perr, UniValue const& result) {
+            if (perr) {
+                promise.set_exception(perr);
+            } else {
+                promise.set_value(result);
+            }
+        });
+        return Result { future.get() };
+    }
+
+    std::string const& GetUrl() const
+    {
+        return url_;
+    }
+
+    BreakerState GetBreakerState() const
+    {
+        return static_cast<BreakerState>(breaker_state_.load());
+    }
+
+private:
+    struct Connection {
+        explicit Connection(asio::strand<asio::io_context::executor_type> const& strand)
+            : stream(strand)
+        {
+        }
+
+        beast::tcp_stream stream;
+        beast::flat_buffer buf;
+        bool reused { false };
+    };
+
+    using ConnectionPtr = std::shared_ptr<Connection>;
+
+    struct MethodStats {
+        std::chrono::milliseconds cache_ttl { 0 };
+        bool unbatched { false };
+        Counter* pnum_hits { nullptr };
+        Counter* pnum_misses { nullptr };
+        Counter* pnum_coalesced { nullptr };
+    };
+
+    /**
+     * A call with all the handlers which are waiting for it
+     */
+    struct PendingCall {
+        uint64_t id;
+        std::string key;
+        std::string method;
+        int height;
+        UniValue request;
+        MethodStats* pstats;
+        std::vector<Handler> handlers;
+    };
+
+    using PendingCallPtr = std::shared_ptr<PendingCall>;
+
+    /**
+     * An HTTP request which carries one or a batch of calls
+     */
+    struct Exchange {
+        std::vector<PendingCallPtr> calls;
+        std::string body;
+        std::chrono::steady_clock::time_point deadline;
+        bool retried { false };
+        bool probe { false };
+        http::request<http::string_body> req;
+        std::unique_ptr<http::response_parser<http::string_body>> pparser;
+        http::response<http::string_body> res;
+    };
+
+    using ExchangePtr = std::shared_ptr<Exchange>;
+
+    struct CacheEntry {
+        UniValue result;
+        int height;
+        std::chrono::steady_clock::time_point expires_at;
+    };
+
+    AsyncRPCClient(asio::io_context& ioc, std::string_view url, Options opts);
+
+    MethodStats& GetMethodStats(std::string const& method);
+
+    void StartCall(std::string method, UniValue params, Handler handler);
+
+    void Flush();
+
+    void SendExchange(std::vector<PendingCallPtr> calls);
+
+    bool AcquireBreaker(Exchange& exchange);
+
+    void DoRequest(ExchangePtr pexchange);
+
+    void DoConnect(ExchangePtr pexchange, ConnectionPtr pconn);
+
+    void DoWrite(ExchangePtr pexchange, ConnectionPtr pconn);
+
+    void HandleResponse(ExchangePtr pexchange, ConnectionPtr pconn);
+
+    void HandleNetError(ExchangePtr pexchange, ConnectionPtr pconn, std::string_view stage, error_code const& ec);
+
+    void FailAll(ExchangePtr pexchange, std::exception_ptr perr);
+
+    void Complete(PendingCallPtr pcall, std::exception_ptr perr, UniValue const& result);
+
+    void RecordSuccess();
+
+    void RecordFailure(Exchange const& exchange);
+
+    void SetBreakerState(BreakerState state);
+
+    void LoadCookie();
+
+    asio::strand<asio::io_context::executor_type> strand_;
+    tcp::resolver resolver_;
+    Options opts_;
+    std::string url_;
+    std::string host_;
+    std::string port_;
+    std::string target_;
+    std::string auth_;
+    std::string cookie_path_;
+    std::vector<tcp::endpoint> endpoints_;
+    std::deque<ConnectionPtr> idle_conns_;
+    uint64_t next_id_ { 0 };
+    std::map<std::string, MethodStats, std::less<>> method_stats_;
+    std::map<std::string, PendingCallPtr> inflight_calls_;
+    std::map<std::string, CacheEntry> cache_;
+    std::vector<PendingCallPtr> queued_calls_;
+    int height_ { 0 };
+    // the breaker is changed on the strand, the state can be read from any thread
+    std::atomic_int breaker_state_ { static_cast<int>(BreakerState::CLOSED) };
+    int num_failures_ { 0 };
+    bool probing_ { false };
+    std::chrono::steady_clock::time_point open_until_;
+    Counter& num_net_errors_;
+    Counter& num_rejected_;
+    Counter& num_batches_;
+    Gauge& breaker_open_gauge_;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "common_types.h"
+#include "flat_hash_map.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+
+std::vector<uint256> MakeRandomKeys(std::mt19937_64& rnd, int n)
+{
+    std::vector<uint256> keys(n);
+    for (auto& key : keys) {
+        for (auto& b : key) {
+            b = rnd() % 256;
+        }
+    }
+    return keys;
+}
+
+struct Result {
+    double insert_ns;
+    double hit_ns;
+    double miss_ns;
+};
+
+template <typename Map> Result RunMap(std::vector<uint256> const& keys, std::vector<uint256> const& missing_keys, int lookup_rounds)
+{
+    Result res;
+    uint64_t sum { 0 };
+    Map m;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        m[keys[i]] = i;
+    }
+    res.insert_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / keys.size();
+
+    start = Clock::now();
+    for (int r = 0; r < lookup_rounds; ++r) {
+        for (auto const& key : keys) {
+            auto it = m.find(key);
+            sum += it->second;
+        }
+    }
+    res.hit_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (keys.size() * lookup_rounds);
+
+    start = Clock::now();
+    for (int r = 0; r < lookup_rounds; ++r) {
+        for (auto const& key : missing_keys) {
+            sum += m.find(key) == std::end(m) ? 0 : 1;
+        }
+    }
+    res.miss_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (missing_keys.size() * lookup_rounds);
+
+    if (sum == 0xffffffff) {
+        // never happens, only prevents the lookups from being optimized out
+        fmt::print("{}\n", sum);
+    }
+    return res;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int max_size = argc > 1 ? std::atoi(argv[1]) : 100000;
+    std::mt19937_64 rnd(2023);
+    fmt::print("{:>8} {:>28} {:>28} {:>28}\n", "size", "std::map ins/hit/miss(ns)", "unordered ins/hit/miss(ns)", "flat ins/hit/miss(ns)");
+    for (int size = 10; size <= max_size; size *= 10) {
+        auto keys = MakeRandomKeys(rnd, size);
+        auto missing_keys = MakeRandomKeys(rnd, size);
+        int lookup_rounds = std::max(1, 1000000 / size);
+        auto r1 = RunMap<std::map<uint256, uint64_t>>(keys, missing_keys, lookup_rounds);
+        auto r2 = RunMap<std::unordered_map<uint256, uint64_t, FlatHash<uint256>>>(keys, missing_keys, lookup_rounds);
+        auto r3 = RunMap<FlatHashMap<uint256, uint64_t>>(keys, missing_keys, lookup_rounds);
+        fmt::print("{:>8} {:>8.1f} {:>9.1f} {:>9.1f} {:>8.1f} {:>9.1f} {:>9.1f} {:>8.1f} {:>9.1f} {:>9.1f}\n", size, r1.insert_ns, r1.hit_ns, r1.miss_ns, r2.insert_ns, r2.hit_ns, r2.miss_ns, r3.insert_ns, r3.hit_ns, r3.miss_ns);
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <fmt/core.h>
+
+#include <json/value.h>
+
+#include "frontend_codec.h"
+#include "frontend_messages.h"
+#include "msg_ids.h"
+#include "timelord_utils.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+
+vdf_client::ProofDetail MakeRandomProof()
+{
+    vdf_client::ProofDetail detail;
+    detail.proof.resize(100);
+    for (auto& b : detail.y) {
+        b = random() % 256;
+    }
+    for (auto& b : detail.proof) {
+        b = random() % 256;
+    }
+    detail.witness_type = 0;
+    detail.iters = 123456789;
+    detail.duration = 60;
+    return detail;
+}
+
+Json::Value MakeProofJson(uint256 const& challenge, vdf_client::ProofDetail const& detail)
+{
+    Json::Value msg;
+    msg["id"] = static_cast<Json::Int>(TimelordMsgs::PROOF);
+    msg["challenge"] = Uint256ToHex(challenge);
+    msg["y"] = FormToHex(detail.y);
+    msg["proof"] = BytesToHex(detail.proof);
+    msg["witness_type"] = static_cast<Json::Int>(detail.witness_type);
+    msg["iters"] = detail.iters;
+    msg["duration"] = detail.duration;
+    return msg;
+}
+
+vdf_client::ProofDetail ProofFromJson(Json::Value const& msg)
+{
+    vdf_client::ProofDetail detail;
+    detail.y = FormFromHex(msg["y"].asString());
+    detail.proof = BytesFromHex(msg["proof"].asString());
+    detail.witness_type = msg["witness_type"].asInt();
+    detail.iters = msg["iters"].asUInt64();
+    detail.duration = msg["duration"].asInt();
+    return detail;
+}
+
+/**
+ * @return The number of the messages per second
+ */
+double Measure(int rounds, std::function<uint64_t()> const& proc)
+{
+    uint64_t sum { 0 };
+    auto start = Clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        sum += proc();
+    }
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+    // keep the results from being optimized out
+    if (sum == 0) {
+        fmt::print("");
+    }
+    return rounds / secs;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int rounds = argc > 1 ? std::atoi(argv[1]) : 100000;
+    uint256 challenge;
+    MakeZero(challenge, 0x5a);
+    auto detail = MakeRandomProof();
+    auto msg = MakeProofJson(challenge, detail);
+
+    std::string styled = msg.toStyledString();
+    std::string json_frame = EncodeJsonFrame(msg);
+    std::string binary_frame = EncodeProofFrame(challenge, detail);
+
+    // encode the proof from its fields, the JSON encodings include the conversion to the hex strings
+    double styled_encode = Measure(rounds, [&]() {
+        return MakeProofJson(challenge, detail).toStyledString().size();
+    });
+    double json_encode = Measure(rounds, [&]() {
+        return EncodeJsonFrame(MakeProofJson(challenge, detail)).size();
+    });
+    double binary_encode = Measure(rounds, [&]() {
+        return EncodeProofFrame(challenge, detail).size();
+    });
+    // the message which is queued to the JSON sessions, the frame is written from the template into a pooled buffer
+    auto pdetail = std::make_shared<vdf_client::ProofDetail const>(detail);
+    double template_encode = Measure(rounds, [&]() {
+        return MakeMsg_Proof(challenge, pdetail)->GetJson().size();
+    });
+
+    // decode the proof back to its fields
+    double json_decode = Measure(rounds, [&]() {
+        return ProofFromJson(ParseStringToJson(std::string_view(json_frame.data(), json_frame.size() - 1))).iters;
+    });
+    double binary_decode = Measure(rounds, [&]() {
+        return DecodeProofFrame(std::string_view(binary_frame).substr(BINARY_FRAME_PREFIX_SIZE)).detail.iters;
+    });
+
+    fmt::print("{:>14} {:>10} {:>16} {:>16}\n", "encoding", "bytes", "encode(msg/s)", "decode(msg/s)");
+    fmt::print("{:>14} {:>10} {:>16.0f} {:>16}\n", "styled json", styled.size() + 1, styled_encode, "-");
+    fmt::print("{:>14} {:>10} {:>16.0f} {:>16.0f}\n", "compact json", json_frame.size(), json_encode, json_decode);
+    fmt::print("{:>14} {:>10} {:>16.0f} {:>16.0f}\n", "binary", binary_frame.size(), binary_encode, binary_decode);
+    fmt::print("{:>14} {:>10} {:>16.0f} {:>16}\n", "template", json_frame.size(), template_encode, "-");
+    return 0;
+}
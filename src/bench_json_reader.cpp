@@ -0,0 +1,119 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+
+#include <fmt/core.h>
+
+#include <json/reader.h>
+#include <json/value.h>
+
+#include "asio_defs.hpp"
+
+#include "frontend.h"
+#include "msg_ids.h"
+#include "timelord_utils.h"
+
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<uint64_t> g_num_allocs { 0 };
+
+void* operator new(std::size_t size)
+{
+    ++g_num_allocs;
+    void* p = std::malloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+
+std::string MakeCalcFrame()
+{
+    uint256 challenge;
+    MakeZero(challenge, 0x5a);
+    Json::Value msg;
+    msg["id"] = static_cast<Json::Int>(TimelordClientMsgs::CALC);
+    msg["challenge"] = Uint256ToHex(challenge);
+    msg["iters"] = 123456789;
+    msg["netspace"]["group_hash"] = Uint256ToHex(challenge);
+    msg["netspace"]["total_size"] = 1024;
+    return EncodeJsonFrame(msg);
+}
+
+struct Result {
+    double allocs;
+    double nsecs;
+};
+
+/**
+ * Receive the frame into the streambuf and parse it as the session does, `proc` returns the id of the message
+ */
+template <typename Proc> Result Run(std::string const& frame, int rounds, Proc&& proc)
+{
+    asio::streambuf buf;
+    uint64_t sum { 0 };
+    uint64_t num_allocs = g_num_allocs;
+    auto start = Clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        auto dest = buf.prepare(frame.size());
+        memcpy(dest.data(), frame.data(), frame.size());
+        buf.commit(frame.size());
+        sum += proc(buf, frame.size());
+        buf.consume(frame.size());
+    }
+    Result res;
+    res.nsecs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / rounds;
+    res.allocs = static_cast<double>(g_num_allocs - num_allocs) / rounds;
+    if (sum == 0) {
+        fmt::print("");
+    }
+    return res;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int rounds = argc > 1 ? std::atoi(argv[1]) : 100000;
+    auto frame = MakeCalcFrame();
+
+    // copy the frame out of the buffer, build a reader and a value for each message
+    auto copied = Run(frame, rounds, [](asio::streambuf& buf, std::size_t size) {
+        std::string text = static_cast<char const*>(buf.data().data());
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        Json::Value root;
+        std::string errs;
+        reader->parse(text.data(), text.data() + text.size(), &root, &errs);
+        return root["id"].asInt();
+    });
+
+    // parse in place with the reader and the value of the session
+    JsonReader json_reader;
+    std::string scratch;
+    auto reused = Run(frame, rounds, [&](asio::streambuf& buf, std::size_t size) {
+        return json_reader.Parse(ViewReceivedData(buf, size - 1, scratch))["id"].asInt();
+    });
+
+    fmt::print("CALC message, {} bytes\n", frame.size());
+    fmt::print("{:>24} {:>14} {:>14}\n", "parsing", "allocs/msg", "ns/msg");
+    fmt::print("{:>24} {:>14.1f} {:>14.0f}\n", "copy + new reader", copied.allocs, copied.nsecs);
+    fmt::print("{:>24} {:>14.1f} {:>14.0f}\n", "in place + reused reader", reused.allocs, reused.nsecs);
+    return 0;
+}
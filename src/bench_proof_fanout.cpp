@@ -0,0 +1,152 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <json/value.h>
+
+#include "asio_defs.hpp"
+
+#include "frontend.h"
+#include "msg_ids.h"
+#include "timelord_utils.h"
+#include "vdf_client_man.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+
+struct Peer {
+    explicit Peer(asio::io_context& ioc)
+        : s(ioc)
+    {
+    }
+
+    tcp::socket s;
+    asio::streambuf read_buf;
+};
+
+struct Sessions {
+    std::vector<FrontEndSessionPtr> sessions;
+    std::vector<std::unique_ptr<Peer>> peers;
+};
+
+Sessions ConnectSessions(asio::io_context& ioc, int num_sessions)
+{
+    tcp::acceptor acceptor(ioc, tcp::endpoint(asio::ip::address::from_string("127.0.0.1"), 0));
+    Sessions res;
+    for (int i = 0; i < num_sessions; ++i) {
+        auto ppeer = std::make_unique<Peer>(ioc);
+        ppeer->s.connect(acceptor.local_endpoint());
+        res.sessions.push_back(std::make_shared<FrontEndSession>(ioc, acceptor.accept()));
+        res.peers.push_back(std::move(ppeer));
+    }
+    return res;
+}
+
+vdf_client::ProofDetail MakeRandomProof()
+{
+    vdf_client::ProofDetail detail;
+    detail.proof.resize(100);
+    for (auto& b : detail.y) {
+        b = random() % 256;
+    }
+    for (auto& b : detail.proof) {
+        b = random() % 256;
+    }
+    detail.witness_type = 0;
+    detail.iters = 123456789;
+    detail.duration = 60;
+    return detail;
+}
+
+Json::Value MakeProofJson(uint256 const& challenge, vdf_client::ProofDetail const& detail)
+{
+    Json::Value msg;
+    msg["id"] = static_cast<Json::Int>(TimelordMsgs::PROOF);
+    msg["challenge"] = Uint256ToHex(challenge);
+    msg["y"] = FormToHex(detail.y);
+    msg["proof"] = BytesToHex(detail.proof);
+    msg["witness_type"] = static_cast<Json::Int>(detail.witness_type);
+    msg["iters"] = detail.iters;
+    msg["duration"] = detail.duration;
+    return msg;
+}
+
+struct Result {
+    double fanout_usecs;
+    double delivered_usecs;
+};
+
+/**
+ * Send the proof to all sessions and wait until all peers received it
+ *
+ * @param serialize_once Encode the message once and share it, otherwise encode it for each session
+ */
+Result RunFanOut(int num_sessions, bool serialize_once)
+{
+    asio::io_context ioc;
+    auto sessions = ConnectSessions(ioc, num_sessions);
+    uint256 challenge;
+    MakeZero(challenge, 0x5a);
+    auto detail = MakeRandomProof();
+
+    int num_delivered { 0 };
+    Clock::time_point delivered_time;
+    for (auto& ppeer : sessions.peers) {
+        asio::async_read_until(ppeer->s, ppeer->read_buf, '\0', [&](error_code const& ec, std::size_t) {
+            if (!ec && ++num_delivered == num_sessions) {
+                delivered_time = Clock::now();
+            }
+        });
+    }
+
+    auto start_time = Clock::now();
+    if (serialize_once) {
+        FrontEndMessage msg = MakeFrontEndMessage(MakeProofJson(challenge, detail));
+        for (auto const& psession : sessions.sessions) {
+            psession->SendMessage(msg);
+        }
+    } else {
+        for (auto const& psession : sessions.sessions) {
+            psession->SendMessage(MakeProofJson(challenge, detail));
+        }
+    }
+    auto fanout_time = Clock::now();
+    ioc.run();
+
+    for (auto const& psession : sessions.sessions) {
+        psession->Stop();
+    }
+
+    Result res;
+    res.fanout_usecs = std::chrono::duration<double, std::micro>(fanout_time - start_time).count();
+    res.delivered_usecs = std::chrono::duration<double, std::micro>(delivered_time - start_time).count();
+    return res;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int max_sessions = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int const ROUNDS = 5;
+    fmt::print("{:>10} {:>22} {:>22} {:>22} {:>22}\n", "sessions", "per-session fanout(us)", "once fanout(us)", "per-session total(us)", "once total(us)");
+    for (int num_sessions = 1; num_sessions <= max_sessions; num_sessions *= (num_sessions < 10 ? 10 : 2)) {
+        Result per_session { 0, 0 }, once { 0, 0 };
+        for (int i = 0; i < ROUNDS; ++i) {
+            auto r1 = RunFanOut(num_sessions, false);
+            auto r2 = RunFanOut(num_sessions, true);
+            per_session.fanout_usecs += r1.fanout_usecs / ROUNDS;
+            per_session.delivered_usecs += r1.delivered_usecs / ROUNDS;
+            once.fanout_usecs += r2.fanout_usecs / ROUNDS;
+            once.delivered_usecs += r2.delivered_usecs / ROUNDS;
+        }
+        fmt::print("{:>10} {:>22.1f} {:>22.1f} {:>22.1f} {:>22.1f}\n", num_sessions, per_session.fanout_usecs, once.fanout_usecs, per_session.delivered_usecs, once.delivered_usecs);
+    }
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "asio_defs.hpp"
+
+#include "timing_wheel.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<uint64_t> g_num_allocs { 0 };
+
+void* operator new(std::size_t size)
+{
+    ++g_num_allocs;
+    void* p = std::malloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+
+constexpr int TIMEOUT_SECONDS = 120;
+
+// the ticks of the wheel and the polls of the loop happen once per the number of the messages
+constexpr int MESSAGES_PER_TICK = 10000;
+
+struct Result {
+    double allocs;
+    double nsecs;
+};
+
+/**
+ * The sessions are touched in random order, `touch` is invoked with the index of the session for each received message
+ */
+template <typename Touch, typename Tick> Result Run(std::vector<int> const& order, Touch&& touch, Tick&& tick)
+{
+    uint64_t num_allocs = g_num_allocs;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        touch(order[i]);
+        if ((i + 1) % MESSAGES_PER_TICK == 0) {
+            tick();
+        }
+    }
+    Result res;
+    res.nsecs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / order.size();
+    res.allocs = static_cast<double>(g_num_allocs - num_allocs) / order.size();
+    return res;
+}
+
+/**
+ * The session resets its timeout by replacing the timer, the replaced timer is cancelled and its handler is invoked with
+ * the error by the next poll
+ */
+struct TimerSession : public std::enable_shared_from_this<TimerSession> {
+    explicit TimerSession(asio::io_context& ioc)
+        : ioc(ioc)
+    {
+    }
+
+    void ResetTimeoutTimer()
+    {
+        timer = std::make_unique<asio::steady_timer>(ioc);
+        timer->expires_after(std::chrono::seconds(TIMEOUT_SECONDS));
+        timer->async_wait([self_weak = std::weak_ptr(shared_from_this())](error_code const& ec) {
+            if (ec) {
+                return;
+            }
+            auto self = self_weak.lock();
+            if (self) {
+                ++self->num_timeouts;
+            }
+        });
+    }
+
+    asio::io_context& ioc;
+    std::unique_ptr<asio::steady_timer> timer;
+    int num_timeouts { 0 };
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int num_sessions = argc > 1 ? std::atoi(argv[1]) : 10000;
+    int num_messages = argc > 2 ? std::atoi(argv[2]) : 1000000;
+
+    std::mt19937 rnd(1);
+    std::vector<int> order(num_messages);
+    for (auto& idx : order) {
+        idx = rnd() % num_sessions;
+    }
+
+    asio::io_context ioc;
+    std::vector<std::shared_ptr<TimerSession>> timer_sessions;
+    for (int i = 0; i < num_sessions; ++i) {
+        timer_sessions.push_back(std::make_shared<TimerSession>(ioc));
+        timer_sessions.back()->ResetTimeoutTimer();
+    }
+    auto timers = Run(
+            order,
+            [&](int idx) {
+                timer_sessions[idx]->ResetTimeoutTimer();
+            },
+            [&]() {
+                ioc.poll();
+            });
+
+    TimingWheel<int> wheel(TIMEOUT_SECONDS);
+    std::vector<TimingWheel<int>::Handle> handles;
+    for (int i = 0; i < num_sessions; ++i) {
+        handles.push_back(wheel.Add(i));
+    }
+    int num_expired { 0 };
+    auto wheel_res = Run(
+            order,
+            [&](int idx) {
+                wheel.Touch(handles[idx]);
+            },
+            [&]() {
+                num_expired += wheel.Tick([](int) {});
+            });
+
+    fmt::print("{} sessions, {} messages, a tick per {} messages\n", num_sessions, num_messages, MESSAGES_PER_TICK);
+    fmt::print("{:>24} {:>14} {:>14}\n", "idle timeout", "allocs/msg", "ns/msg");
+    fmt::print("{:>24} {:>14.1f} {:>14.0f}\n", "new timer per message", timers.allocs, timers.nsecs);
+    fmt::print("{:>24} {:>14.1f} {:>14.0f}\n", "timing wheel", wheel_res.allocs, wheel_res.nsecs);
+    if (num_expired > 0) {
+        fmt::print("{} sessions are expired unexpectedly\n", num_expired);
+    }
+    return 0;
+}
@@ -8,6 +8,7 @@
 #include <string>
 
 #include "common_types.h"
+#include "query_handler.h"
 
 struct BlockInfo {
     uint256 hash;
@@ -29,6 +30,11 @@ struct BlockInfo {
 
 using BlockInfoRangeQuerierType = std::function<std::vector<BlockInfo>(int)>;
 
+/**
+ * Query the blocks from the RPC service, the handler is invoked from the loop of the RPC client
+ */
+using BlockInfoRangeAsyncQuerierType = std::function<void(int num_heights, QueryHandler<std::vector<BlockInfo>> handler)>;
+
 using BlockInfoSaverType = std::function<void(BlockInfo const& block_info)>;
 
 #endif
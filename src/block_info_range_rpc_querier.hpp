@@ -3,29 +3,36 @@
 
 #include "common_types.h"
 
-#include "rpc_client.h"
+#include "async_rpc_client.h"
+#include "rpc_metrics.hpp"
 
 #include "block_querier_utils.h"
 
 class BlockInfoRangeRPCQuerier
 {
 public:
-    explicit BlockInfoRangeRPCQuerier(RPCClient& rpc)
+    explicit BlockInfoRangeRPCQuerier(AsyncRPCClient& rpc)
         : rpc_(rpc)
+        , rpc_latency_(GetRPCLatency("queryupdatetiphistory"))
     {
     }
 
-    std::vector<BlockInfo> operator()(int num_heights) const
+    void operator()(int num_heights, QueryHandler<std::vector<BlockInfo>> handler) const
     {
-        auto res = rpc_.Call("queryupdatetiphistory", std::to_string(num_heights));
-        if (!res.result.isObject()) {
+        AsyncQueryRPC(rpc_, rpc_latency_, "queryupdatetiphistory", &BlockInfoRangeRPCQuerier::ConvertResult, std::move(handler), std::to_string(num_heights));
+    }
+
+private:
+    static std::vector<BlockInfo> ConvertResult(UniValue const& result)
+    {
+        if (!result.isObject()) {
             throw std::runtime_error("the return value is not an array");
         }
-        if (!res.result.exists("tips") || !res.result["tips"].isArray()) {
+        if (!result.exists("tips") || !result["tips"].isArray()) {
             throw std::runtime_error("the member `tips` doesn't exist");
         }
         std::vector<BlockInfo> blocks;
-        auto values = res.result["tips"].getValues();
+        auto values = result["tips"].getValues();
         blocks.reserve(values.size());
         for (auto const& block_json : values) {
             blocks.push_back(ConvertToBlockInfo(block_json));
@@ -33,8 +40,8 @@ public:
         return blocks;
     }
 
-private:
-    RPCClient& rpc_;
+    AsyncRPCClient& rpc_;
+    LatencyHistogram& rpc_latency_;
 };
 
 #endif
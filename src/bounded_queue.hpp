@@ -0,0 +1,115 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <cstdint>
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+/**
+ * A bounded lock-free queue, any number of threads can push and pop (the ring with sequence numbers by Dmitry Vyukov)
+ *
+ * The capacity is rounded up to the power of 2, `TryPush` fails instead of waiting when the queue is full
+ */
+template <typename T> class BoundedQueue
+{
+    struct Cell {
+        std::atomic<std::size_t> seq;
+        T data;
+    };
+
+public:
+    explicit BoundedQueue(std::size_t capacity)
+    {
+        std::size_t size { 2 };
+        while (size < capacity) {
+            size *= 2;
+        }
+        mask_ = size - 1;
+        cells_ = std::make_unique<Cell[]>(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(BoundedQueue const&) = delete;
+
+    BoundedQueue& operator=(BoundedQueue const&) = delete;
+
+    std::size_t GetCapacity() const
+    {
+        return mask_ + 1;
+    }
+
+    /**
+     * @return false when the queue is full, the value is untouched
+     */
+    bool TryPush(T&& val)
+    {
+        Cell* cell;
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            std::size_t seq = cell->seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(val);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @return false when the queue is empty
+     */
+    bool TryPop(T& val)
+    {
+        Cell* cell;
+        std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            std::size_t seq = cell->seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        val = std::move(cell->data);
+        cell->data = T();
+        cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * The approximate number of queued values
+     */
+    std::size_t GetSize() const
+    {
+        std::size_t enqueue_pos = enqueue_pos_.load(std::memory_order_relaxed);
+        std::size_t dequeue_pos = dequeue_pos_.load(std::memory_order_relaxed);
+        return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+    }
+
+private:
+    std::size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<std::size_t> enqueue_pos_ { 0 };
+    alignas(64) std::atomic<std::size_t> dequeue_pos_ { 0 };
+};
+
+#endif
@@ -1,25 +1,80 @@
 #include "challenge_monitor.h"
 
 #include <plog/Log.h>
+#include <tinyformat.h>
 
+#include <algorithm>
+
+#include "proof_tracer.h"
 #include "timelord_utils.h"
 
 using boost::system::error_code;
 
-ChallengeMonitor::ChallengeMonitor(asio::io_context& ioc, RPCClient& rpc, int interval_seconds)
+// a pushed challenge can be ahead of the polled one by this number of heights
+static int const MAX_PUSH_HEIGHTS_AHEAD = 1;
+
+// the difficulty of a pushed challenge is within this ratio of the polled one
+static uint64_t const MAX_PUSH_DIFFICULTY_RATIO = 4;
+
+ChallengeMonitor::Node::Node(asio::strand<asio::io_context::executor_type> const& strand, AsyncRPCClient* prpc)
+    : prpc(prpc)
+    , timer(strand)
+    , num_first_reports(MetricsRegistry::GetInstance().GetCounter("timelord_challenge_first_reports_total", "The number of the new challenges reported first by the node", MakeMetricLabel("node", prpc->GetUrl())))
+{
+}
+
+ChallengeMonitor::ChallengeMonitor(asio::io_context& ioc, std::vector<AsyncRPCClient*> const& rpcs, int interval_seconds, int slow_interval_seconds)
     : ioc_(ioc)
-    , timer_(ioc)
-    , rpc_(rpc)
+    , strand_(asio::make_strand(ioc))
     , interval_seconds_(interval_seconds)
+    , slow_interval_seconds_(std::max(interval_seconds, slow_interval_seconds))
+    , latency_(Instrumentation::GetInstance().GetHandlerLatency("challenge_monitor"))
+    , rpc_latency_(GetRPCLatency("querychallenge"))
+    , push_lead_(MetricsRegistry::GetInstance().GetHistogram("timelord_challenge_push_lead_seconds", "How much earlier a challenge is pushed than it is polled"))
+    , num_polled_(MetricsRegistry::GetInstance().GetCounter("timelord_challenge_notices_total", "The number of the new challenges by the way they are noticed", MakeMetricLabel("source", "poll")))
+    , num_pushed_(MetricsRegistry::GetInstance().GetCounter("timelord_challenge_notices_total", "The number of the new challenges by the way they are noticed", MakeMetricLabel("source", "push")))
+    , num_stale_reports_(MetricsRegistry::GetInstance().GetCounter("timelord_challenge_stale_reports_total", "The number of the challenges ignored because the height is not consistent"))
+    , num_inconsistent_pushes_(MetricsRegistry::GetInstance().GetCounter("timelord_challenge_rejected_pushes_total", "The number of the pushed challenges those are rejected", MakeMetricLabel("reason", "inconsistent")))
+    , num_overridden_pushes_(MetricsRegistry::GetInstance().GetCounter("timelord_challenge_overridden_pushes_total", "The number of the pushed challenges those are overridden by the polls"))
 {
     MakeZero(challenge_, 0);
+    nodes_.reserve(rpcs.size());
+    for (auto prpc : rpcs) {
+        nodes_.emplace_back(strand_, prpc);
+    }
 }
 
-uint256 const& ChallengeMonitor::GetCurrentChallenge() const
+uint256 ChallengeMonitor::GetCurrentChallenge() const
 {
+    std::lock_guard<std::mutex> lg(mtx_);
     return challenge_;
 }
 
+ChallengeMonitor::Status ChallengeMonitor::GetStatus() const
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    if (nodes_.empty()) {
+        return Status::NO_ERROR;
+    }
+    for (auto const& node : nodes_) {
+        if (node.status == Status::NO_ERROR) {
+            return Status::NO_ERROR;
+        }
+    }
+    return nodes_.front().status;
+}
+
+std::string ChallengeMonitor::GetErrorString() const
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    for (auto const& node : nodes_) {
+        if (node.status == Status::NO_ERROR) {
+            return "";
+        }
+    }
+    return nodes_.empty() ? "" : nodes_.front().error_string;
+}
+
 void ChallengeMonitor::SetNewChallengeHandler(NewChallengeHandler handler)
 {
     new_challenge_handler_ = std::move(handler);
@@ -30,75 +85,204 @@ void ChallengeMonitor::SetNewVdfReqHandler(NewVdfReqHandler handler)
     new_vdf_req_handler_ = std::move(handler);
 }
 
+void ChallengeMonitor::PushChallenge(uint256 const& challenge, int height, uint64_t difficulty, std::set<uint64_t> vdf_reqs)
+{
+    asio::dispatch(strand_, [this, challenge, height, difficulty, vdf_reqs = std::move(vdf_reqs)]() {
+        ScopedHandlerTimer timer(latency_, "pushchallenge");
+        ApplyChallenge(PUSH_NODE, challenge, height, difficulty, vdf_reqs);
+    });
+}
+
 void ChallengeMonitor::Run()
 {
-    DoQueryNext();
+    asio::dispatch(strand_, [this]() {
+        for (int i = 0; i < static_cast<int>(nodes_.size()); ++i) {
+            DoQueryNext(i);
+        }
+    });
 }
 
 void ChallengeMonitor::Exit()
 {
-    error_code ignored_ec;
-    timer_.cancel(ignored_ec);
+    asio::dispatch(strand_, [this]() {
+        exiting_ = true;
+        for (auto& node : nodes_) {
+            error_code ignored_ec;
+            node.timer.cancel(ignored_ec);
+        }
+    });
 }
 
-void ChallengeMonitor::QueryChallenge()
+void ChallengeMonitor::HandleQueryChallenge(int node, std::exception_ptr perr, UniValue const& result)
 {
     try {
-        RPCClient::Result result = rpc_.Call("querychallenge");
-        uint256 challenge = Uint256FromHex(result.result["challenge"].get_str());
-        uint64_t difficulty = result.result["difficulty"].get_int64();
-        int height = result.result["target_height"].get_int();
+        if (perr) {
+            std::rethrow_exception(perr);
+        }
+        uint256 challenge = Uint256FromHex(result["challenge"].get_str());
+        uint64_t difficulty = result["difficulty"].get_int64();
+        int height = result["target_height"].get_int();
         // save vdf_reqs
         std::set<uint64_t> new_vdf_reqs;
-        if (result.result.exists("vdf_reqs")) {
-            auto vdf_req_objs = result.result["vdf_reqs"];
+        if (result.exists("vdf_reqs")) {
+            auto vdf_req_objs = result["vdf_reqs"];
             if (vdf_req_objs.isArray()) {
                 for (auto iters_obj : vdf_req_objs.getValues()) {
                     new_vdf_reqs.insert(iters_obj.get_int64());
                 }
             }
         }
-        if (new_vdf_reqs != vdf_reqs_) {
-            vdf_reqs_ = new_vdf_reqs;
-            if (new_vdf_req_handler_) {
-                new_vdf_req_handler_(challenge, new_vdf_reqs);
-            }
-        }
-        if (challenge != challenge_) {
-            auto old_challenge = challenge_;
-            challenge_ = challenge;
-            if (new_challenge_handler_) {
-                new_challenge_handler_(old_challenge, challenge, height, difficulty);
-            }
-        }
-        status_ = Status::NO_ERROR;
-        error_string_.clear();
-    } catch (NetError const& e) {
-        status_ = Status::RPC_ERROR;
-        error_string_ = e.what();
-        PLOGE << "NetError: " << e.what();
+        ApplyChallenge(node, challenge, height, difficulty, new_vdf_reqs);
+        SetStatus(node, Status::NO_ERROR, "");
+    } catch (RPCNetError const& e) {
+        SetStatus(node, Status::RPC_ERROR, e.what());
+        PLOGE << "RPCNetError: " << e.what();
     } catch (std::exception const& e) {
-        status_ = Status::OTHER_ERROR;
-        error_string_ = e.what();
+        SetStatus(node, Status::OTHER_ERROR, e.what());
         PLOGE << "exception: " << e.what();
     }
 }
 
-void ChallengeMonitor::DoQueryNext()
+void ChallengeMonitor::ApplyChallenge(int node, uint256 const& challenge, int height, uint64_t difficulty, std::set<uint64_t> const& reported_vdf_reqs)
 {
-    // ready
-    QueryChallenge();
-    timer_.expires_after(std::chrono::seconds(interval_seconds_));
-    timer_.async_wait([this](error_code const& ec) {
-        if (ec) {
-            if (ec != asio::error::operation_aborted) {
-                PLOGE << ec.message();
-            } else {
-                PLOGD << "timer aborted";
-            }
+    if (node == PUSH_NODE) {
+        if (!IsPushConsistent(height, difficulty)) {
+            PLOGW << tinyformat::format("the pushed challenge (height=%d, difficulty=%d) is rejected, polled height=%d, difficulty=%d", height, difficulty, polled_height_, polled_difficulty_);
+            num_inconsistent_pushes_.Inc();
+            return;
+        }
+    } else if (height >= polled_height_) {
+        polled_height_ = height;
+        polled_difficulty_ = difficulty;
+    }
+    bool is_current = challenge == challenge_;
+    if (!is_current) {
+        // an unconfirmed push is overridden by the poll which is issued after it, the poll in flight may not know it yet
+        bool overrides_push = node != PUSH_NODE && !push_confirmed_ && nodes_[node].queried_at > pushed_at_;
+        if (overrides_push) {
+            PLOGW << tinyformat::format("the pushed challenge (height=%d) is overridden by %s (height=%d)", height_, GetNodeName(node), height);
+            num_overridden_pushes_.Inc();
+        } else if (height < height_ || (height == height_ && node != challenge_node_ && node != PUSH_NODE)) {
+            // the challenge from a lagging node or a competing tip of the same height is ignored, the pushed one is trusted
+            PLOGD << tinyformat::format("the challenge (height=%d) from %s is ignored, current height=%d", height, GetNodeName(node), height_);
+            num_stale_reports_.Inc();
             return;
         }
-        // next
-        DoQueryNext();
+    }
+    bool vdf_reqs_changed, challenge_changed;
+    uint256 old_challenge;
+    std::set<uint64_t> new_vdf_reqs;
+    {
+        std::lock_guard<std::mutex> lg(mtx_);
+        challenge_changed = !is_current;
+        if (challenge_changed) {
+            vdf_reqs_.clear();
+        }
+        // the requests of the same challenge are merged from all nodes
+        auto num_vdf_reqs = vdf_reqs_.size();
+        vdf_reqs_.insert(std::cbegin(reported_vdf_reqs), std::cend(reported_vdf_reqs));
+        vdf_reqs_changed = vdf_reqs_.size() != num_vdf_reqs;
+        new_vdf_reqs = vdf_reqs_;
+        old_challenge = challenge_;
+        challenge_ = challenge;
+    }
+    if (challenge_changed) {
+        height_ = height;
+        challenge_node_ = node;
+    }
+    if (node == PUSH_NODE) {
+        if (challenge_changed) {
+            num_pushed_.Inc();
+            pushed_at_ = std::chrono::steady_clock::now();
+            push_confirmed_ = false;
+        }
+        pushed_ = true;
+    } else if (challenge_changed) {
+        push_confirmed_ = true;
+        num_polled_.Inc();
+        nodes_[node].num_first_reports.Inc();
+        if (pushed_) {
+            // the node didn't push this one, poll at the normal interval until it pushes again
+            PLOGW << "the new challenge is not pushed from the node, polling at the normal interval";
+            pushed_ = false;
+        }
+    } else if (!push_confirmed_) {
+        // the first poll confirms the pushed challenge
+        push_lead_.Record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - pushed_at_).count());
+        push_confirmed_ = true;
+    }
+    if (challenge_changed) {
+        ProofTracer::GetInstance().MarkChallenge(challenge, ProofStage::CHALLENGE_OBSERVED);
+        // the cached results of the nodes are out of date
+        for (auto& node : nodes_) {
+            node.prpc->SetChainHeight(height);
+        }
+    }
+    // the handlers are invoked without holding the lock
+    if (vdf_reqs_changed && new_vdf_req_handler_) {
+        new_vdf_req_handler_(challenge, new_vdf_reqs);
+    }
+    if (challenge_changed && new_challenge_handler_) {
+        new_challenge_handler_(old_challenge, challenge, height, difficulty);
+    }
+}
+
+bool ChallengeMonitor::IsPushConsistent(int height, uint64_t difficulty) const
+{
+    if (polled_height_ == 0) {
+        return false;
+    }
+    if (height < polled_height_ || height > polled_height_ + MAX_PUSH_HEIGHTS_AHEAD) {
+        return false;
+    }
+    return difficulty / MAX_PUSH_DIFFICULTY_RATIO <= polled_difficulty_ && polled_difficulty_ / MAX_PUSH_DIFFICULTY_RATIO <= difficulty;
+}
+
+int ChallengeMonitor::GetIntervalSeconds() const
+{
+    // keep polling at the normal interval until the push is confirmed
+    return pushed_ && push_confirmed_ ? slow_interval_seconds_ : interval_seconds_;
+}
+
+void ChallengeMonitor::SetStatus(int node, Status status, std::string error_string)
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    nodes_[node].status = status;
+    nodes_[node].error_string = std::move(error_string);
+}
+
+std::string ChallengeMonitor::GetNodeName(int node) const
+{
+    return node == PUSH_NODE ? "push" : nodes_[node].prpc->GetUrl();
+}
+
+void ChallengeMonitor::DoQueryNext(int node)
+{
+    // the result is handled on our strand, the loop is never blocked by the RPC service
+    nodes_[node].queried_at = std::chrono::steady_clock::now();
+    AsyncCallRPC(*nodes_[node].prpc, rpc_latency_, "querychallenge", [this, node](std::exception_ptr perr, UniValue const& result) {
+        asio::dispatch(strand_, [this, node, perr, result]() {
+            {
+                ScopedHandlerTimer timer(latency_, "querychallenge");
+                HandleQueryChallenge(node, perr, result);
+            }
+            if (exiting_) {
+                return;
+            }
+            auto& timer = nodes_[node].timer;
+            timer.expires_after(std::chrono::seconds(GetIntervalSeconds()));
+            timer.async_wait([this, node](error_code const& ec) {
+                if (ec) {
+                    if (ec != asio::error::operation_aborted) {
+                        PLOGE << ec.message();
+                    } else {
+                        PLOGD << "timer aborted";
+                    }
+                    return;
+                }
+                // next
+                DoQueryNext(node);
+            });
+        });
     });
 }
@@ -4,17 +4,37 @@
 #include <boost/asio.hpp>
 namespace asio = boost::asio;
 
+#include <chrono>
+#include <exception>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <tuple>
+#include <vector>
 
 #include <string>
 #include <string_view>
 
 #include "common_types.h"
-
-#include <rpc_client.h>
-
+#include "instrumentation.h"
+#include "metrics.h"
+
+#include "async_rpc_client.h"
+
+#include "rpc_metrics.hpp"
+
+/**
+ * Polls the challenge from RPC service asynchronously on its own strand, the current challenge and the status can be read from any thread
+ *
+ * Each node is polled independently, so a lagging node never delays the others. The first report of a new challenge wins,
+ * the reports of a lower height are ignored, and a different challenge at the same height is only accepted from the node
+ * which reported the current one or from a push (a reorg). The vdf_reqs of the current challenge are merged from all nodes
+ *
+ * The node can also push the new challenge through `PushChallenge`, it goes through the same path as the polled one. The
+ * push is only applied when its height and difficulty are close to the polled ones, and it is trusted until the first poll
+ * issued after it: the poll confirms it or overrides it. Once a pushed challenge is confirmed the polling slows down to
+ * `slow_interval_seconds` as a fallback, it speeds up again when the polling finds a change that was not pushed
+ */
 class ChallengeMonitor
 {
 public:
@@ -24,22 +44,20 @@ public:
 
     using NewVdfReqHandler = std::function<void(uint256 const& challenge, std::set<uint64_t> const& vdf_reqs)>;
 
-    ChallengeMonitor(asio::io_context& ioc, RPCClient& rpc, int interval_seconds);
+    ChallengeMonitor(asio::io_context& ioc, std::vector<AsyncRPCClient*> const& rpcs, int interval_seconds, int slow_interval_seconds = 0);
 
-    uint256 const& GetCurrentChallenge() const;
+    uint256 GetCurrentChallenge() const;
 
-    Status GetStatus() const
-    {
-        return status_;
-    }
+    /**
+     * The status is good when any of the nodes is good, otherwise it is the status of the first node
+     */
+    Status GetStatus() const;
 
-    std::string GetErrorString() const
-    {
-        return error_string_;
-    }
+    std::string GetErrorString() const;
 
-    std::set<uint64_t> const& GetVdfReqs() const
+    std::set<uint64_t> GetVdfReqs() const
     {
+        std::lock_guard<std::mutex> lg(mtx_);
         return vdf_reqs_;
     }
 
@@ -47,22 +65,66 @@ public:
 
     void SetNewVdfReqHandler(NewVdfReqHandler handler);
 
+    void PushChallenge(uint256 const& challenge, int height, uint64_t difficulty, std::set<uint64_t> vdf_reqs);
+
     void Run();
 
     void Exit();
 
 private:
-    void QueryChallenge();
+    static int const PUSH_NODE = -1;
+
+    struct Node {
+        Node(asio::strand<asio::io_context::executor_type> const& strand, AsyncRPCClient* prpc);
+
+        AsyncRPCClient* prpc;
+        asio::steady_timer timer;
+        Status status { Status::NO_ERROR };
+        std::string error_string;
+        Counter& num_first_reports;
+        std::chrono::steady_clock::time_point queried_at;
+    };
+
+    void HandleQueryChallenge(int node, std::exception_ptr perr, UniValue const& result);
+
+    void ApplyChallenge(int node, uint256 const& challenge, int height, uint64_t difficulty, std::set<uint64_t> const& reported_vdf_reqs);
+
+    /**
+     * @return false if the pushed challenge is too far from the last polled one, or nothing is polled yet
+     */
+    bool IsPushConsistent(int height, uint64_t difficulty) const;
+
+    int GetIntervalSeconds() const;
+
+    void DoQueryNext(int node);
+
+    void SetStatus(int node, Status status, std::string error_string);
 
-    void DoQueryNext();
+    std::string GetNodeName(int node) const;
 
     asio::io_context& ioc_;
-    asio::steady_timer timer_;
-    RPCClient& rpc_;
-    Status status_ { Status::NO_ERROR };
-    std::string error_string_;
+    asio::strand<asio::io_context::executor_type> strand_;
+    std::vector<Node> nodes_;
+    mutable std::mutex mtx_;
     int interval_seconds_;
+    int slow_interval_seconds_;
+    bool exiting_ { false };
+    bool pushed_ { false };
+    std::chrono::steady_clock::time_point pushed_at_;
+    bool push_confirmed_ { true };
+    LatencyHistogram& latency_;
+    LatencyHistogram& rpc_latency_;
+    LatencyHistogram& push_lead_;
+    Counter& num_polled_;
+    Counter& num_pushed_;
+    Counter& num_stale_reports_;
+    Counter& num_inconsistent_pushes_;
+    Counter& num_overridden_pushes_;
     uint256 challenge_;
+    int height_ { 0 };
+    int challenge_node_ { PUSH_NODE };
+    int polled_height_ { 0 };
+    uint64_t polled_difficulty_ { 0 };
     std::set<uint64_t> vdf_reqs_;
     NewChallengeHandler new_challenge_handler_;
     NewVdfReqHandler new_vdf_req_handler_;
@@ -0,0 +1,96 @@
+#include "challenge_request_index.h"
+
+#include <algorithm>
+
+#include <plog/Log.h>
+#include <tinyformat.h>
+
+#include "timelord_utils.h"
+
+ChallengeRequestIndex::ChallengeRequestIndex(int max_depth)
+    : max_depth_(std::max(max_depth, 1))
+{
+}
+
+bool ChallengeRequestIndex::Add(uint256 const& challenge, FrontEndSessionPtr psession, uint64_t iters, uint256 const& group_hash, uint64_t total_size)
+{
+    auto it = challenges_.find(challenge);
+    if (it == std::end(challenges_)) {
+        std::tie(it, std::ignore) = challenges_.try_emplace(challenge, Entry { generation_, {} });
+    }
+    auto& reqs = it->second.reqs;
+    auto range = reqs.equal_range(iters);
+    for (auto i = range.first; i != range.second; ++i) {
+        if (i->second.session_id == psession->GetId()) {
+            // the session has already requested the iters
+            return false;
+        }
+    }
+    auto req_it = reqs.insert(range.second, std::make_pair(iters, Request { std::weak_ptr(psession), psession->GetId(), iters, group_hash, total_size }));
+    session_handles_[psession->GetId()].push_back({ challenge, req_it });
+    ++num_of_reqs_;
+    return true;
+}
+
+void ChallengeRequestIndex::RemoveSession(uint64_t session_id)
+{
+    auto it = session_handles_.find(session_id);
+    if (it == std::end(session_handles_)) {
+        return;
+    }
+    for (auto const& handle : it->second) {
+        auto it_challenge = challenges_.find(handle.challenge);
+        assert(it_challenge != std::end(challenges_));
+        it_challenge->second.reqs.erase(handle.it);
+        --num_of_reqs_;
+    }
+    PLOGD << "total " << it->second.size() << " request(s) are removed with the session";
+    session_handles_.erase(it);
+}
+
+void ChallengeRequestIndex::NewChallenge(uint256 const& challenge)
+{
+    ++generation_;
+    auto it = challenges_.find(challenge);
+    if (it != std::end(challenges_)) {
+        it->second.generation = generation_;
+    }
+    for (auto i = std::begin(challenges_); i != std::end(challenges_);) {
+        if (i->second.generation + max_depth_ < generation_) {
+            i = Evict(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+ChallengeRequestIndex::Requests const* ChallengeRequestIndex::Find(uint256 const& challenge) const
+{
+    auto it = challenges_.find(challenge);
+    if (it == std::cend(challenges_)) {
+        return nullptr;
+    }
+    return &it->second.reqs;
+}
+
+ChallengeRequestIndex::Challenges::iterator ChallengeRequestIndex::Evict(Challenges::iterator it)
+{
+    for (auto const& [iters, req] : it->second.reqs) {
+        auto it_handles = session_handles_.find(req.session_id);
+        if (it_handles == std::end(session_handles_)) {
+            continue;
+        }
+        auto& handles = it_handles->second;
+        handles.erase(std::remove_if(std::begin(handles), std::end(handles),
+                              [&it](Handle const& handle) {
+                                  return handle.challenge == it->first;
+                              }),
+                std::end(handles));
+        if (handles.empty()) {
+            session_handles_.erase(it_handles);
+        }
+    }
+    PLOGD << tinyformat::format("evicting %d request(s) of challenge %s", it->second.reqs.size(), Uint256ToHex(it->first));
+    num_of_reqs_ -= it->second.reqs.size();
+    return challenges_.erase(it);
+}
@@ -0,0 +1,120 @@
+#ifndef TL_CHALLENGE_REQUEST_INDEX_H
+#define TL_CHALLENGE_REQUEST_INDEX_H
+
+#include <cstdint>
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "common_types.h"
+#include "flat_hash_map.hpp"
+
+#include "frontend.h"
+
+/**
+ * Keeps the requests from the sessions for each challenge, the requests of a challenge are ordered by iters
+ *
+ * The sessions are identified by their ids, a request added after its session is removed stays until the challenge is
+ * evicted, it never blocks the requests of a new session even if the new one is created at the same address
+ */
+class ChallengeRequestIndex
+{
+public:
+    struct Request {
+        std::weak_ptr<FrontEndSession> pweak_session;
+        uint64_t session_id;
+        uint64_t iters;
+        uint256 group_hash;
+        uint64_t total_size;
+    };
+
+    using Requests = std::multimap<uint64_t, Request>;
+
+    /**
+     * @param max_depth A challenge is evicted when there are more than `max_depth` newer challenges
+     */
+    explicit ChallengeRequestIndex(int max_depth);
+
+    /**
+     * Mark the session with the challenge
+     *
+     * @return false when the session has already requested the same iters on the challenge
+     */
+    bool Add(uint256 const& challenge, FrontEndSessionPtr psession, uint64_t iters, uint256 const& group_hash, uint64_t total_size);
+
+    /**
+     * Remove all requests those were sent by the session
+     */
+    void RemoveSession(uint64_t session_id);
+
+    /**
+     * The challenge becomes the current one, challenges those are too old will be evicted
+     */
+    void NewChallenge(uint256 const& challenge);
+
+    /**
+     * Find all requests are sent to the challenge
+     *
+     * @return nullptr when there is no request for the challenge
+     */
+    Requests const* Find(uint256 const& challenge) const;
+
+    /**
+     * Invoke the handler with all requests those iters are less than or equal to `iters`
+     *
+     * @return true if there are more requests with bigger iters
+     */
+    template <typename Handler> bool ForEachUpTo(uint256 const& challenge, uint64_t iters, Handler&& handler) const
+    {
+        auto it = challenges_.find(challenge);
+        if (it == std::cend(challenges_)) {
+            return false;
+        }
+        auto const& reqs = it->second.reqs;
+        auto end = reqs.upper_bound(iters);
+        for (auto i = std::cbegin(reqs); i != end; ++i) {
+            handler(i->second);
+        }
+        return end != std::cend(reqs);
+    }
+
+    std::size_t GetSize() const
+    {
+        return num_of_reqs_;
+    }
+
+    std::size_t GetNumOfChallenges() const
+    {
+        return challenges_.size();
+    }
+
+private:
+    struct Entry {
+        uint64_t generation;
+        Requests reqs;
+    };
+
+    // the entries are moved when the table grows, the iterators of the requests are still valid because the nodes are moved
+    // along with the multimap
+    struct Handle {
+        uint256 challenge;
+        Requests::iterator it;
+    };
+
+    using Challenges = FlatHashMap<uint256, Entry>;
+
+    /**
+     * @return The iterator to the next challenge
+     */
+    Challenges::iterator Evict(Challenges::iterator it);
+
+    int max_depth_;
+    uint64_t generation_ { 0 };
+    std::size_t num_of_reqs_ { 0 };
+    Challenges challenges_;
+    std::unordered_map<uint64_t, std::vector<Handle>> session_handles_;
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef EVENT_BUS_HPP
+#define EVENT_BUS_HPP
+
+#include <cstdint>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#include <string>
+
+#include "asio_defs.hpp"
+
+#include "event_queue_stats.h"
+#include "instrumentation.h"
+#include "loop_bridge.h"
+#include "metrics.h"
+
+/**
+ * A typed publish/subscribe bus, each subscriber has its own bounded queue and the events are handled on the executor of
+ * the subscriber, so the publisher never runs the handlers and never waits on a slow subscriber. The handlers are timed
+ * as the handler latency of the subscriber
+ *
+ * An event type must have the static members `NAME` and `DROPPABLE`. The queue of a subscriber never grows over its
+ * capacity: a droppable event is dropped and counted when the queue is full, the others are moved to the unbounded
+ * overflow list of the subscription and delivered in order. All subscriptions must be made before the first event is
+ * published
+ */
+class EventBus
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct SubscriptionBase {
+        SubscriptionBase(std::string subscriber, char const* event_name, asio::any_io_executor executor, std::size_t capacity)
+            : subscriber(std::move(subscriber))
+            , event_name(event_name)
+            , bridge(std::move(executor), capacity)
+            , capacity(capacity)
+            , latency(Instrumentation::GetInstance().GetHandlerLatency(this->subscriber))
+            , num_drops(MetricsRegistry::GetInstance().GetCounter("timelord_event_drops_total", "The number of the events dropped because the queue of the subscriber is full", MakeMetricLabel("subscriber", this->subscriber) + "," + MakeMetricLabel("event", event_name)))
+        {
+        }
+
+        virtual ~SubscriptionBase() = default;
+
+        void UpdateLag(Clock::time_point published_at)
+        {
+            int64_t lag_usecs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - published_at).count();
+            last_lag_usecs = lag_usecs;
+            if (lag_usecs > max_lag_usecs) {
+                max_lag_usecs = lag_usecs;
+            }
+            ++num_delivered;
+        }
+
+        std::string subscriber;
+        char const* event_name;
+        LoopBridge bridge;
+        std::size_t capacity;
+        LatencyHistogram& latency;
+        Counter& num_drops;
+        std::atomic_uint64_t num_delivered { 0 };
+        std::atomic_int64_t last_lag_usecs { 0 };
+        std::atomic_int64_t max_lag_usecs { 0 };
+    };
+
+    template <typename Event> struct Subscription : public SubscriptionBase {
+        Subscription(std::string subscriber, asio::any_io_executor executor, std::size_t capacity, std::function<void(Event const&)> handler)
+            : SubscriptionBase(std::move(subscriber), Event::NAME, std::move(executor), capacity)
+            , handler(std::move(handler))
+        {
+        }
+
+        std::function<void(Event const&)> handler;
+    };
+
+public:
+    static std::size_t const DEFAULT_CAPACITY = 1024;
+
+    template <typename Event> void Subscribe(std::string subscriber, asio::any_io_executor executor, std::function<void(Event const&)> handler, std::size_t capacity = DEFAULT_CAPACITY)
+    {
+        auto psub = std::make_shared<Subscription<Event>>(std::move(subscriber), std::move(executor), capacity, std::move(handler));
+        subscriptions_[std::type_index(typeid(Event))].push_back(psub);
+        all_subscriptions_.push_back(std::move(psub));
+    }
+
+    /**
+     * Queue the event to all subscribers of the type, it can be called from any thread
+     */
+    template <typename Event> void Publish(Event event) const
+    {
+        auto it = subscriptions_.find(std::type_index(typeid(Event)));
+        if (it == std::cend(subscriptions_)) {
+            return;
+        }
+        // the event is shared by all subscribers
+        auto pevent = std::make_shared<Event const>(std::move(event));
+        auto published_at = Clock::now();
+        for (auto const& pbase : it->second) {
+            auto psub = std::static_pointer_cast<Subscription<Event>>(pbase);
+            auto task = [psub, pevent, published_at]() {
+                psub->UpdateLag(published_at);
+                ScopedHandlerTimer timer(psub->latency, psub->event_name);
+                psub->handler(*pevent);
+            };
+            if constexpr (Event::DROPPABLE) {
+                if (!psub->bridge.TryPost(std::move(task))) {
+                    psub->num_drops.Inc();
+                }
+            } else {
+                psub->bridge.Post(std::move(task));
+            }
+        }
+    }
+
+    std::vector<EventQueueStats> QueryStats() const
+    {
+        std::vector<EventQueueStats> res;
+        for (auto const& psub : all_subscriptions_) {
+            EventQueueStats stats;
+            stats.subscriber = psub->subscriber;
+            stats.event = psub->event_name;
+            stats.depth = psub->bridge.GetNumOfPendingTasks();
+            stats.capacity = psub->capacity;
+            stats.overflow_depth = psub->bridge.GetNumOfOverflowTasks();
+            stats.num_delivered = psub->num_delivered;
+            stats.num_drops = psub->bridge.GetNumOfDrops();
+            stats.num_overflows = psub->bridge.GetNumOfOverflows();
+            stats.last_lag_usecs = psub->last_lag_usecs;
+            stats.max_lag_usecs = psub->max_lag_usecs;
+            res.push_back(std::move(stats));
+        }
+        return res;
+    }
+
+private:
+    std::unordered_map<std::type_index, std::vector<std::shared_ptr<SubscriptionBase>>> subscriptions_;
+    std::vector<std::shared_ptr<SubscriptionBase>> all_subscriptions_;
+};
+
+#endif
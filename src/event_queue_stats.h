@@ -0,0 +1,24 @@
+#ifndef TL_EVENT_QUEUE_STATS_H
+#define TL_EVENT_QUEUE_STATS_H
+
+#include <cstdint>
+
+#include <string>
+
+struct EventQueueStats {
+    std::string subscriber;
+    std::string event;
+    std::size_t depth;
+    std::size_t capacity;
+    // the lossless events waiting in the unbounded overflow list because the queue is full
+    std::size_t overflow_depth;
+    uint64_t num_delivered;
+    // the droppable events dropped when the queue is full
+    uint64_t num_drops;
+    // the lossless events moved to the overflow list
+    uint64_t num_overflows;
+    int64_t last_lag_usecs;
+    int64_t max_lag_usecs;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "fake_node.h"
+
+FakeNode::FakeNode(asio::io_context& ioc, std::chrono::milliseconds delay)
+    : ioc_(ioc)
+    , acceptor_(ioc, tcp::endpoint(asio::ip::address::from_string("127.0.0.1"), 0))
+    , delay_(delay)
+{
+    DoAccept();
+}
+
+std::string FakeNode::GetUrl() const
+{
+    return "http://127.0.0.1:" + std::to_string(acceptor_.local_endpoint().port());
+}
+
+void FakeNode::SetMethodHandler(std::string method, MethodHandler handler)
+{
+    std::lock_guard<std::mutex> lg(handlers_mtx_);
+    handlers_[std::move(method)] = std::move(handler);
+}
+
+int FakeNode::GetNumRequests() const
+{
+    return num_requests_;
+}
+
+int FakeNode::GetNumCalls() const
+{
+    return num_calls_;
+}
+
+int FakeNode::GetLastBatchSize() const
+{
+    return last_batch_size_;
+}
+
+void FakeNode::DoAccept()
+{
+    auto psession = std::make_shared<Session>(ioc_);
+    acceptor_.async_accept(psession->sock, [this, psession](error_code const& ec) {
+        if (ec) {
+            return;
+        }
+        DoRead(psession);
+        DoAccept();
+    });
+}
+
+void FakeNode::DoRead(SessionPtr psession)
+{
+    psession->req = {};
+    http::async_read(psession->sock, psession->buf, psession->req, [this, psession](error_code const& ec, std::size_t) {
+        if (ec) {
+            return;
+        }
+        ++num_requests_;
+        UniValue body;
+        body.read(psession->req.body());
+        UniValue reply;
+        if (body.isArray()) {
+            last_batch_size_ = body.size();
+            reply = UniValue(UniValue::VARR);
+            for (auto const& call : body.getValues()) {
+                reply.push_back(Answer(call));
+            }
+        } else {
+            last_batch_size_ = 1;
+            reply = Answer(body);
+        }
+        psession->res = {};
+        psession->res.result(http::status::ok);
+        psession->res.version(11);
+        psession->res.keep_alive(true);
+        psession->res.body() = reply.write();
+        psession->res.prepare_payload();
+        psession->timer.expires_after(delay_);
+        psession->timer.async_wait([this, psession](error_code const&) {
+            http::async_write(psession->sock, psession->res, [this, psession](error_code const& ec, std::size_t) {
+                if (!ec) {
+                    DoRead(psession);
+                }
+            });
+        });
+    });
+}
+
+UniValue FakeNode::Answer(UniValue const& call)
+{
+    UniValue reply(UniValue::VOBJ);
+    reply.pushKV("id", call["id"]);
+    auto const& method = call["method"].get_str();
+    MethodHandler handler;
+    {
+        std::lock_guard<std::mutex> lg(handlers_mtx_);
+        auto it = handlers_.find(method);
+        if (it != std::cend(handlers_)) {
+            handler = it->second;
+        }
+    }
+    if (method == "fail" || method == "fail_malformed") {
+        UniValue err(UniValue::VOBJ);
+        err.pushKV("code", -1);
+        if (method == "fail") {
+            err.pushKV("message", "failed");
+        } else {
+            err.pushKV("message", -1);
+        }
+        reply.pushKV("result", UniValue());
+        reply.pushKV("error", err);
+        return reply;
+    }
+    ++num_calls_;
+    reply.pushKV("result", handler ? handler(call["params"]) : UniValue(num_calls_.load()));
+    reply.pushKV("error", UniValue());
+    return reply;
+}
@@ -0,0 +1,78 @@
+#ifndef TL_FAKE_NODE_H
+#define TL_FAKE_NODE_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "asio_defs.hpp"
+
+#include <boost/beast.hpp>
+namespace beast = boost::beast;
+namespace http = beast::http;
+
+#include <univalue.h>
+
+/**
+ * A JSON-RPC service in place of the node for the tests and the load generator, the calls are answered by the handlers of
+ * the methods, a call without the handler is answered with the number of the calls the node has served, the method
+ * `fail` returns an error and `fail_malformed` returns an error without the string of the message
+ */
+class FakeNode
+{
+    struct Session {
+        explicit Session(asio::io_context& ioc)
+            : sock(ioc)
+            , timer(ioc)
+        {
+        }
+
+        tcp::socket sock;
+        asio::steady_timer timer;
+        beast::flat_buffer buf;
+        http::request<http::string_body> req;
+        http::response<http::string_body> res;
+    };
+
+    using SessionPtr = std::shared_ptr<Session>;
+
+public:
+    using MethodHandler = std::function<UniValue(UniValue const& params)>;
+
+    explicit FakeNode(asio::io_context& ioc, std::chrono::milliseconds delay = std::chrono::milliseconds(0));
+
+    std::string GetUrl() const;
+
+    /**
+     * The handler is invoked from the loop of the node, it can be set from any thread
+     */
+    void SetMethodHandler(std::string method, MethodHandler handler);
+
+    int GetNumRequests() const;
+
+    int GetNumCalls() const;
+
+    int GetLastBatchSize() const;
+
+private:
+    void DoAccept();
+
+    void DoRead(SessionPtr psession);
+
+    UniValue Answer(UniValue const& call);
+
+    asio::io_context& ioc_;
+    tcp::acceptor acceptor_;
+    std::chrono::milliseconds delay_;
+    std::mutex handlers_mtx_;
+    std::map<std::string, MethodHandler> handlers_;
+    std::atomic_int num_requests_ { 0 };
+    std::atomic_int num_calls_ { 0 };
+    std::atomic_int last_batch_size_ { 0 };
+};
+
+#endif
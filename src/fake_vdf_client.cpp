@@ -0,0 +1,197 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "asio_defs.hpp"
+
+/**
+ * A vdf_client which calculates nothing, it speaks the protocol of vdf_client and returns a fake proof of the iters after
+ * the time the real one takes with the speed, the proofs can't be verified. The timelord can be driven by the load
+ * generator without burning the cpu
+ *
+ * usage: fake_vdf_client <addr> <port> <counter>
+ */
+
+namespace
+{
+
+constexpr uint64_t ITERS_PER_SEC = 100000;
+// the proofs of the larger targets are never returned, the time point would overflow
+constexpr uint64_t MAX_PROOF_SECS = 10 * 365 * 24 * 3600;
+constexpr std::size_t FORM_SIZE = 100;
+constexpr std::size_t PROOF_SIZE = 100;
+
+using Clock = std::chrono::steady_clock;
+
+void PutBigEndian(std::vector<uint8_t>& buf, uint64_t val, int size)
+{
+    for (int i = size - 1; i >= 0; --i) {
+        buf.push_back(static_cast<uint8_t>(val >> (i * 8)));
+    }
+}
+
+/**
+ * The proof is sent as the size of 4 bytes and the hex of the fields
+ */
+std::string MakeProofCommand(uint64_t iters)
+{
+    std::vector<uint8_t> fields;
+    PutBigEndian(fields, iters, 8);
+    PutBigEndian(fields, FORM_SIZE, 8);
+    fields.resize(fields.size() + FORM_SIZE, 0); // y
+    fields.push_back(0); // witness type
+    fields.resize(fields.size() + PROOF_SIZE, 0); // proof
+    static char const* HEX_CHARS = "0123456789abcdef";
+    std::string hex;
+    for (uint8_t b : fields) {
+        hex.push_back(HEX_CHARS[b >> 4]);
+        hex.push_back(HEX_CHARS[b & 0x0f]);
+    }
+    std::vector<uint8_t> size_buf;
+    PutBigEndian(size_buf, hex.size(), 4);
+    return std::string(std::begin(size_buf), std::end(size_buf)) + hex;
+}
+
+class FakeVdfClient
+{
+public:
+    explicit FakeVdfClient(asio::io_context& ioc)
+        : ioc_(ioc)
+        , s_(ioc)
+    {
+    }
+
+    /**
+     * Receive the challenge and the initial form from the timelord, the iters are accepted after replying OK
+     */
+    void Start(std::string const& addr, unsigned short port)
+    {
+        s_.connect(tcp::endpoint(asio::ip::make_address(addr), port));
+        std::string type = ReadSync(1);
+        // the size of the discriminant is sent with 3 chars, the unused ones are zero
+        std::string disc_size = ReadSync(3);
+        ReadSync(std::atoi(disc_size.c_str()));
+        std::string form_size = ReadSync(1);
+        ReadSync(static_cast<uint8_t>(form_size[0]));
+        start_time_ = Clock::now();
+        Write("OK");
+        DoReadItersNext();
+    }
+
+private:
+    std::string ReadSync(std::size_t size)
+    {
+        std::string buf(size, '\0');
+        asio::read(s_, asio::buffer(buf));
+        return buf;
+    }
+
+    void DoReadItersNext()
+    {
+        // the size of the iters is sent with 2 chars, then the iters in decimal
+        read_buf_.resize(2);
+        asio::async_read(s_, asio::buffer(read_buf_), [this](error_code const& ec, std::size_t) {
+            if (ec) {
+                Close();
+                return;
+            }
+            read_buf_.resize(std::atoi(read_buf_.c_str()));
+            asio::async_read(s_, asio::buffer(read_buf_), [this](error_code const& ec, std::size_t) {
+                if (ec) {
+                    Close();
+                    return;
+                }
+                uint64_t iters = std::strtoull(read_buf_.c_str(), nullptr, 10);
+                if (iters == 0) {
+                    // the timelord replies ACK, then the connection is closed by either side
+                    Write("STOP");
+                    read_buf_.resize(3);
+                    asio::async_read(s_, asio::buffer(read_buf_), [this](error_code const&, std::size_t) {
+                        Close();
+                    });
+                    return;
+                }
+                ScheduleProof(iters);
+                DoReadItersNext();
+            });
+        });
+    }
+
+    void ScheduleProof(uint64_t iters)
+    {
+        auto ptimer = std::make_shared<asio::steady_timer>(ioc_);
+        // the seconds and the remainder are calculated apart, `iters * 1000000` overflows for the large targets
+        uint64_t secs = std::min(iters / ITERS_PER_SEC, MAX_PROOF_SECS);
+        uint64_t usecs = iters % ITERS_PER_SEC * 1000000 / ITERS_PER_SEC;
+        ptimer->expires_at(start_time_ + std::chrono::seconds(secs) + std::chrono::microseconds(usecs));
+        ptimer->async_wait([this, ptimer, iters](error_code const& ec) {
+            if (ec || !s_.is_open()) {
+                return;
+            }
+            Write(MakeProofCommand(iters));
+        });
+    }
+
+    void Write(std::string buf)
+    {
+        bool do_write = sending_.empty();
+        sending_.push_back(std::move(buf));
+        if (do_write) {
+            DoWriteNext();
+        }
+    }
+
+    void DoWriteNext()
+    {
+        asio::async_write(s_, asio::buffer(sending_.front()), [this](error_code const& ec, std::size_t) {
+            if (ec) {
+                Close();
+                return;
+            }
+            sending_.pop_front();
+            if (!sending_.empty()) {
+                DoWriteNext();
+            }
+        });
+    }
+
+    void Close()
+    {
+        // the pending proofs are dropped with the loop
+        ioc_.stop();
+    }
+
+    asio::io_context& ioc_;
+    tcp::socket s_;
+    std::string read_buf_;
+    std::deque<std::string> sending_;
+    Clock::time_point start_time_;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <addr> <port> <counter>" << std::endl;
+        return 1;
+    }
+    try {
+        asio::io_context ioc;
+        FakeVdfClient client(ioc);
+        client.Start(argv[1], static_cast<unsigned short>(std::atoi(argv[2])));
+        ioc.run();
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,444 @@
+#ifndef FLAT_HASH_MAP_HPP
+#define FLAT_HASH_MAP_HPP
+
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common_types.h"
+
+/**
+ * The default hasher of the flat containers, it falls back to std::hash
+ */
+template <typename Key> struct FlatHash : public std::hash<Key> {
+};
+
+/**
+ * Challenges and group hashes are already random, the first 8 bytes are good enough to be the hash
+ */
+template <> struct FlatHash<uint256> {
+    std::size_t operator()(uint256 const& val) const
+    {
+        uint64_t prefix;
+        memcpy(&prefix, val.data(), sizeof(prefix));
+        // mix the bits a little, so the keys those are not really random (e.g. from tests) won't cluster
+        return static_cast<std::size_t>(prefix * 0x9E3779B97F4A7C15ull);
+    }
+};
+
+/**
+ * The low bits of the pointers are always zero, all bits are mixed (the finalizer of MurmurHash3) before they are used as
+ * the hash
+ */
+template <typename T> struct FlatHash<T*> {
+    std::size_t operator()(T* val) const
+    {
+        auto n = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(val));
+        n ^= n >> 33;
+        n *= 0xff51afd7ed558ccdull;
+        n ^= n >> 33;
+        n *= 0xc4ceb9fe1a85ec53ull;
+        n ^= n >> 33;
+        return static_cast<std::size_t>(n);
+    }
+};
+
+/**
+ * An open-addressing hash map with linear probing, all slots are stored in one contiguous array
+ *
+ * A control byte is kept for each slot, it is either empty, deleted or a 7-bit tag of the hash, the keys are only compared
+ * when the tags are matched. Erasing leaves a tombstone, so the iterators of other elements are valid until the next
+ * insertion. Like std::unordered_map, the elements are not ordered.
+ */
+template <typename Key, typename T, typename Hash = FlatHash<Key>, typename KeyEqual = std::equal_to<Key>> class FlatHashMap
+{
+    static constexpr uint8_t CTRL_EMPTY = 0x80;
+    static constexpr uint8_t CTRL_DELETED = 0xfe;
+    static constexpr std::size_t MIN_CAPACITY = 8;
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key const, T>;
+    using size_type = std::size_t;
+
+    template <bool IsConst> class Iterator
+    {
+        friend class FlatHashMap;
+        using MapType = std::conditional_t<IsConst, FlatHashMap const, FlatHashMap>;
+
+        Iterator(MapType* pmap, std::size_t index)
+            : pmap_(pmap)
+            , index_(index)
+        {
+            SkipEmpty();
+        }
+
+        void SkipEmpty()
+        {
+            while (index_ < pmap_->ctrls_.size() && !IsFull(pmap_->ctrls_[index_])) {
+                ++index_;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, value_type const*, value_type*>;
+        using reference = std::conditional_t<IsConst, value_type const&, value_type&>;
+
+        Iterator() = default;
+
+        // non-const iterator can be converted to const iterator
+        template <bool OtherConst, typename = std::enable_if_t<IsConst && !OtherConst>>
+        Iterator(Iterator<OtherConst> const& rhs)
+            : pmap_(rhs.pmap_)
+            , index_(rhs.index_)
+        {
+        }
+
+        reference operator*() const
+        {
+            return *pmap_->slots_[index_];
+        }
+
+        pointer operator->() const
+        {
+            return &*pmap_->slots_[index_];
+        }
+
+        Iterator& operator++()
+        {
+            ++index_;
+            SkipEmpty();
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator res = *this;
+            ++*this;
+            return res;
+        }
+
+        template <bool OtherConst> bool operator==(Iterator<OtherConst> const& rhs) const
+        {
+            return index_ == rhs.index_;
+        }
+
+        template <bool OtherConst> bool operator!=(Iterator<OtherConst> const& rhs) const
+        {
+            return index_ != rhs.index_;
+        }
+
+    private:
+        template <bool> friend class Iterator;
+        MapType* pmap_ { nullptr };
+        std::size_t index_ { 0 };
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatHashMap() = default;
+
+    explicit FlatHashMap(std::size_t capacity)
+    {
+        reserve(capacity);
+    }
+
+    iterator begin()
+    {
+        return iterator(this, 0);
+    }
+
+    iterator end()
+    {
+        return iterator(this, ctrls_.size());
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(this, ctrls_.size());
+    }
+
+    const_iterator cbegin() const
+    {
+        return begin();
+    }
+
+    const_iterator cend() const
+    {
+        return end();
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    void clear()
+    {
+        ctrls_.clear();
+        slots_.clear();
+        size_ = 0;
+        num_deleted_ = 0;
+    }
+
+    /**
+     * Make sure `count` elements can be stored without rehashing
+     */
+    void reserve(std::size_t count)
+    {
+        std::size_t capacity = MIN_CAPACITY;
+        while (capacity * 7 / 8 < count) {
+            capacity *= 2;
+        }
+        if (capacity > ctrls_.size()) {
+            Rehash(capacity);
+        }
+    }
+
+    iterator find(Key const& key)
+    {
+        return iterator(this, FindIndex(key));
+    }
+
+    const_iterator find(Key const& key) const
+    {
+        return const_iterator(this, FindIndex(key));
+    }
+
+    std::size_t count(Key const& key) const
+    {
+        return FindIndex(key) != ctrls_.size() ? 1 : 0;
+    }
+
+    bool contains(Key const& key) const
+    {
+        return count(key) > 0;
+    }
+
+    template <typename... Args> std::pair<iterator, bool> try_emplace(Key const& key, Args&&... args)
+    {
+        std::size_t hash = hasher_(key);
+        std::size_t index = FindIndex(key, hash);
+        if (index != ctrls_.size()) {
+            return std::make_pair(iterator(this, index), false);
+        }
+        if ((size_ + num_deleted_ + 1) * 8 > ctrls_.size() * 7) {
+            // too many slots are used, grow the table or just drop the tombstones
+            Rehash(size_ + 1 > ctrls_.size() * 7 / 16 ? std::max(ctrls_.size() * 2, MIN_CAPACITY) : ctrls_.size());
+        }
+        index = InsertIndex(hash);
+        if (ctrls_[index] == CTRL_DELETED) {
+            --num_deleted_;
+        }
+        ctrls_[index] = MakeTag(hash);
+        slots_[index].emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        ++size_;
+        return std::make_pair(iterator(this, index), true);
+    }
+
+    template <typename V> std::pair<iterator, bool> emplace(Key const& key, V&& val)
+    {
+        return try_emplace(key, std::forward<V>(val));
+    }
+
+    std::pair<iterator, bool> insert(value_type const& val)
+    {
+        return try_emplace(val.first, val.second);
+    }
+
+    template <typename P> std::pair<iterator, bool> insert(P&& val)
+    {
+        return try_emplace(val.first, std::forward<P>(val).second);
+    }
+
+    T& operator[](Key const& key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    /**
+     * Erase the element, the iterators of other elements remain valid
+     *
+     * @return The iterator to the next element
+     */
+    iterator erase(const_iterator it)
+    {
+        EraseIndex(it.index_);
+        return iterator(this, it.index_ + 1);
+    }
+
+    iterator erase(iterator it)
+    {
+        return erase(const_iterator(it));
+    }
+
+    std::size_t erase(Key const& key)
+    {
+        std::size_t index = FindIndex(key);
+        if (index == ctrls_.size()) {
+            return 0;
+        }
+        EraseIndex(index);
+        return 1;
+    }
+
+private:
+    static bool IsFull(uint8_t ctrl)
+    {
+        return (ctrl & 0x80) == 0;
+    }
+
+    static uint8_t MakeTag(std::size_t hash)
+    {
+        return static_cast<uint8_t>(hash >> (sizeof(std::size_t) * 8 - 7));
+    }
+
+    std::size_t FindIndex(Key const& key) const
+    {
+        return FindIndex(key, hasher_(key));
+    }
+
+    std::size_t FindIndex(Key const& key, std::size_t hash) const
+    {
+        if (ctrls_.empty()) {
+            return 0;
+        }
+        std::size_t mask = ctrls_.size() - 1;
+        uint8_t tag = MakeTag(hash);
+        for (std::size_t index = hash & mask;; index = (index + 1) & mask) {
+            uint8_t ctrl = ctrls_[index];
+            if (ctrl == CTRL_EMPTY) {
+                return ctrls_.size();
+            }
+            if (ctrl == tag && key_equal_(slots_[index]->first, key)) {
+                return index;
+            }
+        }
+    }
+
+    std::size_t InsertIndex(std::size_t hash) const
+    {
+        std::size_t mask = ctrls_.size() - 1;
+        std::size_t index = hash & mask;
+        while (IsFull(ctrls_[index])) {
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    void EraseIndex(std::size_t index)
+    {
+        slots_[index].reset();
+        ctrls_[index] = CTRL_DELETED;
+        --size_;
+        ++num_deleted_;
+    }
+
+    void Rehash(std::size_t capacity)
+    {
+        std::vector<uint8_t> ctrls(capacity, CTRL_EMPTY);
+        std::vector<std::optional<value_type>> slots(capacity);
+        std::swap(ctrls, ctrls_);
+        std::swap(slots, slots_);
+        num_deleted_ = 0;
+        for (std::size_t i = 0; i < ctrls.size(); ++i) {
+            if (!IsFull(ctrls[i])) {
+                continue;
+            }
+            std::size_t hash = hasher_(slots[i]->first);
+            std::size_t index = InsertIndex(hash);
+            ctrls_[index] = MakeTag(hash);
+            slots_[index].emplace(std::move(*slots[i]));
+        }
+    }
+
+    std::vector<uint8_t> ctrls_;
+    std::vector<std::optional<value_type>> slots_;
+    std::size_t size_ { 0 };
+    std::size_t num_deleted_ { 0 };
+    Hash hasher_;
+    KeyEqual key_equal_;
+};
+
+/**
+ * A set based on FlatHashMap
+ */
+template <typename Key, typename Hash = FlatHash<Key>, typename KeyEqual = std::equal_to<Key>> class FlatHashSet
+{
+    struct Empty {
+    };
+    using MapType = FlatHashMap<Key, Empty, Hash, KeyEqual>;
+
+public:
+    std::size_t size() const
+    {
+        return map_.size();
+    }
+
+    bool empty() const
+    {
+        return map_.empty();
+    }
+
+    void clear()
+    {
+        map_.clear();
+    }
+
+    void reserve(std::size_t count)
+    {
+        map_.reserve(count);
+    }
+
+    /**
+     * @return true when the key is newly inserted
+     */
+    bool insert(Key const& key)
+    {
+        return map_.try_emplace(key).second;
+    }
+
+    bool contains(Key const& key) const
+    {
+        return map_.contains(key);
+    }
+
+    std::size_t erase(Key const& key)
+    {
+        return map_.erase(key);
+    }
+
+    template <typename Handler> void ForEach(Handler&& handler) const
+    {
+        for (auto const& entry : map_) {
+            handler(entry.first);
+        }
+    }
+
+private:
+    MapType map_;
+};
+
+#endif
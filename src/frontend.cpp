@@ -1,11 +1,14 @@
 #include "frontend.h"
 
+#include <algorithm>
+
 #include <json/reader.h>
 #include <json/value.h>
 
 #include <plog/Log.h>
 #include <tinyformat.h>
 
+#include "frontend_messages.h"
 #include "msg_ids.h"
 
 #include "timelord_utils.h"
@@ -14,15 +17,139 @@ using boost::system::error_code;
 
 static constexpr int RESPOND_TIMEOUT_SECONDS = 120;
 
-FrontEndSession::FrontEndSession(asio::io_context& ioc, tcp::socket&& s)
+static constexpr auto IDLE_TICK_INTERVAL = std::chrono::seconds(1);
+
+static std::atomic_uint64_t g_next_session_id { 0 };
+
+namespace
+{
+
+struct SendQueueMetrics {
+    Gauge& queued_bytes;
+    Gauge& queued_msgs;
+    Counter& dropped_msgs;
+    Counter& over_limit;
+};
+
+SendQueueMetrics& GetSendQueueMetrics()
+{
+    auto& registry = MetricsRegistry::GetInstance();
+    static SendQueueMetrics metrics {
+        registry.GetGauge("timelord_frontend_queued_bytes", "The bytes of the messages queued to be sent by all frontend sessions"),
+        registry.GetGauge("timelord_frontend_queued_messages", "The number of the messages queued to be sent by all frontend sessions"),
+        registry.GetCounter("timelord_frontend_dropped_messages_total", "The number of the queued messages dropped for the slow sessions"),
+        registry.GetCounter("timelord_frontend_send_queue_full_total", "How many times the send queue of a frontend session is over the limit"),
+    };
+    return metrics;
+}
+
+/**
+ * The messages carry the latest state, only the newest one is useful when they are queued
+ */
+bool IsCoalescable(int id)
+{
+    return id == static_cast<int>(TimelordMsgs::PONG) || id == static_cast<int>(TimelordMsgs::SPEED);
+}
+
+/**
+ * The message is read through a const reference, the non-const `operator[]` would insert the missing member
+ */
+bool IsPingWithNonce(Json::Value const& msg)
+{
+    return msg.isMember("nonce") && msg["nonce"].isUInt64();
+}
+
+} // namespace
+
+std::string FrontEndSendQueuePolicyToString(FrontEndSendQueuePolicy policy)
+{
+    switch (policy) {
+    case FrontEndSendQueuePolicy::DROP_OLDEST:
+        return "drop-oldest";
+    case FrontEndSendQueuePolicy::COALESCE:
+        return "coalesce";
+    case FrontEndSendQueuePolicy::DISCONNECT:
+        return "disconnect";
+    }
+    return "{unknown}";
+}
+
+std::optional<FrontEndSendQueuePolicy> FrontEndSendQueuePolicyFromString(std::string_view str)
+{
+    if (str == "drop-oldest") {
+        return FrontEndSendQueuePolicy::DROP_OLDEST;
+    }
+    if (str == "coalesce") {
+        return FrontEndSendQueuePolicy::COALESCE;
+    }
+    if (str == "disconnect") {
+        return FrontEndSendQueuePolicy::DISCONNECT;
+    }
+    return {};
+}
+
+FrontEndFrames::FrontEndFrames(int id, Encoder json_encoder, Encoder binary_encoder)
+    : id_(id)
+{
+    json_.encoder = std::move(json_encoder);
+    binary_.encoder = std::move(binary_encoder);
+}
+
+std::string const& FrontEndFrames::GetFrame(FrontEndEncoding encoding) const
+{
+    LazyFrame& lazy = encoding == FrontEndEncoding::BINARY ? binary_ : json_;
+    std::call_once(lazy.once, [&lazy]() {
+        lazy.frame = lazy.encoder();
+        // the fields captured by the encoder are no longer needed
+        lazy.encoder = nullptr;
+    });
+    return lazy.frame;
+}
+
+FrontEndMessage MakeFrontEndMessage(Json::Value value)
+{
+    int id = value["id"].asInt();
+    auto pvalue = std::make_shared<Json::Value const>(std::move(value));
+    auto json_encoder = [pvalue]() {
+        return EncodeJsonFrame(*pvalue);
+    };
+    auto binary_encoder = [pvalue]() {
+        return EncodeBinaryFrame(*pvalue);
+    };
+    return std::make_shared<FrontEndFrames const>(id, std::move(json_encoder), std::move(binary_encoder));
+}
+
+std::string_view ViewReceivedData(asio::streambuf const& buf, std::size_t size, std::string& scratch)
+{
+    auto bufs = buf.data();
+    auto first = asio::buffer_sequence_begin(bufs);
+    if (first->size() >= size) {
+        return std::string_view(static_cast<char const*>(first->data()), size);
+    }
+    scratch.assign(asio::buffers_begin(bufs), asio::buffers_begin(bufs) + size);
+    return scratch;
+}
+
+FrontEndSession::FrontEndSession(asio::io_context& ioc, tcp::socket&& s, FrontEndIdleWheel* pidle_wheel)
     : ioc_(ioc)
     , s_(std::move(s))
+    , id_(++g_next_session_id)
+    , read_buf_(MAX_FRONTEND_FRAME_SIZE)
+    , pidle_wheel_(pidle_wheel)
 {
+    error_code ec;
+    auto endpoint = s_.remote_endpoint(ec);
+    if (!ec) {
+        remote_addr_ = endpoint.address().to_string();
+    }
     PLOGD << "Session " << AddressToString(this) << " is created";
 }
 
 FrontEndSession::~FrontEndSession()
 {
+    auto& metrics = GetSendQueueMetrics();
+    metrics.queued_bytes.Add(-static_cast<int64_t>(queued_bytes_));
+    metrics.queued_msgs.Add(-static_cast<int64_t>(sending_msgs_.size()));
     PLOGD << "Session " << AddressToString(this) << " is going to be released";
 }
 
@@ -36,39 +163,139 @@ void FrontEndSession::SetErrorHandler(ErrorHandler err_handler)
     err_handler_ = std::move(err_handler);
 }
 
+void FrontEndSession::SetSendQueueLimit(std::size_t max_bytes, FrontEndSendQueuePolicy policy)
+{
+    max_queued_bytes_ = max_bytes;
+    send_queue_policy_ = policy;
+}
+
 void FrontEndSession::Start()
 {
-    ResetTimeoutTimer();
+    if (pidle_wheel_) {
+        idle_handle_ = pidle_wheel_->Add(this);
+    }
     DoReadNext();
 }
 
 void FrontEndSession::SendMessage(Json::Value const& value)
 {
-    bool do_send = sending_msgs_.empty();
-    sending_msgs_.push_back(value.toStyledString());
-    if (do_send) {
-        DoSendNext();
-    }
+    SendMessage(MakeFrontEndMessage(value));
+}
+
+void FrontEndSession::SendMessage(FrontEndMessage msg, WrittenHandler written_handler)
+{
+    asio::dispatch(s_.get_executor(), [self = shared_from_this(), msg = std::move(msg), written_handler = std::move(written_handler)]() mutable {
+        self->QueueMessage(std::move(msg), std::move(written_handler));
+    });
 }
 
 void FrontEndSession::Stop()
 {
-    error_code ignored_ec;
-    if (timeout_timer_) {
-        timeout_timer_->cancel(ignored_ec);
+    if (idle_handle_) {
+        pidle_wheel_->Remove(*idle_handle_);
+        idle_handle_.reset();
     }
+    error_code ignored_ec;
     s_.shutdown(tcp::socket::shutdown_both, ignored_ec);
     s_.close(ignored_ec);
     PLOGD << "Session " << AddressToString(this) << " is closed";
 }
 
+void FrontEndSession::ReportError(FrontEndSessionErrorType type, std::string errs)
+{
+    asio::post(s_.get_executor(), [self = shared_from_this(), type, errs = std::move(errs)]() {
+        if (self->err_handler_) {
+            self->err_handler_(self, type, errs);
+        }
+    });
+}
+
+void FrontEndSession::QueueMessage(FrontEndMessage msg, WrittenHandler written_handler)
+{
+    PendingWrite pending { std::move(msg), encoding_ == FrontEndEncoding::BINARY, std::move(written_handler) };
+    std::size_t size = pending.GetSize();
+    bool do_send = sending_msgs_.empty();
+    // a message is always queued when nothing is being written, no matter how large it is
+    if (!do_send && max_queued_bytes_ > 0 && queued_bytes_ + size > max_queued_bytes_ && !MakeRoomForMessage(pending.msg, size)) {
+        return;
+    }
+    sending_msgs_.push_back(std::move(pending));
+    queued_bytes_ += size;
+    auto& metrics = GetSendQueueMetrics();
+    metrics.queued_bytes.Add(size);
+    metrics.queued_msgs.Add(1);
+    if (do_send) {
+        DoSendNext();
+    }
+}
+
+bool FrontEndSession::MakeRoomForMessage(FrontEndMessage const& msg, std::size_t size)
+{
+    auto& metrics = GetSendQueueMetrics();
+    metrics.over_limit.Inc();
+    std::size_t num_dropped { 0 };
+    if (send_queue_policy_ == FrontEndSendQueuePolicy::DROP_OLDEST) {
+        auto it = std::next(std::begin(sending_msgs_));
+        while (queued_bytes_ + size > max_queued_bytes_ && it != std::end(sending_msgs_)) {
+            it = DropQueuedMessage(it);
+            ++num_dropped;
+        }
+    } else if (send_queue_policy_ == FrontEndSendQueuePolicy::COALESCE) {
+        // keep the newest one of each coalescable message, include the new message
+        std::vector<int> ids;
+        auto keep_newest = [&ids](FrontEndMessage const& msg) {
+            int id = msg->GetId();
+            if (!IsCoalescable(id)) {
+                return true;
+            }
+            if (std::find(std::begin(ids), std::end(ids), id) != std::end(ids)) {
+                return false;
+            }
+            ids.push_back(id);
+            return true;
+        };
+        keep_newest(msg);
+        for (auto it = std::prev(std::end(sending_msgs_)); it != std::begin(sending_msgs_);) {
+            if (keep_newest(it->msg)) {
+                --it;
+            } else {
+                it = std::prev(DropQueuedMessage(it));
+                ++num_dropped;
+            }
+        }
+    }
+    if (num_dropped > 0) {
+        PLOGD << tinyformat::format("session %s is over the send queue limit, %d queued message(s) are dropped", AddressToString(this), num_dropped);
+    }
+    if (queued_bytes_ + size <= max_queued_bytes_ || send_queue_policy_ == FrontEndSendQueuePolicy::DROP_OLDEST) {
+        return true;
+    }
+    PLOGW << tinyformat::format("session %s has %d byte(s) queued in %d message(s), it is too slow and will be closed", AddressToString(this), queued_bytes_, sending_msgs_.size());
+    if (err_handler_) {
+        err_handler_(shared_from_this(), FrontEndSessionErrorType::WRITE, "the send queue is full");
+    }
+    return false;
+}
+
+std::deque<FrontEndSession::PendingWrite>::iterator FrontEndSession::DropQueuedMessage(std::deque<PendingWrite>::iterator it)
+{
+    assert(it != std::begin(sending_msgs_));
+    std::size_t size = it->GetSize();
+    queued_bytes_ -= size;
+    auto& metrics = GetSendQueueMetrics();
+    metrics.queued_bytes.Add(-static_cast<int64_t>(size));
+    metrics.queued_msgs.Add(-1);
+    metrics.dropped_msgs.Inc();
+    return sending_msgs_.erase(it);
+}
+
 void FrontEndSession::DoSendNext()
 {
     assert(!sending_msgs_.empty());
-    send_buf_ = sending_msgs_.front();
-    send_buf_.resize(send_buf_.size() + 1);
-    send_buf_[send_buf_.size()] = '\0';
-    asio::async_write(s_, asio::buffer(send_buf_), [self = shared_from_this()](error_code const& ec, std::size_t bytes_wrote) {
+    // the front message is kept in the queue until it is written, the buffer stays valid
+    auto const& pending = sending_msgs_.front();
+    auto const& frame = pending.msg->GetFrame(pending.binary ? FrontEndEncoding::BINARY : FrontEndEncoding::JSON);
+    asio::async_write(s_, asio::buffer(frame), [self = shared_from_this()](error_code const& ec, std::size_t bytes_wrote) {
         if (ec) {
             if (self->err_handler_) {
                 self->err_handler_(self, FrontEndSessionErrorType::WRITE, ec.message());
@@ -76,8 +303,16 @@ void FrontEndSession::DoSendNext()
             PLOGE << "WRITE: " << ec.message();
             return;
         }
-        assert(bytes_wrote == self->send_buf_.size());
+        auto written_handler = std::move(self->sending_msgs_.front().written_handler);
+        std::size_t size = self->sending_msgs_.front().GetSize();
         self->sending_msgs_.pop_front();
+        self->queued_bytes_ -= size;
+        auto& metrics = GetSendQueueMetrics();
+        metrics.queued_bytes.Add(-static_cast<int64_t>(size));
+        metrics.queued_msgs.Add(-1);
+        if (written_handler) {
+            written_handler();
+        }
         if (!self->sending_msgs_.empty()) {
             self->DoSendNext();
         }
@@ -86,64 +321,190 @@ void FrontEndSession::DoSendNext()
 
 void FrontEndSession::DoReadNext()
 {
+    if (encoding_ == FrontEndEncoding::BINARY) {
+        DoReadNextBinary();
+        return;
+    }
     asio::async_read_until(s_, read_buf_, '\0', [self = shared_from_this()](error_code const& ec, std::size_t bytes_read) {
         if (ec) {
-            if (ec == asio::error::eof) {
-                if (self->err_handler_) {
-                    self->err_handler_(self, FrontEndSessionErrorType::CLOSE, ec.message());
-                }
-                PLOGD << "READ: end of file";
-            } else {
-                if (self->err_handler_) {
-                    self->err_handler_(self, FrontEndSessionErrorType::READ, ec.message());
-                }
-                PLOGE << "READ: " << ec.message();
-            }
+            self->HandleReadError(ec);
             return;
         }
-        std::string result = static_cast<char const*>(self->read_buf_.data().data());
-        self->read_buf_.consume(bytes_read);
-        self->ResetTimeoutTimer();
+        self->TouchIdle();
+        // the message is parsed in place, the data is consumed after it is handled
+        auto text = ViewReceivedData(self->read_buf_, bytes_read - 1, self->read_scratch_);
         try {
-            Json::Value msg = ParseStringToJson(result);
-            // Check if it is ping
-            auto msg_id = msg["id"].asInt();
-            if (msg_id == static_cast<int>(TimelordClientMsgs::PING)) {
-                // Just simply send it back
-                msg["id"] = static_cast<Json::Int>(TimelordMsgs::PONG);
-                self->SendMessage(msg);
-            } else {
-                self->msg_handler_(self, msg);
-            }
+            self->HandleMessage(self->json_reader_.Parse(text));
         } catch (std::exception const& e) {
             PLOGE << "READ: failed to parse string into json: " << e.what();
-            PLOGE << "DATA total=" << bytes_read << ": " << result;
-            self->err_handler_(self, FrontEndSessionErrorType::READ, ec.message());
+            PLOGE << "DATA total=" << bytes_read << ": " << text;
+            self->err_handler_(self, FrontEndSessionErrorType::READ, e.what());
         }
+        self->read_buf_.consume(bytes_read);
         // read next
         self->DoReadNext();
     });
 }
 
-void FrontEndSession::ResetTimeoutTimer()
+void FrontEndSession::DoReadNextBinary()
 {
-    timeout_timer_ = std::make_unique<asio::steady_timer>(ioc_);
-    timeout_timer_->expires_after(std::chrono::seconds(RESPOND_TIMEOUT_SECONDS));
-    timeout_timer_->async_wait([self_weak = std::weak_ptr(shared_from_this())](error_code const& ec) {
-        if (ec) {
-            return;
+    std::size_t frame_size;
+    try {
+        auto prefix = ViewReceivedData(read_buf_, std::min(read_buf_.size(), BINARY_FRAME_PREFIX_SIZE), read_scratch_);
+        frame_size = GetBinaryFrameSize(prefix.data(), prefix.size());
+    } catch (std::exception const& e) {
+        PLOGE << "READ: " << e.what();
+        err_handler_(shared_from_this(), FrontEndSessionErrorType::READ, e.what());
+        return;
+    }
+    // the frame might be received along with the previous one
+    if (read_buf_.size() < frame_size) {
+        asio::async_read(s_, read_buf_, asio::transfer_at_least(frame_size - read_buf_.size()), [self = shared_from_this()](error_code const& ec, std::size_t) {
+            if (ec) {
+                self->HandleReadError(ec);
+                return;
+            }
+            self->DoReadNextBinary();
+        });
+        return;
+    }
+    TouchIdle();
+    auto body = ViewReceivedData(read_buf_, frame_size, read_scratch_).substr(BINARY_FRAME_PREFIX_SIZE);
+    try {
+        Json::Value msg = DecodeBinaryFrame(body);
+        HandleMessage(msg);
+    } catch (std::exception const& e) {
+        PLOGE << "READ: failed to decode the binary frame: " << e.what();
+        err_handler_(shared_from_this(), FrontEndSessionErrorType::READ, e.what());
+    }
+    read_buf_.consume(frame_size);
+    DoReadNext();
+}
+
+void FrontEndSession::HandleReadError(error_code const& ec)
+{
+    if (ec == asio::error::eof) {
+        if (err_handler_) {
+            err_handler_(shared_from_this(), FrontEndSessionErrorType::CLOSE, ec.message());
         }
-        auto self = self_weak.lock();
-        if (self) {
-            self->err_handler_(self, FrontEndSessionErrorType::READ, "timeout");
+        PLOGD << "READ: end of file";
+    } else {
+        if (err_handler_) {
+            err_handler_(shared_from_this(), FrontEndSessionErrorType::READ, ec.message());
         }
-    });
+        PLOGE << "READ: " << ec.message();
+    }
+}
+
+void FrontEndSession::HandleMessage(Json::Value& msg)
+{
+    auto msg_id = msg["id"].asInt();
+    if (msg_id == static_cast<int>(TimelordClientMsgs::PING)) {
+        // Just simply send it back
+        if (msg.size() == 1) {
+            QueueMessage(MakeMsg_Pong(), {});
+        } else if (msg.size() == 2 && IsPingWithNonce(msg)) {
+            QueueMessage(MakeMsg_Pong(msg["nonce"].asUInt64()), {});
+        } else {
+            msg["id"] = static_cast<Json::Int>(TimelordMsgs::PONG);
+            QueueMessage(MakeFrontEndMessage(msg), {});
+        }
+    } else if (msg_id == static_cast<int>(TimelordClientMsgs::ENCODING)) {
+        HandleEncodingRequest(msg);
+    } else {
+        msg_handler_(shared_from_this(), msg);
+    }
+}
+
+void FrontEndSession::HandleEncodingRequest(Json::Value const& msg)
+{
+    auto encoding = FrontEndEncodingFromString(msg["encoding"].asString());
+    if (!encoding) {
+        PLOGW << tinyformat::format("session %s requests an unknown encoding `%s', keep using %s", AddressToString(this), msg["encoding"].asString(), FrontEndEncodingToString(encoding_));
+    }
+    Json::Value ack;
+    ack["id"] = static_cast<Json::Int>(TimelordMsgs::ENCODING_ACK);
+    ack["encoding"] = FrontEndEncodingToString(encoding.value_or(encoding_));
+    QueueMessage(MakeFrontEndMessage(ack), {});
+    if (encoding) {
+        PLOGD << tinyformat::format("session %s switches to %s encoding", AddressToString(this), FrontEndEncodingToString(*encoding));
+        encoding_ = *encoding;
+    }
+}
+
+std::string const& FrontEndSession::GetRemoteAddress() const
+{
+    return remote_addr_;
+}
+
+uint64_t FrontEndSession::GetId() const
+{
+    return id_;
+}
+
+void FrontEndSession::HandleIdleTimeout()
+{
+    idle_handle_.reset();
+    if (err_handler_) {
+        err_handler_(shared_from_this(), FrontEndSessionErrorType::READ, "timeout");
+    }
+}
+
+void FrontEndSession::TouchIdle()
+{
+    if (idle_handle_) {
+        pidle_wheel_->Touch(*idle_handle_);
+    }
+}
+
+void FrontEndSessionRegistry::Add(FrontEndSessionPtr psession)
+{
+    assert(psession->registry_index_ == FrontEndSession::NOT_REGISTERED);
+    psession->registry_index_ = sessions_.size();
+    sessions_.push_back(std::move(psession));
+}
+
+bool FrontEndSessionRegistry::Remove(FrontEndSession* psession)
+{
+    std::size_t index = psession->registry_index_;
+    if (index == FrontEndSession::NOT_REGISTERED) {
+        return false;
+    }
+    assert(index < sessions_.size() && sessions_[index].get() == psession);
+    if (index + 1 != sessions_.size()) {
+        sessions_[index] = std::move(sessions_.back());
+        sessions_[index]->registry_index_ = index;
+    }
+    sessions_.pop_back();
+    psession->registry_index_ = FrontEndSession::NOT_REGISTERED;
+    return true;
+}
+
+std::size_t FrontEndSessionRegistry::GetSize() const
+{
+    return sessions_.size();
+}
+
+std::vector<FrontEndSessionPtr> const& FrontEndSessionRegistry::GetSessions() const
+{
+    return sessions_;
+}
+
+FrontEnd::Acceptor::Acceptor(asio::io_context& ioc, std::size_t idle_timeout_ticks, int index)
+    : ioc(ioc)
+    , strand(asio::make_strand(ioc))
+    , acceptor(strand)
+    , idle_wheel(idle_timeout_ticks)
+    , idle_timer(strand)
+    , accepted_counter(MetricsRegistry::GetInstance().GetCounter("timelord_frontend_accepted_total", "The number of the frontend sessions accepted by each acceptor", MakeMetricLabel("acceptor", std::to_string(index))))
+{
 }
 
 FrontEnd::FrontEnd(asio::io_context& ioc)
-    : ioc_(ioc)
-    , acceptor_(ioc)
+    : idle_timeouts_counter_(MetricsRegistry::GetInstance().GetCounter("timelord_frontend_idle_timeouts_total", "The number of the frontend sessions closed for being idle"))
+    , sessions_gauge_(MetricsRegistry::GetInstance().GetGauge("timelord_frontend_sessions", "The number of the active frontend sessions"))
 {
+    acceptors_.push_back(std::make_unique<Acceptor>(ioc, RESPOND_TIMEOUT_SECONDS / IDLE_TICK_INTERVAL.count(), 0));
 }
 
 void FrontEnd::SetConnectionHandler(FrontEndSession::ConnectionHandler conn_handler)
@@ -161,28 +522,59 @@ void FrontEnd::SetErrorHandler(FrontEndSession::ErrorHandler err_handler)
     err_handler_ = err_handler;
 }
 
+void FrontEnd::SetSendQueueLimit(std::size_t max_bytes, FrontEndSendQueuePolicy policy)
+{
+    max_queued_bytes_ = max_bytes;
+    send_queue_policy_ = policy;
+}
+
+void FrontEnd::SetAcceptorLoops(std::vector<asio::io_context*> const& iocs)
+{
+    for (auto pioc : iocs) {
+        acceptors_.push_back(std::make_unique<Acceptor>(*pioc, RESPOND_TIMEOUT_SECONDS / IDLE_TICK_INTERVAL.count(), acceptors_.size()));
+    }
+}
+
 void FrontEnd::Run(std::string_view addr, unsigned short port)
 {
     // prepare to listen
     tcp::endpoint endpoint(asio::ip::address::from_string(std::string(addr)), port);
-    acceptor_.open(endpoint.protocol());
-    acceptor_.set_option(tcp::acceptor::reuse_address(true));
-    acceptor_.bind(endpoint);
-    acceptor_.listen();
-    PLOGD << "Listening on port: " << port;
-    DoAcceptNext();
+    for (auto& pacceptor : acceptors_) {
+        auto& acceptor = pacceptor->acceptor;
+        acceptor.open(endpoint.protocol());
+        acceptor.set_option(tcp::acceptor::reuse_address(true));
+        if (acceptors_.size() > 1) {
+#ifdef SO_REUSEPORT
+            acceptor.set_option(asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+#else
+            throw std::runtime_error("SO_REUSEPORT isn't supported on this platform, only one acceptor can be opened");
+#endif
+        }
+        acceptor.bind(endpoint);
+        acceptor.listen();
+    }
+    PLOGD << tinyformat::format("Listening on port: %d, total %d acceptor(s)", port, acceptors_.size());
+    for (auto& pacceptor : acceptors_) {
+        asio::dispatch(pacceptor->strand, [this, &acceptor = *pacceptor]() {
+            DoAcceptNext(acceptor);
+            DoIdleTickNext(acceptor);
+        });
+    }
 }
 
 void FrontEnd::Exit()
 {
-    asio::post(ioc_, [this]() {
-        for (auto psession : session_vec_) {
-            psession->Stop();
-        }
-        error_code ignored_ec;
-        acceptor_.cancel(ignored_ec);
-        acceptor_.close(ignored_ec);
-    });
+    for (auto& pacceptor : acceptors_) {
+        asio::post(pacceptor->strand, [&acceptor = *pacceptor]() {
+            for (auto const& psession : acceptor.sessions.GetSessions()) {
+                psession->Stop();
+            }
+            error_code ignored_ec;
+            acceptor.acceptor.cancel(ignored_ec);
+            acceptor.acceptor.close(ignored_ec);
+            acceptor.idle_timer.cancel(ignored_ec);
+        });
+    }
 }
 
 std::size_t FrontEnd::GetNumOfSessions() const
@@ -190,9 +582,9 @@ std::size_t FrontEnd::GetNumOfSessions() const
     return num_of_sessions_;
 }
 
-void FrontEnd::DoAcceptNext()
+void FrontEnd::DoAcceptNext(Acceptor& acceptor)
 {
-    acceptor_.async_accept([this](error_code const& ec, tcp::socket&& s) {
+    acceptor.acceptor.async_accept([this, &acceptor](error_code const& ec, tcp::socket&& s) {
         if (ec) {
             if (err_handler_) {
                 err_handler_({}, FrontEndSessionErrorType::CONNECT, ec.message());
@@ -200,24 +592,46 @@ void FrontEnd::DoAcceptNext()
             PLOGE << "CONNECT: " << ec.message();
             return;
         }
-        auto psession = std::make_shared<FrontEndSession>(ioc_, std::move(s));
-        psession->SetErrorHandler([this](FrontEndSessionPtr psession, FrontEndSessionErrorType type, std::string_view errs) {
+        acceptor.accepted_counter.Inc();
+        auto psession = std::make_shared<FrontEndSession>(acceptor.ioc, std::move(s), &acceptor.idle_wheel);
+        psession->SetErrorHandler([this, &acceptor](FrontEndSessionPtr psession, FrontEndSessionErrorType type, std::string_view errs) {
             psession->Stop();
-            auto it = std::find(std::begin(session_vec_), std::end(session_vec_), psession);
-            if (it != std::end(session_vec_)) {
-                session_vec_.erase(it);
-                num_of_sessions_ = session_vec_.size();
+            if (!acceptor.sessions.Remove(psession.get())) {
+                // the session has been closed and reported
+                return;
             }
+            --num_of_sessions_;
+            sessions_gauge_.Add(-1);
             // report to supervisor
             if (err_handler_) {
                 err_handler_(psession, type, errs);
             }
         });
         psession->SetMessageHandler(msg_handler_);
+        psession->SetSendQueueLimit(max_queued_bytes_, send_queue_policy_);
         psession->Start();
-        session_vec_.push_back(psession);
-        num_of_sessions_ = session_vec_.size();
+        acceptor.sessions.Add(psession);
+        ++num_of_sessions_;
+        sessions_gauge_.Add(1);
         conn_handler_(psession);
-        DoAcceptNext();
+        DoAcceptNext(acceptor);
+    });
+}
+
+void FrontEnd::DoIdleTickNext(Acceptor& acceptor)
+{
+    acceptor.idle_timer.expires_after(IDLE_TICK_INTERVAL);
+    acceptor.idle_timer.async_wait([this, &acceptor](error_code const& ec) {
+        if (ec) {
+            return;
+        }
+        auto num_expired = acceptor.idle_wheel.Tick([](FrontEndSession* psession) {
+            psession->HandleIdleTimeout();
+        });
+        if (num_expired > 0) {
+            PLOGD << tinyformat::format("%d idle frontend session(s) are timeout", num_expired);
+            idle_timeouts_counter_.Inc(num_expired);
+        }
+        DoIdleTickNext(acceptor);
     });
 }
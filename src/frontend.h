@@ -4,30 +4,135 @@
 #include <string>
 #include <string_view>
 
+#include <atomic>
 #include <deque>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
 
 #include <functional>
 
 #include "asio_defs.hpp"
 
-namespace Json
-{
-class Value;
-} // namespace Json
+#include "frontend_codec.h"
+#include "metrics.h"
+#include "timelord_utils.h"
+#include "timing_wheel.hpp"
 
 class FrontEndSession;
 using FrontEndSessionPtr = std::shared_ptr<FrontEndSession>;
+
+/**
+ * The idle timeouts of the sessions, the sessions are touched when messages are received
+ */
+using FrontEndIdleWheel = TimingWheel<FrontEndSession*>;
+
+/**
+ * A message which can be shared by the sessions of either encoding. Each frame is encoded on the first use by a session of
+ * its encoding, a message is never encoded into the encoding no session has negotiated. The frames can be read from any
+ * thread
+ */
+class FrontEndFrames
+{
+    friend class FrameBufferPool;
+
+public:
+    using Encoder = std::function<std::string()>;
+
+    FrontEndFrames(int id, Encoder json_encoder, Encoder binary_encoder);
+
+    FrontEndFrames(FrontEndFrames const&) = delete;
+
+    FrontEndFrames& operator=(FrontEndFrames const&) = delete;
+
+    int GetId() const
+    {
+        return id_;
+    }
+
+    /**
+     * @return The frame of the encoding, the encoder is run on the first call and the errors of it are thrown
+     */
+    std::string const& GetFrame(FrontEndEncoding encoding) const;
+
+    std::string const& GetJson() const
+    {
+        return GetFrame(FrontEndEncoding::JSON);
+    }
+
+    std::string const& GetBinary() const
+    {
+        return GetFrame(FrontEndEncoding::BINARY);
+    }
+
+private:
+    struct LazyFrame {
+        Encoder encoder;
+        std::once_flag once;
+        std::string frame;
+    };
+
+    int id_;
+    mutable LazyFrame json_;
+    mutable LazyFrame binary_;
+};
+
+using FrontEndMessage = std::shared_ptr<FrontEndFrames const>;
+
+FrontEndMessage MakeFrontEndMessage(Json::Value value);
+
+/**
+ * The frames of both encodings are limited to the size, the session is closed when a larger one is received
+ */
+inline constexpr std::size_t MAX_FRONTEND_FRAME_SIZE = BINARY_FRAME_PREFIX_SIZE + MAX_BINARY_FRAME_BODY_SIZE;
+
+/**
+ * View the first bytes of the received data in place, they are copied into the scratch only when they span over the
+ * buffers of the streambuf
+ */
+std::string_view ViewReceivedData(asio::streambuf const& buf, std::size_t size, std::string& scratch);
+
 enum class FrontEndSessionErrorType { CONNECT, READ, WRITE, CLOSE };
 
+/**
+ * What to do when the queued messages of a session are over the limit, the message being written is never dropped
+ *
+ * DROP_OLDEST: Drop the oldest queued messages until the new one fits
+ * COALESCE: Drop the queued PONG and SPEED those are replaced by the newer ones, the session is closed if it is still over
+ * DISCONNECT: Close the session
+ */
+enum class FrontEndSendQueuePolicy { DROP_OLDEST, COALESCE, DISCONNECT };
+
+std::string FrontEndSendQueuePolicyToString(FrontEndSendQueuePolicy policy);
+
+/**
+ * @return The policy, or `std::nullopt` when it is unknown
+ */
+std::optional<FrontEndSendQueuePolicy> FrontEndSendQueuePolicyFromString(std::string_view str);
+
+class FrontEndSessionRegistry;
+
 class FrontEndSession : public std::enable_shared_from_this<FrontEndSession>
 {
+    friend class FrontEndSessionRegistry;
+
+    static constexpr std::size_t NOT_REGISTERED = std::numeric_limits<std::size_t>::max();
+
 public:
     using ConnectionHandler = std::function<void(FrontEndSessionPtr psession)>;
+    // the message is parsed into the reader of the session, it is only valid during the call
     using MessageHandler = std::function<void(FrontEndSessionPtr psession, Json::Value const& msg)>;
     using ErrorHandler = std::function<void(FrontEndSessionPtr psession, FrontEndSessionErrorType type, std::string_view errs)>;
+    using WrittenHandler = std::function<void()>;
 
-    FrontEndSession(asio::io_context& ioc, tcp::socket&& s);
+    /**
+     * @param pidle_wheel The session is closed after it is idle for the timeout of the wheel, it must be accessed from the
+     * executor of the socket, no timeout without it
+     */
+    FrontEndSession(asio::io_context& ioc, tcp::socket&& s, FrontEndIdleWheel* pidle_wheel = nullptr);
 
     ~FrontEndSession();
 
@@ -35,29 +140,139 @@ public:
 
     void SetErrorHandler(ErrorHandler err_handler);
 
+    /**
+     * Limit the bytes of the queued messages, it should be set before the session is started
+     *
+     * @param max_bytes 0 for no limit
+     */
+    void SetSendQueueLimit(std::size_t max_bytes, FrontEndSendQueuePolicy policy);
+
     void Start();
 
+    /**
+     * Send the message to the peer, it can be called from any thread, the message is queued on the executor of the socket
+     */
     void SendMessage(Json::Value const& value);
 
+    /**
+     * @param written_handler It is invoked from the executor of the socket after the message is written completely
+     */
+    void SendMessage(FrontEndMessage msg, WrittenHandler written_handler = {});
+
     void Stop();
 
+    /**
+     * Report the error of the session, it can be called from any thread, the error handler is invoked from the executor of
+     * the socket and the session is closed by it
+     */
+    void ReportError(FrontEndSessionErrorType type, std::string errs);
+
+    /**
+     * @return The address of the peer, it is read when the session is created, empty when it cannot be read
+     */
+    std::string const& GetRemoteAddress() const;
+
+    /**
+     * @return The id of the session, it is never reused in the process, unlike the address of the session object
+     */
+    uint64_t GetId() const;
+
+    /**
+     * The entry of the session is already expired from the idle wheel, the error handler is invoked with the timeout
+     */
+    void HandleIdleTimeout();
+
 private:
+    struct PendingWrite {
+        FrontEndMessage msg;
+        bool binary;
+        WrittenHandler written_handler;
+
+        std::size_t GetSize() const
+        {
+            return msg->GetFrame(binary ? FrontEndEncoding::BINARY : FrontEndEncoding::JSON).size();
+        }
+    };
+
+    /**
+     * Queue the message with the current encoding, it must be called from the executor of the socket
+     */
+    void QueueMessage(FrontEndMessage msg, WrittenHandler written_handler);
+
+    /**
+     * Apply the policy when the queue is over the limit with the new message
+     *
+     * @return false if the message shouldn't be queued
+     */
+    bool MakeRoomForMessage(FrontEndMessage const& msg, std::size_t size);
+
+    /**
+     * Drop the queued message, it must not be the front one which is being written
+     */
+    std::deque<PendingWrite>::iterator DropQueuedMessage(std::deque<PendingWrite>::iterator it);
+
     void DoSendNext();
 
     void DoReadNext();
 
-    void ResetTimeoutTimer();
+    void DoReadNextBinary();
+
+    void HandleReadError(error_code const& ec);
+
+    void HandleMessage(Json::Value& msg);
+
+    /**
+     * The reply is sent with the old encoding, the following messages of both directions use the new one
+     */
+    void HandleEncodingRequest(Json::Value const& msg);
+
+    void TouchIdle();
 
     asio::io_context& ioc_;
     tcp::socket s_;
+    uint64_t id_;
+    std::string remote_addr_;
     asio::streambuf read_buf_;
-    std::string send_buf_;
-    std::deque<std::string> sending_msgs_;
-    std::unique_ptr<asio::steady_timer> timeout_timer_;
+    JsonReader json_reader_;
+    std::string read_scratch_;
+    FrontEndEncoding encoding_ { FrontEndEncoding::JSON };
+    std::deque<PendingWrite> sending_msgs_;
+    std::size_t queued_bytes_ { 0 };
+    std::size_t max_queued_bytes_ { 0 };
+    FrontEndSendQueuePolicy send_queue_policy_ { FrontEndSendQueuePolicy::DISCONNECT };
+    std::size_t registry_index_ { NOT_REGISTERED };
+    FrontEndIdleWheel* pidle_wheel_;
+    std::optional<FrontEndIdleWheel::Handle> idle_handle_;
     MessageHandler msg_handler_;
     ErrorHandler err_handler_;
 };
 
+/**
+ * The sessions of a frontend, each session keeps its index in the registry, it is removed in O(1) by moving the last
+ * session into its place. A session can only be in one registry
+ */
+class FrontEndSessionRegistry
+{
+public:
+    void Add(FrontEndSessionPtr psession);
+
+    /**
+     * @return false if the session isn't in the registry, e.g. it has been removed
+     */
+    bool Remove(FrontEndSession* psession);
+
+    std::size_t GetSize() const;
+
+    std::vector<FrontEndSessionPtr> const& GetSessions() const;
+
+private:
+    std::vector<FrontEndSessionPtr> sessions_;
+};
+
+/**
+ * Accepts the sessions on the strand of each acceptor, the sessions share the strand of their acceptor and the handlers
+ * are also invoked from it
+ */
 class FrontEnd
 {
 public:
@@ -69,6 +284,20 @@ public:
 
     void SetErrorHandler(FrontEndSession::ErrorHandler err_handler);
 
+    /**
+     * The limit is applied to the sessions those are accepted later, see `FrontEndSession::SetSendQueueLimit`
+     */
+    void SetSendQueueLimit(std::size_t max_bytes, FrontEndSendQueuePolicy policy);
+
+    /**
+     * Open one more acceptor on each of the loops, all acceptors listen to the same port with SO_REUSEPORT and the
+     * connections are spread over them by the kernel. Each acceptor has its own sessions and idle wheel, so the handlers
+     * are invoked from all the loops concurrently. It should be called before `Run`
+     *
+     * @param iocs The loops must outlive the sessions, including the ones still held by the handlers
+     */
+    void SetAcceptorLoops(std::vector<asio::io_context*> const& iocs);
+
     void Run(std::string_view addr, unsigned short port);
 
     void Exit();
@@ -76,12 +305,31 @@ public:
     std::size_t GetNumOfSessions() const;
 
 private:
-    void DoAcceptNext();
+    /**
+     * An acceptor with the sessions accepted by it, they are only accessed from the strand
+     */
+    struct Acceptor {
+        Acceptor(asio::io_context& ioc, std::size_t idle_timeout_ticks, int index);
 
-    asio::io_context& ioc_;
-    tcp::acceptor acceptor_;
+        asio::io_context& ioc;
+        asio::strand<asio::io_context::executor_type> strand;
+        tcp::acceptor acceptor;
+        FrontEndIdleWheel idle_wheel;
+        asio::steady_timer idle_timer;
+        FrontEndSessionRegistry sessions;
+        Counter& accepted_counter;
+    };
+
+    void DoAcceptNext(Acceptor& acceptor);
+
+    void DoIdleTickNext(Acceptor& acceptor);
+
+    std::vector<std::unique_ptr<Acceptor>> acceptors_;
+    Counter& idle_timeouts_counter_;
     std::atomic_int num_of_sessions_ { 0 };
-    std::vector<FrontEndSessionPtr> session_vec_;
+    Gauge& sessions_gauge_;
+    std::size_t max_queued_bytes_ { 0 };
+    FrontEndSendQueuePolicy send_queue_policy_ { FrontEndSendQueuePolicy::DISCONNECT };
     FrontEndSession::ConnectionHandler conn_handler_;
     FrontEndSession::MessageHandler msg_handler_;
     FrontEndSession::ErrorHandler err_handler_;
@@ -1,14 +1,18 @@
 #include "frontend_client.h"
 
+#include <algorithm>
+
 #include <fmt/core.h>
 #include <plog/Log.h>
 
+#include "msg_ids.h"
 #include "timelord_utils.h"
 
 using boost::system::error_code;
 
 FrontEndClient::FrontEndClient(asio::io_context& ioc)
     : ioc_(ioc)
+    , read_buf_(MAX_FRONTEND_FRAME_SIZE)
 {
 }
 
@@ -64,20 +68,35 @@ void FrontEndClient::Connect(std::string_view host, unsigned short port)
 
 void FrontEndClient::SendMessage(Json::Value const& msg)
 {
-    if (ps_ == nullptr) {
-        throw std::runtime_error("please connect to server before sending message");
-    }
-    bool do_send = sending_msgs_.empty();
-    sending_msgs_.push_back(msg.toStyledString());
-    if (do_send) {
-        DoSendNext();
-    }
+    QueueFrame(send_encoding_ == FrontEndEncoding::BINARY ? EncodeBinaryFrame(msg) : EncodeJsonFrame(msg));
+}
+
+void FrontEndClient::SendMessage(FrontEndMessage const& msg)
+{
+    QueueFrame(msg->GetFrame(send_encoding_));
+}
+
+void FrontEndClient::RequestEncoding(FrontEndEncoding encoding)
+{
+    Json::Value msg;
+    msg["id"] = static_cast<Json::Int>(TimelordClientMsgs::ENCODING);
+    msg["encoding"] = FrontEndEncodingToString(encoding);
+    SendMessage(msg);
+    send_encoding_ = encoding;
 }
 
 void FrontEndClient::SendShutdown()
 {
+    QueueFrame(std::string("shutdown", sizeof("shutdown")));
+}
+
+void FrontEndClient::QueueFrame(std::string frame)
+{
+    if (ps_ == nullptr) {
+        throw std::runtime_error("please connect to server before sending message");
+    }
     bool do_send = sending_msgs_.empty();
-    sending_msgs_.push_back("shutdown");
+    sending_msgs_.push_back(std::move(frame));
     if (do_send) {
         DoSendNext();
     }
@@ -97,6 +116,10 @@ void FrontEndClient::Exit()
 
 void FrontEndClient::DoReadNext()
 {
+    if (recv_encoding_ == FrontEndEncoding::BINARY) {
+        DoReadNextBinary();
+        return;
+    }
     asio::async_read_until(*ps_, read_buf_, '\0', [this](error_code const& ec, std::size_t bytes) {
         if (ec) {
             if (ec != asio::error::eof) {
@@ -106,27 +129,72 @@ void FrontEndClient::DoReadNext()
             Exit();
             return;
         }
-        std::istreambuf_iterator<char> begin(&read_buf_), end;
-        std::string result(begin, end);
+        // the binary frames might follow in the buffer, only the JSON message is consumed
         try {
-            Json::Value msg = ParseStringToJson(result);
-            msg_handler_(msg);
+            HandleMessage(json_reader_.Parse(ViewReceivedData(read_buf_, bytes - 1, read_scratch_)));
         } catch (std::exception const& e) {
             PLOGE << "READ: " << e.what();
-            err_handler_(FrontEndSessionErrorType::READ, ec.message());
+            err_handler_(FrontEndSessionErrorType::READ, e.what());
         }
+        read_buf_.consume(bytes);
         DoReadNext();
     });
 }
 
+void FrontEndClient::DoReadNextBinary()
+{
+    std::size_t frame_size;
+    try {
+        auto prefix = ViewReceivedData(read_buf_, std::min(read_buf_.size(), BINARY_FRAME_PREFIX_SIZE), read_scratch_);
+        frame_size = GetBinaryFrameSize(prefix.data(), prefix.size());
+    } catch (std::exception const& e) {
+        PLOGE << "READ: " << e.what();
+        err_handler_(FrontEndSessionErrorType::READ, e.what());
+        Exit();
+        return;
+    }
+    if (read_buf_.size() < frame_size) {
+        asio::async_read(*ps_, read_buf_, asio::transfer_at_least(frame_size - read_buf_.size()), [this](error_code const& ec, std::size_t) {
+            if (ec) {
+                if (ec != asio::error::eof) {
+                    PLOGE << ec.message();
+                    err_handler_(FrontEndSessionErrorType::READ, ec.message());
+                }
+                Exit();
+                return;
+            }
+            DoReadNextBinary();
+        });
+        return;
+    }
+    auto body = ViewReceivedData(read_buf_, frame_size, read_scratch_).substr(BINARY_FRAME_PREFIX_SIZE);
+    try {
+        HandleMessage(DecodeBinaryFrame(body));
+    } catch (std::exception const& e) {
+        PLOGE << "READ: " << e.what();
+        err_handler_(FrontEndSessionErrorType::READ, e.what());
+    }
+    read_buf_.consume(frame_size);
+    DoReadNext();
+}
+
+void FrontEndClient::HandleMessage(Json::Value const& msg)
+{
+    if (msg["id"].asInt() == static_cast<int>(TimelordMsgs::ENCODING_ACK)) {
+        auto encoding = FrontEndEncodingFromString(msg["encoding"].asString());
+        if (encoding) {
+            recv_encoding_ = *encoding;
+        }
+    }
+    msg_handler_(msg);
+}
+
 void FrontEndClient::DoSendNext()
 {
     assert(!sending_msgs_.empty());
-    auto const& msg = sending_msgs_.front();
-    send_buf_.resize(msg.size() + 1);
-    memcpy(send_buf_.data(), msg.data(), msg.size());
-    send_buf_[msg.size()] = '\0';
-    asio::async_write(*ps_, asio::buffer(send_buf_), [this](error_code const& ec, std::size_t bytes) {
+    // the front frame is kept in the queue until it is written
+    auto const& frame = sending_msgs_.front();
+    asio::async_write(*ps_, asio::buffer(frame), [this](error_code const& ec, std::size_t bytes) {
         if (ec) {
             err_handler_(FrontEndSessionErrorType::WRITE, ec.message());
             Exit();
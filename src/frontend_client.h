@@ -33,8 +33,19 @@ public:
 
     void Connect(std::string_view host, unsigned short port);
 
+    /**
+     * The message is encoded with the current encoding of the client
+     */
     void SendMessage(Json::Value const& msg);
 
+    void SendMessage(FrontEndMessage const& msg);
+
+    /**
+     * Ask the server to switch the encoding, the following messages are sent with the new encoding, the received
+     * messages are decoded with it after ENCODING_ACK
+     */
+    void RequestEncoding(FrontEndEncoding encoding);
+
     void SendShutdown();
 
     void Exit();
@@ -42,12 +53,21 @@ public:
 private:
     void DoReadNext();
 
+    void DoReadNextBinary();
+
+    void HandleMessage(Json::Value const& msg);
+
+    void QueueFrame(std::string frame);
+
     void DoSendNext();
 
     asio::io_context& ioc_;
     std::unique_ptr<tcp::socket> ps_;
     asio::streambuf read_buf_;
-    std::vector<uint8_t> send_buf_;
+    JsonReader json_reader_;
+    std::string read_scratch_;
+    FrontEndEncoding send_encoding_ { FrontEndEncoding::JSON };
+    FrontEndEncoding recv_encoding_ { FrontEndEncoding::JSON };
     std::deque<std::string> sending_msgs_;
     ConnectionHandler conn_handler_;
     MessageHandler msg_handler_;
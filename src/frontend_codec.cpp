@@ -0,0 +1,370 @@
+#include "frontend_codec.h"
+
+#include <cstring>
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include <json/writer.h>
+
+#include <tinyformat.h>
+
+#include "msg_ids.h"
+#include "timelord_utils.h"
+
+namespace
+{
+
+class FrameWriter
+{
+public:
+    explicit FrameWriter(int id, std::size_t payload_size = 0, std::string buf = {})
+        : buf_(std::move(buf))
+    {
+        buf_.clear();
+        buf_.reserve(BINARY_FRAME_PREFIX_SIZE + 2 + payload_size);
+        buf_.resize(BINARY_FRAME_PREFIX_SIZE);
+        PutInt(static_cast<uint16_t>(id));
+    }
+
+    template <typename T> void PutInt(T val)
+    {
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            buf_.push_back(static_cast<char>((val >> (i * 8)) & 0xff));
+        }
+    }
+
+    template <typename Container> void PutBytes(Container const& bytes)
+    {
+        buf_.append(reinterpret_cast<char const*>(bytes.data()), bytes.size());
+    }
+
+    void PutString(std::string_view str)
+    {
+        buf_.append(str);
+    }
+
+    std::string Finish()
+    {
+        auto body_size = static_cast<uint32_t>(buf_.size() - BINARY_FRAME_PREFIX_SIZE);
+        for (std::size_t i = 0; i < BINARY_FRAME_PREFIX_SIZE; ++i) {
+            buf_[i] = static_cast<char>((body_size >> (i * 8)) & 0xff);
+        }
+        return std::move(buf_);
+    }
+
+private:
+    std::string buf_;
+};
+
+class FrameReader
+{
+public:
+    explicit FrameReader(std::string_view body)
+        : body_(body)
+    {
+    }
+
+    template <typename T> T GetInt()
+    {
+        auto p = Take(sizeof(T));
+        T val { 0 };
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            val |= static_cast<T>(static_cast<uint8_t>(p[i])) << (i * 8);
+        }
+        return val;
+    }
+
+    template <typename Array> void GetArray(Array& arr)
+    {
+        memcpy(arr.data(), Take(arr.size()), arr.size());
+    }
+
+    Bytes GetBytes(std::size_t size)
+    {
+        auto p = reinterpret_cast<uint8_t const*>(Take(size));
+        return Bytes(p, p + size);
+    }
+
+    std::string_view GetRest()
+    {
+        auto rest = body_.substr(pos_);
+        pos_ = body_.size();
+        return rest;
+    }
+
+    void Finish() const
+    {
+        if (pos_ != body_.size()) {
+            throw std::runtime_error(tinyformat::format("the binary frame has %d extra bytes", body_.size() - pos_));
+        }
+    }
+
+private:
+    char const* Take(std::size_t size)
+    {
+        if (body_.size() - pos_ < size) {
+            throw std::runtime_error("the binary frame is truncated");
+        }
+        auto p = body_.data() + pos_;
+        pos_ += size;
+        return p;
+    }
+
+    std::string_view body_;
+    std::size_t pos_ { 0 };
+};
+
+std::size_t GetProofLayoutSize(vdf_client::ProofDetail const& detail)
+{
+    return std::tuple_size_v<VdfForm> + 1 + 8 + 4 + 4 + detail.proof.size();
+}
+
+void PutProof(FrameWriter& writer, vdf_client::ProofDetail const& detail)
+{
+    writer.PutBytes(detail.y);
+    writer.PutInt(detail.witness_type);
+    writer.PutInt(detail.iters);
+    writer.PutInt(static_cast<uint32_t>(detail.duration));
+    writer.PutInt(static_cast<uint32_t>(detail.proof.size()));
+    writer.PutBytes(detail.proof);
+}
+
+vdf_client::ProofDetail GetProof(FrameReader& reader)
+{
+    vdf_client::ProofDetail detail;
+    reader.GetArray(detail.y);
+    detail.witness_type = reader.GetInt<uint8_t>();
+    detail.iters = reader.GetInt<uint64_t>();
+    detail.duration = static_cast<int>(reader.GetInt<uint32_t>());
+    detail.proof = reader.GetBytes(reader.GetInt<uint32_t>());
+    return detail;
+}
+
+vdf_client::ProofDetail ProofFromJson(Json::Value const& msg)
+{
+    vdf_client::ProofDetail detail;
+    detail.y = FormFromHex(msg["y"].asString());
+    detail.proof = BytesFromHex(msg["proof"].asString());
+    detail.witness_type = msg["witness_type"].asInt();
+    detail.iters = msg["iters"].asUInt64();
+    detail.duration = msg["duration"].asInt();
+    return detail;
+}
+
+std::string WriteCompactJson(Json::Value const& msg)
+{
+    // the writer is built once for each thread
+    thread_local std::unique_ptr<Json::StreamWriter> pwriter = []() {
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "";
+        return std::unique_ptr<Json::StreamWriter>(builder.newStreamWriter());
+    }();
+    std::ostringstream os;
+    pwriter->write(msg, &os);
+    return os.str();
+}
+
+} // namespace
+
+void ProofToJson(vdf_client::ProofDetail const& detail, Json::Value& msg)
+{
+    msg["y"] = FormToHex(detail.y);
+    msg["proof"] = BytesToHex(detail.proof);
+    msg["witness_type"] = static_cast<Json::Int>(detail.witness_type);
+    msg["iters"] = static_cast<Json::UInt64>(detail.iters);
+    msg["duration"] = detail.duration;
+}
+
+std::string FrontEndEncodingToString(FrontEndEncoding encoding)
+{
+    switch (encoding) {
+    case FrontEndEncoding::JSON:
+        return "json";
+    case FrontEndEncoding::BINARY:
+        return "binary";
+    }
+    return "{unknown}";
+}
+
+std::optional<FrontEndEncoding> FrontEndEncodingFromString(std::string_view str)
+{
+    if (str == "json") {
+        return FrontEndEncoding::JSON;
+    }
+    if (str == "binary") {
+        return FrontEndEncoding::BINARY;
+    }
+    return {};
+}
+
+std::string EncodeJsonFrame(Json::Value const& msg)
+{
+    std::string frame = WriteCompactJson(msg);
+    frame.push_back('\0');
+    return frame;
+}
+
+std::string EncodeBinaryFrame(Json::Value const& msg)
+{
+    int id = msg["id"].asInt();
+    if (id == static_cast<int>(TimelordClientMsgs::PING) || id == static_cast<int>(TimelordMsgs::PONG)) {
+        return EncodePingFrame(id, msg["nonce"].asUInt64());
+    }
+    if (id == static_cast<int>(TimelordClientMsgs::CALC)) {
+        CalcFrame calc;
+        calc.challenge = Uint256FromHex(msg["challenge"].asString());
+        calc.iters = msg["iters"].asUInt64();
+        MakeZero(calc.group_hash, 0);
+        calc.total_size = 0;
+        if (msg.isMember("netspace") && msg["netspace"].isObject()) {
+            calc.group_hash = Uint256FromHex(msg["netspace"]["group_hash"].asString());
+            calc.total_size = msg["netspace"]["total_size"].asUInt64();
+        }
+        return EncodeCalcFrame(calc);
+    }
+    if (id == static_cast<int>(TimelordMsgs::CALC_REPLY)) {
+        std::optional<vdf_client::ProofDetail> detail;
+        if (msg.isMember("proof")) {
+            detail = ProofFromJson(msg);
+        }
+        return EncodeCalcReplyFrame(msg["calculating"].asBool(), Uint256FromHex(msg["challenge"].asString()), detail ? &*detail : nullptr);
+    }
+    if (id == static_cast<int>(TimelordMsgs::PROOF)) {
+        return EncodeProofFrame(Uint256FromHex(msg["challenge"].asString()), ProofFromJson(msg));
+    }
+    std::string payload = WriteCompactJson(msg);
+    FrameWriter writer(id, payload.size());
+    writer.PutString(payload);
+    return writer.Finish();
+}
+
+std::string EncodePingFrame(int id, uint64_t nonce, std::string buf)
+{
+    FrameWriter writer(id, 8, std::move(buf));
+    writer.PutInt(nonce);
+    return writer.Finish();
+}
+
+std::string EncodeCalcFrame(CalcFrame const& calc)
+{
+    FrameWriter writer(static_cast<int>(TimelordClientMsgs::CALC), 32 + 8 + 32 + 8);
+    writer.PutBytes(calc.challenge);
+    writer.PutInt(calc.iters);
+    writer.PutBytes(calc.group_hash);
+    writer.PutInt(calc.total_size);
+    return writer.Finish();
+}
+
+std::string EncodeCalcReplyFrame(bool calculating, uint256 const& challenge, vdf_client::ProofDetail const* pdetail, std::string buf)
+{
+    FrameWriter writer(static_cast<int>(TimelordMsgs::CALC_REPLY), 1 + 32 + 1 + (pdetail ? GetProofLayoutSize(*pdetail) : 0), std::move(buf));
+    writer.PutInt(static_cast<uint8_t>(calculating));
+    writer.PutBytes(challenge);
+    writer.PutInt(static_cast<uint8_t>(pdetail != nullptr));
+    if (pdetail) {
+        PutProof(writer, *pdetail);
+    }
+    return writer.Finish();
+}
+
+std::string EncodeProofFrame(uint256 const& challenge, vdf_client::ProofDetail const& detail, std::string buf)
+{
+    FrameWriter writer(static_cast<int>(TimelordMsgs::PROOF), 32 + GetProofLayoutSize(detail), std::move(buf));
+    writer.PutBytes(challenge);
+    PutProof(writer, detail);
+    return writer.Finish();
+}
+
+std::size_t GetBinaryFrameSize(char const* data, std::size_t size)
+{
+    if (size < BINARY_FRAME_PREFIX_SIZE) {
+        return BINARY_FRAME_PREFIX_SIZE;
+    }
+    auto body_size = FrameReader(std::string_view(data, BINARY_FRAME_PREFIX_SIZE)).GetInt<uint32_t>();
+    if (body_size < 2 || body_size > MAX_BINARY_FRAME_BODY_SIZE) {
+        throw std::runtime_error(tinyformat::format("invalid size of the binary frame: %d", body_size));
+    }
+    return BINARY_FRAME_PREFIX_SIZE + body_size;
+}
+
+int GetBinaryFrameId(std::string_view body)
+{
+    return FrameReader(body).GetInt<uint16_t>();
+}
+
+CalcFrame DecodeCalcFrame(std::string_view body)
+{
+    FrameReader reader(body);
+    reader.GetInt<uint16_t>();
+    CalcFrame calc;
+    reader.GetArray(calc.challenge);
+    calc.iters = reader.GetInt<uint64_t>();
+    reader.GetArray(calc.group_hash);
+    calc.total_size = reader.GetInt<uint64_t>();
+    reader.Finish();
+    return calc;
+}
+
+CalcReplyFrame DecodeCalcReplyFrame(std::string_view body)
+{
+    FrameReader reader(body);
+    reader.GetInt<uint16_t>();
+    CalcReplyFrame reply;
+    reply.calculating = reader.GetInt<uint8_t>() != 0;
+    reader.GetArray(reply.challenge);
+    if (reader.GetInt<uint8_t>() != 0) {
+        reply.detail = GetProof(reader);
+    }
+    reader.Finish();
+    return reply;
+}
+
+ProofFrame DecodeProofFrame(std::string_view body)
+{
+    FrameReader reader(body);
+    reader.GetInt<uint16_t>();
+    ProofFrame proof;
+    reader.GetArray(proof.challenge);
+    proof.detail = GetProof(reader);
+    reader.Finish();
+    return proof;
+}
+
+Json::Value DecodeBinaryFrame(std::string_view body)
+{
+    int id = GetBinaryFrameId(body);
+    Json::Value msg;
+    if (id == static_cast<int>(TimelordClientMsgs::PING) || id == static_cast<int>(TimelordMsgs::PONG)) {
+        FrameReader reader(body);
+        reader.GetInt<uint16_t>();
+        msg["nonce"] = static_cast<Json::UInt64>(reader.GetInt<uint64_t>());
+        reader.Finish();
+    } else if (id == static_cast<int>(TimelordClientMsgs::CALC)) {
+        auto calc = DecodeCalcFrame(body);
+        msg["challenge"] = Uint256ToHex(calc.challenge);
+        msg["iters"] = static_cast<Json::UInt64>(calc.iters);
+        if (calc.total_size > 0) {
+            msg["netspace"]["group_hash"] = Uint256ToHex(calc.group_hash);
+            msg["netspace"]["total_size"] = static_cast<Json::UInt64>(calc.total_size);
+        }
+    } else if (id == static_cast<int>(TimelordMsgs::CALC_REPLY)) {
+        auto reply = DecodeCalcReplyFrame(body);
+        msg["calculating"] = reply.calculating;
+        msg["challenge"] = Uint256ToHex(reply.challenge);
+        if (reply.detail) {
+            ProofToJson(*reply.detail, msg);
+        }
+    } else if (id == static_cast<int>(TimelordMsgs::PROOF)) {
+        auto proof = DecodeProofFrame(body);
+        msg["challenge"] = Uint256ToHex(proof.challenge);
+        ProofToJson(proof.detail, msg);
+    } else {
+        FrameReader reader(body);
+        reader.GetInt<uint16_t>();
+        msg = ParseStringToJson(reader.GetRest());
+    }
+    msg["id"] = id;
+    return msg;
+}
@@ -0,0 +1,109 @@
+#ifndef TL_FRONTEND_CODEC_H
+#define TL_FRONTEND_CODEC_H
+
+#include <cstdint>
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <json/value.h>
+
+#include "common_types.h"
+#include "proof_detail.h"
+
+/**
+ * The encoding of a frontend connection, JSON is used until the client asks for the binary encoding after READY
+ */
+enum class FrontEndEncoding { JSON, BINARY };
+
+std::string FrontEndEncodingToString(FrontEndEncoding encoding);
+
+/**
+ * @return The encoding, or `std::nullopt` when it is unknown
+ */
+std::optional<FrontEndEncoding> FrontEndEncodingFromString(std::string_view str);
+
+/**
+ * The binary frame is a length prefix (u32) followed by the body: the message id (u16) and the payload, the integers are
+ * little-endian
+ *
+ * PING/PONG, CALC, CALC_REPLY and PROOF have fixed layouts, the proofs and the challenges are raw bytes. The payloads of
+ * other messages are compact JSON
+ */
+inline constexpr std::size_t BINARY_FRAME_PREFIX_SIZE = 4;
+
+inline constexpr std::size_t MAX_BINARY_FRAME_BODY_SIZE = 16 * 1024 * 1024;
+
+struct CalcFrame {
+    uint256 challenge;
+    uint64_t iters;
+    uint256 group_hash;
+    uint64_t total_size;
+};
+
+struct CalcReplyFrame {
+    bool calculating;
+    uint256 challenge;
+    std::optional<vdf_client::ProofDetail> detail;
+};
+
+struct ProofFrame {
+    uint256 challenge;
+    vdf_client::ProofDetail detail;
+};
+
+/**
+ * Encode the message into compact JSON terminated with '\0'
+ */
+std::string EncodeJsonFrame(Json::Value const& msg);
+
+/**
+ * Write the fields of the proof into the JSON message, they are shared by CALC_REPLY, PROOF and the replies of CALC_BATCH
+ */
+void ProofToJson(vdf_client::ProofDetail const& detail, Json::Value& msg);
+
+/**
+ * Encode the message into a binary frame, the messages with fixed layouts are converted from their JSON fields
+ */
+std::string EncodeBinaryFrame(Json::Value const& msg);
+
+/**
+ * The frames below are written into `buf` when it is given, its capacity is reused
+ */
+std::string EncodePingFrame(int id, uint64_t nonce, std::string buf = {});
+
+std::string EncodeCalcFrame(CalcFrame const& calc);
+
+std::string EncodeCalcReplyFrame(bool calculating, uint256 const& challenge, vdf_client::ProofDetail const* pdetail, std::string buf = {});
+
+std::string EncodeProofFrame(uint256 const& challenge, vdf_client::ProofDetail const& detail, std::string buf = {});
+
+/**
+ * Get the number of the bytes of the next frame from the received data
+ *
+ * @return The size of the whole frame, or the size of the prefix when the prefix isn't received completely
+ *
+ * @exception std::runtime_error The size of the frame is invalid
+ */
+std::size_t GetBinaryFrameSize(char const* data, std::size_t size);
+
+/**
+ * @param body The frame without the length prefix
+ */
+int GetBinaryFrameId(std::string_view body);
+
+CalcFrame DecodeCalcFrame(std::string_view body);
+
+CalcReplyFrame DecodeCalcReplyFrame(std::string_view body);
+
+ProofFrame DecodeProofFrame(std::string_view body);
+
+/**
+ * Decode the frame into the same JSON message which is received from the JSON encoding
+ *
+ * @exception std::runtime_error The frame is truncated or malformed
+ */
+Json::Value DecodeBinaryFrame(std::string_view body);
+
+#endif
@@ -0,0 +1,222 @@
+#include "frontend_messages.h"
+
+#include <algorithm>
+#include <charconv>
+#include <string_view>
+
+#include <json/value.h>
+
+#include "msg_ids.h"
+
+namespace
+{
+
+// the keys are in the order of jsoncpp writes them
+constexpr std::string_view READY_JSON = R"({"encodings":["json","binary"],"id":1020})";
+
+constexpr std::string_view PONG_JSON = R"({"id":1000})";
+constexpr std::string_view PONG_JSON_0 = R"({"id":1000,"nonce":)";
+
+constexpr std::string_view CALC_REPLY_JSON_0 = R"({"calculating":)";
+constexpr std::string_view CALC_REPLY_JSON_1 = R"(,"challenge":")";
+constexpr std::string_view CALC_REPLY_JSON_2 = R"(","id":1040})";
+constexpr std::string_view CALC_REPLY_PROOF_JSON_2 = R"(","duration":)";
+constexpr std::string_view CALC_REPLY_PROOF_JSON_3 = R"(,"id":1040,"iters":)";
+
+constexpr std::string_view PROOF_JSON_0 = R"({"challenge":")";
+constexpr std::string_view PROOF_JSON_1 = R"(","duration":)";
+constexpr std::string_view PROOF_JSON_2 = R"(,"id":1010,"iters":)";
+
+// the common tail of the proofs
+constexpr std::string_view PROOF_JSON_TAIL_0 = R"(,"proof":")";
+constexpr std::string_view PROOF_JSON_TAIL_1 = R"(","witness_type":)";
+constexpr std::string_view PROOF_JSON_TAIL_2 = R"(,"y":")";
+constexpr std::string_view PROOF_JSON_TAIL_3 = R"("})";
+
+static_assert(static_cast<int>(TimelordMsgs::READY) == 1020 && static_cast<int>(TimelordMsgs::PONG) == 1000 && static_cast<int>(TimelordMsgs::CALC_REPLY) == 1040 && static_cast<int>(TimelordMsgs::PROOF) == 1010, "the ids in the templates are out of date");
+
+template <typename Container> void AppendHex(std::string& out, Container const& bytes)
+{
+    static char const* SZ_HEX_CHARS = "0123456789abcdef";
+    auto pos = out.size();
+    out.resize(pos + bytes.size() * 2);
+    for (uint8_t b : bytes) {
+        out[pos++] = SZ_HEX_CHARS[b >> 4];
+        out[pos++] = SZ_HEX_CHARS[b & 0x0f];
+    }
+}
+
+/**
+ * The uint256 is written in the reversed byte order as `Uint256ToHex` does
+ */
+void AppendUint256Hex(std::string& out, uint256 const& val)
+{
+    uint256 reversed;
+    std::reverse_copy(std::cbegin(val), std::cend(val), std::begin(reversed));
+    AppendHex(out, reversed);
+}
+
+template <typename T> void AppendInt(std::string& out, T val)
+{
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), val);
+    out.append(buf, res.ptr);
+}
+
+std::size_t GetProofJsonSize(vdf_client::ProofDetail const& detail)
+{
+    return 128 + detail.y.size() * 2 + detail.proof.size() * 2;
+}
+
+void AppendProofTail(std::string& out, vdf_client::ProofDetail const& detail)
+{
+    out.append(PROOF_JSON_TAIL_0);
+    AppendHex(out, detail.proof);
+    out.append(PROOF_JSON_TAIL_1);
+    AppendInt(out, static_cast<int>(detail.witness_type));
+    out.append(PROOF_JSON_TAIL_2);
+    AppendHex(out, detail.y);
+    out.append(PROOF_JSON_TAIL_3);
+    out.push_back('\0');
+}
+
+} // namespace
+
+FrameBufferPool& FrameBufferPool::GetInstance()
+{
+    static FrameBufferPool instance;
+    return instance;
+}
+
+std::string FrameBufferPool::Acquire()
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    if (bufs_.empty()) {
+        return {};
+    }
+    std::string buf = std::move(bufs_.back());
+    bufs_.pop_back();
+    return buf;
+}
+
+void FrameBufferPool::Release(std::string buf)
+{
+    if (buf.capacity() == 0 || buf.capacity() > MAX_POOLED_CAPACITY) {
+        return;
+    }
+    buf.clear();
+    std::lock_guard<std::mutex> lg(mtx_);
+    if (bufs_.size() < MAX_POOLED_BUFFERS) {
+        bufs_.push_back(std::move(buf));
+    }
+}
+
+FrontEndMessage FrameBufferPool::MakeMessage(int id, FrontEndFrames::Encoder json_encoder, FrontEndFrames::Encoder binary_encoder)
+{
+    auto pframes = new FrontEndFrames(id, std::move(json_encoder), std::move(binary_encoder));
+    return FrontEndMessage(pframes, [this, pframes](FrontEndFrames const*) {
+        // the frames never encoded are empty, they aren't pooled
+        Release(std::move(pframes->json_.frame));
+        Release(std::move(pframes->binary_.frame));
+        delete pframes;
+    });
+}
+
+FrontEndMessage MakeMsg_Ready()
+{
+    // it never changes
+    static FrontEndMessage msg = []() {
+        auto json_encoder = []() {
+            std::string json(READY_JSON);
+            json.push_back('\0');
+            return json;
+        };
+        auto binary_encoder = []() {
+            return EncodeBinaryFrame(ParseStringToJson(READY_JSON));
+        };
+        return std::make_shared<FrontEndFrames const>(static_cast<int>(TimelordMsgs::READY), std::move(json_encoder), std::move(binary_encoder));
+    }();
+    return msg;
+}
+
+FrontEndMessage MakeMsg_Pong()
+{
+    static FrontEndMessage msg = []() {
+        auto json_encoder = []() {
+            std::string json(PONG_JSON);
+            json.push_back('\0');
+            return json;
+        };
+        auto binary_encoder = []() {
+            return EncodePingFrame(static_cast<int>(TimelordMsgs::PONG), 0);
+        };
+        return std::make_shared<FrontEndFrames const>(static_cast<int>(TimelordMsgs::PONG), std::move(json_encoder), std::move(binary_encoder));
+    }();
+    return msg;
+}
+
+FrontEndMessage MakeMsg_Pong(uint64_t nonce)
+{
+    auto& pool = FrameBufferPool::GetInstance();
+    auto json_encoder = [&pool, nonce]() {
+        std::string json = pool.Acquire();
+        json.append(PONG_JSON_0);
+        AppendInt(json, nonce);
+        json.append("}");
+        json.push_back('\0');
+        return json;
+    };
+    auto binary_encoder = [&pool, nonce]() {
+        return EncodePingFrame(static_cast<int>(TimelordMsgs::PONG), nonce, pool.Acquire());
+    };
+    return pool.MakeMessage(static_cast<int>(TimelordMsgs::PONG), std::move(json_encoder), std::move(binary_encoder));
+}
+
+FrontEndMessage MakeMsg_CalcReply(bool calculating, uint256 const& challenge, vdf_client::ProofDetailPtr detail)
+{
+    auto& pool = FrameBufferPool::GetInstance();
+    auto json_encoder = [&pool, calculating, challenge, detail]() {
+        std::string json = pool.Acquire();
+        json.reserve(detail ? GetProofJsonSize(*detail) : 128);
+        json.append(CALC_REPLY_JSON_0);
+        json.append(calculating ? "true" : "false");
+        json.append(CALC_REPLY_JSON_1);
+        AppendUint256Hex(json, challenge);
+        if (detail) {
+            json.append(CALC_REPLY_PROOF_JSON_2);
+            AppendInt(json, detail->duration);
+            json.append(CALC_REPLY_PROOF_JSON_3);
+            AppendInt(json, detail->iters);
+            AppendProofTail(json, *detail);
+        } else {
+            json.append(CALC_REPLY_JSON_2);
+            json.push_back('\0');
+        }
+        return json;
+    };
+    auto binary_encoder = [&pool, calculating, challenge, detail]() {
+        return EncodeCalcReplyFrame(calculating, challenge, detail.get(), pool.Acquire());
+    };
+    return pool.MakeMessage(static_cast<int>(TimelordMsgs::CALC_REPLY), std::move(json_encoder), std::move(binary_encoder));
+}
+
+FrontEndMessage MakeMsg_Proof(uint256 const& challenge, vdf_client::ProofDetailPtr detail)
+{
+    auto& pool = FrameBufferPool::GetInstance();
+    auto json_encoder = [&pool, challenge, detail]() {
+        std::string json = pool.Acquire();
+        json.reserve(GetProofJsonSize(*detail));
+        json.append(PROOF_JSON_0);
+        AppendUint256Hex(json, challenge);
+        json.append(PROOF_JSON_1);
+        AppendInt(json, detail->duration);
+        json.append(PROOF_JSON_2);
+        AppendInt(json, detail->iters);
+        AppendProofTail(json, *detail);
+        return json;
+    };
+    auto binary_encoder = [&pool, challenge, detail]() {
+        return EncodeProofFrame(challenge, *detail, pool.Acquire());
+    };
+    return pool.MakeMessage(static_cast<int>(TimelordMsgs::PROOF), std::move(json_encoder), std::move(binary_encoder));
+}
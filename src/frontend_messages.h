@@ -0,0 +1,58 @@
+#ifndef TL_FRONTEND_MESSAGES_H
+#define TL_FRONTEND_MESSAGES_H
+
+#include <cstdint>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common_types.h"
+#include "frontend.h"
+#include "proof_detail.h"
+
+/**
+ * Keeps the buffers of the released messages, their capacities are reused by the next messages
+ */
+class FrameBufferPool
+{
+public:
+    static FrameBufferPool& GetInstance();
+
+    std::string Acquire();
+
+    void Release(std::string buf);
+
+    /**
+     * Make a message from the encoders, the frames are released to the pool when the message is released
+     */
+    FrontEndMessage MakeMessage(int id, FrontEndFrames::Encoder json_encoder, FrontEndFrames::Encoder binary_encoder);
+
+private:
+    static constexpr std::size_t MAX_POOLED_BUFFERS = 64;
+
+    static constexpr std::size_t MAX_POOLED_CAPACITY = 64 * 1024;
+
+    std::mutex mtx_;
+    std::vector<std::string> bufs_;
+};
+
+/**
+ * The hot outbound messages are written from the templates with only the variable fields filled in. The JSON frames are
+ * the same bytes as `EncodeJsonFrame` writes for the equivalent `Json::Value`. The proofs are shared by the encoders, they
+ * aren't copied for the frames encoded later
+ */
+FrontEndMessage MakeMsg_Ready();
+
+/**
+ * The reply of the PING which has no other fields
+ */
+FrontEndMessage MakeMsg_Pong();
+
+FrontEndMessage MakeMsg_Pong(uint64_t nonce);
+
+FrontEndMessage MakeMsg_CalcReply(bool calculating, uint256 const& challenge, vdf_client::ProofDetailPtr detail);
+
+FrontEndMessage MakeMsg_Proof(uint256 const& challenge, vdf_client::ProofDetailPtr detail);
+
+#endif
@@ -0,0 +1,158 @@
+#include "instrumentation.h"
+
+#include <algorithm>
+
+#include <plog/Log.h>
+#include <tinyformat.h>
+
+using boost::system::error_code;
+
+namespace
+{
+
+int64_t EstimatePercentile(LatencySnapshot const& snapshot, double q)
+{
+    if (snapshot.count == 0) {
+        return 0;
+    }
+    auto rank = static_cast<uint64_t>(q * snapshot.count);
+    uint64_t accumulated { 0 };
+    for (std::size_t i = 0; i < snapshot.bucket_counts.size(); ++i) {
+        accumulated += snapshot.bucket_counts[i];
+        if (accumulated > rank) {
+            // the upper bound of the bucket, the samples over the last bound are estimated with the max value
+            return snapshot.bucket_bounds[i] < 0 ? snapshot.max_usecs : std::min(snapshot.bucket_bounds[i], snapshot.max_usecs);
+        }
+    }
+    return snapshot.max_usecs;
+}
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram(std::string name)
+    : name_(std::move(name))
+{
+}
+
+void LatencyHistogram::Record(int64_t usecs)
+{
+    std::size_t i { 0 };
+    while (i < BUCKET_BOUNDS.size() && usecs > BUCKET_BOUNDS[i]) {
+        ++i;
+    }
+    buckets_[i].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_usecs_.fetch_add(usecs, std::memory_order_relaxed);
+    int64_t max_usecs = max_usecs_.load(std::memory_order_relaxed);
+    while (usecs > max_usecs && !max_usecs_.compare_exchange_weak(max_usecs, usecs, std::memory_order_relaxed)) {
+    }
+}
+
+LatencySnapshot LatencyHistogram::GetSnapshot() const
+{
+    LatencySnapshot snapshot;
+    snapshot.name = name_;
+    snapshot.count = count_.load(std::memory_order_relaxed);
+    snapshot.sum_usecs = sum_usecs_.load(std::memory_order_relaxed);
+    snapshot.max_usecs = max_usecs_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < buckets_.size(); ++i) {
+        snapshot.bucket_bounds.push_back(i < BUCKET_BOUNDS.size() ? BUCKET_BOUNDS[i] : -1);
+        snapshot.bucket_counts.push_back(buckets_[i].load(std::memory_order_relaxed));
+    }
+    snapshot.p50_usecs = EstimatePercentile(snapshot, 0.5);
+    snapshot.p90_usecs = EstimatePercentile(snapshot, 0.9);
+    snapshot.p99_usecs = EstimatePercentile(snapshot, 0.99);
+    return snapshot;
+}
+
+Instrumentation& Instrumentation::GetInstance()
+{
+    static Instrumentation instance;
+    return instance;
+}
+
+LatencyHistogram& Instrumentation::GetHandlerLatency(std::string_view subsystem)
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    return GetOrCreate(handler_latencies_, subsystem);
+}
+
+LatencyHistogram& Instrumentation::GetLoopLag(std::string_view loop_name)
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    return GetOrCreate(loop_lags_, loop_name);
+}
+
+LatencyStats Instrumentation::QueryStats() const
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    LatencyStats stats;
+    for (auto const& [name, phistogram] : handler_latencies_) {
+        stats.handlers.push_back(phistogram->GetSnapshot());
+    }
+    for (auto const& [name, phistogram] : loop_lags_) {
+        stats.loop_lags.push_back(phistogram->GetSnapshot());
+    }
+    return stats;
+}
+
+LatencyHistogram& Instrumentation::GetOrCreate(Histograms& histograms, std::string_view name)
+{
+    auto it = histograms.find(name);
+    if (it == std::end(histograms)) {
+        it = histograms.emplace(std::string(name), std::make_unique<LatencyHistogram>(std::string(name))).first;
+    }
+    return *it->second;
+}
+
+ScopedHandlerTimer::ScopedHandlerTimer(LatencyHistogram& histogram, std::string_view origin)
+    : histogram_(histogram)
+    , origin_(origin)
+    , start_(std::chrono::steady_clock::now())
+{
+}
+
+ScopedHandlerTimer::~ScopedHandlerTimer()
+{
+    int64_t usecs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_).count();
+    histogram_.Record(usecs);
+    if (usecs > Instrumentation::GetInstance().GetSlowHandlerThresholdUsecs()) {
+        PLOGW << tinyformat::format("slow handler: %s (%s) took %.3f ms", histogram_.GetName(), origin_, usecs / 1000.0);
+    }
+}
+
+LoopLagProbe::LoopLagProbe(asio::io_context& ioc, std::string_view loop_name, std::chrono::milliseconds interval)
+    : strand_(asio::make_strand(ioc))
+    , timer_(strand_)
+    , interval_(interval)
+    , lag_(Instrumentation::GetInstance().GetLoopLag(loop_name))
+{
+}
+
+void LoopLagProbe::Run()
+{
+    asio::dispatch(strand_, [this]() {
+        WaitNext();
+    });
+}
+
+void LoopLagProbe::Exit()
+{
+    asio::dispatch(strand_, [this]() {
+        error_code ignored_ec;
+        timer_.cancel(ignored_ec);
+    });
+}
+
+void LoopLagProbe::WaitNext()
+{
+    timer_.expires_after(interval_);
+    timer_.async_wait([this](error_code const& ec) {
+        if (ec) {
+            return;
+        }
+        // the timer fires late when the thread is blocked by other handlers
+        lag_.Record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - timer_.expiry()).count());
+        WaitNext();
+    });
+}
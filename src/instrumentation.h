@@ -0,0 +1,151 @@
+#ifndef TL_INSTRUMENTATION_H
+#define TL_INSTRUMENTATION_H
+
+#include <cstdint>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <string>
+#include <string_view>
+
+#include "asio_defs.hpp"
+
+#include "latency_stats.h"
+
+/**
+ * A histogram of latencies with fixed buckets, the samples are recorded without locks from any thread
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr std::array<int64_t, 15> BUCKET_BOUNDS { 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000 };
+
+    explicit LatencyHistogram(std::string name);
+
+    std::string const& GetName() const
+    {
+        return name_;
+    }
+
+    void Record(int64_t usecs);
+
+    LatencySnapshot GetSnapshot() const;
+
+private:
+    std::string name_;
+    std::array<std::atomic_uint64_t, BUCKET_BOUNDS.size() + 1> buckets_ {};
+    std::atomic_uint64_t count_ { 0 };
+    std::atomic_int64_t sum_usecs_ { 0 };
+    std::atomic_int64_t max_usecs_ { 0 };
+};
+
+/**
+ * The registry of the handler latencies of the subsystems and the lags of the event loops, the histograms are created on
+ * the first query and they live as long as the process, so the references can be kept by the callers
+ */
+class Instrumentation
+{
+public:
+    static Instrumentation& GetInstance();
+
+    LatencyHistogram& GetHandlerLatency(std::string_view subsystem);
+
+    LatencyHistogram& GetLoopLag(std::string_view loop_name);
+
+    void SetSlowHandlerThreshold(std::chrono::microseconds threshold)
+    {
+        slow_handler_threshold_usecs_ = threshold.count();
+    }
+
+    int64_t GetSlowHandlerThresholdUsecs() const
+    {
+        return slow_handler_threshold_usecs_;
+    }
+
+    LatencyStats QueryStats() const;
+
+private:
+    using Histograms = std::map<std::string, std::unique_ptr<LatencyHistogram>, std::less<>>;
+
+    static LatencyHistogram& GetOrCreate(Histograms& histograms, std::string_view name);
+
+    mutable std::mutex mtx_;
+    Histograms handler_latencies_;
+    Histograms loop_lags_;
+    std::atomic_int64_t slow_handler_threshold_usecs_ { 100000 };
+};
+
+/**
+ * Records the time from construction to destruction into the histogram, the handler is logged with its origin when it
+ * takes longer than the threshold
+ */
+class ScopedHandlerTimer
+{
+public:
+    ScopedHandlerTimer(LatencyHistogram& histogram, std::string_view origin);
+
+    ~ScopedHandlerTimer();
+
+    ScopedHandlerTimer(ScopedHandlerTimer const&) = delete;
+
+    ScopedHandlerTimer& operator=(ScopedHandlerTimer const&) = delete;
+
+private:
+    LatencyHistogram& histogram_;
+    std::string_view origin_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Records the time from construction to destruction into the histogram
+ */
+class ScopedLatencyTimer
+{
+public:
+    explicit ScopedLatencyTimer(LatencyHistogram& histogram)
+        : histogram_(histogram)
+        , start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ScopedLatencyTimer()
+    {
+        histogram_.Record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_).count());
+    }
+
+    ScopedLatencyTimer(ScopedLatencyTimer const&) = delete;
+
+    ScopedLatencyTimer& operator=(ScopedLatencyTimer const&) = delete;
+
+private:
+    LatencyHistogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Measures how late a periodic timer fires on the loop, a busy loop delays the timer
+ */
+class LoopLagProbe
+{
+public:
+    LoopLagProbe(asio::io_context& ioc, std::string_view loop_name, std::chrono::milliseconds interval);
+
+    void Run();
+
+    void Exit();
+
+private:
+    void WaitNext();
+
+    asio::strand<asio::io_context::executor_type> strand_;
+    asio::steady_timer timer_;
+    std::chrono::milliseconds interval_;
+    LatencyHistogram& lag_;
+};
+
+#endif
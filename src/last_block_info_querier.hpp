@@ -3,30 +3,35 @@
 
 #include "block_info.h"
 #include "block_querier_utils.h"
-#include "rpc_client.h"
+#include "async_rpc_client.h"
+#include "rpc_metrics.hpp"
 
 class LastBlockInfoQuerier
 {
 public:
-    explicit LastBlockInfoQuerier(RPCClient& rpc)
+    explicit LastBlockInfoQuerier(AsyncRPCClient& rpc)
         : rpc_(rpc)
+        , rpc_latency_(GetRPCLatency("queryupdatetiphistory"))
     {
     }
 
-    BlockInfo operator()() const
+    void operator()(QueryHandler<BlockInfo> handler) const
     {
-        BlockInfo block_info;
+        AsyncQueryRPC(rpc_, rpc_latency_, "queryupdatetiphistory", &LastBlockInfoQuerier::ConvertResult, std::move(handler), std::string("1"));
+    }
 
-        auto res = rpc_.Call("queryupdatetiphistory", std::string("1"));
-        if (!res.result.isObject()) {
+private:
+    static BlockInfo ConvertResult(UniValue const& result)
+    {
+        if (!result.isObject()) {
             throw std::runtime_error("the return value is not an object");
         }
 
-        if (!res.result.exists("tips") || !res.result["tips"].isArray()) {
+        if (!result.exists("tips") || !result["tips"].isArray()) {
             throw std::runtime_error("`tips` doesn't exist or it is not an array");
         }
 
-        auto values = res.result["tips"].getValues();
+        auto values = result["tips"].getValues();
         if (values.empty()) {
             throw std::runtime_error("empty result from `queryupdatetiphistory`");
         }
@@ -34,8 +39,8 @@ public:
         return ConvertToBlockInfo(values.front());
     }
 
-private:
-    RPCClient& rpc_;
+    AsyncRPCClient& rpc_;
+    LatencyHistogram& rpc_latency_;
 };
 
 #endif
@@ -0,0 +1,27 @@
+#ifndef TL_LATENCY_STATS_H
+#define TL_LATENCY_STATS_H
+
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+struct LatencySnapshot {
+    std::string name;
+    uint64_t count;
+    int64_t sum_usecs;
+    int64_t max_usecs;
+    int64_t p50_usecs;
+    int64_t p90_usecs;
+    int64_t p99_usecs;
+    // the upper bounds of the buckets and the number of samples fall into each of them, the last bound is -1 (infinite)
+    std::vector<int64_t> bucket_bounds;
+    std::vector<uint64_t> bucket_counts;
+};
+
+struct LatencyStats {
+    std::vector<LatencySnapshot> handlers;
+    std::vector<LatencySnapshot> loop_lags;
+};
+
+#endif
@@ -34,6 +34,11 @@ public:
         storage_.AppendRequest(request);
     }
 
+    void AppendRequests(std::vector<VDFRequest> const& requests)
+    {
+        storage_.AppendRequests(requests);
+    }
+
 private:
     Storage& storage_;
 };
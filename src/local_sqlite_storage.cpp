@@ -13,6 +13,11 @@
 LocalSQLiteStorage::LocalSQLiteStorage(std::string_view file_path)
     : sql3_(file_path)
 {
+    // the connections of the readers and the writer are working on different threads, the readers never see the
+    // uncommitted writes and the writer waits for the locks instead of failing
+    sql3_.ExecuteSQL("pragma journal_mode = wal");
+    sql3_.ExecuteSQL("pragma busy_timeout = 5000");
+
     sql3_.ExecuteSQL("create table if not exists vdf_record (timestamp, challenge, height)");
     sql3_.ExecuteSQL("create index if not exists vdf_record_challenge_idx on vdf_record (challenge)");
     sql3_.ExecuteSQL("create index if not exists vdf_record_timestamp_idx on vdf_record (timestamp)");
@@ -56,6 +61,27 @@ void LocalSQLiteStorage::AppendRequest(VDFRequest const& request)
     stmt.Run();
 }
 
+void LocalSQLiteStorage::AppendRequests(std::vector<VDFRequest> const& requests)
+{
+    sql3_.BeginTransaction();
+    try {
+        auto stmt = sql3_.Prepare("insert or ignore into vdf_requests (challenge, iters, estimated_seconds, group_hash, total_size) values (?, ?, ?, ?, ?)");
+        for (auto const& request : requests) {
+            stmt.Bind(1, request.challenge);
+            stmt.Bind(2, request.iters);
+            stmt.Bind(3, request.estimated_seconds);
+            stmt.Bind(4, request.group_hash);
+            stmt.Bind(5, request.total_size);
+            stmt.Run();
+            stmt.Reset();
+        }
+        sql3_.CommitTransaction();
+    } catch (std::exception const&) {
+        sql3_.RollbackTransaction();
+        throw;
+    }
+}
+
 void LocalSQLiteStorage::AppendBlock(BlockInfo const& block_info)
 {
     auto stmt = sql3_.Prepare("insert into blocks (hash, timestamp, challenge, height, filter_bits, block_difficulty, challenge_difficulty, farmer_pk, address, reward, accumulate, vdf_time, vdf_iters, vdf_speed) values (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
@@ -187,8 +213,8 @@ int LocalSQLiteStorage::QueryNumHeightsByTimeRange(int pass_hours, int min_heigh
 std::vector<NetspaceData> LocalSQLiteStorage::QueryNetspace(int num_heights, bool sum_netspace)
 {
     std::vector<NetspaceData> results;
-    char const* SZ_QUERY_NETSPACE_SUM_NETSPACE = "select blocks.height, blocks.challenge_difficulty, blocks.block_difficulty, sum(vdf_requests.total_size) from blocks left join vdf_requests on vdf_requests.challenge = blocks.challenge group by blocks.challenge order by blocks.height desc limit ?";
-    char const* SZ_QUERY_NETSPACE = "select height, challenge_difficulty, block_difficulty, 0 from blocks order by height desc limit ?";
+    char const* SZ_QUERY_NETSPACE_SUM_NETSPACE = "select blocks.height, blocks.challenge_difficulty, blocks.block_difficulty, sum(vdf_requests.total_size), blocks.challenge from blocks left join vdf_requests on vdf_requests.challenge = blocks.challenge group by blocks.challenge order by blocks.height desc limit ?";
+    char const* SZ_QUERY_NETSPACE = "select height, challenge_difficulty, block_difficulty, 0, challenge from blocks order by height desc limit ?";
     std::string sql_str = sum_netspace ? SZ_QUERY_NETSPACE_SUM_NETSPACE : SZ_QUERY_NETSPACE;
     auto stmt = sql3_.Prepare(sql_str);
     stmt.Bind(1, num_heights);
@@ -198,11 +224,29 @@ std::vector<NetspaceData> LocalSQLiteStorage::QueryNetspace(int num_heights, boo
         data.challenge_difficulty = stmt.GetColumnInt64(1);
         data.block_difficulty = stmt.GetColumnInt64(2);
         data.netspace = stmt.GetColumnInt64(3);
+        data.challenge = stmt.GetColumnUint256(4);
         results.push_back(std::move(data));
     }
     return results;
 }
 
+std::vector<NetspaceSummary> LocalSQLiteStorage::QueryNetspaceSummaries(int num_challenges)
+{
+    std::vector<NetspaceSummary> results;
+    auto stmt = sql3_.Prepare("select vdf_record.challenge, vdf_record.height, vdf_record.timestamp, sum(vdf_requests.total_size), count(vdf_requests.group_hash) from vdf_record left join vdf_requests on vdf_requests.challenge = vdf_record.challenge group by vdf_record.challenge order by vdf_record.height desc limit ?");
+    stmt.Bind(1, num_challenges);
+    while (stmt.StepNext()) {
+        NetspaceSummary summary;
+        summary.challenge = stmt.GetColumnUint256(0);
+        summary.height = stmt.GetColumnInt64(1);
+        summary.timestamp = stmt.GetColumnInt64(2);
+        summary.total_size = stmt.GetColumnInt64(3);
+        summary.num_groups = stmt.GetColumnInt64(4);
+        results.push_back(std::move(summary));
+    }
+    return results;
+}
+
 std::vector<RankRecord> LocalSQLiteStorage::QueryRank(int from_height, int count)
 {
     auto stmt = sql3_.Prepare("select farmer_pk, sum(reward), count(*), avg(block_difficulty) from blocks where height >= ? group by farmer_pk limit ?");
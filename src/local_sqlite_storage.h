@@ -26,6 +26,12 @@ public:
 
     void AppendRequest(VDFRequest const& request);
 
+    /**
+     * Append the requests in one transaction, the requests those are already saved (the same challenge and group hash) are
+     * ignored
+     */
+    void AppendRequests(std::vector<VDFRequest> const& requests);
+
     void AppendBlock(BlockInfo const& block_info);
 
     std::tuple<VDFRecord, bool> QueryRecord(uint256 const& challenge);
@@ -42,6 +48,8 @@ public:
 
     std::vector<NetspaceData> QueryNetspace(int num_heights, bool sum_netspace);
 
+    std::vector<NetspaceSummary> QueryNetspaceSummaries(int num_challenges);
+
     std::vector<RankRecord> QueryRank(int from_height, int count);
 
     uint64_t QueryMaxNetspace(int from_height, int best_height);
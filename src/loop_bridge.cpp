@@ -0,0 +1,59 @@
+#include "loop_bridge.h"
+
+LoopBridge::LoopBridge(asio::any_io_executor executor, std::size_t capacity)
+    : executor_(std::move(executor))
+    , queue_(capacity)
+{
+}
+
+bool LoopBridge::TryPost(Task task)
+{
+    if (!queue_.TryPush(std::move(task))) {
+        ++num_drops_;
+        return false;
+    }
+    ScheduleDrain();
+    return true;
+}
+
+void LoopBridge::Post(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lg(overflow_mtx_);
+        if (!overflow_.empty() || !queue_.TryPush(std::move(task))) {
+            overflow_.push_back(std::move(task));
+            overflow_size_ = overflow_.size();
+            ++num_overflows_;
+        }
+    }
+    ScheduleDrain();
+}
+
+void LoopBridge::ScheduleDrain()
+{
+    if (!drain_scheduled_.exchange(true, std::memory_order_acq_rel)) {
+        asio::post(executor_, [this]() {
+            Drain();
+        });
+    }
+}
+
+void LoopBridge::Drain()
+{
+    // reset the flag before draining, a task pushed after this point schedules another drain
+    drain_scheduled_.store(false, std::memory_order_release);
+    Task task;
+    while (queue_.TryPop(task)) {
+        task();
+    }
+    // the tasks in the overflow list are queued after the ones above, the tasks queued from now on are drained next time
+    std::deque<Task> overflow;
+    {
+        std::lock_guard<std::mutex> lg(overflow_mtx_);
+        overflow.swap(overflow_);
+        overflow_size_ = 0;
+    }
+    for (auto& overflow_task : overflow) {
+        overflow_task();
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef TL_LOOP_BRIDGE_H
+#define TL_LOOP_BRIDGE_H
+
+#include <cstdint>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include "asio_defs.hpp"
+
+#include "bounded_queue.hpp"
+
+/**
+ * Moves the tasks from other threads to an executor through a bounded lock-free queue, the tasks are executed in order
+ *
+ * Only one drain is posted to the executor no matter how many tasks are pushed before it runs. The queue never grows over
+ * its capacity: `TryPost` drops the task when the queue is full, `Post` moves it to an unbounded overflow list which the
+ * drain empties after the queue, so neither of them waits on the executor
+ */
+class LoopBridge
+{
+public:
+    using Task = std::function<void()>;
+
+    LoopBridge(asio::any_io_executor executor, std::size_t capacity);
+
+    /**
+     * Queue the task or drop it when the queue is full
+     *
+     * @return false when the task is dropped
+     */
+    bool TryPost(Task task);
+
+    /**
+     * Queue the task, it goes to the overflow list when the queue is full or the list isn't empty, so the order is kept
+     */
+    void Post(Task task);
+
+    std::size_t GetNumOfPendingTasks() const
+    {
+        return queue_.GetSize();
+    }
+
+    std::size_t GetNumOfOverflowTasks() const
+    {
+        return overflow_size_;
+    }
+
+    uint64_t GetNumOfDrops() const
+    {
+        return num_drops_;
+    }
+
+    uint64_t GetNumOfOverflows() const
+    {
+        return num_overflows_;
+    }
+
+private:
+    void ScheduleDrain();
+
+    void Drain();
+
+    asio::any_io_executor executor_;
+    BoundedQueue<Task> queue_;
+    std::mutex overflow_mtx_;
+    std::deque<Task> overflow_;
+    std::atomic_size_t overflow_size_ { 0 };
+    std::atomic_bool drain_scheduled_ { false };
+    std::atomic_uint64_t num_drops_ { 0 };
+    std::atomic_uint64_t num_overflows_ { 0 };
+};
+
+#endif
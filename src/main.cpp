@@ -1,4 +1,9 @@
+#include <algorithm>
+#include <memory>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <cxxopts.hpp>
 
@@ -16,10 +21,9 @@
 
 #include "block_info_sqlite_saver.hpp"
 #include "last_block_info_querier.hpp"
-#include "local_db_netspace_size_querier.hpp"
 #include "local_db_rank_querier.hpp"
 #include "missing_block_importer.hpp"
-#include "netspace_querier.hpp"
+#include "netspace_aggregator_querier.hpp"
 #include "num_heights_by_hours_querier.hpp"
 #include "pledge_info_rpc_querier.hpp"
 #include "recently_netspace_size_rpc_querier.hpp"
@@ -29,6 +33,10 @@
 
 #include "vdf_web_service.h"
 
+#include "instrumentation.h"
+#include "metrics.h"
+#include "proof_tracer.h"
+#include "thread_utils.h"
 #include "timelord.h"
 
 char const* SZ_APP_NAME = "Timelord";
@@ -49,15 +57,29 @@ int main(int argc, char* argv[])
             ("vdf_client-path", "The full path to `vdf_client'", cxxopts::value<std::string>()->default_value("$HOME/vdf_client")) // --vdf_client-path
             ("vdf_client-addr", "vdf_client will listen to this address", cxxopts::value<std::string>()->default_value("127.0.0.1")) // --vdf_client-addr
             ("vdf_client-port", "vdf_client will listen to this port", cxxopts::value<unsigned short>()->default_value("29292")) // --vdf_client-port
+            ("challenge-depth", "Requests of a challenge are dropped when there are more newer challenges than this", cxxopts::value<int>()->default_value("10")) // --challenge-depth
+            ("netspace-history", "Keep the netspace of this number of challenges in memory", cxxopts::value<int>()->default_value("5000")) // --netspace-history
+            ("io-threads", "Number of threads to run the best-effort services (web service, RPC polling)", cxxopts::value<int>()->default_value("2")) // --io-threads
+            ("proof-cpu", "Pin the thread of the proof loop to this cpu core, -1 to disable", cxxopts::value<int>()->default_value("-1")) // --proof-cpu
+            ("proof-priority", "Run the proof loop with SCHED_FIFO and this priority, 0 to disable", cxxopts::value<int>()->default_value("0")) // --proof-priority
+            ("send-queue-kb", "Limit the queued messages of each frontend session to this size, 0 for no limit", cxxopts::value<int>()->default_value("4096")) // --send-queue-kb
+            ("slow-consumer", "What to do when the send queue of a session is full: drop-oldest, coalesce or disconnect", cxxopts::value<std::string>()->default_value("disconnect")) // --slow-consumer
+            ("push-from", "Accept the challenges pushed (NEW_CHALLENGE) from these addresses, separated by commas or repeated", cxxopts::value<std::vector<std::string>>()->default_value("")) // --push-from
+            ("push-token", "Accept the challenges pushed with this token from any address", cxxopts::value<std::string>()->default_value("")) // --push-token
+            ("frontend-acceptors", "Accept the frontend sessions with this number of acceptors, each on its own loop and thread, they share the port with SO_REUSEPORT", cxxopts::value<int>()->default_value("1")) // --frontend-acceptors
+            ("slow-handler-ms", "Log the handlers which block the loops longer than this", cxxopts::value<int>()->default_value("100")) // --slow-handler-ms
             ("db", "store vdf and related information to this file", cxxopts::value<std::string>()->default_value("./timelord.sqlite3")) // --db
             ("web_service-prefix", "The prefix of the api url path", cxxopts::value<std::string>()->default_value("")) // --web_service-path_prefix
             ("web_service-addr", "Web service will listen to this address", cxxopts::value<std::string>()->default_value("127.0.0.1")) // --web_service-addr
             ("web_service-port", "Web service will listen to this port", cxxopts::value<uint16_t>()->default_value("39393")) // --web_service-port
-            ("rpc", "The endpoint of btchd core", cxxopts::value<std::string>()->default_value("http://127.0.0.1:18732")) // --rpc
+            ("rpc", "The endpoints of btchd core, separated by commas or repeated, the challenge is polled from all of them and the proofs are submitted to all of them", cxxopts::value<std::vector<std::string>>()->default_value("http://127.0.0.1:18732")) // --rpc
             ("use-cookie", "Use cookie file to login") // --use-cookie
             ("cookie", "Full path to the `.cookie` file generated by btchd core", cxxopts::value<std::string>()->default_value("$HOME/.btchd/testnet3/.cookie")) // --cookie
             ("rpc-user", "The username to identify RPC connection", cxxopts::value<std::string>()) // --rpc-user
             ("rpc-password", "The password to verify RPC connection", cxxopts::value<std::string>()) // --rpc-password
+            ("rpc-timeout-ms", "The deadline of each RPC call", cxxopts::value<int>()->default_value("10000")) // --rpc-timeout-ms
+            ("rpc-import-timeout-ms", "The deadline of the RPC call which imports the missing blocks on start", cxxopts::value<int>()->default_value("600000")) // --rpc-import-timeout-ms
+            ("rpc-cache-ms", "The results of the status queries are cached for the duration or until the height is changed, 0 to disable", cxxopts::value<int>()->default_value("3000")) // --rpc-cache-ms
             ("skip-import-check", "The importing procedure will import all blocks from the chain since min-height") // --skip-import-check
             ("skip-host-detection", "Do not detect the host cause sometimes you are under the stupid GTFW") // --skip-host-detection
             ;
@@ -84,11 +106,22 @@ int main(int argc, char* argv[])
         std::string vdf_client_path = ExpandEnvPath(parse_result["vdf_client-path"].as<std::string>());
         std::string vdf_client_addr = parse_result["vdf_client-addr"].as<std::string>();
         unsigned short vdf_client_port = parse_result["vdf_client-port"].as<unsigned short>();
+        int challenge_depth = parse_result["challenge-depth"].as<int>();
+        int netspace_history = parse_result["netspace-history"].as<int>();
+        int num_io_threads = std::max(parse_result["io-threads"].as<int>(), 1);
+        int proof_cpu = parse_result["proof-cpu"].as<int>();
+        int num_frontend_acceptors = std::max(parse_result["frontend-acceptors"].as<int>(), 1);
+        int proof_priority = parse_result["proof-priority"].as<int>();
+        auto slow_consumer_policy = FrontEndSendQueuePolicyFromString(parse_result["slow-consumer"].as<std::string>());
+        if (!slow_consumer_policy) {
+            throw std::runtime_error(tinyformat::format("unknown slow consumer policy `%s'", parse_result["slow-consumer"].as<std::string>()));
+        }
+        Instrumentation::GetInstance().SetSlowHandlerThreshold(std::chrono::milliseconds(parse_result["slow-handler-ms"].as<int>()));
         std::string db_path = parse_result["db"].as<std::string>();
         std::string web_service_prefix = parse_result["web_service-prefix"].as<std::string>();
         std::string web_service_addr = parse_result["web_service-addr"].as<std::string>();
         uint16_t web_service_port = parse_result["web_service-port"].as<uint16_t>();
-        std::string url = parse_result["rpc"].as<std::string>();
+        auto urls = parse_result["rpc"].as<std::vector<std::string>>();
         std::string cookie_path;
         std::string rpc_user;
         std::string rpc_password;
@@ -100,47 +133,172 @@ int main(int argc, char* argv[])
             rpc_password = parse_result["rpc-password"].as<std::string>();
         }
 
+        AsyncRPCClient::Options rpc_opts;
+        rpc_opts.timeout = std::chrono::milliseconds(parse_result["rpc-timeout-ms"].as<int>());
+
         bool mainnet = parse_result.count("mainnet") > 0;
 
+        // the extra frontend acceptors run on their own loops, the sessions are released with the timelord, so the loops
+        // are declared before it
+        std::vector<std::unique_ptr<asio::io_context>> frontend_iocs;
+        for (int i = 1; i < num_frontend_acceptors; ++i) {
+            frontend_iocs.push_back(std::make_unique<asio::io_context>(1));
+        }
+        // the proof path (vdf_client -> timelord -> frontend) runs on its own loop and thread, other services run on `ioc`
+        asio::io_context proof_ioc(1);
         asio::io_context ioc;
+        // the RPC client runs on its own loop, the callers which wait for the results never block the loop of the client
+        asio::io_context rpc_ioc(1);
+        // an error of any loop stops the main loops, so the services are shut down as the main loop returns
+        auto stop_on_error = [&ioc, &proof_ioc]() {
+            ioc.stop();
+            proof_ioc.stop();
+        };
+        LoopThread rpc_loop(rpc_ioc, "rpc", stop_on_error);
         PLOGI << "initializing timelord...";
         PLOGI << "network: " << (mainnet ? "mainnet" : "testnet3");
-        PLOGI << "url: " << url;
+        for (auto const& url : urls) {
+            PLOGI << "url: " << url;
+        }
         PLOGI << "cookie: " << cookie_path;
         PLOGI << "use_cookie: " << (use_cookie ? "yes" : "no");
         PLOGI << "vdf: " << vdf_client_path;
+        PLOGI << "io threads: " << num_io_threads;
+        PLOGI << "frontend acceptors: " << num_frontend_acceptors;
 
         // prepare local database
         PLOGI << "database: " << db_path;
         LocalSQLiteStorage db(db_path);
-        LocalSQLiteDatabaseKeeper persist_operator(db);
+        // the persist worker writes on its own thread through its own connection, the web service reads through `db`
+        LocalSQLiteStorage persist_db(db_path);
+        LocalSQLiteDatabaseKeeper persist_operator(persist_db);
+
+        // the netspace of the recent challenges are loaded from local database
+        NetspaceAggregator netspace(netspace_history);
+        {
+            auto summaries = db.QueryNetspaceSummaries(netspace_history);
+            std::reverse(std::begin(summaries), std::end(summaries));
+            auto last_requests = summaries.empty() ? std::vector<VDFRequest>() : db.QueryRequests(summaries.back().challenge);
+            netspace.Seed(std::move(summaries), last_requests);
+            PLOGI << tinyformat::format("netspace of total %d challenge(s) are loaded", netspace.GetHistory().size());
+        }
 
         int fork_height = std::atoi(mainnet ? SZ_FORK_HEIGHT_MAINNET : SZ_FORK_HEIGHT_TESTNET);
 
-        // prepare RPC login
-        RPCLogin login = use_cookie ? RPCLogin(cookie_path) : RPCLogin(rpc_user, rpc_password);
-        RPCClient rpc(true, url, std::move(login));
-        Timelord timelord(ioc, rpc, vdf_client_path, vdf_client_addr, vdf_client_port, fork_height, persist_operator, db, VDFProofSubmitter(rpc));
+        auto make_rpc_client = [&](std::string const& url, AsyncRPCClient::Options const& opts) {
+            return use_cookie ? std::make_unique<AsyncRPCClient>(rpc_ioc, url, cookie_path, opts) : std::make_unique<AsyncRPCClient>(rpc_ioc, url, rpc_user, rpc_password, opts);
+        };
+        // the RPC clients are shared by all components, the queriers use the first node
+        std::vector<std::unique_ptr<AsyncRPCClient>> rpc_clients;
+        std::vector<AsyncRPCClient*> rpcs;
+        // the proofs are submitted through their own clients, the failures of the other calls never open their breakers
+        std::vector<AsyncRPCClient*> submit_rpcs;
+        AsyncRPCClient::Options submit_opts = rpc_opts;
+        rpc_opts.name = "query";
+        submit_opts.name = "submit";
+        for (auto const& url : urls) {
+            rpc_clients.push_back(make_rpc_client(url, rpc_opts));
+            rpcs.push_back(rpc_clients.back().get());
+            rpc_clients.push_back(make_rpc_client(url, submit_opts));
+            submit_rpcs.push_back(rpc_clients.back().get());
+        }
+        auto rpc_cache_ttl = std::chrono::milliseconds(parse_result["rpc-cache-ms"].as<int>());
+        for (auto prpc : rpcs) {
+            for (char const* method : { "queryupdatetiphistory", "querysupply", "querypledgeinfo", "querynetspace" }) {
+                prpc->SetCacheTTL(method, rpc_cache_ttl);
+            }
+        }
+        for (auto prpc : submit_rpcs) {
+            // each proof is sent alone, it never waits for the others
+            prpc->SetUnbatched("submitvdfproof");
+        }
+        AsyncRPCClient& rpc = *rpcs.front();
+        Timelord timelord(proof_ioc, ioc, rpcs, vdf_client_path, vdf_client_addr, vdf_client_port, fork_height, challenge_depth, persist_operator, persist_db, netspace, VDFProofSubmitter(submit_rpcs));
+        timelord.SetSendQueueLimit(static_cast<std::size_t>(std::max(parse_result["send-queue-kb"].as<int>(), 0)) * 1024, *slow_consumer_policy);
+        if (!frontend_iocs.empty()) {
+            std::vector<asio::io_context*> iocs;
+            for (auto const& pioc : frontend_iocs) {
+                iocs.push_back(pioc.get());
+            }
+            timelord.SetFrontEndAcceptorLoops(iocs);
+        }
+        std::set<std::string> push_from;
+        for (auto const& addr : parse_result["push-from"].as<std::vector<std::string>>()) {
+            if (!addr.empty()) {
+                push_from.insert(addr);
+            }
+        }
+        timelord.SetChallengePushAuth(push_from, parse_result["push-token"].as<std::string>());
 
         // before starting services, we need to import the missing blocks
         bool force_from_min_height = parse_result.count("skip-import-check") > 0;
         PLOGD << "Import missing blocks...";
-        int num_imported = ImportMissingBlocks(BlockInfoRangeLocalDBQuerier(db), BlockInfoRangeRPCQuerier(rpc), BlockInfoSQLiteSaver(db), fork_height, force_from_min_height);
+        // the history of all missing blocks is queried in one call, it is much larger and slower than the others
+        AsyncRPCClient::Options import_opts = rpc_opts;
+        import_opts.timeout = std::chrono::milliseconds(parse_result["rpc-import-timeout-ms"].as<int>());
+        import_opts.max_response_bytes = 0;
+        import_opts.name = "import";
+        auto pimport_rpc = make_rpc_client(urls.front(), import_opts);
+        int num_imported = ImportMissingBlocks(BlockInfoRangeLocalDBQuerier(db), BlockInfoRangeRPCQuerier(*pimport_rpc), BlockInfoSQLiteSaver(db), fork_height, force_from_min_height);
         PLOGI << tinyformat::format("total %d blocks are imported", num_imported);
 
         // prepare status querier
         bool skip_host_detection = parse_result.count("skip-host-detection") > 0;
-        StandardStatusQuerier status_querier(LastBlockInfoQuerier(rpc), VDFPackByChallengeQuerier(db), LocalDBNetspaceMaxSizeQuerier(db, fork_height), timelord, !skip_host_detection);
+        StandardStatusQuerier status_querier(LastBlockInfoQuerier(rpc), VDFPackByChallengeQuerier(db), NetspaceAggregatorMaxSizeQuerier(netspace), timelord, !skip_host_detection);
 
         // start web service
         PLOGI << tinyformat::format("web-service is listening on %s:%d", web_service_addr, web_service_port);
-        VDFWebService web_service(ioc, web_service_addr, web_service_port, 30, web_service_prefix, fork_height, NumHeightsByHoursQuerier(db, fork_height), BlockInfoRangeLocalDBQuerier(db), NetspaceSQLiteQuerier(db, true), status_querier, LocalDBRankQuerier(db, fork_height, 10), SupplyRPCQuerier(rpc), PledgeInfoRPCQuerier(rpc), RecentlyNetspaceSizeRPCQuerier(rpc));
+        VDFWebService web_service(ioc, web_service_addr, web_service_port, 30, web_service_prefix, fork_height, NumHeightsByHoursQuerier(db, fork_height), BlockInfoRangeLocalDBQuerier(db), NetspaceAggregatorQuerier(db, netspace), status_querier, LocalDBRankQuerier(db, fork_height, 10), SupplyRPCQuerier(rpc), PledgeInfoRPCQuerier(rpc), RecentlyNetspaceSizeRPCQuerier(rpc), [&rpc]() {
+            rpc.Prefetch({ { "queryupdatetiphistory", MakeRPCParams("1") }, { "querysupply", MakeRPCParams("0") }, { "querypledgeinfo", MakeRPCParams() }, { "querynetspace", MakeRPCParams() } });
+        }, [&timelord]() {
+            return timelord.QueryEventQueueStats();
+        }, []() {
+            return Instrumentation::GetInstance().QueryStats();
+        }, []() {
+            return MetricsRegistry::GetInstance().Render();
+        }, []() {
+            return ProofTracer::GetInstance().QueryStats();
+        });
         web_service.Run();
 
+        // the probes measure the lags of the loops
+        LoopLagProbe proof_lag_probe(proof_ioc, "proof", std::chrono::milliseconds(1000));
+        LoopLagProbe io_lag_probe(ioc, "io", std::chrono::milliseconds(1000));
+        proof_lag_probe.Run();
+        io_lag_probe.Run();
+
         // start timelord
         PLOGI << tinyformat::format("timelord is listening on %s:%d", timelord_addr, timelord_port);
         timelord.Run(timelord_addr, timelord_port);
-        ioc.run();
+        std::vector<std::unique_ptr<LoopThread>> frontend_loops;
+        for (auto const& pioc : frontend_iocs) {
+            frontend_loops.push_back(std::make_unique<LoopThread>(*pioc, "frontend", stop_on_error));
+        }
+        std::thread proof_thread([&proof_ioc, &stop_on_error, proof_cpu, proof_priority]() {
+            if (proof_cpu >= 0 && PinCurrentThreadToCore(proof_cpu)) {
+                PLOGI << "the proof loop is pinned to cpu " << proof_cpu;
+            }
+            if (proof_priority > 0 && RaiseCurrentThreadPriority(proof_priority)) {
+                PLOGI << "the priority of the proof loop is raised";
+            }
+            RunLoop(proof_ioc, "proof", stop_on_error);
+        });
+        std::vector<std::thread> io_threads;
+        for (int i = 1; i < num_io_threads; ++i) {
+            io_threads.emplace_back([&ioc, &stop_on_error]() {
+                RunLoop(ioc, "io", stop_on_error);
+            });
+        }
+        RunLoop(ioc, "io", stop_on_error);
+        for (auto& t : io_threads) {
+            t.join();
+        }
+        proof_ioc.stop();
+        proof_thread.join();
+        for (auto& ploop : frontend_loops) {
+            ploop->Stop();
+        }
+        rpc_loop.Stop();
         PLOGD << "exit.";
     } catch (std::exception const& e) {
         PLOGE << e.what();
@@ -0,0 +1,149 @@
+#include "metrics.h"
+
+#include <sstream>
+#include <stdexcept>
+
+#include <tinyformat.h>
+
+namespace
+{
+
+std::string JoinLabels(std::string_view labels, std::string_view extra)
+{
+    if (labels.empty()) {
+        return std::string(extra);
+    }
+    if (extra.empty()) {
+        return std::string(labels);
+    }
+    return tinyformat::format("%s,%s", labels, extra);
+}
+
+void RenderSample(std::ostream& os, std::string_view name, std::string_view labels, std::string const& value)
+{
+    os << name;
+    if (!labels.empty()) {
+        os << '{' << labels << '}';
+    }
+    os << ' ' << value << '\n';
+}
+
+void RenderHeader(std::ostream& os, std::string_view name, std::string_view help, char const* type)
+{
+    os << "# HELP " << name << ' ' << help << '\n';
+    os << "# TYPE " << name << ' ' << type << '\n';
+}
+
+void RenderHistogram(std::ostream& os, std::string_view name, std::string_view labels, LatencySnapshot const& snapshot)
+{
+    uint64_t accumulated { 0 };
+    for (std::size_t i = 0; i < snapshot.bucket_counts.size(); ++i) {
+        accumulated += snapshot.bucket_counts[i];
+        auto le = snapshot.bucket_bounds[i] < 0 ? std::string("+Inf") : tinyformat::format("%g", snapshot.bucket_bounds[i] / 1000000.0);
+        RenderSample(os, tinyformat::format("%s_bucket", name), JoinLabels(labels, MakeMetricLabel("le", le)), std::to_string(accumulated));
+    }
+    RenderSample(os, tinyformat::format("%s_sum", name), labels, tinyformat::format("%.6f", snapshot.sum_usecs / 1000000.0));
+    RenderSample(os, tinyformat::format("%s_count", name), labels, std::to_string(snapshot.count));
+}
+
+} // namespace
+
+MetricsRegistry& MetricsRegistry::GetInstance()
+{
+    static MetricsRegistry instance;
+    return instance;
+}
+
+Counter& MetricsRegistry::GetCounter(std::string_view name, std::string_view help, std::string_view labels)
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    auto& family = GetFamily(name, help, Type::COUNTER);
+    auto it = family.counters.find(labels);
+    if (it == std::end(family.counters)) {
+        it = family.counters.emplace(std::string(labels), std::make_unique<Counter>()).first;
+    }
+    return *it->second;
+}
+
+Gauge& MetricsRegistry::GetGauge(std::string_view name, std::string_view help, std::string_view labels)
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    auto& family = GetFamily(name, help, Type::GAUGE);
+    auto it = family.gauges.find(labels);
+    if (it == std::end(family.gauges)) {
+        it = family.gauges.emplace(std::string(labels), std::make_unique<Gauge>()).first;
+    }
+    return *it->second;
+}
+
+LatencyHistogram& MetricsRegistry::GetHistogram(std::string_view name, std::string_view help, std::string_view labels)
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    auto& family = GetFamily(name, help, Type::HISTOGRAM);
+    auto it = family.histograms.find(labels);
+    if (it == std::end(family.histograms)) {
+        it = family.histograms.emplace(std::string(labels), std::make_unique<LatencyHistogram>(tinyformat::format("%s{%s}", name, labels))).first;
+    }
+    return *it->second;
+}
+
+std::string MetricsRegistry::Render() const
+{
+    std::ostringstream os;
+    {
+        std::lock_guard<std::mutex> lg(mtx_);
+        for (auto const& [name, family] : families_) {
+            char const* type = family.type == Type::COUNTER ? "counter" : (family.type == Type::GAUGE ? "gauge" : "histogram");
+            RenderHeader(os, name, family.help, type);
+            for (auto const& [labels, pcounter] : family.counters) {
+                RenderSample(os, name, labels, std::to_string(pcounter->Get()));
+            }
+            for (auto const& [labels, pgauge] : family.gauges) {
+                RenderSample(os, name, labels, std::to_string(pgauge->Get()));
+            }
+            for (auto const& [labels, phistogram] : family.histograms) {
+                RenderHistogram(os, name, labels, phistogram->GetSnapshot());
+            }
+        }
+    }
+    auto stats = Instrumentation::GetInstance().QueryStats();
+    RenderHeader(os, "timelord_handler_duration_seconds", "The time the handlers block the loops", "histogram");
+    for (auto const& snapshot : stats.handlers) {
+        RenderHistogram(os, "timelord_handler_duration_seconds", MakeMetricLabel("subsystem", snapshot.name), snapshot);
+    }
+    RenderHeader(os, "timelord_loop_lag_seconds", "How late a periodic timer fires on the loops", "histogram");
+    for (auto const& snapshot : stats.loop_lags) {
+        RenderHistogram(os, "timelord_loop_lag_seconds", MakeMetricLabel("loop", snapshot.name), snapshot);
+    }
+    return os.str();
+}
+
+MetricsRegistry::Family& MetricsRegistry::GetFamily(std::string_view name, std::string_view help, Type type)
+{
+    auto it = families_.find(name);
+    if (it == std::end(families_)) {
+        Family family;
+        family.help = std::string(help);
+        family.type = type;
+        it = families_.emplace(std::string(name), std::move(family)).first;
+    } else if (it->second.type != type) {
+        throw std::runtime_error(tinyformat::format("the metric %s is registered with another type", name));
+    }
+    return it->second;
+}
+
+std::string MakeMetricLabel(std::string_view name, std::string_view value)
+{
+    std::string escaped;
+    for (char ch : value) {
+        if (ch == '\\' || ch == '"') {
+            escaped.push_back('\\');
+            escaped.push_back(ch);
+        } else if (ch == '\n') {
+            escaped.append("\\n");
+        } else {
+            escaped.push_back(ch);
+        }
+    }
+    return tinyformat::format("%s=\"%s\"", name, escaped);
+}
@@ -0,0 +1,103 @@
+#ifndef TL_METRICS_H
+#define TL_METRICS_H
+
+#include <cstdint>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <string>
+#include <string_view>
+
+#include "instrumentation.h"
+
+class Counter
+{
+public:
+    void Inc(uint64_t n = 1)
+    {
+        val_.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t Get() const
+    {
+        return val_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic_uint64_t val_ { 0 };
+};
+
+class Gauge
+{
+public:
+    void Set(int64_t val)
+    {
+        val_.store(val, std::memory_order_relaxed);
+    }
+
+    void Add(int64_t n)
+    {
+        val_.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    int64_t Get() const
+    {
+        return val_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic_int64_t val_ { 0 };
+};
+
+/**
+ * The metrics are rendered in the text format of Prometheus
+ *
+ * A metric is created (under the lock) on the first query by its name and labels, the callers keep the reference and the
+ * updates are only atomic operations. Rendering only reads the atomic values, so scraping never waits on the database or
+ * the RPC service
+ */
+class MetricsRegistry
+{
+public:
+    static MetricsRegistry& GetInstance();
+
+    /**
+     * @param labels The labels are formatted by `MakeMetricLabel` and joined by ','
+     */
+    Counter& GetCounter(std::string_view name, std::string_view help, std::string_view labels = "");
+
+    Gauge& GetGauge(std::string_view name, std::string_view help, std::string_view labels = "");
+
+    /**
+     * The histogram records the values in microseconds, they are rendered in seconds
+     */
+    LatencyHistogram& GetHistogram(std::string_view name, std::string_view help, std::string_view labels = "");
+
+    /**
+     * Render all metrics and the handler latencies and loop lags from `Instrumentation`
+     */
+    std::string Render() const;
+
+private:
+    enum class Type { COUNTER, GAUGE, HISTOGRAM };
+
+    struct Family {
+        std::string help;
+        Type type;
+        std::map<std::string, std::unique_ptr<Counter>, std::less<>> counters;
+        std::map<std::string, std::unique_ptr<Gauge>, std::less<>> gauges;
+        std::map<std::string, std::unique_ptr<LatencyHistogram>, std::less<>> histograms;
+    };
+
+    Family& GetFamily(std::string_view name, std::string_view help, Type type);
+
+    mutable std::mutex mtx_;
+    std::map<std::string, Family, std::less<>> families_;
+};
+
+std::string MakeMetricLabel(std::string_view name, std::string_view value);
+
+#endif
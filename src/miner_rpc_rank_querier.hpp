@@ -5,41 +5,52 @@
 #include <vector>
 
 #include "rank_record.h"
-#include "rpc_client.h"
+#include "async_rpc_client.h"
+#include "rpc_metrics.hpp"
 
 class MinerRPCRankQuerier
 {
 public:
-    MinerRPCRankQuerier(RPCClient& rpc, int start_height, int count)
+    using Result = std::tuple<std::vector<RankRecord>, int>;
+
+    MinerRPCRankQuerier(AsyncRPCClient& rpc, int start_height, int count)
         : rpc_(rpc)
+        , rpc_latency_(GetRPCLatency("countblockowners"))
         , start_height_(start_height)
         , count_(count)
     {
     }
 
-    std::tuple<std::vector<RankRecord>, int> operator()() const
+    void operator()(QueryHandler<Result> handler) const
+    {
+        AsyncQueryRPC(rpc_, rpc_latency_, "countblockowners", [start_height = start_height_, count = count_](UniValue const& result) {
+            return ConvertResult(result, start_height, count);
+        }, std::move(handler), std::to_string(start_height_));
+    }
+
+private:
+    static Result ConvertResult(UniValue const& result, int start_height, int count)
     {
         std::vector<RankRecord> ranks;
-        auto res = rpc_.Call("countblockowners", std::to_string(start_height_));
-        auto keys = res.result.getKeys();
+        auto keys = result.getKeys();
         int curr_count { 0 };
         for (auto const& key : keys) {
             if (key != "begin" && key != "end" && key != "count") {
                 RankRecord rank;
                 rank.address = key;
-                rank.produced_blocks = res.result[key].get_int64();
+                rank.produced_blocks = result[key].get_int64();
                 ranks.push_back(std::move(rank));
                 ++curr_count;
-                if (curr_count == count_) {
+                if (curr_count == count) {
                     break;
                 }
             }
         }
-        return std::make_tuple(ranks, start_height_);
+        return std::make_tuple(ranks, start_height);
     }
 
-private:
-    RPCClient& rpc_;
+    AsyncRPCClient& rpc_;
+    LatencyHistogram& rpc_latency_;
     int start_height_;
     int count_;
 };
@@ -1,16 +1,35 @@
 #ifndef MISSING_BLOCK_IMPORTER_HPP
 #define MISSING_BLOCK_IMPORTER_HPP
 
+#include <future>
+
 #include <plog/Log.h>
 
 #include "block_info.h"
 #include "timelord_utils.h"
 
+/**
+ * Start the query of the blocks and wait for the result, it is only for the thread which doesn't run the loop of the querier
+ */
+template <typename RPCQuerier> std::vector<BlockInfo> QueryBlocksAndWait(RPCQuerier& rpc_querier, int num_heights)
+{
+    std::promise<std::vector<BlockInfo>> promise;
+    auto future = promise.get_future();
+    rpc_querier(num_heights, [&promise](std::exception_ptr perr, std::vector<BlockInfo> const& blocks) {
+        if (perr) {
+            promise.set_exception(perr);
+        } else {
+            promise.set_value(blocks);
+        }
+    });
+    return future.get();
+}
+
 /**
  * @brief Find and import missing blocks from RPC server to local database
  *
  * @tparam LocalDBQuerier local database querier type
- * @tparam RPCQuerier RPC querier type
+ * @tparam RPCQuerier RPC querier type, the blocks are handed over to its handler
  * @tparam Saver local database saver type
  * @param local_querier local database querier
  * @param rpc_querier RPC querier
@@ -22,7 +41,7 @@
  */
 template <typename LocalDBQuerier, typename RPCQuerier, typename Saver> int ImportMissingBlocks(LocalDBQuerier local_querier, RPCQuerier rpc_querier, Saver saver, int min_height, bool force_from_min_height)
 {
-    auto blocks = rpc_querier(1);
+    auto blocks = QueryBlocksAndWait(rpc_querier, 1);
     if (blocks.empty()) {
         // something is wrong of the RPC service, cannot proceed
         PLOGE << "RPC service returns no block";
@@ -43,7 +62,7 @@ template <typename LocalDBQuerier, typename RPCQuerier, typename Saver> int Impo
     }
     PLOGD << tinyformat::format("querying total %d blocks from RPC service", num_heights);
 
-    blocks = rpc_querier(num_heights);
+    blocks = QueryBlocksAndWait(rpc_querier, num_heights);
 
     int num_saved { 0 };
     for (auto const& block : blocks) {
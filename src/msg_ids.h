@@ -10,12 +10,19 @@ enum class TimelordMsgs : int {
     READY = 1020,
     SPEED = 1030,
     CALC_REPLY = 1040,
+    ENCODING_ACK = 1050,
+    CHALLENGE = 1060,
+    CALC_BATCH_REPLY = 1070,
 };
 
 // messages send from Bhd
 enum class TimelordClientMsgs : int {
     PING = 2000,
     CALC = 2010,
+    NEW_CHALLENGE = 2020,
+    ENCODING = 2030,
+    SUBSCRIBE = 2040,
+    CALC_BATCH = 2050,
 };
 
 inline std::string MsgIdToString(TimelordMsgs id)
@@ -31,6 +38,12 @@ inline std::string MsgIdToString(TimelordMsgs id)
         return "(TimelordMsgs)SPEED";
     case TimelordMsgs::CALC_REPLY:
         return "(TimelordMsgs)CALC_REPLY";
+    case TimelordMsgs::ENCODING_ACK:
+        return "(TimelordMsgs)ENCODING_ACK";
+    case TimelordMsgs::CHALLENGE:
+        return "(TimelordMsgs)CHALLENGE";
+    case TimelordMsgs::CALC_BATCH_REPLY:
+        return "(TimelordMsgs)CALC_BATCH_REPLY";
     }
     return "{unknown}";
 }
@@ -42,6 +55,14 @@ inline std::string MsgIdToString(TimelordClientMsgs id)
         return "(TimelordClientMsgs)PING";
     case TimelordClientMsgs::CALC:
         return "(TimelordClientMsgs)CALC";
+    case TimelordClientMsgs::NEW_CHALLENGE:
+        return "(TimelordClientMsgs)NEW_CHALLENGE";
+    case TimelordClientMsgs::ENCODING:
+        return "(TimelordClientMsgs)ENCODING";
+    case TimelordClientMsgs::SUBSCRIBE:
+        return "(TimelordClientMsgs)SUBSCRIBE";
+    case TimelordClientMsgs::CALC_BATCH:
+        return "(TimelordClientMsgs)CALC_BATCH";
     }
     return "{unknown}";
 }
@@ -0,0 +1,76 @@
+#include "netspace_aggregator.h"
+
+#include <algorithm>
+
+NetspaceAggregator::NetspaceAggregator(std::size_t max_history)
+    : max_history_(std::max<std::size_t>(max_history, 1))
+{
+}
+
+void NetspaceAggregator::Seed(std::vector<Entry> entries, std::vector<VDFRequest> const& last_requests)
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    history_.clear();
+    groups_.clear();
+    for (auto& entry : entries) {
+        history_.push_back(std::move(entry));
+        if (history_.size() > max_history_) {
+            history_.pop_front();
+        }
+    }
+    if (history_.empty()) {
+        return;
+    }
+    for (auto const& req : last_requests) {
+        if (req.challenge == history_.back().challenge) {
+            groups_.insert(req.group_hash);
+        }
+    }
+}
+
+void NetspaceAggregator::NewChallenge(uint256 const& challenge, int height, uint32_t timestamp)
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    if (!history_.empty() && history_.back().challenge == challenge) {
+        // the challenge is still the current one, keep summing
+        return;
+    }
+    groups_.clear();
+    history_.push_back({ challenge, height, timestamp, 0, 0 });
+    if (history_.size() > max_history_) {
+        history_.pop_front();
+    }
+}
+
+std::tuple<uint64_t, bool> NetspaceAggregator::Add(uint256 const& group_hash, uint64_t total_size)
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    if (history_.empty()) {
+        return std::make_tuple(0, false);
+    }
+    auto& curr = history_.back();
+    bool newly = groups_.insert(group_hash);
+    if (newly) {
+        curr.total_size += total_size;
+        ++curr.num_groups;
+    }
+    return std::make_tuple(curr.total_size, newly);
+}
+
+uint64_t NetspaceAggregator::GetCurrentSize() const
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    return history_.empty() ? 0 : history_.back().total_size;
+}
+
+uint64_t NetspaceAggregator::QueryMaxSize(int best_height, uint32_t since_timestamp) const
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    uint64_t max_size { 0 };
+    for (auto const& entry : history_) {
+        if (entry.height < best_height && entry.timestamp >= since_timestamp) {
+            max_size = std::max(max_size, entry.total_size);
+        }
+    }
+    return max_size;
+}
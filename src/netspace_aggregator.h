@@ -0,0 +1,71 @@
+#ifndef TL_NETSPACE_AGGREGATOR_H
+#define TL_NETSPACE_AGGREGATOR_H
+
+#include <cstdint>
+
+#include <deque>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include "common_types.h"
+#include "flat_hash_map.hpp"
+
+#include "netspace_data.h"
+#include "vdf_record.h"
+
+/**
+ * Sums the netspace reported by the groups of miners for each challenge, the totals of the last challenges are kept in memory
+ *
+ * The aggregator is updated by timelord and it is read by the web service from other threads, all methods are thread-safe
+ */
+class NetspaceAggregator
+{
+public:
+    using Entry = NetspaceSummary;
+
+    explicit NetspaceAggregator(std::size_t max_history);
+
+    /**
+     * Initialize the history with the entries from local database
+     *
+     * @param entries The entries are ordered from the oldest one to the newest one
+     * @param last_requests The saved requests of the newest entry, they are used to identify the groups have already reported
+     */
+    void Seed(std::vector<Entry> entries, std::vector<VDFRequest> const& last_requests);
+
+    /**
+     * Start to sum the netspace for a new challenge
+     */
+    void NewChallenge(uint256 const& challenge, int height, uint32_t timestamp);
+
+    /**
+     * Add the netspace of a group to the current challenge
+     *
+     * @return The total size of the current challenge and true when the group is new to the challenge
+     */
+    std::tuple<uint64_t, bool> Add(uint256 const& group_hash, uint64_t total_size);
+
+    uint64_t GetCurrentSize() const;
+
+    /**
+     * Find the maximum netspace size of the challenges those height are less than `best_height`
+     *
+     * @param since_timestamp Only count the challenges those timestamp >= since_timestamp
+     */
+    uint64_t QueryMaxSize(int best_height, uint32_t since_timestamp = 0) const;
+
+    std::deque<Entry> GetHistory() const
+    {
+        std::lock_guard<std::mutex> lg(mtx_);
+        return history_;
+    }
+
+private:
+    mutable std::mutex mtx_;
+    std::size_t max_history_;
+    std::deque<Entry> history_;
+    FlatHashSet<uint256> groups_;
+};
+
+#endif
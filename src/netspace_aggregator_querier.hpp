@@ -0,0 +1,63 @@
+#ifndef NETSPACE_AGGREGATOR_QUERIER_HPP
+#define NETSPACE_AGGREGATOR_QUERIER_HPP
+
+#include <ctime>
+
+#include <map>
+#include <vector>
+
+#include "netspace_aggregator.h"
+#include "netspace_data.h"
+
+#include "local_sqlite_storage.h"
+
+class NetspaceAggregatorMaxSizeQuerier
+{
+public:
+    explicit NetspaceAggregatorMaxSizeQuerier(NetspaceAggregator const& aggregator)
+        : aggregator_(aggregator)
+    {
+    }
+
+    uint64_t operator()(int pass_hours, int best_height) const
+    {
+        uint32_t since_timestamp = pass_hours == 0 ? 0 : time(nullptr) - pass_hours * 60 * 60;
+        return aggregator_.QueryMaxSize(best_height, since_timestamp);
+    }
+
+private:
+    NetspaceAggregator const& aggregator_;
+};
+
+class NetspaceAggregatorQuerier
+{
+public:
+    NetspaceAggregatorQuerier(LocalSQLiteStorage& storage, NetspaceAggregator const& aggregator)
+        : storage_(storage)
+        , aggregator_(aggregator)
+    {
+    }
+
+    std::vector<NetspaceData> operator()(int num_heights) const
+    {
+        // the blocks are queried without joining the requests, the netspace is filled from the aggregator
+        auto data = storage_.QueryNetspace(num_heights, false);
+        std::map<uint256, uint64_t> sizes;
+        for (auto const& entry : aggregator_.GetHistory()) {
+            sizes.insert_or_assign(entry.challenge, entry.total_size);
+        }
+        for (auto& d : data) {
+            auto it = sizes.find(d.challenge);
+            if (it != std::cend(sizes)) {
+                d.netspace = it->second;
+            }
+        }
+        return data;
+    }
+
+private:
+    LocalSQLiteStorage& storage_;
+    NetspaceAggregator const& aggregator_;
+};
+
+#endif
@@ -3,11 +3,22 @@
 
 #include <cstdint>
 
+#include "common_types.h"
+
 struct NetspaceData {
+    uint256 challenge;
     int height;
     uint64_t challenge_difficulty;
     uint64_t block_difficulty;
     uint64_t netspace;
 };
 
+struct NetspaceSummary {
+    uint256 challenge;
+    int height;
+    uint32_t timestamp;
+    uint64_t total_size;
+    std::size_t num_groups;
+};
+
 #endif
@@ -0,0 +1,127 @@
+#include "persist_worker.h"
+
+#include <plog/Log.h>
+#include <tinyformat.h>
+
+#include "timelord_events.h"
+#include "timelord_utils.h"
+
+PersistWorker::PersistWorker(BlockInfoRangeAsyncQuerierType block_info_querier, BlockInfoSaverType block_info_saver, LocalSQLiteDatabaseKeeper& persist_operator, int fork_height)
+    : block_info_querier_(std::move(block_info_querier))
+    , block_info_saver_(std::move(block_info_saver))
+    , persist_operator_(persist_operator)
+    , fork_height_(fork_height)
+{
+}
+
+PersistWorker::~PersistWorker()
+{
+    Exit();
+}
+
+void PersistWorker::Run()
+{
+    if (pthread_) {
+        return;
+    }
+    work_guard_.emplace(asio::make_work_guard(ioc_));
+    pthread_ = std::make_unique<std::thread>([this]() {
+        PLOGD << "persist worker is running";
+        ioc_.run();
+        PLOGD << "persist worker exited";
+    });
+}
+
+void PersistWorker::Exit()
+{
+    // all pending jobs are going to be finished before the thread exits
+    work_guard_.reset();
+    if (pthread_) {
+        pthread_->join();
+        pthread_.reset();
+    }
+}
+
+void PersistWorker::Subscribe(EventBus& bus)
+{
+    bus.Subscribe<ChallengeRecordedEvent>("persist", ioc_.get_executor(), [this](ChallengeRecordedEvent const& event) {
+        SaveRecord(event.record);
+        SaveLastBlock(event.record.height);
+        for (auto const& request : event.requests) {
+            SaveRequest(request);
+        }
+    });
+    bus.Subscribe<CalcRequestedEvent>("persist", ioc_.get_executor(), [this](CalcRequestedEvent const& event) {
+        SaveRequest(event.request);
+    });
+    bus.Subscribe<CalcBatchRequestedEvent>("persist", ioc_.get_executor(), [this](CalcBatchRequestedEvent const& event) {
+        SaveRequests(event.requests);
+    });
+}
+
+void PersistWorker::SaveRecord(VDFRecord const& record)
+{
+    // append new record to local database for the incoming block
+    if (record.height < fork_height_) {
+        PLOGE << tinyformat::format("challenge on height %d is less than fork height %d", record.height, fork_height_);
+        return;
+    }
+    try {
+        persist_operator_.AppendRecord(record);
+    } catch (std::exception const& e) {
+        PLOGE << tinyformat::format("cannot save the record of challenge %s, err: %s", Uint256ToHex(record.challenge), e.what());
+    }
+}
+
+void PersistWorker::SaveLastBlock(int height)
+{
+    // we should query last new block info. and save it to local database, the worker keeps running until the result arrives
+    block_info_querier_(1, [this, height, work_guard = asio::make_work_guard(ioc_)](std::exception_ptr perr, std::vector<BlockInfo> const& new_blocks) {
+        try {
+            if (perr) {
+                std::rethrow_exception(perr);
+            }
+        } catch (std::exception const& e) {
+            PLOGE << tinyformat::format("cannot query the last block info, err: %s", e.what());
+            return;
+        }
+        if (new_blocks.empty()) {
+            return;
+        }
+        asio::post(ioc_, [this, height, block_info = new_blocks.front()]() {
+            SaveBlock(height, block_info);
+        });
+    });
+}
+
+void PersistWorker::SaveBlock(int height, BlockInfo const& block_info)
+{
+    // check the block height before we save it
+    if (block_info.height == height - 1 && height - 1 >= fork_height_) {
+        // ok, we got a record
+        try {
+            block_info_saver_(block_info);
+            PLOGI << tinyformat::format("saved block height=%d into local db", block_info.height);
+        } catch (std::exception const& e) {
+            PLOGE << tinyformat::format("cannot save block height=%d into local db, err: %s", block_info.height, e.what());
+        }
+    }
+}
+
+void PersistWorker::SaveRequest(VDFRequest const& request)
+{
+    try {
+        persist_operator_.AppendRequest(request);
+    } catch (std::exception const& e) {
+        PLOGE << tinyformat::format("cannot save the request(group_hash: %s): %s", Uint256ToHex(request.group_hash), e.what());
+    }
+}
+
+void PersistWorker::SaveRequests(std::vector<VDFRequest> const& requests)
+{
+    try {
+        persist_operator_.AppendRequests(requests);
+    } catch (std::exception const& e) {
+        PLOGE << tinyformat::format("cannot save %d request(s): %s", requests.size(), e.what());
+    }
+}
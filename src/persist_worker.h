@@ -0,0 +1,63 @@
+#ifndef TL_PERSIST_WORKER_H
+#define TL_PERSIST_WORKER_H
+
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "asio_defs.hpp"
+
+#include "common_types.h"
+
+#include "block_info.h"
+#include "vdf_record.h"
+
+#include "event_bus.hpp"
+#include "local_sqlite_storage.h"
+
+/**
+ * Runs the database writes on a background thread and the RPC queries asynchronously, so the io thread which delivers
+ * the challenges and the proofs never waits on them
+ */
+class PersistWorker
+{
+public:
+    PersistWorker(BlockInfoRangeAsyncQuerierType block_info_querier, BlockInfoSaverType block_info_saver, LocalSQLiteDatabaseKeeper& persist_operator, int fork_height);
+
+    ~PersistWorker();
+
+    void Run();
+
+    void Exit();
+
+    /**
+     * Subscribe the events to save on the worker thread: the record of the new challenge with the last block and the requests
+     * are related to the challenge, and the requests report the netspace of new groups
+     */
+    void Subscribe(EventBus& bus);
+
+private:
+    void SaveRecord(VDFRecord const& record);
+
+    /**
+     * Query the last block from the RPC service, it is saved on the worker thread when the result is received
+     */
+    void SaveLastBlock(int height);
+
+    void SaveBlock(int height, BlockInfo const& block_info);
+
+    void SaveRequest(VDFRequest const& request);
+
+    void SaveRequests(std::vector<VDFRequest> const& requests);
+
+    asio::io_context ioc_;
+    std::optional<asio::executor_work_guard<asio::io_context::executor_type>> work_guard_;
+    std::unique_ptr<std::thread> pthread_;
+    BlockInfoRangeAsyncQuerierType block_info_querier_;
+    BlockInfoSaverType block_info_saver_;
+    LocalSQLiteDatabaseKeeper& persist_operator_;
+    int fork_height_;
+};
+
+#endif
@@ -2,26 +2,33 @@
 #define PLEDGE_INFO_RPC_QUERIER_HPP
 
 #include "pledge_info.h"
-#include "rpc_client.h"
+#include "async_rpc_client.h"
+#include "rpc_metrics.hpp"
 
 class PledgeInfoRPCQuerier
 {
 public:
-    explicit PledgeInfoRPCQuerier(RPCClient& rpc)
+    explicit PledgeInfoRPCQuerier(AsyncRPCClient& rpc)
         : rpc_(rpc)
+        , rpc_latency_(GetRPCLatency("querypledgeinfo"))
     {
     }
 
-    PledgeInfo operator()() const
+    void operator()(QueryHandler<PledgeInfo> handler) const
     {
-        auto res = rpc_.Call("querypledgeinfo");
-        if (!res.result.isObject()) {
+        AsyncQueryRPC(rpc_, rpc_latency_, "querypledgeinfo", &PledgeInfoRPCQuerier::ConvertResult, std::move(handler));
+    }
+
+private:
+    static PledgeInfo ConvertResult(UniValue const& result)
+    {
+        if (!result.isObject()) {
             throw std::runtime_error("the type of the result from RPC command `querypledgeinfo` is not object");
         }
         PledgeInfo pledge_info;
-        pledge_info.retarget_min_heights = res.result["retarget_min_heights"].get_int();
-        pledge_info.capacity_eval_window = res.result["capacity_eval_window"].get_int();
-        auto terms_json = res.result["terms"].getValues();
+        pledge_info.retarget_min_heights = result["retarget_min_heights"].get_int();
+        pledge_info.capacity_eval_window = result["capacity_eval_window"].get_int();
+        auto terms_json = result["terms"].getValues();
         int i { 0 };
         for (auto const& term_json : terms_json) {
             PledgeItem pledge;
@@ -32,8 +39,8 @@ public:
         return pledge_info;
     }
 
-private:
-    RPCClient& rpc_;
+    AsyncRPCClient& rpc_;
+    LatencyHistogram& rpc_latency_;
 };
 
 #endif
@@ -0,0 +1,28 @@
+#ifndef TL_PROOF_DETAIL_H
+#define TL_PROOF_DETAIL_H
+
+#include <cstdint>
+
+#include <memory>
+
+#include "common_types.h"
+
+namespace vdf_client
+{
+
+/**
+ * A proof from vdf_client, it is never changed after it is parsed and it is shared by all consumers
+ */
+struct ProofDetail {
+    VdfForm y;
+    Bytes proof;
+    uint8_t witness_type;
+    uint64_t iters;
+    int duration;
+};
+
+using ProofDetailPtr = std::shared_ptr<ProofDetail const>;
+
+} // namespace vdf_client
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef TL_PROOF_TRACE_H
+#define TL_PROOF_TRACE_H
+
+#include <cstdint>
+
+#include <utility>
+#include <vector>
+
+#include "common_types.h"
+
+#include "latency_stats.h"
+
+enum class ProofStage : int {
+    CHALLENGE_OBSERVED,
+    VDF_CLIENT_SPAWNED,
+    VDF_CLIENT_READY,
+    ITERS_SENT,
+    PROOF_RECEIVED,
+    PROOF_SUBMITTED,
+    PROOF_WRITTEN,
+};
+
+inline char const* ProofStageToString(ProofStage stage)
+{
+    switch (stage) {
+    case ProofStage::CHALLENGE_OBSERVED:
+        return "challenge_observed";
+    case ProofStage::VDF_CLIENT_SPAWNED:
+        return "vdf_client_spawned";
+    case ProofStage::VDF_CLIENT_READY:
+        return "vdf_client_ready";
+    case ProofStage::ITERS_SENT:
+        return "iters_sent";
+    case ProofStage::PROOF_RECEIVED:
+        return "proof_received";
+    case ProofStage::PROOF_SUBMITTED:
+        return "proof_submitted";
+    case ProofStage::PROOF_WRITTEN:
+        return "proof_written";
+    }
+    return "unknown";
+}
+
+// the stages with the microseconds since the trace is created
+using ProofStageTimes = std::vector<std::pair<ProofStage, int64_t>>;
+
+struct ProofRequestTrace {
+    uint64_t iters;
+    // each stage is recorded once, proof_written is the time of the first write
+    ProofStageTimes stages;
+    // the proof is written to many sessions, the writes are counted and the time of the last one is kept
+    uint64_t num_written { 0 };
+    int64_t last_written { 0 };
+};
+
+struct ChallengeTrace {
+    uint256 challenge;
+    // unix time in milliseconds when the trace is created
+    int64_t created_at;
+    ProofStageTimes stages;
+    std::vector<ProofRequestTrace> requests;
+};
+
+struct ProofTraceStats {
+    std::vector<LatencySnapshot> stages;
+    std::vector<ChallengeTrace> recent;
+};
+
+#endif
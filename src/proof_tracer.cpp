@@ -0,0 +1,129 @@
+#include "proof_tracer.h"
+
+#include <algorithm>
+
+#include "metrics.h"
+
+ProofTracer& ProofTracer::GetInstance()
+{
+    static ProofTracer instance;
+    return instance;
+}
+
+ProofTracer::ProofTracer()
+{
+    for (int i = static_cast<int>(ProofStage::VDF_CLIENT_SPAWNED); i < static_cast<int>(durations_.size()); ++i) {
+        durations_[i] = &MetricsRegistry::GetInstance().GetHistogram("timelord_proof_stage_seconds", "The duration of the stages of the proofs", MakeMetricLabel("stage", ProofStageToString(static_cast<ProofStage>(i))));
+    }
+}
+
+void ProofTracer::MarkChallenge(uint256 const& challenge, ProofStage stage)
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    auto& entry = GetEntry(challenge);
+    auto& stages = entry.trace.stages;
+    bool exists = std::any_of(std::cbegin(stages), std::cend(stages), [stage](auto const& stage_time) {
+        return stage_time.first == stage;
+    });
+    if (exists) {
+        return;
+    }
+    int64_t elapsed = GetElapsed(entry);
+    stages.emplace_back(stage, elapsed);
+    RecordDuration(stage, stages, ProofStage::CHALLENGE_OBSERVED, elapsed);
+}
+
+void ProofTracer::MarkRequest(uint256 const& challenge, uint64_t iters, ProofStage stage)
+{
+    std::lock_guard<std::mutex> lg(mtx_);
+    auto& entry = GetEntry(challenge);
+    auto& requests = entry.trace.requests;
+    auto it = std::find_if(std::begin(requests), std::end(requests), [iters](ProofRequestTrace const& request) {
+        return request.iters == iters;
+    });
+    if (it == std::end(requests)) {
+        ProofRequestTrace request;
+        request.iters = iters;
+        it = requests.insert(std::end(requests), std::move(request));
+    }
+    auto& stages = it->stages;
+    int64_t elapsed = GetElapsed(entry);
+    if (stage == ProofStage::PROOF_WRITTEN) {
+        // the writes to the sessions are aggregated, the trace doesn't grow with the number of sessions
+        if (it->num_written++ == 0) {
+            stages.emplace_back(stage, elapsed);
+        }
+        it->last_written = elapsed;
+        RecordDuration(stage, stages, ProofStage::PROOF_RECEIVED, elapsed);
+        return;
+    }
+    bool exists = std::any_of(std::cbegin(stages), std::cend(stages), [stage](auto const& stage_time) {
+        return stage_time.first == stage;
+    });
+    if (exists) {
+        return;
+    }
+    stages.emplace_back(stage, elapsed);
+    if (stage == ProofStage::ITERS_SENT) {
+        RecordDuration(stage, entry.trace.stages, ProofStage::CHALLENGE_OBSERVED, elapsed);
+    } else if (stage == ProofStage::PROOF_RECEIVED) {
+        RecordDuration(stage, stages, ProofStage::ITERS_SENT, elapsed);
+    } else {
+        RecordDuration(stage, stages, ProofStage::PROOF_RECEIVED, elapsed);
+    }
+}
+
+ProofTraceStats ProofTracer::QueryStats() const
+{
+    ProofTraceStats stats;
+    for (std::size_t i = 0; i < durations_.size(); ++i) {
+        if (durations_[i]) {
+            auto snapshot = durations_[i]->GetSnapshot();
+            snapshot.name = ProofStageToString(static_cast<ProofStage>(i));
+            stats.stages.push_back(std::move(snapshot));
+        }
+    }
+    std::lock_guard<std::mutex> lg(mtx_);
+    for (auto it = std::crbegin(entries_); it != std::crend(entries_); ++it) {
+        stats.recent.push_back(it->trace);
+    }
+    return stats;
+}
+
+ProofTracer::Entry& ProofTracer::GetEntry(uint256 const& challenge)
+{
+    auto it = std::find_if(std::begin(entries_), std::end(entries_), [&challenge](Entry const& entry) {
+        return entry.trace.challenge == challenge;
+    });
+    if (it != std::end(entries_)) {
+        return *it;
+    }
+    if (entries_.size() == MAX_RECENT_CHALLENGES) {
+        entries_.pop_front();
+    }
+    Entry entry;
+    entry.trace.challenge = challenge;
+    entry.trace.created_at = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    entry.base = Clock::now();
+    entries_.push_back(std::move(entry));
+    return entries_.back();
+}
+
+int64_t ProofTracer::GetElapsed(Entry const& entry) const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - entry.base).count();
+}
+
+void ProofTracer::RecordDuration(ProofStage stage, ProofStageTimes const& from_stages, ProofStage from, int64_t elapsed)
+{
+    auto platency = durations_[static_cast<int>(stage)];
+    if (platency == nullptr) {
+        return;
+    }
+    auto it = std::find_if(std::cbegin(from_stages), std::cend(from_stages), [from](auto const& stage_time) {
+        return stage_time.first == from;
+    });
+    if (it != std::cend(from_stages)) {
+        platency->Record(elapsed - it->second);
+    }
+}
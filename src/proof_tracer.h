@@ -0,0 +1,60 @@
+#ifndef TL_PROOF_TRACER_H
+#define TL_PROOF_TRACER_H
+
+#include <cstdint>
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <mutex>
+
+#include "common_types.h"
+
+#include "instrumentation.h"
+#include "proof_trace.h"
+
+/**
+ * Records the time of each stage from a new challenge to the proofs are written to the sessions, the stages can be marked
+ * from any thread
+ *
+ * The recent challenges are kept with their raw traces. The duration of each stage is also recorded into a histogram, it is
+ * measured from the stage before it:
+ *   vdf_client_spawned, vdf_client_ready and iters_sent: since challenge_observed
+ *   proof_received: since iters_sent
+ *   proof_submitted and proof_written: since proof_received
+ */
+class ProofTracer
+{
+public:
+    static constexpr std::size_t MAX_RECENT_CHALLENGES = 32;
+
+    static ProofTracer& GetInstance();
+
+    ProofTracer();
+
+    void MarkChallenge(uint256 const& challenge, ProofStage stage);
+
+    void MarkRequest(uint256 const& challenge, uint64_t iters, ProofStage stage);
+
+    ProofTraceStats QueryStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        ChallengeTrace trace;
+        Clock::time_point base;
+    };
+
+    Entry& GetEntry(uint256 const& challenge);
+
+    int64_t GetElapsed(Entry const& entry) const;
+
+    void RecordDuration(ProofStage stage, ProofStageTimes const& from_stages, ProofStage from, int64_t elapsed);
+
+    mutable std::mutex mtx_;
+    std::deque<Entry> entries_;
+    std::array<LatencyHistogram*, static_cast<int>(ProofStage::PROOF_WRITTEN) + 1> durations_ {};
+};
+
+#endif
@@ -2,19 +2,29 @@
 #define QUERIER_DEFS_H
 
 #include <functional>
+#include <string>
 #include <vector>
 
 #include "block_info.h"
+#include "event_queue_stats.h"
+#include "latency_stats.h"
 #include "netspace_data.h"
+#include "proof_detail.h"
 #include "pledge_info.h"
+#include "proof_trace.h"
+#include "query_handler.h"
 #include "rank_record.h"
 #include "supply_data.h"
 #include "timelord_status.h"
 #include "vdf_record.h"
 
-using TimelordStatusQuerierType = std::function<TimelordStatus()>;
+/**
+ * The queriers below which take a `QueryHandler` are served from the RPC service, the handler is invoked from the loop of
+ * the RPC client and it should never wait on the others
+ */
+using TimelordStatusQuerierType = std::function<void(QueryHandler<TimelordStatus> handler)>;
 
-using LastBlockInfoQuerierType = std::function<BlockInfo()>;
+using LastBlockInfoQuerierType = std::function<void(QueryHandler<BlockInfo> handler)>;
 
 using BlockInfoRangeQuerierType = std::function<std::vector<BlockInfo>(int num_heights)>;
 
@@ -28,12 +38,25 @@ using RankQuerierType = std::function<std::tuple<std::vector<RankRecord>, int>(i
 
 using NetspaceSizeQuerierType = std::function<uint64_t(int pass_hours, int best_height)>;
 
-using SupplyQuerierType = std::function<Supply()>;
+using SupplyQuerierType = std::function<void(QueryHandler<Supply> handler)>;
 
-using PledgeInfoQuerierType = std::function<PledgeInfo()>;
+using PledgeInfoQuerierType = std::function<void(QueryHandler<PledgeInfo> handler)>;
 
-using RecentlyNetspaceSizeQuerierType = std::function<uint64_t()>;
+using RecentlyNetspaceSizeQuerierType = std::function<void(QueryHandler<uint64_t> handler)>;
 
-using VDFProofSubmitterType = std::function<void(uint256 const& challenge, Bytes const& y, Bytes const& proof, int witness_type, uint64_t iters, int duration)>;
+/**
+ * Start the RPC calls of the status in one batch, the queriers above are served from the results
+ */
+using RPCPrefetcherType = std::function<void()>;
+
+using EventQueueStatsQuerierType = std::function<std::vector<EventQueueStats>()>;
+
+using LatencyStatsQuerierType = std::function<LatencyStats()>;
+
+using MetricsQuerierType = std::function<std::string()>;
+
+using ProofTraceQuerierType = std::function<ProofTraceStats()>;
+
+using VDFProofSubmitterType = std::function<void(uint256 const& challenge, vdf_client::ProofDetailPtr const& detail)>;
 
 #endif
@@ -0,0 +1,12 @@
+#ifndef QUERY_HANDLER_H
+#define QUERY_HANDLER_H
+
+#include <exception>
+#include <functional>
+
+/**
+ * Receives the result of an asynchronous query, the result is default constructed when `perr` is set
+ */
+template <typename T> using QueryHandler = std::function<void(std::exception_ptr perr, T const& result)>;
+
+#endif
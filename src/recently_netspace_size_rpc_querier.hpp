@@ -3,27 +3,34 @@
 
 #include <cstdint>
 
-#include "rpc_client.h"
+#include "async_rpc_client.h"
+#include "rpc_metrics.hpp"
 
 class RecentlyNetspaceSizeRPCQuerier
 {
 public:
-    explicit RecentlyNetspaceSizeRPCQuerier(RPCClient& rpc)
+    explicit RecentlyNetspaceSizeRPCQuerier(AsyncRPCClient& rpc)
         : rpc_(rpc)
+        , rpc_latency_(GetRPCLatency("querynetspace"))
     {
     }
 
-    uint64_t operator()() const
+    void operator()(QueryHandler<uint64_t> handler) const
     {
-        auto res = rpc_.Call("querynetspace");
-        if (!res.result.isObject()) {
+        AsyncQueryRPC(rpc_, rpc_latency_, "querynetspace", &RecentlyNetspaceSizeRPCQuerier::ConvertResult, std::move(handler));
+    }
+
+private:
+    static uint64_t ConvertResult(UniValue const& result)
+    {
+        if (!result.isObject()) {
             throw std::runtime_error("require an object but the service didn't return one.");
         }
-        return res.result["netspace_tib"].get_int64();
+        return result["netspace_tib"].get_int64();
     }
 
-private:
-    RPCClient& rpc_;
+    AsyncRPCClient& rpc_;
+    LatencyHistogram& rpc_latency_;
 };
 
 #endif
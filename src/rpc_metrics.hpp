@@ -0,0 +1,48 @@
+#ifndef RPC_METRICS_HPP
+#define RPC_METRICS_HPP
+
+#include <chrono>
+#include <string_view>
+#include <utility>
+
+#include "async_rpc_client.h"
+
+#include "metrics.h"
+#include "query_handler.h"
+
+inline LatencyHistogram& GetRPCLatency(std::string_view method)
+{
+    return MetricsRegistry::GetInstance().GetHistogram("timelord_rpc_duration_seconds", "The duration of the RPC calls", MakeMetricLabel("method", method));
+}
+
+/**
+ * Start the call of the RPC method, the duration is recorded before the handler is invoked from the strand of the client
+ */
+template <typename... Args> void AsyncCallRPC(AsyncRPCClient& rpc, LatencyHistogram& latency, std::string const& method, AsyncRPCClient::Handler handler, Args&&... args)
+{
+    rpc.AsyncCall(method, MakeRPCParams(std::forward<Args>(args)...), [&latency, start = std::chrono::steady_clock::now(), handler = std::move(handler)](std::exception_ptr perr, UniValue const& result) {
+        latency.Record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+        handler(perr, result);
+    });
+}
+
+/**
+ * Start the call of the RPC method and hand the result converted by `convert` to the handler, the errors of the call and the
+ * conversion are handed over as the exception
+ */
+template <typename T, typename Converter, typename... Args> void AsyncQueryRPC(AsyncRPCClient& rpc, LatencyHistogram& latency, std::string const& method, Converter convert, QueryHandler<T> handler, Args&&... args)
+{
+    AsyncCallRPC(rpc, latency, method, [convert = std::move(convert), handler = std::move(handler)](std::exception_ptr perr, UniValue const& result) {
+        T value {};
+        if (!perr) {
+            try {
+                value = convert(result);
+            } catch (...) {
+                perr = std::current_exception();
+            }
+        }
+        handler(perr, value);
+    }, std::forward<Args>(args)...);
+}
+
+#endif
@@ -1,11 +1,58 @@
 #include "sqlite_stmt_wrap.h"
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+
 #include <tinyformat.h>
 
+#include "metrics.h"
 #include "timelord_utils.h"
 
+namespace
+{
+
+// the statements are labeled by the first word, the others are labeled as `other'
+constexpr std::array<std::string_view, 14> STATEMENT_KINDS { "select", "insert", "update", "delete", "replace", "create", "drop", "alter", "begin", "commit", "rollback", "pragma", "with", "other" };
+
+bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs)
+{
+    return lhs.size() == rhs.size() && std::equal(std::cbegin(lhs), std::cend(lhs), std::cbegin(rhs), [](char l, char r) {
+        return std::tolower(static_cast<unsigned char>(l)) == std::tolower(static_cast<unsigned char>(r));
+    });
+}
+
+/**
+ * The histograms are resolved once for all kinds, the statements are prepared without touching the registry
+ */
+LatencyHistogram& GetStatementLatency(std::string_view sql)
+{
+    static std::array<LatencyHistogram*, STATEMENT_KINDS.size()> const latencies = []() {
+        std::array<LatencyHistogram*, STATEMENT_KINDS.size()> latencies;
+        for (std::size_t i = 0; i < STATEMENT_KINDS.size(); ++i) {
+            latencies[i] = &MetricsRegistry::GetInstance().GetHistogram("timelord_sqlite_statement_duration_seconds", "The duration of the steps of the sqlite statements", MakeMetricLabel("statement", STATEMENT_KINDS[i]));
+        }
+        return latencies;
+    }();
+    std::string_view kind;
+    auto begin = sql.find_first_not_of(" \t\r\n");
+    if (begin != std::string_view::npos) {
+        auto end = sql.find_first_of(" \t\r\n(", begin);
+        kind = sql.substr(begin, end == std::string_view::npos ? std::string_view::npos : end - begin);
+    }
+    for (std::size_t i = 0; i + 1 < STATEMENT_KINDS.size(); ++i) {
+        if (EqualsIgnoreCase(kind, STATEMENT_KINDS[i])) {
+            return *latencies[i];
+        }
+    }
+    return *latencies.back();
+}
+
+} // namespace
+
 SQLiteStmt::SQLiteStmt(sqlite3* sql3, std::string_view sql)
     : sql3_(sql3)
+    , platency_(&GetStatementLatency(sql))
 {
     CheckSQL(sql3, sqlite3_prepare_v2(sql3_, sql.data(), -1, &stmt_, nullptr));
 }
@@ -27,6 +74,7 @@ void SQLiteStmt::Close()
 }
 
 SQLiteStmt::SQLiteStmt(SQLiteStmt&& rhs)
+    : platency_(rhs.platency_)
 {
     stmt_ = rhs.stmt_;
     rhs.stmt_ = nullptr;
@@ -36,6 +84,7 @@ SQLiteStmt& SQLiteStmt::operator=(SQLiteStmt&& rhs)
 {
     if (&rhs != this) {
         stmt_ = rhs.stmt_;
+        platency_ = rhs.platency_;
         rhs.stmt_ = nullptr;
     }
     return *this;
@@ -58,16 +107,29 @@ void SQLiteStmt::Bind(int index, Bytes const& val)
 
 void SQLiteStmt::Run()
 {
-    int res = sqlite3_step(stmt_);
+    int res;
+    {
+        ScopedLatencyTimer timer(*platency_);
+        res = sqlite3_step(stmt_);
+    }
     if (res != SQLITE_DONE) {
         char const* errmsg = sqlite3_errmsg(sql3_);
         throw std::runtime_error(tinyformat::format("failed to run sql, error: %s", errmsg));
     }
 }
 
+void SQLiteStmt::Reset()
+{
+    CheckSQL(sql3_, sqlite3_reset(stmt_));
+}
+
 bool SQLiteStmt::StepNext()
 {
-    int res = sqlite3_step(stmt_);
+    int res;
+    {
+        ScopedLatencyTimer timer(*platency_);
+        res = sqlite3_step(stmt_);
+    }
     if (res == SQLITE_ROW) {
         return true;
     } else if (res == SQLITE_DONE) {
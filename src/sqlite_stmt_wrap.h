@@ -7,6 +7,7 @@
 
 #include "common_types.h"
 
+#include "instrumentation.h"
 #include "sqlite_utils.h"
 
 class SQLiteStmt
@@ -44,6 +45,11 @@ public:
 
     void Run();
 
+    /**
+     * Reset the statement to run it again, the bindings are kept until they are bound again
+     */
+    void Reset();
+
     bool StepNext();
 
     int64_t GetLastInsertedRowID() const;
@@ -63,6 +69,7 @@ public:
 private:
     sqlite3* sql3_;
     sqlite3_stmt* stmt_ { nullptr };
+    LatencyHistogram* platency_;
 };
 
 #endif
@@ -80,3 +80,8 @@ void SQLite::CommitTransaction()
 {
     ExecuteSQL("commit transaction");
 }
+
+void SQLite::RollbackTransaction()
+{
+    ExecuteSQL("rollback transaction");
+}
@@ -34,6 +34,8 @@ public:
 
     void CommitTransaction();
 
+    void RollbackTransaction();
+
 private:
     sqlite3* sql3_ { nullptr };
     Status status_ { Status::Error };
@@ -13,7 +13,7 @@ StandardStatusQuerier::StandardStatusQuerier(LastBlockInfoQuerierType last_block
 {
 }
 
-TimelordStatus StandardStatusQuerier::operator()() const
+void StandardStatusQuerier::operator()(QueryHandler<TimelordStatus> handler) const
 {
     if (hostip_.empty() && detect_hostip_) {
         try {
@@ -35,20 +35,26 @@ TimelordStatus StandardStatusQuerier::operator()() const
         status.max_size = netspace_max_querier_(0, status.height);
         status.status_string = timelord_status.status_string;
         status.num_connections = timelord_status.num_connections;
+        status.num_requests = timelord_status.num_requests;
     } catch (std::exception const& e) {
         PLOGE << tinyformat::format("query status failed: %s", e.what());
     }
 
-    try {
-        status.last_block_info = last_block_querier_();
-    } catch (std::exception const& e) {
-        PLOGE << tinyformat::format("query last block info. failed: %s", e.what());
-    }
     try {
         status.vdf_pack = vdf_pack_querier_(status.challenge);
     } catch (std::exception const& e) {
         PLOGE << tinyformat::format("query vdf info. failed: %s", e.what());
     }
 
-    return status;
+    last_block_querier_([status, handler = std::move(handler)](std::exception_ptr perr, BlockInfo const& block_info) mutable {
+        try {
+            if (perr) {
+                std::rethrow_exception(perr);
+            }
+            status.last_block_info = block_info;
+        } catch (std::exception const& e) {
+            PLOGE << tinyformat::format("query last block info. failed: %s", e.what());
+        }
+        handler(nullptr, status);
+    });
 }
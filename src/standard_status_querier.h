@@ -13,7 +13,11 @@ class StandardStatusQuerier
 public:
     StandardStatusQuerier(LastBlockInfoQuerierType last_block_querier, VDFPackByChallengeQuerierType vdf_pack_querier, NetspaceSizeQuerierType netspace_max_querier, Timelord const& timelord, bool detect_hostip);
 
-    TimelordStatus operator()() const;
+    /**
+     * The status is made from the timelord and the local database at once, the handler is invoked when the last block is
+     * received from the RPC service
+     */
+    void operator()(QueryHandler<TimelordStatus> handler) const;
 
 private:
     LastBlockInfoQuerierType last_block_querier_;
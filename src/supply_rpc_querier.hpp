@@ -1,36 +1,44 @@
 #ifndef SUPPLY_RPC_QUERIER_HPP
 #define SUPPLY_RPC_QUERIER_HPP
 
-#include "rpc_client.h"
+#include "supply_data.h"
+#include "async_rpc_client.h"
+#include "rpc_metrics.hpp"
 
 class SupplyRPCQuerier
 {
 public:
-    explicit SupplyRPCQuerier(RPCClient& rpc)
+    explicit SupplyRPCQuerier(AsyncRPCClient& rpc)
         : rpc_(rpc)
+        , rpc_latency_(GetRPCLatency("querysupply"))
     {
     }
 
-    Supply operator()() const
+    void operator()(QueryHandler<Supply> handler) const
     {
-        auto res = rpc_.Call("querysupply", std::string("0"));
-        if (!res.result.isObject()) {
+        AsyncQueryRPC(rpc_, rpc_latency_, "querysupply", &SupplyRPCQuerier::ConvertResult, std::move(handler), std::string("0"));
+    }
+
+private:
+    static Supply ConvertResult(UniValue const& result)
+    {
+        if (!result.isObject()) {
             throw std::runtime_error("the type of result from `querysupply` is not object");
         }
 
-        if (!res.result.exists("calc")) {
+        if (!result.exists("calc")) {
             throw std::runtime_error("member `calc` cannot be found");
         }
-        auto calcObj = res.result["calc"];
+        auto calcObj = result["calc"];
 
-        if (!res.result.exists("last")) {
+        if (!result.exists("last")) {
             throw std::runtime_error("member `last` cannot be found");
         }
-        auto lastObj = res.result["last"];
+        auto lastObj = result["last"];
 
         Supply supply;
 
-        supply.dist_height = res.result["dist_height"].get_int();
+        supply.dist_height = result["dist_height"].get_int();
 
         supply.calc.height = calcObj["calc_height"].get_int();
         supply.calc.burned = calcObj["burned"].get_real();
@@ -45,8 +53,8 @@ public:
         return supply;
     }
 
-private:
-    RPCClient& rpc_;
+    AsyncRPCClient& rpc_;
+    LatencyHistogram& rpc_latency_;
 };
 
 #endif
@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+
+#include "async_rpc_client.h"
+#include "fake_node.h"
+#include "thread_utils.h"
+
+static char const* SZ_CLOSED_URL = "http://127.0.0.1:1";
+static char const* SZ_SILENT_URL = "http://127.0.0.1:28732";
+static unsigned short const SILENT_PORT = 28732;
+
+TEST(AsyncRPCClientTest, BreakerOpensAfterFailures)
+{
+    asio::io_context ioc;
+    LoopThread loop(ioc);
+    AsyncRPCClient::Options opts;
+    opts.timeout = std::chrono::milliseconds(1000);
+    opts.breaker_failures = 2;
+    opts.breaker_cooldown = std::chrono::milliseconds(200);
+    AsyncRPCClient rpc(ioc, SZ_CLOSED_URL, "user", "passwd", opts);
+
+    EXPECT_THROW(rpc.Call("getblockcount"), RPCNetError);
+    EXPECT_EQ(rpc.GetBreakerState(), AsyncRPCClient::BreakerState::CLOSED);
+    EXPECT_THROW(rpc.Call("getblockcount"), RPCNetError);
+    EXPECT_EQ(rpc.GetBreakerState(), AsyncRPCClient::BreakerState::OPEN);
+    // the gauge belongs to the client, the other clients never reset it
+    opts.name = "other";
+    AsyncRPCClient other_rpc(ioc, SZ_CLOSED_URL, "user", "passwd", opts);
+    auto& registry = MetricsRegistry::GetInstance();
+    std::string label = MakeMetricLabel("node", SZ_CLOSED_URL) + ",";
+    EXPECT_EQ(registry.GetGauge("timelord_rpc_breaker_open", "", label + MakeMetricLabel("client", "default")).Get(), 1);
+    EXPECT_EQ(registry.GetGauge("timelord_rpc_breaker_open", "", label + MakeMetricLabel("client", "other")).Get(), 0);
+
+    // rejected without reaching the service
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_THROW(rpc.Call("getblockcount"), RPCNetError);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(100));
+
+    // the probe fails after the cooldown, the breaker is opened again
+    std::this_thread::sleep_for(opts.breaker_cooldown);
+    EXPECT_THROW(rpc.Call("getblockcount"), RPCNetError);
+    EXPECT_EQ(rpc.GetBreakerState(), AsyncRPCClient::BreakerState::OPEN);
+}
+
+TEST(AsyncRPCClientTest, Timeout)
+{
+    asio::io_context ioc;
+    // the connections are accepted but nothing is responded
+    tcp::acceptor acceptor(ioc, tcp::endpoint(asio::ip::address::from_string("127.0.0.1"), SILENT_PORT));
+    tcp::socket peer(ioc);
+    acceptor.async_accept(peer, [](error_code const&) { });
+    LoopThread loop(ioc);
+
+    AsyncRPCClient::Options opts;
+    opts.timeout = std::chrono::milliseconds(200);
+    AsyncRPCClient rpc(ioc, SZ_SILENT_URL, "user", "passwd", opts);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_THROW(rpc.Call("getblockcount"), RPCNetError);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, opts.timeout);
+    EXPECT_LT(elapsed, std::chrono::seconds(2));
+    loop.Stop();
+}
+
+TEST(AsyncRPCClientTest, CacheByHeight)
+{
+    asio::io_context ioc;
+    FakeNode node(ioc);
+    LoopThread loop(ioc);
+    AsyncRPCClient rpc(ioc, node.GetUrl(), "user", "passwd", AsyncRPCClient::Options());
+    rpc.SetCacheTTL("getblockcount", std::chrono::seconds(10));
+
+    int first = rpc.Call("getblockcount").result.get_int();
+    EXPECT_EQ(rpc.Call("getblockcount").result.get_int(), first);
+    EXPECT_EQ(node.GetNumRequests(), 1);
+
+    // the methods without TTL are not cached
+    rpc.Call("getbestblockhash");
+    rpc.Call("getbestblockhash");
+    EXPECT_EQ(node.GetNumRequests(), 3);
+
+    rpc.SetChainHeight(2);
+    EXPECT_NE(rpc.Call("getblockcount").result.get_int(), first);
+    EXPECT_EQ(node.GetNumRequests(), 4);
+    loop.Stop();
+}
+
+TEST(AsyncRPCClientTest, CoalesceInFlight)
+{
+    asio::io_context ioc;
+    FakeNode node(ioc, std::chrono::milliseconds(200));
+    LoopThread loop(ioc);
+    AsyncRPCClient rpc(ioc, node.GetUrl(), "user", "passwd", AsyncRPCClient::Options());
+
+    std::promise<int> promise1, promise2;
+    rpc.AsyncCall("getblockcount", MakeRPCParams(), [&promise1](std::exception_ptr, UniValue const& result) {
+        promise1.set_value(result.get_int());
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    rpc.AsyncCall("getblockcount", MakeRPCParams(), [&promise2](std::exception_ptr, UniValue const& result) {
+        promise2.set_value(result.get_int());
+    });
+    EXPECT_EQ(promise1.get_future().get(), promise2.get_future().get());
+    EXPECT_EQ(node.GetNumCalls(), 1);
+    loop.Stop();
+}
+
+TEST(AsyncRPCClientTest, NoCoalesceAcrossHeights)
+{
+    asio::io_context ioc;
+    FakeNode node(ioc, std::chrono::milliseconds(200));
+    LoopThread loop(ioc);
+    AsyncRPCClient rpc(ioc, node.GetUrl(), "user", "passwd", AsyncRPCClient::Options());
+    rpc.SetCacheTTL("getblockcount", std::chrono::seconds(10));
+
+    std::promise<int> promise1, promise2;
+    rpc.AsyncCall("getblockcount", MakeRPCParams(), [&promise1](std::exception_ptr, UniValue const& result) {
+        promise1.set_value(result.get_int());
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // the call in flight belongs to the old height, neither joined nor cached for the new one
+    rpc.SetChainHeight(2);
+    rpc.AsyncCall("getblockcount", MakeRPCParams(), [&promise2](std::exception_ptr, UniValue const& result) {
+        promise2.set_value(result.get_int());
+    });
+    int first = promise1.get_future().get();
+    int second = promise2.get_future().get();
+    EXPECT_NE(first, second);
+    EXPECT_EQ(rpc.Call("getblockcount").result.get_int(), second);
+    EXPECT_EQ(node.GetNumCalls(), 2);
+    loop.Stop();
+}
+
+TEST(AsyncRPCClientTest, UnbatchedMethod)
+{
+    asio::io_context ioc;
+    FakeNode node(ioc);
+    LoopThread loop(ioc);
+    AsyncRPCClient rpc(ioc, node.GetUrl(), "user", "passwd", AsyncRPCClient::Options());
+    rpc.SetUnbatched("submitvdfproof");
+
+    rpc.Prefetch({ { "querysupply", MakeRPCParams("0") }, { "submitvdfproof", MakeRPCParams() }, { "querynetspace", MakeRPCParams() } });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (node.GetNumCalls() < 3 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // the two queries in one batch, the proof alone
+    EXPECT_EQ(node.GetNumCalls(), 3);
+    EXPECT_EQ(node.GetNumRequests(), 2);
+    loop.Stop();
+}
+
+TEST(AsyncRPCClientTest, ResponseLimit)
+{
+    asio::io_context ioc;
+    FakeNode node(ioc);
+    node.SetMethodHandler("queryupdatetiphistory", [](UniValue const&) {
+        return UniValue(std::string(9 * 1024 * 1024, 'x'));
+    });
+    LoopThread loop(ioc);
+    // larger than the default limit of the parser
+    AsyncRPCClient::Options opts;
+    opts.max_response_bytes = 0;
+    AsyncRPCClient rpc(ioc, node.GetUrl(), "user", "passwd", opts);
+    EXPECT_EQ(rpc.Call("queryupdatetiphistory", "1000000").result.get_str().size(), 9 * 1024 * 1024);
+    loop.Stop();
+}
+
+TEST(AsyncRPCClientTest, PrefetchInBatch)
+{
+    asio::io_context ioc;
+    FakeNode node(ioc);
+    LoopThread loop(ioc);
+    AsyncRPCClient rpc(ioc, node.GetUrl(), "user", "passwd", AsyncRPCClient::Options());
+    rpc.SetCacheTTL("querysupply", std::chrono::seconds(10));
+    rpc.SetCacheTTL("querynetspace", std::chrono::seconds(10));
+
+    rpc.Prefetch({ { "querysupply", MakeRPCParams("0") }, { "querynetspace", MakeRPCParams() }, { "fail", MakeRPCParams() } });
+    rpc.Call("querysupply", "0");
+    rpc.Call("querynetspace");
+    EXPECT_EQ(node.GetNumRequests(), 1);
+    EXPECT_EQ(node.GetLastBatchSize(), 3);
+
+    // the error of one call in the batch is reported to itself only
+    EXPECT_THROW(rpc.Call("fail"), RPCCallError);
+    loop.Stop();
+}
+
+TEST(AsyncRPCClientTest, MalformedError)
+{
+    asio::io_context ioc;
+    FakeNode node(ioc);
+    LoopThread loop(ioc);
+    AsyncRPCClient rpc(ioc, node.GetUrl(), "user", "passwd", AsyncRPCClient::Options());
+
+    // the error without the string of the message is reported to the call, the loop keeps running
+    EXPECT_THROW(rpc.Call("fail_malformed"), RPCCallError);
+    rpc.Prefetch({ { "fail_malformed", MakeRPCParams() }, { "querynetspace", MakeRPCParams() } });
+    EXPECT_NO_THROW(rpc.Call("getblockcount"));
+    loop.Stop();
+}
@@ -1,10 +1,11 @@
 #include <gtest/gtest.h>
 
+#include <future>
 #include <memory>
 
-#include <rpc_client.h>
-
+#include "async_rpc_client.h"
 #include "last_block_info_querier.hpp"
+#include "thread_utils.h"
 
 char const* SZ_RPC_URL = "http://127.0.0.1:18732";
 char const* SZ_RPC_COOKIE_PATH = "$HOME/.btchd/testnet3/.cookie";
@@ -14,18 +15,32 @@ class BlockQuerierTest : public testing::Test
 protected:
     void SetUp() override
     {
-        rpc_ = std::make_unique<RPCClient>(true, SZ_RPC_URL, RPCLogin(ExpandEnvPath(SZ_RPC_COOKIE_PATH)));
+        rpc_ = std::make_unique<AsyncRPCClient>(ioc_, SZ_RPC_URL, ExpandEnvPath(SZ_RPC_COOKIE_PATH), AsyncRPCClient::Options());
         querier_ = std::make_unique<LastBlockInfoQuerier>(*rpc_);
     }
 
-    void TearDown() override { }
+    void TearDown() override
+    {
+        rpc_loop_.Stop();
+    }
 
-    std::unique_ptr<RPCClient> rpc_;
+    asio::io_context ioc_;
+    LoopThread rpc_loop_ { ioc_ };
+    std::unique_ptr<AsyncRPCClient> rpc_;
     std::unique_ptr<LastBlockInfoQuerier> querier_;
 };
 
 TEST_F(BlockQuerierTest, Query)
 {
+    std::promise<BlockInfo> promise;
+    auto future = promise.get_future();
+    (*querier_)([&promise](std::exception_ptr perr, BlockInfo const& block_info) {
+        if (perr) {
+            promise.set_exception(perr);
+        } else {
+            promise.set_value(block_info);
+        }
+    });
     BlockInfo block_info;
-    EXPECT_NO_THROW({ block_info = (*querier_)(); });
+    EXPECT_NO_THROW({ block_info = future.get(); });
 }
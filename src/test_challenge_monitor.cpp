@@ -1,14 +1,20 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include "asio_defs.hpp"
 
 #include <plog/Log.h>
 
 #include "challenge_monitor.h"
+#include "fake_node.h"
 #include "test_utils.h"
+#include "thread_utils.h"
 
 static char const* SZ_RPC_URL = "http://127.0.0.1:18732";
 static char const* SZ_COOKIE_PATH = "$HOME/.btchd/testnet3/.cookie";
@@ -19,8 +25,8 @@ class ChallengeMonitorTest : public ::testing::Test
 protected:
     void SetUp() override
     {
-        rpc_ = std::make_unique<RPCClient>(true, SZ_RPC_URL, RPCLogin(ExpandEnvPath(SZ_COOKIE_PATH)));
-        pchallenge_monitor_ = std::make_unique<ChallengeMonitor>(ChallengeMonitor(ioc_, *rpc_, INTERVAL_SECONDS));
+        rpc_ = std::make_unique<AsyncRPCClient>(ioc_, SZ_RPC_URL, ExpandEnvPath(SZ_COOKIE_PATH), AsyncRPCClient::Options());
+        pchallenge_monitor_ = std::make_unique<ChallengeMonitor>(ioc_, std::vector<AsyncRPCClient*> { rpc_.get() }, INTERVAL_SECONDS);
     }
 
     void TearDown() override
@@ -52,7 +58,7 @@ private:
     asio::io_context ioc_;
     std::unique_ptr<ChallengeMonitor> pchallenge_monitor_;
     std::unique_ptr<std::thread> pthread_;
-    std::unique_ptr<RPCClient> rpc_;
+    std::unique_ptr<AsyncRPCClient> rpc_;
 };
 
 TEST_F(ChallengeMonitorTest, Base)
@@ -81,3 +87,144 @@ TEST_F(ChallengeMonitorTest, Base)
     }
     EXPECT_TRUE(true);
 }
+
+/**
+ * The challenge is polled from a fake node, the tests change the reported challenge and push the challenges
+ */
+class ChallengeMonitorPushTest : public ::testing::Test
+{
+protected:
+    ChallengeMonitorPushTest()
+        : node_(node_ioc_)
+        , node_loop_(node_ioc_)
+        , rpc_(ioc_, node_.GetUrl(), "", "", AsyncRPCClient::Options())
+        , monitor_(ioc_, std::vector<AsyncRPCClient*> { &rpc_ }, 1)
+    {
+        node_.SetMethodHandler("querychallenge", [this](UniValue const&) {
+            std::lock_guard<std::mutex> lg(m_);
+            UniValue result(UniValue::VOBJ);
+            result.pushKV("challenge", Uint256ToHex(reported_challenge_));
+            result.pushKV("difficulty", static_cast<int64_t>(reported_difficulty_));
+            result.pushKV("target_height", reported_height_);
+            return result;
+        });
+        monitor_.SetNewChallengeHandler([this](uint256 const&, uint256 const& new_challenge, int, uint64_t) {
+            std::lock_guard<std::mutex> lg(m_);
+            challenges_.push_back(new_challenge);
+            cv_.notify_all();
+        });
+    }
+
+    static uint256 MakeChallenge(uint8_t n)
+    {
+        uint256 challenge;
+        MakeZero(challenge, n);
+        return challenge;
+    }
+
+    void Report(uint256 const& challenge, int height, uint64_t difficulty)
+    {
+        std::lock_guard<std::mutex> lg(m_);
+        reported_challenge_ = challenge;
+        reported_height_ = height;
+        reported_difficulty_ = difficulty;
+    }
+
+    void Push(uint256 const& challenge, int height, uint64_t difficulty)
+    {
+        monitor_.PushChallenge(challenge, height, difficulty, {});
+    }
+
+    void Run()
+    {
+        monitor_.Run();
+        ploop_ = std::make_unique<LoopThread>(ioc_);
+    }
+
+    bool WaitForChallenge(uint256 const& challenge, std::chrono::seconds timeout = std::chrono::seconds(5))
+    {
+        std::unique_lock<std::mutex> lk(m_);
+        return cv_.wait_for(lk, timeout, [this, &challenge]() {
+            return !challenges_.empty() && challenges_.back() == challenge;
+        });
+    }
+
+    std::vector<uint256> GetChallenges()
+    {
+        std::lock_guard<std::mutex> lg(m_);
+        return challenges_;
+    }
+
+private:
+    asio::io_context node_ioc_;
+    FakeNode node_;
+    LoopThread node_loop_;
+    asio::io_context ioc_;
+    AsyncRPCClient rpc_;
+    ChallengeMonitor monitor_;
+    std::unique_ptr<LoopThread> ploop_;
+    std::mutex m_;
+    std::condition_variable cv_;
+    uint256 reported_challenge_ { MakeChallenge(0) };
+    int reported_height_ { 0 };
+    uint64_t reported_difficulty_ { 0 };
+    std::vector<uint256> challenges_;
+};
+
+TEST_F(ChallengeMonitorPushTest, PushChallenge)
+{
+    Report(MakeChallenge(1), 99, 200);
+    Run();
+    ASSERT_TRUE(WaitForChallenge(MakeChallenge(1)));
+    // the same challenge is pushed twice, only the first one is a new challenge
+    Report(MakeChallenge(2), 100, 200);
+    Push(MakeChallenge(2), 100, 200);
+    Push(MakeChallenge(2), 100, 200);
+    ASSERT_TRUE(WaitForChallenge(MakeChallenge(2)));
+    // the next poll confirms it
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    EXPECT_EQ(GetChallenges(), std::vector<uint256>({ MakeChallenge(1), MakeChallenge(2) }));
+}
+
+TEST_F(ChallengeMonitorPushTest, OverrideUnconfirmedPush)
+{
+    Report(MakeChallenge(1), 99, 200);
+    Run();
+    ASSERT_TRUE(WaitForChallenge(MakeChallenge(1)));
+    // the node doesn't agree with the push, the next poll takes the challenge back even though its height is lower
+    Push(MakeChallenge(2), 100, 200);
+    ASSERT_TRUE(WaitForChallenge(MakeChallenge(2)));
+    ASSERT_TRUE(WaitForChallenge(MakeChallenge(1)));
+    EXPECT_EQ(GetChallenges(), std::vector<uint256>({ MakeChallenge(1), MakeChallenge(2), MakeChallenge(1) }));
+}
+
+TEST_F(ChallengeMonitorPushTest, IgnoreLowerHeight)
+{
+    Report(MakeChallenge(1), 99, 200);
+    Run();
+    ASSERT_TRUE(WaitForChallenge(MakeChallenge(1)));
+    Report(MakeChallenge(4), 100, 200);
+    Push(MakeChallenge(2), 100, 200);
+    Push(MakeChallenge(3), 99, 200);
+    // a competing tip of the same height is accepted from the push, the pushes are applied in order
+    Push(MakeChallenge(4), 100, 200);
+    ASSERT_TRUE(WaitForChallenge(MakeChallenge(4)));
+    EXPECT_EQ(GetChallenges(), std::vector<uint256>({ MakeChallenge(1), MakeChallenge(2), MakeChallenge(4) }));
+}
+
+TEST_F(ChallengeMonitorPushTest, RejectInconsistentPush)
+{
+    // nothing is polled yet
+    Push(MakeChallenge(2), 100, 200);
+    Report(MakeChallenge(1), 99, 200);
+    Run();
+    ASSERT_TRUE(WaitForChallenge(MakeChallenge(1)));
+    // too far ahead, too hard, too easy
+    Push(MakeChallenge(3), 105, 200);
+    Push(MakeChallenge(4), 100, 200 * 10);
+    Push(MakeChallenge(5), 100, 200 / 10);
+    Report(MakeChallenge(6), 100, 250);
+    Push(MakeChallenge(6), 100, 250);
+    ASSERT_TRUE(WaitForChallenge(MakeChallenge(6)));
+    EXPECT_EQ(GetChallenges(), std::vector<uint256>({ MakeChallenge(1), MakeChallenge(6) }));
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include "asio_defs.hpp"
+
+#include "challenge_request_index.h"
+
+#include "timelord_utils.h"
+
+class ChallengeRequestIndexTest : public testing::Test
+{
+protected:
+    FrontEndSessionPtr MakeSession()
+    {
+        return std::make_shared<FrontEndSession>(ioc_, tcp::socket(ioc_));
+    }
+
+    static uint256 MakeChallenge(uint8_t v)
+    {
+        uint256 challenge;
+        MakeZero(challenge, v);
+        return challenge;
+    }
+
+    static std::vector<uint64_t> CollectItersUpTo(ChallengeRequestIndex const& index, uint256 const& challenge, uint64_t iters, bool* more = nullptr)
+    {
+        std::vector<uint64_t> res;
+        bool more_req = index.ForEachUpTo(challenge, iters, [&res](ChallengeRequestIndex::Request const& req) {
+            res.push_back(req.iters);
+        });
+        if (more) {
+            *more = more_req;
+        }
+        return res;
+    }
+
+private:
+    asio::io_context ioc_;
+};
+
+TEST_F(ChallengeRequestIndexTest, OrderedByIters)
+{
+    ChallengeRequestIndex index(3);
+    auto challenge = MakeChallenge(1);
+    auto psession1 = MakeSession();
+    auto psession2 = MakeSession();
+    EXPECT_TRUE(index.Add(challenge, psession1, 300, {}, 0));
+    EXPECT_TRUE(index.Add(challenge, psession2, 100, {}, 0));
+    EXPECT_TRUE(index.Add(challenge, psession1, 200, {}, 0));
+    EXPECT_FALSE(index.Add(challenge, psession1, 200, {}, 0));
+    EXPECT_EQ(index.GetSize(), 3);
+
+    bool more;
+    EXPECT_EQ(CollectItersUpTo(index, challenge, 200, &more), std::vector<uint64_t>({ 100, 200 }));
+    EXPECT_TRUE(more);
+    EXPECT_EQ(CollectItersUpTo(index, challenge, 1000, &more), std::vector<uint64_t>({ 100, 200, 300 }));
+    EXPECT_FALSE(more);
+    EXPECT_TRUE(CollectItersUpTo(index, MakeChallenge(2), 1000).empty());
+}
+
+TEST_F(ChallengeRequestIndexTest, RemoveSession)
+{
+    ChallengeRequestIndex index(3);
+    auto challenge1 = MakeChallenge(1);
+    auto challenge2 = MakeChallenge(2);
+    auto psession1 = MakeSession();
+    auto psession2 = MakeSession();
+    index.Add(challenge1, psession1, 100, {}, 0);
+    index.Add(challenge2, psession1, 100, {}, 0);
+    index.Add(challenge1, psession2, 200, {}, 0);
+
+    index.RemoveSession(psession1->GetId());
+    EXPECT_EQ(index.GetSize(), 1);
+    EXPECT_EQ(CollectItersUpTo(index, challenge1, 1000), std::vector<uint64_t>({ 200 }));
+    EXPECT_TRUE(CollectItersUpTo(index, challenge2, 1000).empty());
+
+    // nothing happens when the session is removed twice
+    index.RemoveSession(psession1->GetId());
+    EXPECT_EQ(index.GetSize(), 1);
+}
+
+TEST_F(ChallengeRequestIndexTest, EvictOldChallenges)
+{
+    ChallengeRequestIndex index(2);
+    auto psession = MakeSession();
+    index.NewChallenge(MakeChallenge(1));
+    index.Add(MakeChallenge(1), psession, 100, {}, 0);
+    // the request is received before the challenge becomes the current one
+    index.Add(MakeChallenge(4), psession, 100, {}, 0);
+    index.NewChallenge(MakeChallenge(2));
+    index.NewChallenge(MakeChallenge(3));
+    EXPECT_EQ(index.GetNumOfChallenges(), 2);
+    index.NewChallenge(MakeChallenge(4));
+    EXPECT_EQ(index.GetNumOfChallenges(), 1);
+    EXPECT_EQ(index.GetSize(), 1);
+    EXPECT_NE(index.Find(MakeChallenge(4)), nullptr);
+
+    // removing the session after the eviction must not touch the evicted challenge
+    index.RemoveSession(psession->GetId());
+    EXPECT_EQ(index.GetSize(), 0);
+}
+
+TEST_F(ChallengeRequestIndexTest, RequestAfterSessionRemoved)
+{
+    ChallengeRequestIndex index(3);
+    auto challenge = MakeChallenge(1);
+    auto psession1 = MakeSession();
+    // the close of the session is handled before its request
+    index.RemoveSession(psession1->GetId());
+    EXPECT_TRUE(index.Add(challenge, psession1, 100, {}, 0));
+    psession1.reset();
+
+    // the new session might be created at the same address, its request is never taken as a duplicate
+    auto psession2 = MakeSession();
+    EXPECT_TRUE(index.Add(challenge, psession2, 100, {}, 0));
+    std::vector<FrontEndSessionPtr> sessions;
+    index.ForEachUpTo(challenge, 100, [&sessions](ChallengeRequestIndex::Request const& req) {
+        auto psession = req.pweak_session.lock();
+        if (psession) {
+            sessions.push_back(psession);
+        }
+    });
+    EXPECT_EQ(sessions, std::vector<FrontEndSessionPtr>({ psession2 }));
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asio_defs.hpp"
+
+#include "event_bus.hpp"
+
+struct NumberEvent {
+    static constexpr char const* NAME = "Number";
+    static constexpr bool DROPPABLE = true;
+    int number;
+};
+
+struct TextEvent {
+    static constexpr char const* NAME = "Text";
+    static constexpr bool DROPPABLE = false;
+    std::string text;
+};
+
+TEST(EventBus, DeliverToSubscribersOfTheType)
+{
+    asio::io_context ioc;
+    EventBus bus;
+    std::vector<int> numbers1, numbers2;
+    std::vector<std::string> texts;
+    bus.Subscribe<NumberEvent>("sub1", ioc.get_executor(), [&numbers1](NumberEvent const& event) {
+        numbers1.push_back(event.number);
+    });
+    bus.Subscribe<NumberEvent>("sub2", ioc.get_executor(), [&numbers2](NumberEvent const& event) {
+        numbers2.push_back(event.number);
+    });
+    bus.Subscribe<TextEvent>("sub1", ioc.get_executor(), [&texts](TextEvent const& event) {
+        texts.push_back(event.text);
+    });
+    for (int i = 0; i < 10; ++i) {
+        bus.Publish(NumberEvent { i });
+    }
+    bus.Publish(TextEvent { "hello" });
+    // nothing is handled before the executor runs
+    EXPECT_TRUE(numbers1.empty());
+    auto stats = bus.QueryStats();
+    ASSERT_EQ(stats.size(), 3);
+    EXPECT_EQ(stats[0].subscriber, "sub1");
+    EXPECT_EQ(stats[0].event, "Number");
+    EXPECT_EQ(stats[0].depth, 10);
+    EXPECT_EQ(stats[2].depth, 1);
+
+    ioc.run();
+    std::vector<int> expected { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    EXPECT_EQ(numbers1, expected);
+    EXPECT_EQ(numbers2, expected);
+    ASSERT_EQ(texts.size(), 1);
+    EXPECT_EQ(texts.front(), "hello");
+
+    stats = bus.QueryStats();
+    EXPECT_EQ(stats[0].depth, 0);
+    EXPECT_EQ(stats[0].num_delivered, 10);
+    EXPECT_EQ(stats[1].num_delivered, 10);
+    EXPECT_EQ(stats[2].num_delivered, 1);
+    EXPECT_GE(stats[0].max_lag_usecs, stats[0].last_lag_usecs);
+}
+
+TEST(EventBus, SlowSubscriberDropsEvents)
+{
+    asio::io_context ioc;
+    EventBus bus;
+    std::vector<int> numbers;
+    bus.Subscribe<NumberEvent>("slow", ioc.get_executor(), [&numbers](NumberEvent const& event) { numbers.push_back(event.number); }, 4);
+    // the subscriber doesn't run, the events exceed the capacity are dropped, the publisher never waits
+    for (int i = 0; i < 100; ++i) {
+        bus.Publish(NumberEvent { i });
+    }
+    auto stats = bus.QueryStats();
+    ASSERT_EQ(stats.size(), 1);
+    EXPECT_EQ(stats[0].depth, 4);
+    EXPECT_EQ(stats[0].num_drops, 96);
+    EXPECT_EQ(stats[0].overflow_depth, 0);
+    ioc.run();
+    EXPECT_EQ(numbers, std::vector<int>({ 0, 1, 2, 3 }));
+}
+
+TEST(EventBus, SlowSubscriberOverflowsLosslessEvents)
+{
+    asio::io_context ioc;
+    EventBus bus;
+    std::vector<std::string> texts;
+    bus.Subscribe<TextEvent>("slow", ioc.get_executor(), [&texts](TextEvent const& event) { texts.push_back(event.text); }, 4);
+    // the subscriber doesn't run, the publisher never waits, the events exceed the capacity go to the overflow list
+    for (int i = 0; i < 100; ++i) {
+        bus.Publish(TextEvent { std::to_string(i) });
+    }
+    auto stats = bus.QueryStats();
+    ASSERT_EQ(stats.size(), 1);
+    EXPECT_EQ(stats[0].depth, 4);
+    EXPECT_EQ(stats[0].overflow_depth, 96);
+    EXPECT_EQ(stats[0].num_overflows, 96);
+    EXPECT_EQ(stats[0].num_drops, 0);
+    // nothing is dropped and the order is kept
+    ioc.run();
+    ASSERT_EQ(texts.size(), 100);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(texts[i], std::to_string(i));
+    }
+    stats = bus.QueryStats();
+    EXPECT_EQ(stats[0].depth, 0);
+    EXPECT_EQ(stats[0].overflow_depth, 0);
+}
+
+TEST(EventBus, PublishWithoutSubscribers)
+{
+    EventBus bus;
+    bus.Publish(NumberEvent { 1 });
+    EXPECT_TRUE(bus.QueryStats().empty());
+}
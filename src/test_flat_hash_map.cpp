@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+
+#include "flat_hash_map.hpp"
+
+#include "timelord_utils.h"
+
+namespace
+{
+
+uint256 MakeRandomUint256(std::mt19937_64& rnd)
+{
+    uint256 res;
+    for (auto& b : res) {
+        b = rnd() % 256;
+    }
+    return res;
+}
+
+} // namespace
+
+TEST(FlatHashMap, InsertFindErase)
+{
+    FlatHashMap<uint256, int> m;
+    uint256 k1, k2;
+    MakeZero(k1, 1);
+    MakeZero(k2, 2);
+    EXPECT_TRUE(m.empty());
+    EXPECT_EQ(m.find(k1), std::cend(m));
+
+    EXPECT_TRUE(m.insert(std::make_pair(k1, 100)).second);
+    EXPECT_FALSE(m.insert(std::make_pair(k1, 200)).second);
+    m[k2] = 300;
+    EXPECT_EQ(m.size(), 2);
+    EXPECT_EQ(m.find(k1)->second, 100);
+    EXPECT_EQ(m[k2], 300);
+
+    EXPECT_EQ(m.erase(k1), 1);
+    EXPECT_EQ(m.erase(k1), 0);
+    EXPECT_FALSE(m.contains(k1));
+    EXPECT_TRUE(m.contains(k2));
+    EXPECT_EQ(m.size(), 1);
+}
+
+TEST(FlatHashMap, SameAsStdMap)
+{
+    std::mt19937_64 rnd(2023);
+    FlatHashMap<uint256, uint64_t> m;
+    std::map<uint256, uint64_t> expected;
+    std::vector<uint256> keys;
+    for (int i = 0; i < 10000; ++i) {
+        auto key = MakeRandomUint256(rnd);
+        keys.push_back(key);
+        m[key] = i;
+        expected[key] = i;
+        // erase some keys, the slots are reused by the following insertions
+        if (i % 3 == 0) {
+            auto const& erasing = keys[rnd() % keys.size()];
+            EXPECT_EQ(m.erase(erasing), expected.erase(erasing));
+        }
+    }
+    EXPECT_EQ(m.size(), expected.size());
+    for (auto const& [key, val] : expected) {
+        auto it = m.find(key);
+        ASSERT_NE(it, std::end(m));
+        EXPECT_EQ(it->second, val);
+    }
+    std::size_t count { 0 };
+    for (auto const& [key, val] : m) {
+        EXPECT_EQ(expected[key], val);
+        ++count;
+    }
+    EXPECT_EQ(count, expected.size());
+}
+
+TEST(FlatHashMap, EraseWhileIterating)
+{
+    FlatHashMap<uint256, int> m;
+    for (int i = 0; i < 100; ++i) {
+        uint256 key;
+        MakeZero(key, i);
+        m[key] = i;
+    }
+    for (auto it = std::begin(m); it != std::end(m);) {
+        if (it->second % 2 == 0) {
+            it = m.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    EXPECT_EQ(m.size(), 50);
+    for (auto const& [key, val] : m) {
+        EXPECT_EQ(val % 2, 1);
+    }
+}
+
+TEST(FlatHashSet, Insert)
+{
+    FlatHashSet<uint256> s;
+    uint256 k;
+    MakeZero(k, 1);
+    EXPECT_TRUE(s.insert(k));
+    EXPECT_FALSE(s.insert(k));
+    EXPECT_TRUE(s.contains(k));
+    EXPECT_EQ(s.size(), 1);
+    s.clear();
+    EXPECT_FALSE(s.contains(k));
+}
+
+TEST(FlatHashSet, PointerKeys)
+{
+    // the aligned pointers are spread over the slots
+    std::vector<std::unique_ptr<int>> vals;
+    FlatHashSet<int const*> s;
+    FlatHash<int const*> hasher;
+    std::set<std::size_t> low_bits;
+    for (int i = 0; i < 64; ++i) {
+        vals.push_back(std::make_unique<int>(i));
+        EXPECT_TRUE(s.insert(vals.back().get()));
+        low_bits.insert(hasher(vals.back().get()) & 0x3f);
+    }
+    EXPECT_GT(low_bits.size(), 32);
+    for (auto const& pval : vals) {
+        EXPECT_TRUE(s.contains(pval.get()));
+    }
+    EXPECT_EQ(s.erase(vals.front().get()), 1);
+    EXPECT_FALSE(s.contains(vals.front().get()));
+}
@@ -2,8 +2,12 @@
 
 #include <condition_variable>
 #include <functional>
+#include <future>
+#include <memory>
 #include <mutex>
+#include <set>
 #include <thread>
+#include <vector>
 
 #include <json/value.h>
 
@@ -14,10 +18,13 @@ using std::placeholders::_2;
 
 #include "frontend.h"
 #include "frontend_client.h"
+#include "frontend_messages.h"
 
 #include "msg_ids.h"
 
+#include "metrics.h"
 #include "test_utils.h"
+#include "thread_utils.h"
 #include "timelord_utils.h"
 
 char const* SZ_LOCAL_ADDR = "127.0.0.1";
@@ -223,3 +230,395 @@ TEST_F(BaseServer, RunWith1Session_msg)
     client_thread.Join();
     Join();
 }
+
+TEST(FrontEnd, NegotiateBinaryEncoding)
+{
+    unsigned short const PORT = 18182;
+    asio::io_context ioc;
+    FrontEnd frontend(ioc);
+    frontend.SetConnectionHandler([](FrontEndSessionPtr psession) { });
+    std::promise<Json::Value> calc_promise;
+    frontend.SetMessageHandler([&calc_promise](FrontEndSessionPtr psession, Json::Value const& msg) {
+        calc_promise.set_value(msg);
+    });
+    frontend.Run(SZ_LOCAL_ADDR, PORT);
+    std::thread server_thread([&ioc]() {
+        ioc.run();
+    });
+
+    asio::io_context client_ioc;
+    FrontEndClient client(client_ioc);
+    std::vector<int> received_ids;
+    std::promise<uint64_t> pong_promise;
+    client.SetConnectionHandler([&client]() {
+        client.RequestEncoding(FrontEndEncoding::BINARY);
+        Json::Value ping;
+        ping["id"] = static_cast<Json::Int>(TimelordClientMsgs::PING);
+        ping["nonce"] = 12345;
+        client.SendMessage(ping);
+        Json::Value calc;
+        calc["id"] = static_cast<Json::Int>(TimelordClientMsgs::CALC);
+        uint256 challenge;
+        MakeZero(challenge, 1);
+        calc["challenge"] = Uint256ToHex(challenge);
+        calc["iters"] = 1000;
+        client.SendMessage(calc);
+    });
+    client.SetMessageHandler([&received_ids, &pong_promise](Json::Value const& msg) {
+        received_ids.push_back(msg["id"].asInt());
+        if (msg["id"].asInt() == static_cast<int>(TimelordMsgs::PONG)) {
+            pong_promise.set_value(msg["nonce"].asUInt64());
+        }
+    });
+    client.SetErrorHandler([](FrontEndSessionErrorType type, std::string_view errs) { });
+    client.SetCloseHandler([]() { });
+    client.Connect(SZ_LOCAL_ADDR, PORT);
+    std::thread client_thread([&client_ioc]() {
+        client_ioc.run();
+    });
+
+    // the PONG is decoded from the binary frame
+    EXPECT_EQ(pong_promise.get_future().get(), 12345);
+    auto calc = calc_promise.get_future().get();
+    EXPECT_EQ(calc["id"].asInt(), static_cast<int>(TimelordClientMsgs::CALC));
+    EXPECT_EQ(calc["iters"].asUInt64(), 1000);
+    EXPECT_EQ(received_ids, std::vector<int>({ static_cast<int>(TimelordMsgs::ENCODING_ACK), static_cast<int>(TimelordMsgs::PONG) }));
+
+    asio::post(client_ioc, [&client]() {
+        client.Exit();
+    });
+    client_thread.join();
+    frontend.Exit();
+    ioc.stop();
+    server_thread.join();
+}
+
+TEST(FrontEnd, PingEchoesMessage)
+{
+    unsigned short const PORT = 18187;
+    asio::io_context ioc;
+    FrontEnd frontend(ioc);
+    frontend.SetConnectionHandler([](FrontEndSessionPtr psession) { });
+    frontend.SetMessageHandler([](FrontEndSessionPtr psession, Json::Value const& msg) { });
+    frontend.Run(SZ_LOCAL_ADDR, PORT);
+    std::thread server_thread([&ioc]() {
+        ioc.run();
+    });
+
+    asio::io_context client_ioc;
+    FrontEndClient client(client_ioc);
+    std::promise<Json::Value> pong_promise;
+    client.SetConnectionHandler([&client]() {
+        Json::Value ping;
+        ping["id"] = static_cast<Json::Int>(TimelordClientMsgs::PING);
+        ping["memo"] = "hello";
+        // the nonce has no binary layout, it is still echoed to the JSON session
+        ping["nonce"] = -1;
+        client.SendMessage(ping);
+    });
+    client.SetMessageHandler([&pong_promise](Json::Value const& msg) {
+        if (msg["id"].asInt() == static_cast<int>(TimelordMsgs::PONG)) {
+            pong_promise.set_value(msg);
+        }
+    });
+    client.SetErrorHandler([](FrontEndSessionErrorType type, std::string_view errs) { });
+    client.SetCloseHandler([]() { });
+    client.Connect(SZ_LOCAL_ADDR, PORT);
+    std::thread client_thread([&client_ioc]() {
+        client_ioc.run();
+    });
+
+    // the message with other fields is sent back as it is
+    auto pong = pong_promise.get_future().get();
+    EXPECT_EQ(pong["memo"].asString(), "hello");
+    EXPECT_EQ(pong["nonce"].asInt(), -1);
+    EXPECT_EQ(pong.size(), 3);
+
+    asio::post(client_ioc, [&client]() {
+        client.Exit();
+    });
+    client_thread.join();
+    frontend.Exit();
+    ioc.stop();
+    server_thread.join();
+}
+
+TEST(FrontEnd, ParseReceivedDataInPlace)
+{
+    asio::streambuf buf;
+    std::string frames = std::string("{\"id\":2000}", 12) + std::string("{\"id\":2010,\"iters\":5}", 22);
+    auto dest = buf.prepare(frames.size());
+    memcpy(dest.data(), frames.data(), frames.size());
+    buf.commit(frames.size());
+
+    JsonReader reader;
+    std::string scratch;
+    EXPECT_EQ(reader.Parse(ViewReceivedData(buf, 11, scratch))["id"].asInt(), 2000);
+    EXPECT_TRUE(scratch.empty());
+    buf.consume(12);
+    // the value is reused by the next message
+    auto const& msg = reader.Parse(ViewReceivedData(buf, 21, scratch));
+    EXPECT_EQ(msg["id"].asInt(), 2010);
+    EXPECT_EQ(msg["iters"].asInt(), 5);
+    EXPECT_THROW(reader.Parse("{\"id\":"), std::runtime_error);
+}
+
+TEST(FrontEnd, SessionRegistry)
+{
+    asio::io_context ioc;
+    FrontEndSessionRegistry registry;
+    std::vector<FrontEndSessionPtr> sessions;
+    for (int i = 0; i < 4; ++i) {
+        sessions.push_back(std::make_shared<FrontEndSession>(ioc, tcp::socket(ioc)));
+        registry.Add(sessions.back());
+    }
+    EXPECT_TRUE(registry.Remove(sessions[1].get()));
+    EXPECT_FALSE(registry.Remove(sessions[1].get()));
+    EXPECT_TRUE(registry.Remove(sessions[3].get()));
+    EXPECT_EQ(registry.GetSessions(), std::vector<FrontEndSessionPtr>({ sessions[0], sessions[2] }));
+    // the moved session is still removed by its index
+    EXPECT_TRUE(registry.Remove(sessions[0].get()));
+    EXPECT_TRUE(registry.Remove(sessions[2].get()));
+    EXPECT_EQ(registry.GetSize(), 0);
+}
+
+namespace
+{
+
+/**
+ * The peer never reads, the first large message stays being written and the following ones are queued
+ */
+class StalledPeer
+{
+public:
+    static constexpr std::size_t LARGE_MESSAGE_SIZE = 4 * 1024 * 1024;
+
+    explicit StalledPeer(unsigned short port)
+        : client_(ioc_)
+    {
+        tcp::acceptor acceptor(ioc_, tcp::endpoint(asio::ip::address::from_string(SZ_LOCAL_ADDR), port));
+        client_.open(tcp::v4());
+        client_.set_option(asio::socket_base::receive_buffer_size(4096));
+        client_.connect(acceptor.local_endpoint());
+        auto s = acceptor.accept();
+        s.set_option(asio::socket_base::send_buffer_size(4096));
+        psession_ = std::make_shared<FrontEndSession>(ioc_, std::move(s));
+        psession_->SetErrorHandler([this](FrontEndSessionPtr psession, FrontEndSessionErrorType type, std::string_view errs) {
+            errors_.push_back(type);
+        });
+        Json::Value large;
+        large["id"] = static_cast<Json::Int>(TimelordMsgs::READY);
+        large["data"] = std::string(LARGE_MESSAGE_SIZE, 'x');
+        large_msg_ = MakeFrontEndMessage(large);
+    }
+
+    ~StalledPeer()
+    {
+        psession_->Stop();
+        ioc_.poll();
+    }
+
+    /**
+     * @param max_bytes The bytes can be queued besides the large message
+     */
+    void SetLimit(std::size_t max_bytes, FrontEndSendQueuePolicy policy)
+    {
+        psession_->SetSendQueueLimit(large_msg_->GetJson().size() + max_bytes, policy);
+        psession_->SendMessage(large_msg_);
+        ioc_.poll();
+    }
+
+    void Send(FrontEndMessage msg)
+    {
+        psession_->SendMessage(std::move(msg));
+        ioc_.poll();
+    }
+
+    std::vector<FrontEndSessionErrorType> const& GetErrors() const
+    {
+        return errors_;
+    }
+
+private:
+    asio::io_context ioc_;
+    tcp::socket client_;
+    FrontEndSessionPtr psession_;
+    FrontEndMessage large_msg_;
+    std::vector<FrontEndSessionErrorType> errors_;
+};
+
+FrontEndMessage MakeSpeedMessage(uint64_t iters_per_sec)
+{
+    Json::Value msg;
+    msg["id"] = static_cast<Json::Int>(TimelordMsgs::SPEED);
+    msg["iters_per_sec"] = static_cast<Json::UInt64>(iters_per_sec);
+    return MakeFrontEndMessage(msg);
+}
+
+FrontEndMessage MakeCalcReplyMessage()
+{
+    uint256 challenge;
+    MakeZero(challenge, 1);
+    Json::Value msg;
+    msg["id"] = static_cast<Json::Int>(TimelordMsgs::CALC_REPLY);
+    msg["calculating"] = true;
+    msg["challenge"] = Uint256ToHex(challenge);
+    return MakeFrontEndMessage(msg);
+}
+
+struct QueueStats {
+    int64_t queued_msgs;
+    uint64_t dropped_msgs;
+};
+
+QueueStats GetQueueStats()
+{
+    auto& registry = MetricsRegistry::GetInstance();
+    return QueueStats { registry.GetGauge("timelord_frontend_queued_messages", "").Get(), registry.GetCounter("timelord_frontend_dropped_messages_total", "").Get() };
+}
+
+} // namespace
+
+TEST(FrontEnd, SendQueueDropOldest)
+{
+    auto msg = MakeCalcReplyMessage();
+    std::size_t num_fits = 1024 / msg->GetJson().size();
+    auto stats = GetQueueStats();
+    {
+        StalledPeer peer(18183);
+        peer.SetLimit(1024, FrontEndSendQueuePolicy::DROP_OLDEST);
+        for (int i = 0; i < 100; ++i) {
+            peer.Send(msg);
+        }
+        EXPECT_TRUE(peer.GetErrors().empty());
+        EXPECT_EQ(GetQueueStats().queued_msgs - stats.queued_msgs, 1 + num_fits);
+        EXPECT_EQ(GetQueueStats().dropped_msgs - stats.dropped_msgs, 100 - num_fits);
+    }
+    // the gauge is restored when the session is released
+    EXPECT_EQ(GetQueueStats().queued_msgs, stats.queued_msgs);
+}
+
+TEST(FrontEnd, SendQueueCoalesce)
+{
+    auto stats = GetQueueStats();
+    StalledPeer peer(18184);
+    peer.SetLimit(1024, FrontEndSendQueuePolicy::COALESCE);
+    for (int i = 0; i < 50; ++i) {
+        peer.Send(MakeSpeedMessage(i));
+        peer.Send(MakeMsg_Pong(i));
+    }
+    // the older SPEED and PONG are dropped each time the limit is hit
+    EXPECT_TRUE(peer.GetErrors().empty());
+    auto queued = GetQueueStats().queued_msgs - stats.queued_msgs;
+    auto dropped = GetQueueStats().dropped_msgs - stats.dropped_msgs;
+    EXPECT_EQ(queued + dropped, 101);
+    EXPECT_LE(queued, 1 + 1024 / MakeMsg_Pong(0)->GetJson().size());
+    // the replies are never coalesced
+    for (int i = 0; i < 20; ++i) {
+        peer.Send(MakeCalcReplyMessage());
+    }
+    ASSERT_FALSE(peer.GetErrors().empty());
+    EXPECT_EQ(peer.GetErrors().front(), FrontEndSessionErrorType::WRITE);
+}
+
+TEST(FrontEnd, SendQueueDisconnect)
+{
+    StalledPeer peer(18185);
+    peer.SetLimit(1024, FrontEndSendQueuePolicy::DISCONNECT);
+    auto msg = MakeCalcReplyMessage();
+    std::size_t num_fits = 1024 / msg->GetJson().size();
+    for (std::size_t i = 0; i < num_fits; ++i) {
+        peer.Send(msg);
+    }
+    EXPECT_TRUE(peer.GetErrors().empty());
+    peer.Send(msg);
+    EXPECT_EQ(peer.GetErrors(), std::vector<FrontEndSessionErrorType>({ FrontEndSessionErrorType::WRITE }));
+}
+
+TEST(FrontEnd, ReusePortAcceptors)
+{
+    unsigned short const PORT = 18186;
+    int const NUM_CLIENTS = 30;
+
+    auto get_accepted = [](int index) {
+        return MetricsRegistry::GetInstance().GetCounter("timelord_frontend_accepted_total", "", MakeMetricLabel("acceptor", std::to_string(index))).Get();
+    };
+    std::vector<uint64_t> accepted_before;
+    for (int i = 0; i < 3; ++i) {
+        accepted_before.push_back(get_accepted(i));
+    }
+
+    // the loops of the extra acceptors are declared before the frontend, they are stopped before it is destroyed
+    asio::io_context ioc(1);
+    std::vector<std::unique_ptr<asio::io_context>> acceptor_iocs;
+    for (int i = 0; i < 2; ++i) {
+        acceptor_iocs.push_back(std::make_unique<asio::io_context>(1));
+    }
+    FrontEnd frontend(ioc);
+    frontend.SetAcceptorLoops({ acceptor_iocs[0].get(), acceptor_iocs[1].get() });
+
+    // the connection handler is invoked from all the loops
+    std::mutex m;
+    std::condition_variable cv;
+    std::set<std::thread::id> conn_threads;
+    int num_pongs { 0 };
+    frontend.SetConnectionHandler([&](FrontEndSessionPtr) {
+        std::lock_guard lg(m);
+        conn_threads.insert(std::this_thread::get_id());
+    });
+    frontend.SetMessageHandler([](FrontEndSessionPtr, Json::Value const&) {});
+    frontend.Run(SZ_LOCAL_ADDR, PORT);
+    std::vector<std::unique_ptr<LoopThread>> loops;
+    loops.push_back(std::make_unique<LoopThread>(ioc));
+    for (auto const& pioc : acceptor_iocs) {
+        loops.push_back(std::make_unique<LoopThread>(*pioc));
+    }
+
+    asio::io_context client_ioc;
+    std::vector<std::unique_ptr<FrontEndClient>> clients;
+    for (int i = 0; i < NUM_CLIENTS; ++i) {
+        auto pclient = std::make_unique<FrontEndClient>(client_ioc);
+        auto& client = *pclient;
+        client.SetConnectionHandler([&client, i]() {
+            Json::Value msg;
+            msg["id"] = static_cast<Json::Int>(TimelordClientMsgs::PING);
+            msg["nonce"] = static_cast<Json::UInt64>(i);
+            client.SendMessage(msg);
+        });
+        client.SetMessageHandler([&](Json::Value const& msg) {
+            if (msg["id"].asInt() == static_cast<int>(TimelordMsgs::PONG)) {
+                std::lock_guard lg(m);
+                ++num_pongs;
+                cv.notify_all();
+            }
+        });
+        client.SetErrorHandler([](FrontEndSessionErrorType, std::string_view) {});
+        client.SetCloseHandler([]() {});
+        client.Connect(SZ_LOCAL_ADDR, PORT);
+        clients.push_back(std::move(pclient));
+    }
+    LoopThread client_loop(client_ioc);
+    {
+        std::unique_lock lk(m);
+        ASSERT_TRUE(cv.wait_for(lk, std::chrono::seconds(10), [&]() { return num_pongs == NUM_CLIENTS; }));
+    }
+    EXPECT_EQ(frontend.GetNumOfSessions(), NUM_CLIENTS);
+
+    // the connections are spread over the acceptors by the kernel
+    int num_used_acceptors { 0 };
+    for (int i = 0; i < 3; ++i) {
+        if (get_accepted(i) > accepted_before[i]) {
+            ++num_used_acceptors;
+        }
+    }
+    EXPECT_GT(num_used_acceptors, 1);
+    {
+        std::lock_guard lg(m);
+        EXPECT_GT(conn_threads.size(), 1);
+    }
+
+    // the sessions left by the stopped loops are released with the frontend
+    client_loop.Stop();
+    frontend.Exit();
+    loops.clear();
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <json/value.h>
+
+#include "frontend_codec.h"
+#include "msg_ids.h"
+#include "timelord_utils.h"
+
+namespace
+{
+
+vdf_client::ProofDetail MakeProof()
+{
+    vdf_client::ProofDetail detail;
+    for (std::size_t i = 0; i < detail.y.size(); ++i) {
+        detail.y[i] = i;
+    }
+    detail.proof.resize(100);
+    for (std::size_t i = 0; i < detail.proof.size(); ++i) {
+        detail.proof[i] = 255 - i;
+    }
+    detail.witness_type = 1;
+    detail.iters = 123456789012;
+    detail.duration = 60;
+    return detail;
+}
+
+std::string_view GetBody(std::string const& frame)
+{
+    EXPECT_EQ(GetBinaryFrameSize(frame.data(), frame.size()), frame.size());
+    return std::string_view(frame).substr(BINARY_FRAME_PREFIX_SIZE);
+}
+
+} // namespace
+
+TEST(FrontEndCodec, Proof)
+{
+    uint256 challenge;
+    MakeZero(challenge, 0x5a);
+    auto detail = MakeProof();
+    auto frame = EncodeProofFrame(challenge, detail);
+    auto body = GetBody(frame);
+    EXPECT_EQ(GetBinaryFrameId(body), static_cast<int>(TimelordMsgs::PROOF));
+
+    auto proof = DecodeProofFrame(body);
+    EXPECT_EQ(proof.challenge, challenge);
+    EXPECT_EQ(proof.detail.y, detail.y);
+    EXPECT_EQ(proof.detail.proof, detail.proof);
+    EXPECT_EQ(proof.detail.witness_type, detail.witness_type);
+    EXPECT_EQ(proof.detail.iters, detail.iters);
+    EXPECT_EQ(proof.detail.duration, detail.duration);
+
+    // the same fields as the JSON message
+    auto msg = DecodeBinaryFrame(body);
+    EXPECT_EQ(msg["id"].asInt(), static_cast<int>(TimelordMsgs::PROOF));
+    EXPECT_EQ(msg["challenge"].asString(), Uint256ToHex(challenge));
+    EXPECT_EQ(msg["proof"].asString(), BytesToHex(detail.proof));
+    EXPECT_EQ(msg["iters"].asUInt64(), detail.iters);
+    EXPECT_EQ(EncodeBinaryFrame(msg), frame);
+}
+
+TEST(FrontEndCodec, CalcAndReply)
+{
+    Json::Value msg;
+    msg["id"] = static_cast<Json::Int>(TimelordClientMsgs::CALC);
+    msg["challenge"] = Uint256ToHex(Uint256FromHex("0101010101010101010101010101010101010101010101010101010101010101"));
+    msg["iters"] = 1000;
+    msg["netspace"]["group_hash"] = "0202020202020202020202020202020202020202020202020202020202020202";
+    msg["netspace"]["total_size"] = 4096;
+    auto calc = DecodeCalcFrame(GetBody(EncodeBinaryFrame(msg)));
+    EXPECT_EQ(Uint256ToHex(calc.challenge), msg["challenge"].asString());
+    EXPECT_EQ(calc.iters, 1000);
+    EXPECT_EQ(Uint256ToHex(calc.group_hash), msg["netspace"]["group_hash"].asString());
+    EXPECT_EQ(calc.total_size, 4096);
+
+    uint256 challenge;
+    MakeZero(challenge, 1);
+    auto reply = DecodeCalcReplyFrame(GetBody(EncodeCalcReplyFrame(true, challenge, nullptr)));
+    EXPECT_TRUE(reply.calculating);
+    EXPECT_EQ(reply.challenge, challenge);
+    EXPECT_FALSE(reply.detail.has_value());
+
+    auto detail = MakeProof();
+    reply = DecodeCalcReplyFrame(GetBody(EncodeCalcReplyFrame(false, challenge, &detail)));
+    EXPECT_FALSE(reply.calculating);
+    ASSERT_TRUE(reply.detail.has_value());
+    EXPECT_EQ(reply.detail->proof, detail.proof);
+}
+
+TEST(FrontEndCodec, JsonPayload)
+{
+    Json::Value msg;
+    msg["id"] = static_cast<Json::Int>(TimelordMsgs::SPEED);
+    msg["iters_per_sec"] = 200000;
+    auto decoded = DecodeBinaryFrame(GetBody(EncodeBinaryFrame(msg)));
+    EXPECT_EQ(decoded, msg);
+
+    auto json_frame = EncodeJsonFrame(msg);
+    EXPECT_EQ(json_frame.back(), '\0');
+    EXPECT_EQ(json_frame.find('\n'), std::string::npos);
+}
+
+TEST(FrontEndCodec, MalformedFrames)
+{
+    uint256 challenge;
+    MakeZero(challenge, 0);
+    auto frame = EncodeProofFrame(challenge, MakeProof());
+    // the prefix isn't received completely
+    EXPECT_EQ(GetBinaryFrameSize(frame.data(), 2), BINARY_FRAME_PREFIX_SIZE);
+    // truncated
+    auto body = GetBody(frame);
+    EXPECT_THROW(DecodeProofFrame(body.substr(0, body.size() - 1)), std::runtime_error);
+    // extra bytes
+    EXPECT_THROW(DecodeCalcFrame(body), std::runtime_error);
+    // too large
+    std::string prefix("\xff\xff\xff\xff", BINARY_FRAME_PREFIX_SIZE);
+    EXPECT_THROW(GetBinaryFrameSize(prefix.data(), prefix.size()), std::runtime_error);
+
+    // the y of the JSON proof must fill the form
+    auto msg = DecodeBinaryFrame(body);
+    auto y = msg["y"].asString();
+    msg["y"] = y.substr(2);
+    EXPECT_THROW(EncodeBinaryFrame(msg), std::runtime_error);
+    msg["y"] = y + "00";
+    EXPECT_THROW(EncodeBinaryFrame(msg), std::runtime_error);
+}
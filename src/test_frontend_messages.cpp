@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <json/value.h>
+
+#include "frontend_codec.h"
+#include "frontend_messages.h"
+#include "msg_ids.h"
+#include "timelord_utils.h"
+
+namespace
+{
+
+vdf_client::ProofDetail MakeProof()
+{
+    vdf_client::ProofDetail detail;
+    for (std::size_t i = 0; i < detail.y.size(); ++i) {
+        detail.y[i] = i * 7;
+    }
+    detail.proof.resize(100);
+    for (std::size_t i = 0; i < detail.proof.size(); ++i) {
+        detail.proof[i] = 255 - i;
+    }
+    detail.witness_type = 2;
+    detail.iters = 18446744073709551615ULL;
+    detail.duration = -1;
+    return detail;
+}
+
+// the bytes are distinct, the byte order of the challenge is checked
+uint256 MakeChallenge()
+{
+    uint256 challenge;
+    for (std::size_t i = 0; i < challenge.size(); ++i) {
+        challenge[i] = i + 1;
+    }
+    return challenge;
+}
+
+void AddProof(Json::Value& msg, vdf_client::ProofDetail const& detail)
+{
+    msg["y"] = FormToHex(detail.y);
+    msg["proof"] = BytesToHex(detail.proof);
+    msg["witness_type"] = static_cast<Json::Int>(detail.witness_type);
+    msg["iters"] = static_cast<Json::UInt64>(detail.iters);
+    msg["duration"] = detail.duration;
+}
+
+} // namespace
+
+TEST(FrontEndMessages, ReadyAndPong)
+{
+    Json::Value ready;
+    ready["id"] = static_cast<Json::Int>(TimelordMsgs::READY);
+    ready["encodings"].append("json");
+    ready["encodings"].append("binary");
+    EXPECT_EQ(MakeMsg_Ready()->GetJson(), EncodeJsonFrame(ready));
+    EXPECT_EQ(MakeMsg_Ready()->GetBinary(), EncodeBinaryFrame(ready));
+
+    Json::Value pong;
+    pong["id"] = static_cast<Json::Int>(TimelordMsgs::PONG);
+    EXPECT_EQ(MakeMsg_Pong()->GetJson(), EncodeJsonFrame(pong));
+    pong["nonce"] = static_cast<Json::UInt64>(42);
+    EXPECT_EQ(MakeMsg_Pong(42)->GetJson(), EncodeJsonFrame(pong));
+    EXPECT_EQ(MakeMsg_Pong(42)->GetBinary(), EncodeBinaryFrame(pong));
+}
+
+TEST(FrontEndMessages, CalcReply)
+{
+    uint256 challenge = MakeChallenge();
+    Json::Value msg;
+    msg["id"] = static_cast<Json::Int>(TimelordMsgs::CALC_REPLY);
+    msg["calculating"] = true;
+    msg["challenge"] = Uint256ToHex(challenge);
+    EXPECT_EQ(MakeMsg_CalcReply(true, challenge, nullptr)->GetJson(), EncodeJsonFrame(msg));
+
+    auto detail = MakeProof();
+    msg["calculating"] = false;
+    AddProof(msg, detail);
+    auto reply = MakeMsg_CalcReply(false, challenge, std::make_shared<vdf_client::ProofDetail const>(detail));
+    EXPECT_EQ(reply->GetJson(), EncodeJsonFrame(msg));
+    EXPECT_EQ(reply->GetBinary(), EncodeBinaryFrame(msg));
+}
+
+TEST(FrontEndMessages, EncodeOnFirstUse)
+{
+    // the PONG echoes the PING with a nonce which has no binary layout, the JSON sessions still receive it
+    Json::Value pong;
+    pong["id"] = static_cast<Json::Int>(TimelordMsgs::PONG);
+    pong["nonce"] = "abc";
+    pong["extra"] = 1;
+    auto msg = MakeFrontEndMessage(pong);
+    EXPECT_EQ(msg->GetId(), static_cast<int>(TimelordMsgs::PONG));
+    EXPECT_EQ(msg->GetJson(), EncodeJsonFrame(pong));
+    EXPECT_THROW(msg->GetBinary(), std::exception);
+    // the frame is encoded once, the same buffer is returned
+    EXPECT_EQ(&msg->GetJson(), &msg->GetJson());
+}
+
+TEST(FrontEndMessages, Proof)
+{
+    uint256 challenge = MakeChallenge();
+    auto detail = MakeProof();
+    Json::Value msg;
+    msg["id"] = static_cast<Json::Int>(TimelordMsgs::PROOF);
+    msg["challenge"] = Uint256ToHex(challenge);
+    AddProof(msg, detail);
+    // the buffers are reused by the next messages
+    for (int i = 0; i < 3; ++i) {
+        auto proof = MakeMsg_Proof(challenge, std::make_shared<vdf_client::ProofDetail const>(detail));
+        EXPECT_EQ(proof->GetJson(), EncodeJsonFrame(msg));
+        EXPECT_EQ(proof->GetBinary(), EncodeProofFrame(challenge, detail));
+    }
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "asio_defs.hpp"
+
+#include "instrumentation.h"
+
+TEST(LatencyHistogram, Percentiles)
+{
+    LatencyHistogram histogram("test");
+    for (int i = 0; i < 90; ++i) {
+        histogram.Record(80);
+    }
+    for (int i = 0; i < 9; ++i) {
+        histogram.Record(3000);
+    }
+    histogram.Record(7000000);
+    auto snapshot = histogram.GetSnapshot();
+    EXPECT_EQ(snapshot.name, "test");
+    EXPECT_EQ(snapshot.count, 100);
+    EXPECT_EQ(snapshot.max_usecs, 7000000);
+    EXPECT_EQ(snapshot.sum_usecs, 90 * 80 + 9 * 3000 + 7000000);
+    EXPECT_EQ(snapshot.p50_usecs, 100);
+    EXPECT_EQ(snapshot.p90_usecs, 5000);
+    EXPECT_EQ(snapshot.p99_usecs, 7000000);
+    ASSERT_EQ(snapshot.bucket_counts.size(), LatencyHistogram::BUCKET_BOUNDS.size() + 1);
+    EXPECT_EQ(snapshot.bucket_counts.front(), 90);
+    EXPECT_EQ(snapshot.bucket_counts.back(), 1);
+    EXPECT_EQ(snapshot.bucket_bounds.back(), -1);
+}
+
+TEST(Instrumentation, ScopedHandlerTimer)
+{
+    auto& latency = Instrumentation::GetInstance().GetHandlerLatency("test_scoped");
+    EXPECT_EQ(&latency, &Instrumentation::GetInstance().GetHandlerLatency("test_scoped"));
+    {
+        ScopedHandlerTimer timer(latency, "sleep");
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    auto snapshot = latency.GetSnapshot();
+    EXPECT_EQ(snapshot.count, 1);
+    EXPECT_GE(snapshot.max_usecs, 2000);
+}
+
+TEST(Instrumentation, LoopLagProbe)
+{
+    asio::io_context ioc;
+    LoopLagProbe probe(ioc, "test_loop", std::chrono::milliseconds(10));
+    probe.Run();
+    // block the loop, so the timer fires late
+    asio::post(ioc, []() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    });
+    ioc.run_for(std::chrono::milliseconds(100));
+    probe.Exit();
+    ioc.run();
+    auto stats = Instrumentation::GetInstance().QueryStats();
+    ASSERT_FALSE(stats.loop_lags.empty());
+    auto const& lag = stats.loop_lags.front();
+    EXPECT_EQ(lag.name, "test_loop");
+    EXPECT_GT(lag.count, 0);
+    EXPECT_GE(lag.max_usecs, 10000);
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "asio_defs.hpp"
+
+#include "bounded_queue.hpp"
+#include "loop_bridge.h"
+#include "thread_utils.h"
+
+TEST(BoundedQueue, PushPop)
+{
+    BoundedQueue<int> q(3);
+    EXPECT_EQ(q.GetCapacity(), 4);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(q.TryPush(int(i)));
+    }
+    EXPECT_FALSE(q.TryPush(4));
+    EXPECT_EQ(q.GetSize(), 4);
+    int val;
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(q.TryPop(val));
+        EXPECT_EQ(val, i);
+    }
+    EXPECT_FALSE(q.TryPop(val));
+}
+
+TEST(LoopBridge, TasksFromManyThreads)
+{
+    int const NUM_THREADS = 4;
+    int const NUM_TASKS = 10000;
+    asio::io_context ioc;
+    auto guard = asio::make_work_guard(ioc);
+    std::thread loop([&ioc]() {
+        ioc.run();
+    });
+    // the capacity is small, the tasks overflow when the loop falls behind, the tasks of each thread are kept in order
+    LoopBridge bridge(ioc.get_executor(), 64);
+    std::vector<std::vector<int>> received(NUM_THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&bridge, &received, t]() {
+            for (int i = 0; i < NUM_TASKS; ++i) {
+                bridge.Post([&received, t, i]() {
+                    received[t].push_back(i);
+                });
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    guard.reset();
+    loop.join();
+    for (auto const& r : received) {
+        EXPECT_EQ(r.size(), NUM_TASKS);
+        EXPECT_TRUE(std::is_sorted(std::begin(r), std::end(r)));
+    }
+    EXPECT_EQ(bridge.GetNumOfPendingTasks(), 0);
+    EXPECT_EQ(bridge.GetNumOfOverflowTasks(), 0);
+    EXPECT_EQ(bridge.GetNumOfDrops(), 0);
+}
+
+TEST(LoopBridge, DropWhenFull)
+{
+    asio::io_context ioc;
+    LoopBridge bridge(ioc.get_executor(), 4);
+    std::vector<int> received;
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(bridge.TryPost([&received, i]() { received.push_back(i); }), i < 4);
+    }
+    EXPECT_EQ(bridge.GetNumOfDrops(), 6);
+    ioc.run();
+    EXPECT_EQ(received, std::vector<int>({ 0, 1, 2, 3 }));
+}
+
+TEST(LoopBridge, OverflowWhenFull)
+{
+    asio::io_context ioc;
+    LoopBridge bridge(ioc.get_executor(), 4);
+    std::vector<int> received;
+    // the executor doesn't run, the caller never waits and nothing is lost
+    for (int i = 0; i < 10; ++i) {
+        bridge.Post([&received, i]() { received.push_back(i); });
+    }
+    EXPECT_EQ(bridge.GetNumOfPendingTasks(), 4);
+    EXPECT_EQ(bridge.GetNumOfOverflowTasks(), 6);
+    EXPECT_EQ(bridge.GetNumOfOverflows(), 6);
+    ioc.run();
+    EXPECT_EQ(received, std::vector<int>({ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 }));
+    EXPECT_EQ(bridge.GetNumOfOverflowTasks(), 0);
+}
+
+TEST(LoopThread, ErrorOfHandler)
+{
+    asio::io_context ioc;
+    std::promise<void> stopped;
+    LoopThread loop(ioc, "test", [&stopped]() {
+        stopped.set_value();
+    });
+    // the error is logged and reported instead of terminating the process
+    asio::post(ioc, []() {
+        throw std::runtime_error("error from the handler");
+    });
+    EXPECT_EQ(stopped.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    loop.Stop();
+}
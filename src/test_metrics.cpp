@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+#include "metrics.h"
+
+TEST(Metrics, SameMetricFromNameAndLabels)
+{
+    auto& registry = MetricsRegistry::GetInstance();
+    auto& counter = registry.GetCounter("test_requests_total", "The test requests", MakeMetricLabel("kind", "a"));
+    EXPECT_EQ(&counter, &registry.GetCounter("test_requests_total", "The test requests", MakeMetricLabel("kind", "a")));
+    EXPECT_NE(&counter, &registry.GetCounter("test_requests_total", "The test requests", MakeMetricLabel("kind", "b")));
+    EXPECT_THROW(registry.GetGauge("test_requests_total", "The test requests"), std::runtime_error);
+}
+
+TEST(Metrics, Render)
+{
+    auto& registry = MetricsRegistry::GetInstance();
+    registry.GetCounter("test_render_total", "The counter").Inc(3);
+    registry.GetGauge("test_render_gauge", "The gauge").Set(-5);
+    auto& histogram = registry.GetHistogram("test_render_seconds", "The histogram", MakeMetricLabel("method", "x"));
+    histogram.Record(200);
+    histogram.Record(3000000);
+
+    auto text = registry.Render();
+    EXPECT_NE(text.find("# TYPE test_render_total counter\ntest_render_total 3\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE test_render_gauge gauge\ntest_render_gauge -5\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE test_render_seconds histogram\n"), std::string::npos);
+    EXPECT_NE(text.find("test_render_seconds_bucket{method=\"x\",le=\"0.0001\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find("test_render_seconds_bucket{method=\"x\",le=\"0.00025\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("test_render_seconds_bucket{method=\"x\",le=\"+Inf\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("test_render_seconds_sum{method=\"x\"} 3.000200\n"), std::string::npos);
+    EXPECT_NE(text.find("test_render_seconds_count{method=\"x\"} 2\n"), std::string::npos);
+}
+
+TEST(Metrics, EscapeLabel)
+{
+    EXPECT_EQ(MakeMetricLabel("path", "a\"b\\c\n"), "path=\"a\\\"b\\\\c\\n\"");
+}
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include "netspace_aggregator.h"
+
+#include "timelord_utils.h"
+
+static uint256 MakeHash(uint8_t v)
+{
+    uint256 hash;
+    MakeZero(hash, v);
+    return hash;
+}
+
+TEST(NetspaceAggregator, SumAndDeduplicate)
+{
+    NetspaceAggregator aggregator(10);
+    aggregator.NewChallenge(MakeHash(1), 100, 1000);
+    EXPECT_EQ(aggregator.Add(MakeHash(10), 5), std::make_tuple(5, true));
+    EXPECT_EQ(aggregator.Add(MakeHash(11), 7), std::make_tuple(12, true));
+    EXPECT_EQ(aggregator.Add(MakeHash(10), 5), std::make_tuple(12, false));
+    EXPECT_EQ(aggregator.GetCurrentSize(), 12);
+
+    // the same challenge doesn't reset the sum
+    aggregator.NewChallenge(MakeHash(1), 100, 1000);
+    EXPECT_EQ(aggregator.GetCurrentSize(), 12);
+
+    aggregator.NewChallenge(MakeHash(2), 101, 1100);
+    EXPECT_EQ(aggregator.GetCurrentSize(), 0);
+    EXPECT_EQ(aggregator.Add(MakeHash(10), 3), std::make_tuple(3, true));
+    EXPECT_EQ(aggregator.GetHistory().size(), 2);
+    EXPECT_EQ(aggregator.QueryMaxSize(102), 12);
+    EXPECT_EQ(aggregator.QueryMaxSize(101), 12);
+    EXPECT_EQ(aggregator.QueryMaxSize(102, 1050), 3);
+}
+
+TEST(NetspaceAggregator, HistoryIsLimited)
+{
+    NetspaceAggregator aggregator(3);
+    for (int i = 0; i < 5; ++i) {
+        aggregator.NewChallenge(MakeHash(i), 100 + i, 1000 + i);
+        aggregator.Add(MakeHash(10), 1 + i);
+    }
+    EXPECT_EQ(aggregator.GetHistory().size(), 3);
+    EXPECT_EQ(aggregator.GetHistory().front().height, 102);
+    EXPECT_EQ(aggregator.QueryMaxSize(104), 4);
+}
+
+TEST(NetspaceAggregator, Seed)
+{
+    NetspaceAggregator aggregator(10);
+    NetspaceAggregator::Entry entry { MakeHash(1), 100, 1000, 8, 1 };
+    VDFRequest req { MakeHash(1), 1000, 10, MakeHash(10), 8 };
+    aggregator.Seed({ entry }, { req });
+    EXPECT_EQ(aggregator.GetCurrentSize(), 8);
+    // the timelord is restarted with the same challenge, the group has already reported
+    aggregator.NewChallenge(MakeHash(1), 100, 1000);
+    EXPECT_EQ(aggregator.Add(MakeHash(10), 8), std::make_tuple(8, false));
+    EXPECT_EQ(aggregator.Add(MakeHash(11), 2), std::make_tuple(10, true));
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "proof_tracer.h"
+#include "timelord_utils.h"
+
+namespace
+{
+
+uint256 MakeChallenge(uint8_t v)
+{
+    uint256 challenge;
+    MakeZero(challenge, v);
+    return challenge;
+}
+
+int64_t FindStage(ProofStageTimes const& stages, ProofStage stage)
+{
+    for (auto const& [s, usecs] : stages) {
+        if (s == stage) {
+            return usecs;
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+TEST(ProofTracer, StagesOfChallengeAndRequests)
+{
+    ProofTracer tracer;
+    uint256 challenge = MakeChallenge(1);
+    tracer.MarkChallenge(challenge, ProofStage::CHALLENGE_OBSERVED);
+    tracer.MarkChallenge(challenge, ProofStage::VDF_CLIENT_SPAWNED);
+    tracer.MarkChallenge(challenge, ProofStage::VDF_CLIENT_READY);
+    tracer.MarkRequest(challenge, 1000, ProofStage::ITERS_SENT);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    tracer.MarkRequest(challenge, 1000, ProofStage::PROOF_RECEIVED);
+    tracer.MarkRequest(challenge, 1000, ProofStage::PROOF_SUBMITTED);
+    tracer.MarkRequest(challenge, 1000, ProofStage::PROOF_WRITTEN);
+    tracer.MarkRequest(challenge, 1000, ProofStage::PROOF_WRITTEN);
+    // only the first one is recorded
+    tracer.MarkRequest(challenge, 1000, ProofStage::PROOF_RECEIVED);
+
+    auto stats = tracer.QueryStats();
+    ASSERT_EQ(stats.recent.size(), 1);
+    auto const& trace = stats.recent.front();
+    EXPECT_EQ(trace.challenge, challenge);
+    EXPECT_EQ(trace.stages.size(), 3);
+    EXPECT_EQ(FindStage(trace.stages, ProofStage::CHALLENGE_OBSERVED), 0);
+    ASSERT_EQ(trace.requests.size(), 1);
+    auto const& request = trace.requests.front();
+    EXPECT_EQ(request.iters, 1000);
+    // the writes are aggregated
+    EXPECT_EQ(request.stages.size(), 4);
+    EXPECT_EQ(request.num_written, 2);
+    EXPECT_GE(request.last_written, FindStage(request.stages, ProofStage::PROOF_WRITTEN));
+    EXPECT_GE(FindStage(request.stages, ProofStage::PROOF_RECEIVED) - FindStage(request.stages, ProofStage::ITERS_SENT), 2000);
+
+    ASSERT_EQ(stats.stages.size(), 6);
+    EXPECT_EQ(stats.stages.front().name, "vdf_client_spawned");
+    for (auto const& snapshot : stats.stages) {
+        EXPECT_GT(snapshot.count, 0);
+    }
+}
+
+TEST(ProofTracer, KeepRecentChallenges)
+{
+    ProofTracer tracer;
+    uint256 first_challenge = MakeChallenge(0);
+    tracer.MarkChallenge(first_challenge, ProofStage::CHALLENGE_OBSERVED);
+    uint256 last_challenge;
+    for (std::size_t i = 0; i < ProofTracer::MAX_RECENT_CHALLENGES; ++i) {
+        last_challenge = MakeChallenge(static_cast<uint8_t>(i + 1));
+        tracer.MarkChallenge(last_challenge, ProofStage::CHALLENGE_OBSERVED);
+    }
+    auto stats = tracer.QueryStats();
+    ASSERT_EQ(stats.recent.size(), ProofTracer::MAX_RECENT_CHALLENGES);
+    EXPECT_EQ(stats.recent.front().challenge, last_challenge);
+    for (auto const& trace : stats.recent) {
+        EXPECT_NE(trace.challenge, first_challenge);
+    }
+}
@@ -1,12 +1,24 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include "timelord.h"
 #include "utils.h"
 
 #include "local_sqlite_storage.h"
 
+#include "fake_node.h"
+#include "frontend_client.h"
+#include "msg_ids.h"
+#include "thread_utils.h"
+#include "timelord_client.h"
+
 static char const* SZ_URL = "http://127.0.0.1:18732";
 static char const* SZ_COOKIE_PATH = "$HOME/.btchd/testnet3/.cookie";
 static char const* SZ_VDF_CLIENT_PATH = "$HOME/Workspace/BitcoinHD/chiavdf/src/vdf_client";
@@ -23,8 +35,9 @@ public:
     TimelordTest()
         : storage_(SZ_VDF_DB_PATH)
         , persist_operator_(storage_)
-        , rpc_(true, SZ_URL, RPCLogin(SZ_COOKIE_PATH))
-        , timelord_(ioc_, rpc_, ExpandEnvPath(SZ_VDF_CLIENT_PATH), SZ_VDF_CLIENT_ADDR, VDF_CLIENT_PORT, 200000, persist_operator_, storage_, [](uint256 const& challenge, Bytes const& y, Bytes const& proof, int witness_type, uint64_t iters, int duration) {})
+        , netspace_(100)
+        , rpc_(ioc_, SZ_URL, ExpandEnvPath(SZ_COOKIE_PATH), AsyncRPCClient::Options())
+        , timelord_(ioc_, ioc_, { &rpc_ }, ExpandEnvPath(SZ_VDF_CLIENT_PATH), SZ_VDF_CLIENT_ADDR, VDF_CLIENT_PORT, 200000, 10, persist_operator_, storage_, netspace_, [](uint256 const& challenge, vdf_client::ProofDetailPtr const& detail) {})
     {
     }
 
@@ -51,7 +64,8 @@ private:
     asio::io_context ioc_;
     LocalSQLiteStorage storage_;
     LocalSQLiteDatabaseKeeper persist_operator_;
-    RPCClient rpc_;
+    NetspaceAggregator netspace_;
+    AsyncRPCClient rpc_;
     Timelord timelord_;
     std::unique_ptr<std::thread> pthread_;
 };
@@ -60,3 +74,528 @@ TEST_F(TimelordTest, baseTest)
 {
     Run();
 }
+
+static unsigned short const FAKE_VDF_CLIENT_PORT = 19192;
+static unsigned short const FAKE_TIMELORD_LISTENING_PORT = 29292;
+
+uint256 MakeTestChallenge(uint8_t n)
+{
+    uint256 challenge;
+    MakeZero(challenge, n);
+    return challenge;
+}
+
+/**
+ * A session of the timelord on its own loop, the received messages are recorded
+ */
+class TimelordClientWrap
+{
+public:
+    struct Received {
+        bool connected { false };
+        std::vector<uint256> challenges;
+        std::vector<uint64_t> proof_iters;
+        std::vector<TimelordClient::CalcReply> batch_replies;
+    };
+
+    using Predicate = std::function<bool(Received const& received)>;
+
+    TimelordClientWrap()
+        : client_(ioc_)
+        , loop_(ioc_)
+    {
+        Post([this]() {
+            client_.SetChallengeReceiver([this](uint256 const& challenge, int, uint64_t) {
+                Record([&]() {
+                    received_.challenges.push_back(challenge);
+                });
+            });
+            client_.SetProofReceiver([this](uint256 const&, vdf_client::ProofDetailPtr const& detail) {
+                Record([&]() {
+                    received_.proof_iters.push_back(detail->iters);
+                });
+            });
+            client_.SetCalcBatchReplyReceiver([this](std::vector<TimelordClient::CalcReply> const& replies) {
+                Record([&]() {
+                    received_.batch_replies = replies;
+                });
+            });
+            client_.SetConnectionHandler([this]() {
+                Record([&]() {
+                    received_.connected = true;
+                });
+            });
+            client_.SetErrorHandler([](FrontEndSessionErrorType, std::string_view) {});
+            client_.Connect(SZ_TIMELORD_LISTENING_ADDR, FAKE_TIMELORD_LISTENING_PORT);
+        });
+        EXPECT_TRUE(WaitFor([](Received const& received) {
+            return received.connected;
+        }));
+    }
+
+    ~TimelordClientWrap()
+    {
+        Post([this]() {
+            client_.Exit();
+        });
+    }
+
+    /**
+     * The client is only accessed from its loop
+     */
+    void Post(std::function<void()> f)
+    {
+        asio::post(ioc_, std::move(f));
+    }
+
+    TimelordClient& GetClient()
+    {
+        return client_;
+    }
+
+    /**
+     * Wait until the received messages satisfy the predicate
+     */
+    bool WaitFor(Predicate pred, std::chrono::seconds timeout = std::chrono::seconds(5))
+    {
+        std::unique_lock<std::mutex> lk(m_);
+        return cv_.wait_for(lk, timeout, [this, &pred]() {
+            return pred(received_);
+        });
+    }
+
+    Received GetReceived()
+    {
+        std::lock_guard<std::mutex> lg(m_);
+        return received_;
+    }
+
+private:
+    void Record(std::function<void()> f)
+    {
+        {
+            std::lock_guard<std::mutex> lg(m_);
+            f();
+        }
+        cv_.notify_all();
+    }
+
+    std::mutex m_;
+    std::condition_variable cv_;
+    Received received_;
+    asio::io_context ioc_;
+    TimelordClient client_;
+    LoopThread loop_;
+};
+
+/**
+ * A timelord polls the challenge from a fake node, the proofs are calculated by the fake vdf_client
+ */
+class TimelordFakeTest : public ::testing::Test
+{
+public:
+    TimelordFakeTest()
+        : node_(node_ioc_)
+        , node_loop_(node_ioc_)
+        , storage_(":memory:")
+        , persist_operator_(storage_)
+        , netspace_(100)
+        , rpc_loop_(rpc_ioc_)
+        , rpc_(rpc_ioc_, node_.GetUrl(), "", "", AsyncRPCClient::Options())
+        , timelord_(ioc_, ioc_, { &rpc_ }, FAKE_VDF_CLIENT_PATH, SZ_VDF_CLIENT_ADDR, FAKE_VDF_CLIENT_PORT, 0, 10, persist_operator_, storage_, netspace_, [](uint256 const&, vdf_client::ProofDetailPtr const&) {})
+    {
+        node_.SetMethodHandler("querychallenge", [this](UniValue const&) {
+            std::lock_guard<std::mutex> lg(m_);
+            UniValue result(UniValue::VOBJ);
+            result.pushKV("challenge", Uint256ToHex(reported_challenge_));
+            result.pushKV("difficulty", static_cast<int64_t>(reported_difficulty_));
+            result.pushKV("target_height", reported_height_);
+            return result;
+        });
+    }
+
+protected:
+    void TearDown() override
+    {
+        // the vdf_client processes are killed before the loop exits
+        timelord_.Exit();
+        if (pthread_) {
+            pthread_->join();
+        }
+    }
+
+    void Report(uint256 const& challenge, int height, uint64_t difficulty)
+    {
+        std::lock_guard<std::mutex> lg(m_);
+        reported_challenge_ = challenge;
+        reported_height_ = height;
+        reported_difficulty_ = difficulty;
+    }
+
+    void Run()
+    {
+        timelord_.Run(SZ_TIMELORD_LISTENING_ADDR, FAKE_TIMELORD_LISTENING_PORT);
+        pthread_ = std::make_unique<std::thread>([this]() {
+            ioc_.run();
+        });
+    }
+
+    Timelord& GetTimelord()
+    {
+        return timelord_;
+    }
+
+    LocalSQLiteStorage& GetStorage()
+    {
+        return storage_;
+    }
+
+private:
+    asio::io_context node_ioc_;
+    FakeNode node_;
+    LoopThread node_loop_;
+    // the RPC client runs on its own loop as it does in the timelord, the loop of the timelord drains after exiting
+    asio::io_context rpc_ioc_;
+    LoopThread rpc_loop_;
+    asio::io_context ioc_;
+    LocalSQLiteStorage storage_;
+    LocalSQLiteDatabaseKeeper persist_operator_;
+    NetspaceAggregator netspace_;
+    AsyncRPCClient rpc_;
+    Timelord timelord_;
+    std::unique_ptr<std::thread> pthread_;
+    std::mutex m_;
+    uint256 reported_challenge_ { MakeTestChallenge(0) };
+    int reported_height_ { 0 };
+    uint64_t reported_difficulty_ { 0 };
+};
+
+TEST_F(TimelordFakeTest, PushChallengeWithToken)
+{
+    Report(MakeTestChallenge(1), 99, 200);
+    GetTimelord().SetChallengePushAuth({}, "secret");
+    Run();
+    TimelordClientWrap client;
+    client.Post([&client]() {
+        client.GetClient().Subscribe();
+    });
+    ASSERT_TRUE(client.WaitFor([](TimelordClientWrap::Received const& received) {
+        return received.challenges.size() == 1;
+    }));
+    // the pushes are handled in order, only the last one is accepted
+    Report(MakeTestChallenge(4), 100, 200);
+    client.Post([&client]() {
+        client.GetClient().PushChallenge(MakeTestChallenge(2), 100, 200, {});
+        client.GetClient().PushChallenge(MakeTestChallenge(3), 100, 200, {}, "wrong");
+        client.GetClient().PushChallenge(MakeTestChallenge(4), 100, 200, {}, "secret");
+    });
+    ASSERT_TRUE(client.WaitFor([](TimelordClientWrap::Received const& received) {
+        return received.challenges.size() == 2;
+    }));
+    EXPECT_EQ(client.GetReceived().challenges, std::vector<uint256>({ MakeTestChallenge(1), MakeTestChallenge(4) }));
+}
+
+TEST_F(TimelordFakeTest, PushChallengeFromTrustedAddress)
+{
+    Report(MakeTestChallenge(1), 99, 200);
+    GetTimelord().SetChallengePushAuth({ "127.0.0.1" }, "");
+    Run();
+    TimelordClientWrap client;
+    client.Post([&client]() {
+        client.GetClient().Subscribe();
+    });
+    ASSERT_TRUE(client.WaitFor([](TimelordClientWrap::Received const& received) {
+        return received.challenges.size() == 1;
+    }));
+    Report(MakeTestChallenge(2), 100, 200);
+    client.Post([&client]() {
+        client.GetClient().PushChallenge(MakeTestChallenge(2), 100, 200, {});
+    });
+    ASSERT_TRUE(client.WaitFor([](TimelordClientWrap::Received const& received) {
+        return received.challenges.size() == 2;
+    }));
+    EXPECT_EQ(client.GetReceived().challenges.back(), MakeTestChallenge(2));
+}
+
+TEST_F(TimelordFakeTest, PushMalformedChallenge)
+{
+    Report(MakeTestChallenge(1), 99, 200);
+    GetTimelord().SetChallengePushAuth({ "127.0.0.1" }, "");
+    Run();
+    TimelordClientWrap subscriber;
+    subscriber.Post([&subscriber]() {
+        subscriber.GetClient().Subscribe();
+    });
+    ASSERT_TRUE(subscriber.WaitFor([](TimelordClientWrap::Received const& received) {
+        return received.challenges.size() == 1;
+    }));
+    Report(MakeTestChallenge(2), 100, 200);
+    // the challenge of 64 non-hex characters is ignored, the session is kept
+    Json::Value push;
+    push["id"] = static_cast<Json::Int>(TimelordClientMsgs::NEW_CHALLENGE);
+    push["challenge"] = std::string(64, 'z');
+    push["height"] = 100;
+    push["difficulty"] = 200;
+    asio::io_context ioc;
+    FrontEndClient client(ioc);
+    std::promise<void> pong_promise;
+    asio::post(ioc, [&]() {
+        client.SetConnectionHandler([&client, &push]() {
+            client.SendMessage(push);
+            Json::Value ping;
+            ping["id"] = static_cast<Json::Int>(TimelordClientMsgs::PING);
+            ping["nonce"] = 1;
+            client.SendMessage(ping);
+        });
+        client.SetMessageHandler([&pong_promise](Json::Value const& msg) {
+            if (msg["id"].asInt() == static_cast<int>(TimelordMsgs::PONG)) {
+                pong_promise.set_value();
+            }
+        });
+        client.SetErrorHandler([](FrontEndSessionErrorType, std::string_view) {});
+        client.SetCloseHandler([]() {});
+        client.Connect(SZ_TIMELORD_LISTENING_ADDR, FAKE_TIMELORD_LISTENING_PORT);
+    });
+    LoopThread loop(ioc);
+    EXPECT_EQ(pong_promise.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    asio::post(ioc, [&client]() {
+        client.Exit();
+    });
+    // the next challenge comes from the valid push
+    subscriber.Post([&subscriber]() {
+        subscriber.GetClient().PushChallenge(MakeTestChallenge(2), 100, 200, {});
+    });
+    ASSERT_TRUE(subscriber.WaitFor([](TimelordClientWrap::Received const& received) {
+        return received.challenges.size() == 2;
+    }));
+    EXPECT_EQ(subscriber.GetReceived().challenges.back(), MakeTestChallenge(2));
+}
+
+TEST_F(TimelordFakeTest, SubscribeToChallenges)
+{
+    Report(MakeTestChallenge(1), 99, 200);
+    Run();
+    TimelordClientWrap client;
+    client.Post([&client]() {
+        client.GetClient().Subscribe();
+    });
+    // the current challenge is the reply
+    ASSERT_TRUE(client.WaitFor([](TimelordClientWrap::Received const& received) {
+        return received.challenges.size() == 1;
+    }));
+    EXPECT_EQ(client.GetReceived().challenges.front(), MakeTestChallenge(1));
+    // the new challenge is sent when it is polled
+    Report(MakeTestChallenge(2), 100, 200);
+    ASSERT_TRUE(client.WaitFor([](TimelordClientWrap::Received const& received) {
+        return received.challenges.size() == 2;
+    }, std::chrono::seconds(10)));
+    EXPECT_EQ(client.GetReceived().challenges.back(), MakeTestChallenge(2));
+}
+
+TEST_F(TimelordFakeTest, SubscribeToProofs)
+{
+    Report(MakeTestChallenge(1), 99, 200);
+    Run();
+    TimelordClientWrap requester, subscriber;
+    for (auto pclient : { &requester, &subscriber }) {
+        pclient->Post([pclient]() {
+            pclient->GetClient().Subscribe();
+        });
+        ASSERT_TRUE(pclient->WaitFor([](TimelordClientWrap::Received const& received) {
+            return received.challenges.size() == 1;
+        }));
+    }
+    requester.Post([&requester]() {
+        requester.GetClient().Calc(MakeTestChallenge(1), 1000);
+    });
+    ASSERT_TRUE(subscriber.WaitFor([](TimelordClientWrap::Received const& received) {
+        return !received.proof_iters.empty();
+    }));
+    ASSERT_TRUE(requester.WaitFor([](TimelordClientWrap::Received const& received) {
+        return !received.proof_iters.empty();
+    }));
+    // the requester receives the proof once even though it also subscribes
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_EQ(requester.GetReceived().proof_iters, std::vector<uint64_t>({ 1000 }));
+    EXPECT_EQ(subscriber.GetReceived().proof_iters, std::vector<uint64_t>({ 1000 }));
+}
+
+TEST_F(TimelordFakeTest, CalcBatch)
+{
+    Report(MakeTestChallenge(1), 99, 200);
+    Run();
+    TimelordClientWrap client;
+    client.Post([&client]() {
+        client.GetClient().Subscribe();
+    });
+    ASSERT_TRUE(client.WaitFor([](TimelordClientWrap::Received const& received) {
+        return received.challenges.size() == 1;
+    }));
+    uint256 group_hash = MakeTestChallenge(9);
+    client.Post([&client, group_hash]() {
+        client.GetClient().CalcBatch({ { MakeTestChallenge(1), 100000 }, { MakeTestChallenge(2), 200000 }, { MakeTestChallenge(1), 300000 } }, group_hash, 500);
+    });
+    ASSERT_TRUE(client.WaitFor([](TimelordClientWrap::Received const& received) {
+        return !received.batch_replies.empty();
+    }));
+    // the replies are in the order of the targets, only the targets of the current challenge are calculating
+    auto replies = client.GetReceived().batch_replies;
+    ASSERT_EQ(replies.size(), 3);
+    EXPECT_EQ(replies[0].challenge, MakeTestChallenge(1));
+    EXPECT_TRUE(replies[0].calculating);
+    EXPECT_EQ(replies[1].challenge, MakeTestChallenge(2));
+    EXPECT_FALSE(replies[1].calculating);
+    EXPECT_EQ(replies[2].challenge, MakeTestChallenge(1));
+    EXPECT_TRUE(replies[2].calculating);
+    // the group is counted once
+    EXPECT_EQ(GetTimelord().QueryStatus().total_size, 500);
+    // only the first request of the new group is saved
+    std::vector<VDFRequest> requests;
+    for (int i = 0; i < 50 && requests.empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        requests = GetStorage().QueryRequests(MakeTestChallenge(1));
+    }
+    ASSERT_EQ(requests.size(), 1);
+    EXPECT_EQ(requests.front().iters, 100000);
+    EXPECT_EQ(requests.front().total_size, 500);
+}
+
+TEST_F(TimelordFakeTest, MalformedCalcClosesSession)
+{
+    Report(MakeTestChallenge(1), 99, 200);
+    Run();
+    asio::io_context ioc;
+    FrontEndClient client(ioc);
+    std::promise<void> closed;
+    std::once_flag closed_once;
+    auto set_closed = [&]() {
+        std::call_once(closed_once, [&]() {
+            closed.set_value();
+        });
+    };
+    asio::post(ioc, [&]() {
+        client.SetConnectionHandler([&client]() {
+            Json::Value calc;
+            calc["id"] = static_cast<Json::Int>(TimelordClientMsgs::CALC);
+            calc["challenge"] = std::string(64, 'z');
+            calc["iters"] = 1000;
+            client.SendMessage(calc);
+        });
+        client.SetMessageHandler([](Json::Value const&) {});
+        client.SetErrorHandler([&](FrontEndSessionErrorType, std::string_view) {
+            set_closed();
+        });
+        client.SetCloseHandler([&]() {
+            set_closed();
+        });
+        client.Connect(SZ_TIMELORD_LISTENING_ADDR, FAKE_TIMELORD_LISTENING_PORT);
+    });
+    LoopThread loop(ioc);
+    // the session is closed by the timelord
+    EXPECT_EQ(closed.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    asio::post(ioc, [&client]() {
+        client.Exit();
+    });
+    // the timelord keeps serving the others
+    TimelordClientWrap other;
+    other.Post([&other]() {
+        other.GetClient().Subscribe();
+    });
+    EXPECT_TRUE(other.WaitFor([](TimelordClientWrap::Received const& received) {
+        return received.challenges.size() == 1;
+    }));
+}
+
+/**
+ * Send the raw message from a session and wait for the reply of the id
+ */
+Json::Value RequestRaw(Json::Value const& msg, TimelordMsgs reply_id)
+{
+    asio::io_context ioc;
+    FrontEndClient client(ioc);
+    std::promise<Json::Value> reply_promise;
+    asio::post(ioc, [&]() {
+        client.SetConnectionHandler([&client, &msg]() {
+            client.SendMessage(msg);
+        });
+        client.SetMessageHandler([&reply_promise, reply_id](Json::Value const& reply) {
+            if (reply["id"].asInt() == static_cast<int>(reply_id)) {
+                reply_promise.set_value(reply);
+            }
+        });
+        client.SetErrorHandler([](FrontEndSessionErrorType, std::string_view) {});
+        client.SetCloseHandler([]() {});
+        client.Connect(SZ_TIMELORD_LISTENING_ADDR, FAKE_TIMELORD_LISTENING_PORT);
+    });
+    LoopThread loop(ioc);
+    auto reply_future = reply_promise.get_future();
+    EXPECT_EQ(reply_future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    asio::post(ioc, [&client]() {
+        client.Exit();
+    });
+    return reply_future.valid() ? reply_future.get() : Json::Value();
+}
+
+TEST_F(TimelordFakeTest, CalcBatchMalformedTargets)
+{
+    Report(MakeTestChallenge(1), 99, 200);
+    Run();
+    TimelordClientWrap subscriber;
+    subscriber.Post([&subscriber]() {
+        subscriber.GetClient().Subscribe();
+    });
+    ASSERT_TRUE(subscriber.WaitFor([](TimelordClientWrap::Received const& received) {
+        return received.challenges.size() == 1;
+    }));
+    Json::Value batch;
+    batch["id"] = static_cast<Json::Int>(TimelordClientMsgs::CALC_BATCH);
+    Json::Value target;
+    target["challenge"] = Uint256ToHex(MakeTestChallenge(1));
+    target["iters"] = 100000;
+    batch["targets"].append(target);
+    target["challenge"] = std::string(64, 'z');
+    batch["targets"].append(target);
+    target["challenge"] = Uint256ToHex(MakeTestChallenge(1));
+    target["iters"] = -1;
+    batch["targets"].append(target);
+    target["iters"] = 200000;
+    target["netspace"]["group_hash"] = std::string(64, 'z');
+    target["netspace"]["total_size"] = 100;
+    batch["targets"].append(target);
+    auto reply = RequestRaw(batch, TimelordMsgs::CALC_BATCH_REPLY);
+    auto const& replies = reply["replies"];
+    ASSERT_EQ(replies.size(), 4);
+    EXPECT_TRUE(replies[0]["calculating"].asBool());
+    EXPECT_FALSE(replies[0].isMember("error"));
+    for (Json::ArrayIndex i = 1; i < replies.size(); ++i) {
+        EXPECT_EQ(replies[i]["error"].asString(), "malformed target");
+    }
+}
+
+TEST_F(TimelordFakeTest, CalcBatchMalformedOrTooLarge)
+{
+    Report(MakeTestChallenge(1), 99, 200);
+    Run();
+    Json::Value batch;
+    batch["id"] = static_cast<Json::Int>(TimelordClientMsgs::CALC_BATCH);
+    batch["netspace"] = "none";
+    Json::Value target;
+    target["challenge"] = Uint256ToHex(MakeTestChallenge(1));
+    target["iters"] = 0;
+    batch["targets"].append(target);
+    // the malformed batch is still replied
+    auto reply = RequestRaw(batch, TimelordMsgs::CALC_BATCH_REPLY);
+    ASSERT_EQ(reply["replies"].size(), 1);
+    EXPECT_EQ(reply["replies"][0]["error"].asString(), "malformed batch");
+
+    // the targets over the limit are replied with the errors
+    batch.removeMember("netspace");
+    for (int i = 0; i < 1000; ++i) {
+        batch["targets"].append(target);
+    }
+    reply = RequestRaw(batch, TimelordMsgs::CALC_BATCH_REPLY);
+    auto const& replies = reply["replies"];
+    ASSERT_EQ(replies.size(), 1001);
+    EXPECT_FALSE(replies[999].isMember("error"));
+    EXPECT_EQ(replies[1000]["error"].asString(), "batch too large");
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "timing_wheel.hpp"
+
+namespace
+{
+
+std::vector<int> Tick(TimingWheel<int>& wheel, int ticks = 1)
+{
+    std::vector<int> expired;
+    for (int i = 0; i < ticks; ++i) {
+        wheel.Tick([&](int val) {
+            expired.push_back(val);
+        });
+    }
+    return expired;
+}
+
+} // namespace
+
+TEST(TimingWheel, ExpireAfterTimeout)
+{
+    TimingWheel<int> wheel(3);
+    wheel.Add(1);
+    Tick(wheel);
+    wheel.Add(2);
+    EXPECT_EQ(wheel.GetSize(), 2);
+
+    EXPECT_TRUE(Tick(wheel, 2).empty());
+    EXPECT_EQ(Tick(wheel), std::vector<int>({ 1 }));
+    EXPECT_EQ(Tick(wheel), std::vector<int>({ 2 }));
+    EXPECT_EQ(wheel.GetSize(), 0);
+    EXPECT_TRUE(Tick(wheel, 10).empty());
+}
+
+TEST(TimingWheel, TouchAndRemove)
+{
+    TimingWheel<int> wheel(3);
+    auto h1 = wheel.Add(1);
+    auto h2 = wheel.Add(2);
+    wheel.Add(3);
+    Tick(wheel, 2);
+    wheel.Touch(h1);
+    wheel.Touch(h1);
+    wheel.Remove(h2);
+    EXPECT_EQ(wheel.GetSize(), 2);
+
+    EXPECT_EQ(Tick(wheel, 2), std::vector<int>({ 3 }));
+    wheel.Touch(h1);
+    EXPECT_TRUE(Tick(wheel, 3).empty());
+    EXPECT_EQ(Tick(wheel), std::vector<int>({ 1 }));
+}
+
+TEST(TimingWheel, ChangeEntriesWhileExpiring)
+{
+    TimingWheel<int> wheel(2);
+    std::vector<TimingWheel<int>::Handle> handles;
+    for (int i = 0; i < 4; ++i) {
+        handles.push_back(wheel.Add(i));
+    }
+    std::vector<int> expired;
+    Tick(wheel, 2);
+    wheel.Tick([&](int val) {
+        expired.push_back(val);
+        if (val == 0) {
+            // keep 1 from expiring, remove 2 and add a new one
+            wheel.Touch(handles[1]);
+            wheel.Remove(handles[2]);
+            handles.push_back(wheel.Add(4));
+        }
+    });
+    EXPECT_EQ(expired, std::vector<int>({ 0, 3 }));
+    EXPECT_EQ(wheel.GetSize(), 2);
+    EXPECT_TRUE(Tick(wheel, 2).empty());
+    EXPECT_EQ(Tick(wheel), std::vector<int>({ 1, 4 }));
+}
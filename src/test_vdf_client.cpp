@@ -71,26 +71,21 @@ TEST(Path, Check)
 TEST_F(VdfClientTest, Base)
 {
     bool proof_is_ready { false };
-    std::map<uint256, std::vector<vdf_client::ProofDetail>> recv_proofs;
+    std::map<uint256, std::vector<vdf_client::ProofDetailPtr>> recv_proofs;
     int num_of_waiting_proofs { 1 };
     std::condition_variable cv;
     std::mutex m;
-    SetProofReceiver([&m, &proof_is_ready, &cv, &recv_proofs, &num_of_waiting_proofs](uint256 const& challenge, vdf_client::ProofDetail const& detail) {
+    SetProofReceiver([&m, &proof_is_ready, &cv, &recv_proofs, &num_of_waiting_proofs](uint256 const& challenge, vdf_client::ProofDetailPtr const& detail) {
         PLOGD << "==> challenge: " << Uint256ToHex(challenge);
-        PLOGD << "==> y: " << BytesToHex(detail.y);
-        PLOGD << "==> proof: " << BytesToHex(detail.proof);
-        PLOGD << "==> witness_type: " << (int)detail.witness_type;
-        PLOGD << "==> iters: " << detail.iters;
-        PLOGD << "==> duration: " << detail.duration;
-        PLOGD << "==> iters/sec: " << detail.iters / detail.duration;
+        PLOGD << "==> y: " << FormToHex(detail->y);
+        PLOGD << "==> proof: " << BytesToHex(detail->proof);
+        PLOGD << "==> witness_type: " << (int)detail->witness_type;
+        PLOGD << "==> iters: " << detail->iters;
+        PLOGD << "==> duration: " << detail->duration;
+        PLOGD << "==> iters/sec: " << detail->iters / detail->duration;
         {
             std::lock_guard<std::mutex> lg(m);
-            auto it = recv_proofs.find(challenge);
-            if (it == std::cend(recv_proofs)) {
-                recv_proofs.insert(std::make_pair(challenge, std::vector<vdf_client::ProofDetail> { detail }));
-            } else {
-                it->second.push_back(detail);
-            }
+            recv_proofs[challenge].push_back(detail);
             --num_of_waiting_proofs;
             proof_is_ready = num_of_waiting_proofs == 0;
         }
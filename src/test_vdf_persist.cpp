@@ -67,3 +67,18 @@ TEST_F(StorageTest, StoreAndQuery1RecWithRequestResult)
     EXPECT_EQ(last_pack.requests.size(), 1);
     EXPECT_EQ(pack, last_pack);
 }
+
+TEST_F(StorageTest, AppendRequestsInBatch)
+{
+    VDFRecordPack pack = GenerateRandomPack(time(nullptr), 30000, false);
+    std::vector<VDFRequest> requests;
+    for (int i = 0; i < 10; ++i) {
+        requests.push_back(GenerateRandomRequest(pack.record.challenge));
+    }
+    GetPersist().AppendRecord(pack.record);
+    EXPECT_NO_THROW({ GetPersist().AppendRequest(requests.front()); });
+    // the saved one is ignored
+    EXPECT_NO_THROW({ GetPersist().AppendRequests(requests); });
+    EXPECT_EQ(storage_->QueryRequests(pack.record.challenge).size(), requests.size());
+    EXPECT_NO_THROW({ GetPersist().AppendRequests({}); });
+}
@@ -13,6 +13,7 @@ namespace fs = std::filesystem;
 #include "vdf_web_service.h"
 
 #include "test_utils.h"
+#include "thread_utils.h"
 
 char const* SZ_WEBSERVICE_LOCAL_DBNAME = "webservice_db.sqlite3";
 
@@ -119,20 +120,34 @@ TEST_F(WebServiceTest, FullTests)
             [](int) -> std::vector<NetspaceData> {
                 return {};
             },
-            []() -> TimelordStatus {
-                return {};
+            [](QueryHandler<TimelordStatus> handler) {
+                handler(nullptr, {});
             },
             [](int) -> std::tuple<std::vector<RankRecord>, int> {
                 return {};
             },
-            []() -> Supply {
+            [](QueryHandler<Supply> handler) {
+                handler(nullptr, {});
+            },
+            [](QueryHandler<PledgeInfo> handler) {
+                handler(nullptr, {});
+            },
+            [](QueryHandler<uint64_t> handler) {
+                handler(nullptr, 0);
+            },
+            []() {
+            },
+            []() -> std::vector<EventQueueStats> {
                 return {};
             },
-            []() -> PledgeInfo {
+            []() -> LatencyStats {
                 return {};
             },
-            []() -> uint64_t {
-                return 0;
+            []() -> std::string {
+                return "";
+            },
+            []() -> ProofTraceStats {
+                return {};
             });
     service.Run();
 
@@ -167,3 +182,91 @@ TEST_F(WebServiceTest, FullTests)
     service.Stop();
     service_thread.join();
 }
+
+TEST_F(WebServiceTest, StatusFromAsyncQueriers)
+{
+    // the queriers of the RPC service finish on their own loop
+    asio::io_context rpc_ioc;
+    LoopThread rpc_loop(rpc_ioc);
+    std::atomic_bool supply_failed { false };
+
+    asio::io_context ioc;
+    VDFWebService service(
+            ioc, SZ_LISTEN_ADDR, LISTEN_PORT, 30, "", 0,
+            [](int) {
+                return 0;
+            },
+            [](int) -> std::vector<BlockInfo> {
+                return {};
+            },
+            [](int) -> std::vector<NetspaceData> {
+                return {};
+            },
+            [&rpc_ioc](QueryHandler<TimelordStatus> handler) {
+                asio::post(rpc_ioc, [handler]() {
+                    TimelordStatus status {};
+                    status.height = 100;
+                    handler(nullptr, status);
+                });
+            },
+            [](int) -> std::tuple<std::vector<RankRecord>, int> {
+                return {};
+            },
+            [&rpc_ioc, &supply_failed](QueryHandler<Supply> handler) {
+                asio::post(rpc_ioc, [handler, &supply_failed]() {
+                    if (supply_failed) {
+                        handler(std::make_exception_ptr(std::runtime_error("no supply")), {});
+                        return;
+                    }
+                    Supply supply {};
+                    supply.dist_height = 7;
+                    handler(nullptr, supply);
+                });
+            },
+            [&rpc_ioc](QueryHandler<PledgeInfo> handler) {
+                asio::post(rpc_ioc, [handler]() {
+                    handler(nullptr, {});
+                });
+            },
+            [&rpc_ioc](QueryHandler<uint64_t> handler) {
+                asio::post(rpc_ioc, [handler]() {
+                    handler(nullptr, 123);
+                });
+            },
+            []() {
+            },
+            []() -> std::vector<EventQueueStats> {
+                return {};
+            },
+            []() -> LatencyStats {
+                return {};
+            },
+            []() -> std::string {
+                return "";
+            },
+            []() -> ProofTraceStats {
+                return {};
+            });
+    service.Run();
+
+    std::thread service_thread([&ioc]() {
+        ioc.run();
+    });
+
+    auto [json, succ] = RunTestClient("/api/status");
+    EXPECT_TRUE(succ);
+    check_json(json, "height", 100);
+    check_json(json, "estimated_netspace", 123);
+    ASSERT_TRUE(json.isMember("supply"));
+    check_json(json["supply"], "dist_height", 7);
+
+    // the error of any query is responded
+    supply_failed = true;
+    std::tie(json, succ) = RunTestClient("/api/status");
+    EXPECT_TRUE(succ);
+    EXPECT_TRUE(json.isMember("err"));
+
+    service.Stop();
+    service_thread.join();
+    rpc_loop.Stop();
+}
@@ -0,0 +1,108 @@
+#include "thread_utils.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <string>
+
+#include <plog/Log.h>
+#include <tinyformat.h>
+
+static int const NICE_VALUE_OF_PRIORITY = -10;
+
+bool PinCurrentThreadToCore(int core)
+{
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core, &cpu_set);
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    if (ret != 0) {
+        PLOGE << tinyformat::format("cannot pin the thread to core %d, %s", core, strerror(ret));
+        return false;
+    }
+    return true;
+#else
+    PLOGE << "pinning thread to a core is not supported on this platform";
+    return false;
+#endif
+}
+
+bool RaiseCurrentThreadPriority(int priority)
+{
+    sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (ret == 0) {
+        return true;
+    }
+    PLOGI << tinyformat::format("cannot use SCHED_FIFO(%d) for the thread, %s, trying nice value %d", priority, strerror(ret), NICE_VALUE_OF_PRIORITY);
+#ifdef __linux__
+    // the nice value is per thread on linux
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), NICE_VALUE_OF_PRIORITY) == 0) {
+        return true;
+    }
+#endif
+    PLOGE << tinyformat::format("cannot raise the priority of the thread, %s", strerror(errno));
+    return false;
+}
+
+void RunLoop(asio::io_context& ioc, std::string_view name, std::function<void()> const& on_error)
+{
+    try {
+        ioc.run();
+    } catch (std::exception const& e) {
+        PLOGE << tinyformat::format("the %s loop is stopped by an error: %s", name, e.what());
+        if (on_error) {
+            on_error();
+        }
+    }
+}
+
+LoopThread::LoopThread(asio::io_context& ioc, std::string_view name, std::function<void()> on_error)
+    : ioc_(ioc)
+    , work_(asio::make_work_guard(ioc))
+    , thread_([&ioc, name = std::string(name), on_error = std::move(on_error)]() {
+        RunLoop(ioc, name, on_error);
+    })
+{
+}
+
+LoopThread::~LoopThread()
+{
+    Stop();
+}
+
+void LoopThread::Stop()
+{
+    if (!thread_.joinable()) {
+        return;
+    }
+    work_.reset();
+    ioc_.stop();
+    thread_.join();
+}
+
+std::chrono::nanoseconds LoopThread::GetCpuTime()
+{
+    if (!thread_.joinable()) {
+        return std::chrono::nanoseconds(0);
+    }
+    clockid_t clock_id;
+    if (pthread_getcpuclockid(thread_.native_handle(), &clock_id) != 0) {
+        return std::chrono::nanoseconds(0);
+    }
+    timespec ts;
+    if (clock_gettime(clock_id, &ts) != 0) {
+        return std::chrono::nanoseconds(0);
+    }
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
@@ -0,0 +1,59 @@
+#ifndef TL_THREAD_UTILS_H
+#define TL_THREAD_UTILS_H
+
+#include <chrono>
+#include <functional>
+#include <string_view>
+#include <thread>
+
+#include "asio_defs.hpp"
+
+/**
+ * Pin the calling thread to the cpu core
+ *
+ * @return false when the affinity cannot be changed
+ */
+bool PinCurrentThreadToCore(int core);
+
+/**
+ * Run the calling thread with the real-time scheduling policy (SCHED_FIFO) and the priority, the nice value is lowered
+ * instead when the process has no privilege to use the real-time policy
+ *
+ * @return false when neither of them can be changed
+ */
+bool RaiseCurrentThreadPriority(int priority);
+
+/**
+ * Run the io_context on the calling thread until it is stopped, the exception thrown by a handler is logged and `on_error`
+ * is invoked instead of terminating the process
+ */
+void RunLoop(asio::io_context& ioc, std::string_view name, std::function<void()> const& on_error);
+
+/**
+ * Runs the io_context on its own thread until `Stop` is called or it is destroyed, see `RunLoop` for `on_error`
+ */
+class LoopThread
+{
+public:
+    explicit LoopThread(asio::io_context& ioc, std::string_view name = "loop", std::function<void()> on_error = {});
+
+    ~LoopThread();
+
+    LoopThread(LoopThread const&) = delete;
+
+    LoopThread& operator=(LoopThread const&) = delete;
+
+    void Stop();
+
+    /**
+     * @return The cpu time consumed by the thread, zero when the thread is stopped or it cannot be read
+     */
+    std::chrono::nanoseconds GetCpuTime();
+
+private:
+    asio::io_context& ioc_;
+    asio::executor_work_guard<asio::io_context::executor_type> work_;
+    std::thread thread_;
+};
+
+#endif
@@ -1,5 +1,7 @@
 #include "timelord.h"
 
+#include <algorithm>
+#include <cctype>
 #include <filesystem>
 namespace fs = std::filesystem;
 
@@ -10,16 +12,24 @@ using boost::system::error_code;
 #include "block_info_range_rpc_querier.hpp"
 #include "block_info_sqlite_saver.hpp"
 
+#include "frontend_codec.h"
+#include "frontend_messages.h"
 #include "msg_ids.h"
 #include "timelord_utils.h"
 
 using std::placeholders::_1;
 using std::placeholders::_2;
-using std::placeholders::_3;
-using std::placeholders::_4;
 
 static int const SECS_TO_WAIT_BEFORE_CLOSE_VDF = 5;
 
+// the targets of a CALC_BATCH are handled in one turn of the strand, the batch is limited to keep the turn short
+static std::size_t const MAX_CALC_BATCH_SIZE = 1000;
+
+static int const SECS_TO_POLL_CHALLENGE = 3;
+
+// the polling interval when the challenges are pushed from the node
+static int const SECS_TO_POLL_CHALLENGE_PUSHED = 30;
+
 void LogNetspace(uint256 const& group_hash, uint64_t total_size, uint64_t sum_size)
 {
     PLOGI << tinyformat::format("netspace from group_hash: %s, curr %s TB, total %s TB", Uint256ToHex(group_hash), MakeNumberTBStr(total_size), MakeNumberTBStr(sum_size));
@@ -27,22 +37,7 @@ void LogNetspace(uint256 const& group_hash, uint64_t total_size, uint64_t sum_si
 
 void SendMsg_Ready(FrontEndSessionPtr psession)
 {
-    Json::Value msg;
-    msg["id"] = static_cast<Json::Int>(TimelordMsgs::READY);
-    psession->SendMessage(msg);
-}
-
-void SendMsg_Proof(FrontEndSessionPtr psession, uint256 const& challenge, vdf_client::ProofDetail const& detail)
-{
-    Json::Value msg;
-    msg["id"] = static_cast<Json::Int>(TimelordMsgs::PROOF);
-    msg["challenge"] = Uint256ToHex(challenge);
-    msg["y"] = BytesToHex(detail.y);
-    msg["proof"] = BytesToHex(detail.proof);
-    msg["witness_type"] = static_cast<Json::Int>(detail.witness_type);
-    msg["iters"] = detail.iters;
-    msg["duration"] = detail.duration;
-    psession->SendMessage(msg);
+    psession->SendMessage(MakeMsg_Ready());
 }
 
 void SendMsg_Speed(FrontEndSessionPtr psession, uint64_t iters_per_sec)
@@ -53,20 +48,92 @@ void SendMsg_Speed(FrontEndSessionPtr psession, uint64_t iters_per_sec)
     psession->SendMessage(msg);
 }
 
-void SendMsg_CalcReply(FrontEndSessionPtr psession, bool calculating, uint256 const& challenge, std::optional<vdf_client::ProofDetail> detail)
+void SendMsg_CalcReply(FrontEndSessionPtr psession, bool calculating, uint256 const& challenge, vdf_client::ProofDetailPtr const& detail)
+{
+    psession->SendMessage(MakeMsg_CalcReply(calculating, challenge, detail));
+}
+
+/**
+ * The reply of a target in CALC_BATCH, it has the same fields as CALC_REPLY without the id
+ */
+Json::Value MakeCalcReplyJson(bool calculating, uint256 const& challenge, vdf_client::ProofDetail const* pdetail)
+{
+    Json::Value reply;
+    reply["calculating"] = calculating;
+    reply["challenge"] = Uint256ToHex(challenge);
+    if (pdetail) {
+        ProofToJson(*pdetail, reply);
+    }
+    return reply;
+}
+
+/**
+ * The reply of a target in CALC_BATCH which isn't handled
+ */
+Json::Value MakeCalcErrorReplyJson(std::string_view error)
+{
+    Json::Value reply;
+    reply["calculating"] = false;
+    reply["error"] = std::string(error);
+    return reply;
+}
+
+bool IsUint256Hex(Json::Value const& value)
+{
+    if (!value.isString()) {
+        return false;
+    }
+    std::string hex = value.asString();
+    return hex.size() == 256 / 8 * 2 && std::all_of(std::cbegin(hex), std::cend(hex), [](char ch) {
+        return std::isxdigit(static_cast<unsigned char>(ch)) != 0;
+    });
+}
+
+/**
+ * @return false if the netspace of the message is malformed, it is optional
+ */
+bool IsNetspaceValid(Json::Value const& msg)
+{
+    if (!msg.isMember("netspace")) {
+        return true;
+    }
+    Json::Value const& netspace = msg["netspace"];
+    return netspace.isObject() && IsUint256Hex(netspace["group_hash"]) && netspace["total_size"].isUInt64();
+}
+
+/**
+ * @return false if the target of CALC_BATCH is malformed, the values are read without a check after it
+ */
+bool IsCalcTargetValid(Json::Value const& target)
+{
+    return target.isObject() && IsUint256Hex(target["challenge"]) && target["iters"].isUInt64() && IsNetspaceValid(target);
+}
+
+/**
+ * Read the netspace of the message, the arguments are left untouched when it isn't there
+ */
+void ParseNetspace(Json::Value const& msg, uint256& group_hash, uint64_t& total_size)
+{
+    if (msg.isMember("netspace") && msg["netspace"].isObject()) {
+        Json::Value const& netspace = msg["netspace"];
+        group_hash = Uint256FromHex(netspace["group_hash"].asString());
+        total_size = netspace["total_size"].asUInt64();
+    }
+}
+
+FrontEndMessage MakeMsg_Challenge(uint256 const& challenge, int height, uint64_t difficulty)
 {
     Json::Value msg;
-    msg["id"] = static_cast<Json::Int>(TimelordMsgs::CALC_REPLY);
-    msg["calculating"] = calculating;
+    msg["id"] = static_cast<Json::Int>(TimelordMsgs::CHALLENGE);
     msg["challenge"] = Uint256ToHex(challenge);
-    if (detail.has_value()) {
-        msg["y"] = BytesToHex(detail->y);
-        msg["proof"] = BytesToHex(detail->proof);
-        msg["witness_type"] = static_cast<int>(detail->witness_type);
-        msg["iters"] = detail->iters;
-        msg["duration"] = detail->duration;
-    }
-    psession->SendMessage(msg);
+    msg["height"] = height;
+    msg["difficulty"] = static_cast<Json::UInt64>(difficulty);
+    return MakeFrontEndMessage(msg);
+}
+
+MessageDispatcher::MessageDispatcher()
+    : latency_(Instrumentation::GetInstance().GetHandlerLatency("frontend"))
+{
 }
 
 void MessageDispatcher::RegisterHandler(int id, Handler handler)
@@ -82,41 +149,106 @@ void MessageDispatcher::operator()(FrontEndSessionPtr psession, Json::Value cons
         return;
     }
     auto id = msg["id"].asInt();
-    PLOGD << tinyformat::format("received: %s", MsgIdToString(static_cast<TimelordClientMsgs>(id)));
+    auto msg_name = MsgIdToString(static_cast<TimelordClientMsgs>(id));
+    PLOGD << tinyformat::format("received: %s", msg_name);
     auto it = handlers_.find(id);
     if (it == std::cend(handlers_)) {
         return;
     }
+    ScopedHandlerTimer timer(latency_, msg_name);
     it->second(psession, msg);
 }
 
-Timelord::Timelord(asio::io_context& ioc, RPCClient& rpc, std::string_view vdf_client_path, std::string_view vdf_client_addr, unsigned short vdf_client_port, int fork_height, LocalSQLiteDatabaseKeeper& persist_operator, LocalSQLiteStorage& storage, VDFProofSubmitterType submitter)
+Timelord::Timelord(asio::io_context& ioc, asio::io_context& best_effort_ioc, std::vector<AsyncRPCClient*> const& rpcs, std::string_view vdf_client_path, std::string_view vdf_client_addr, unsigned short vdf_client_port, int fork_height, int max_challenge_depth, LocalSQLiteDatabaseKeeper& persist_operator, LocalSQLiteStorage& storage, NetspaceAggregator& netspace, VDFProofSubmitterType submitter)
     : ioc_(ioc)
-    , persist_operator_(persist_operator)
-    , block_info_querier_(BlockInfoRangeRPCQuerier(rpc))
-    , block_info_saver_(BlockInfoSQLiteSaver(storage))
+    , strand_(asio::make_strand(ioc))
+    , persist_worker_(BlockInfoRangeRPCQuerier(*rpcs.front()), BlockInfoSQLiteSaver(storage), persist_operator, fork_height)
     , vdf_proof_submitter_(std::move(submitter))
-    , challenge_monitor_(ioc_, rpc, 3)
+    , challenge_monitor_(best_effort_ioc, rpcs, SECS_TO_POLL_CHALLENGE, SECS_TO_POLL_CHALLENGE_PUSHED)
+    , num_untrusted_pushes_(MetricsRegistry::GetInstance().GetCounter("timelord_challenge_rejected_pushes_total", "The number of the pushed challenges those are rejected", MakeMetricLabel("reason", "untrusted")))
     , frontend_(ioc)
-    , fork_height_(fork_height)
+    , challenge_reqs_(max_challenge_depth)
     , vdf_client_man_(ioc_, vdf_client::TimeType::N, ExpandEnvPath(std::string(vdf_client_path)), vdf_client_addr, vdf_client_port)
+    , iters_per_sec_gauge_(MetricsRegistry::GetInstance().GetGauge("timelord_iters_per_second", "The speed of vdf_client from the last proof"))
+    , num_proofs_(MetricsRegistry::GetInstance().GetCounter("timelord_proofs_produced_total", "The number of the proofs received from vdf_client"))
+    , num_calcs_(MetricsRegistry::GetInstance().GetCounter("timelord_calc_requests_total", "The number of the CALC requests received from frontend"))
+    , subscribers_gauge_(MetricsRegistry::GetInstance().GetGauge("timelord_frontend_subscribers", "The number of the frontend sessions subscribe to the challenges and the proofs"))
+    , netspace_(netspace)
 {
     PLOGD << "Timelord is created with " << vdf_client_addr << ":" << vdf_client_port << ", vdf=" << vdf_client_path << " listening " << vdf_client_addr << ":" << vdf_client_port;
     auto full_path = ExpandEnvPath(std::string(vdf_client_path));
     if (!fs::exists(full_path) || !fs::is_regular_file(full_path)) {
         throw std::runtime_error(fmt::format("the full path to `vdf_client' is incorrect, path={}", vdf_client_path));
     }
-    vdf_client_man_.SetProofReceiver(std::bind(&Timelord::HandleVdfClient_ProofIsReceived, this, _1, _2));
-    challenge_monitor_.SetNewChallengeHandler(std::bind(&Timelord::HandleChallengeMonitor_NewChallenge, this, _1, _2, _3, _4));
-    challenge_monitor_.SetNewVdfReqHandler(std::bind(&Timelord::HandleChallengeMonitor_NewVdfReqs, this, _1, _2));
+    MakeZero(curr_challenge_, 0);
+    // the events come from the strands of other components, the arguments are copied and the handlers run on our strand
+    vdf_client_man_.SetProofReceiver([this, &latency = Instrumentation::GetInstance().GetHandlerLatency("timelord")](uint256 const& challenge, vdf_client::ProofDetailPtr const& detail) {
+        asio::dispatch(strand_, [this, &latency, challenge, detail]() {
+            ScopedHandlerTimer timer(latency, "proof");
+            HandleVdfClient_ProofIsReceived(challenge, detail);
+        });
+    });
+    // the challenge monitor runs on the best-effort loop, the events are passed through the bus
+    challenge_monitor_.SetNewChallengeHandler([this](uint256 const& old_challenge, uint256 const& new_challenge, int height, uint64_t difficulty) {
+        bus_.Publish(NewChallengeEvent { old_challenge, new_challenge, height, difficulty });
+    });
+    challenge_monitor_.SetNewVdfReqHandler([this](uint256 const& challenge, std::set<uint64_t> const& vdf_reqs) {
+        bus_.Publish(NewVdfReqsEvent { challenge, vdf_reqs });
+    });
     msg_dispatcher_.RegisterHandler(static_cast<int>(TimelordClientMsgs::CALC), std::bind(&Timelord::HandleFrontEnd_SessionRequestChallenge, this, _1, _2));
-    frontend_.SetConnectionHandler(std::bind(&Timelord::HandleFrontEnd_NewSessionConnected, this, _1));
-    frontend_.SetMessageHandler(msg_dispatcher_);
-    frontend_.SetErrorHandler(std::bind(&Timelord::HandleFrontEnd_SessionError, this, _1, _2, _3));
+    msg_dispatcher_.RegisterHandler(static_cast<int>(TimelordClientMsgs::NEW_CHALLENGE), std::bind(&Timelord::HandleFrontEnd_SessionPushChallenge, this, _1, _2));
+    msg_dispatcher_.RegisterHandler(static_cast<int>(TimelordClientMsgs::SUBSCRIBE), std::bind(&Timelord::HandleFrontEnd_SessionSubscribe, this, _1, _2));
+    msg_dispatcher_.RegisterHandler(static_cast<int>(TimelordClientMsgs::CALC_BATCH), std::bind(&Timelord::HandleFrontEnd_SessionRequestBatch, this, _1, _2));
+    frontend_.SetConnectionHandler([this](FrontEndSessionPtr psession) {
+        asio::dispatch(strand_, [this, psession]() {
+            HandleFrontEnd_NewSessionConnected(psession);
+        });
+    });
+    frontend_.SetMessageHandler([this](FrontEndSessionPtr psession, Json::Value const& msg) {
+        asio::dispatch(strand_, [this, psession, msg]() {
+            // the handlers run out of the read handler of the session, the errors are reported to the session from here
+            try {
+                msg_dispatcher_(psession, msg);
+            } catch (std::exception const& e) {
+                PLOGE << tinyformat::format("session %s sends a message which cannot be handled: %s", AddressToString(psession.get()), e.what());
+                psession->ReportError(FrontEndSessionErrorType::READ, e.what());
+            }
+        });
+    });
+    // the session is closed on the same path as its messages, so it is handled after them and never dropped
+    frontend_.SetErrorHandler([this](FrontEndSessionPtr psession, FrontEndSessionErrorType type, std::string_view errs) {
+        asio::dispatch(strand_, [this, psession, errs = std::string(errs)]() {
+            HandleFrontEnd_SessionClosed(psession, errs);
+        });
+    });
+    // subscribers, the proofs are submitted from the best-effort loop, away from the proof path
+    bus_.Subscribe<NewChallengeEvent>("timelord", strand_, std::bind(&Timelord::HandleChallengeMonitor_NewChallenge, this, _1));
+    bus_.Subscribe<NewVdfReqsEvent>("timelord", strand_, std::bind(&Timelord::HandleChallengeMonitor_NewVdfReqs, this, _1));
+    bus_.Subscribe<ProofReadyEvent>("submitter", asio::make_strand(best_effort_ioc), [this](ProofReadyEvent const& event) {
+        vdf_proof_submitter_(event.challenge, event.detail);
+    });
+    persist_worker_.Subscribe(bus_);
+}
+
+void Timelord::SetSendQueueLimit(std::size_t max_bytes, FrontEndSendQueuePolicy policy)
+{
+    frontend_.SetSendQueueLimit(max_bytes, policy);
+}
+
+void Timelord::SetFrontEndAcceptorLoops(std::vector<asio::io_context*> const& iocs)
+{
+    frontend_.SetAcceptorLoops(iocs);
+}
+
+void Timelord::SetChallengePushAuth(std::set<std::string> trusted_addrs, std::string token)
+{
+    push_trusted_addrs_ = std::move(trusted_addrs);
+    push_token_ = std::move(token);
 }
 
 void Timelord::Run(std::string_view addr, unsigned short port)
 {
+    persist_worker_.Run();
     vdf_client_man_.Run();
     challenge_monitor_.Run();
     frontend_.Run(addr, port);
@@ -124,13 +256,16 @@ void Timelord::Run(std::string_view addr, unsigned short port)
 
 void Timelord::Exit()
 {
-    for (auto ptimer : ptimer_wait_close_vdf_set_) {
-        error_code ignored_ec;
-        ptimer->cancel(ignored_ec);
-    }
+    asio::dispatch(strand_, [this]() {
+        for (auto ptimer : ptimer_wait_close_vdf_set_) {
+            error_code ignored_ec;
+            ptimer->cancel(ignored_ec);
+        }
+    });
     vdf_client_man_.Exit();
     challenge_monitor_.Exit();
     frontend_.Exit();
+    persist_worker_.Exit();
 }
 
 Timelord::Status Timelord::QueryStatus() const
@@ -141,6 +276,7 @@ Timelord::Status Timelord::QueryStatus() const
     status.height = height_;
     status.iters_per_sec = iters_per_sec_;
     status.num_connections = frontend_.GetNumOfSessions();
+    status.num_requests = num_requests_;
     if (challenge_monitor_.GetStatus() == ChallengeMonitor::Status::NO_ERROR) {
         status.status_string = "good";
     } else if (challenge_monitor_.GetStatus() == ChallengeMonitor::Status::RPC_ERROR) {
@@ -148,25 +284,70 @@ Timelord::Status Timelord::QueryStatus() const
     } else if (challenge_monitor_.GetStatus() == ChallengeMonitor::Status::OTHER_ERROR) {
         status.status_string = tinyformat::format("other error: %s", challenge_monitor_.GetErrorString());
     }
-    // count total size
-    status.total_size = 0;
-    for (auto const& pa : netspace_) {
-        status.total_size += pa.second;
-    }
+    status.total_size = netspace_.GetCurrentSize();
     return status;
 }
 
-void Timelord::HandleChallengeMonitor_NewChallenge(uint256 const& old_challenge, uint256 const& new_challenge, int height, uint64_t difficulty)
+std::vector<EventQueueStats> Timelord::QueryEventQueueStats() const
+{
+    return bus_.QueryStats();
+}
+
+void Timelord::HandleChallengeMonitor_NewChallenge(NewChallengeEvent const& event)
 {
+    auto const& new_challenge = event.challenge;
+    int height = event.height;
     PLOGI << tinyformat::format("challenge is changed to %s, height=%d", Uint256ToHex(new_challenge), height);
 
+    curr_challenge_ = new_challenge;
     height_ = height;
-    difficulty_ = difficulty;
-    netspace_.clear();
+    difficulty_ = event.difficulty;
+    netspace_.NewChallenge(new_challenge, height, time(nullptr));
+
+    // the saved requests are delivered to vdf_client before anything else
+    std::vector<VDFRequest> requests;
+    challenge_reqs_.NewChallenge(new_challenge);
+    num_requests_ = challenge_reqs_.GetSize();
+    auto preqs = challenge_reqs_.Find(new_challenge);
+    if (preqs) {
+        PLOGI << "delivering total " << preqs->size() << " saved request(s)";
+        for (auto const& [iters, req] : *preqs) {
+            vdf_client_man_.CalcIters(new_challenge, iters);
+        }
+        for (auto const& [iters, req] : *preqs) {
+            uint64_t sum_size;
+            bool newly;
+            std::tie(sum_size, newly) = netspace_.Add(req.group_hash, req.total_size);
+            if (newly) {
+                LogNetspace(req.group_hash, req.total_size, sum_size);
+                requests.push_back(MakeRequest(new_challenge, iters, req.group_hash, req.total_size));
+            }
+        }
+    }
+
+    // the challenge must be calculated as soon as possible
+    vdf_client_man_.CalcIters(new_challenge, 100000 * 60 * 60);
+
+    // then the subscribers are notified, the message is encoded only once
+    if (!subscribers_.empty()) {
+        auto challenge_msg = MakeMsg_Challenge(new_challenge, height, event.difficulty);
+        for (auto it = std::begin(subscribers_); it != std::end(subscribers_);) {
+            auto psubscriber = it->second.lock();
+            if (psubscriber) {
+                psubscriber->SendMessage(challenge_msg);
+                ++it;
+            } else {
+                // the session is closed before it subscribes
+                it = subscribers_.erase(it);
+            }
+        }
+        subscribers_gauge_.Set(subscribers_.size());
+        PLOGD << tinyformat::format("the challenge is sent to %d subscriber(s)", subscribers_.size());
+    }
 
-    auto ptimer = std::make_shared<asio::steady_timer>(ioc_);
+    auto ptimer = std::make_shared<asio::steady_timer>(strand_);
     ptimer->expires_after(std::chrono::seconds(SECS_TO_WAIT_BEFORE_CLOSE_VDF));
-    ptimer->async_wait([this, ptimer, challenge = old_challenge](error_code const& ec) {
+    ptimer->async_wait([this, ptimer, challenge = event.old_challenge](error_code const& ec) {
         ptimer_wait_close_vdf_set_.erase(ptimer);
         if (ec) {
             if (ec != asio::error::operation_aborted) {
@@ -180,75 +361,25 @@ void Timelord::HandleChallengeMonitor_NewChallenge(uint256 const& old_challenge,
     });
     ptimer_wait_close_vdf_set_.insert(std::move(ptimer));
 
-    // the challenge must be calculated as soon as possible
-    vdf_client_man_.CalcIters(new_challenge, 100000 * 60 * 60);
-
-    // append new record to local database for the incoming block
-    if (height >= fork_height_) {
-        VDFRecord record;
-        record.timestamp = time(nullptr);
-        record.challenge = new_challenge;
-        record.height = height;
-        persist_operator_.AppendRecord(record);
-    } else {
-        PLOGE << tinyformat::format("challenge on height %d is less than fork height %d", height, fork_height_);
-    }
-
-    // we should query last new block info. and save it to local database
-    auto new_blocks = block_info_querier_(1);
-    if (!new_blocks.empty()) {
-        auto const& block_info = new_blocks.front();
-        // check the block height before we save it
-        if (block_info.height == height - 1 && height - 1 >= fork_height_) {
-            // ok, we got a record
-            try {
-                block_info_saver_(block_info);
-                PLOGI << tinyformat::format("saved block height=%d into local db", block_info.height);
-            } catch (std::exception const& e) {
-                PLOGE << tinyformat::format("cannot save block height=%d into local db, err: %s", block_info.height, e.what());
-            }
-        }
-    }
-
-    // need to deliver iters to vdf_client?
-    auto it = challenge_reqs_.find(new_challenge);
-    if (it != std::cend(challenge_reqs_)) {
-        PLOGI << "delivering total " << it->second.size() << " saved request(s)";
-        for (auto req : it->second) {
-            vdf_client_man_.CalcIters(new_challenge, req.iters);
-            // save the request to local database
-            uint64_t sum_size;
-            bool newly;
-            std::tie(sum_size, newly) = AddAndSumNetspace(req.group_hash, req.total_size);
-            if (newly) {
-                LogNetspace(req.group_hash, req.total_size, sum_size);
-                // update to local database
-                VDFRequest request;
-                request.challenge = new_challenge;
-                request.iters = req.iters;
-                request.estimated_seconds = iters_per_sec_ > 0 ? req.iters / iters_per_sec_ : 0;
-                request.group_hash = req.group_hash;
-                request.total_size = req.total_size;
-                try {
-                    persist_operator_.AppendRequest(request);
-                } catch (std::exception const& e) {
-                    PLOGE << tinyformat::format("cannot save the request(group_hash: %s): %s", Uint256ToHex(req.group_hash), e.what());
-                }
-            }
-        }
-    }
+    // the record, the last block and the requests are saved by the subscribers
+    VDFRecord record;
+    record.timestamp = time(nullptr);
+    record.challenge = new_challenge;
+    record.height = height;
+    bus_.Publish(ChallengeRecordedEvent { std::move(record), std::move(requests) });
 }
 
-void Timelord::HandleChallengeMonitor_NewVdfReqs(uint256 const& challenge, std::set<uint64_t> const& vdf_reqs)
+void Timelord::HandleChallengeMonitor_NewVdfReqs(NewVdfReqsEvent const& event)
 {
-    for (uint64_t iters : vdf_reqs) {
+    auto const& challenge = event.challenge;
+    for (uint64_t iters : event.vdf_reqs) {
         if (iters == 0) {
             continue;
         }
         auto detail = vdf_client_man_.QueryExistingProof(challenge, iters);
-        if (detail.has_value()) {
+        if (detail) {
             PLOGD << tinyformat::format("the proof already exists, just send it back to miner, challenge: (iters=%s)%s", FormatNumberStr(std::to_string(iters)), Uint256ToHex(challenge));
-            vdf_proof_submitter_(challenge, detail->y, detail->proof, detail->witness_type, detail->iters, detail->duration);
+            SubmitProof(challenge, detail);
             continue;
         }
         vdf_client_man_.CalcIters(challenge, iters);
@@ -261,144 +392,279 @@ void Timelord::HandleFrontEnd_NewSessionConnected(FrontEndSessionPtr psession)
     SendMsg_Ready(psession);
 }
 
-void Timelord::HandleFrontEnd_SessionError(FrontEndSessionPtr psession, FrontEndSessionErrorType type, std::string_view errs)
+void Timelord::HandleFrontEnd_SessionClosed(FrontEndSessionPtr psession, std::string const& errs)
 {
+    if (psession) {
+        challenge_reqs_.RemoveSession(psession->GetId());
+        num_requests_ = challenge_reqs_.GetSize();
+        if (subscribers_.erase(psession->GetId()) > 0) {
+            subscribers_gauge_.Set(subscribers_.size());
+        }
+    }
     PLOGD << "session error occurs: " << errs << ", session count " << frontend_.GetNumOfSessions();
 }
 
+void Timelord::HandleFrontEnd_SessionPushChallenge(FrontEndSessionPtr psession, Json::Value const& msg)
+{
+    if (!IsChallengePushAllowed(psession, msg)) {
+        PLOGW << tinyformat::format("the challenge pushed from session %s (%s) is rejected, the peer isn't trusted", AddressToString(psession.get()), psession->GetRemoteAddress());
+        num_untrusted_pushes_.Inc();
+        return;
+    }
+    if (!IsUint256Hex(msg["challenge"]) || !msg["height"].isInt() || !msg["difficulty"].isUInt64()) {
+        PLOGW << tinyformat::format("the challenge pushed from session %s is malformed", AddressToString(psession.get()));
+        return;
+    }
+    uint256 challenge = Uint256FromHex(msg["challenge"].asString());
+    int height = msg["height"].asInt();
+    uint64_t difficulty = msg["difficulty"].asUInt64();
+    std::set<uint64_t> vdf_reqs;
+    if (msg.isMember("vdf_reqs") && msg["vdf_reqs"].isArray()) {
+        for (auto const& iters : msg["vdf_reqs"]) {
+            vdf_reqs.insert(iters.asUInt64());
+        }
+    }
+    PLOGD << tinyformat::format("challenge is pushed from session %s, height=%d, challenge=%s", AddressToString(psession.get()), height, Uint256ToHex(challenge));
+    // the challenge monitor checks it against the polled state, then publishes the events as it does for the polled one
+    challenge_monitor_.PushChallenge(challenge, height, difficulty, std::move(vdf_reqs));
+}
+
+bool Timelord::IsChallengePushAllowed(FrontEndSessionPtr const& psession, Json::Value const& msg) const
+{
+    if (push_trusted_addrs_.find(psession->GetRemoteAddress()) != std::cend(push_trusted_addrs_)) {
+        return true;
+    }
+    if (push_token_.empty() || !msg["token"].isString()) {
+        return false;
+    }
+    // the token is compared in constant time
+    std::string token = msg["token"].asString();
+    unsigned char diff = token.size() == push_token_.size() ? 0 : 1;
+    for (std::size_t i = 0; i < push_token_.size(); ++i) {
+        diff |= push_token_[i] ^ (i < token.size() ? token[i] : 0);
+    }
+    return diff == 0;
+}
+
+void Timelord::HandleFrontEnd_SessionSubscribe(FrontEndSessionPtr psession, Json::Value const& msg)
+{
+    subscribers_[psession->GetId()] = psession;
+    subscribers_gauge_.Set(subscribers_.size());
+    PLOGD << tinyformat::format("session %s subscribes, total %d subscriber(s)", AddressToString(psession.get()), subscribers_.size());
+    // the current challenge is sent as the reply
+    if (!IsZero(curr_challenge_)) {
+        psession->SendMessage(MakeMsg_Challenge(curr_challenge_, height_, difficulty_));
+    }
+}
+
 void Timelord::HandleFrontEnd_SessionRequestChallenge(FrontEndSessionPtr psession, Json::Value const& msg)
 {
     uint256 challenge = Uint256FromHex(msg["challenge"].asString());
     uint64_t iters = msg["iters"].asInt64();
+    num_calcs_.Inc();
 
-    if (iters == 0) {
-        SendMsg_CalcReply(psession, false, challenge, {});
+    uint256 group_hash;
+    uint64_t total_size { 0 };
+    ParseNetspace(msg, group_hash, total_size);
+
+    auto res = CalcTarget(psession, challenge, iters, group_hash, total_size);
+    if (res.calculating && UpdateNetspace(group_hash, total_size)) {
+        // the request of a new group is saved to local database by the subscriber
+        bus_.Publish(CalcRequestedEvent { MakeRequest(challenge, iters, group_hash, total_size) });
+    }
+    SendMsg_CalcReply(psession, res.calculating, challenge, res.detail);
+}
+
+void Timelord::HandleFrontEnd_SessionRequestBatch(FrontEndSessionPtr psession, Json::Value const& msg)
+{
+    Json::Value const& targets = msg["targets"];
+    Json::Value replies(Json::arrayValue);
+    auto send_replies = [&psession, &replies]() {
+        Json::Value reply;
+        reply["id"] = static_cast<Json::Int>(TimelordMsgs::CALC_BATCH_REPLY);
+        reply["replies"] = std::move(replies);
+        psession->SendMessage(reply);
+    };
+    if (!targets.isArray() || !IsNetspaceValid(msg)) {
+        PLOGE << tinyformat::format("session %s sends a malformed CALC_BATCH", AddressToString(psession.get()));
+        // the client is still replied, every target is rejected
+        if (targets.isArray()) {
+            for (Json::ArrayIndex i = 0; i < targets.size(); ++i) {
+                replies.append(MakeCalcErrorReplyJson("malformed batch"));
+            }
+        }
+        send_replies();
         return;
     }
+    std::size_t num_targets = std::min<std::size_t>(targets.size(), MAX_CALC_BATCH_SIZE);
+    if (num_targets < targets.size()) {
+        PLOGW << tinyformat::format("session %s sends %d targets in a CALC_BATCH, only the first %d are handled", AddressToString(psession.get()), targets.size(), num_targets);
+    }
+    num_calcs_.Inc(num_targets);
+
+    // the netspace of the batch is used by the targets those don't carry their own one
+    uint256 batch_group_hash;
+    uint64_t batch_total_size { 0 };
+    ParseNetspace(msg, batch_group_hash, batch_total_size);
+
+    std::vector<VDFRequest> new_group_reqs;
+    FlatHashSet<uint256> updated_groups;
+    for (Json::ArrayIndex i = 0; i < num_targets; ++i) {
+        Json::Value const& target = targets[i];
+        if (!IsCalcTargetValid(target)) {
+            // the malformed target is replied with an error, the replies are kept in the order of the targets
+            PLOGW << tinyformat::format("session %s sends a malformed target #%d in a CALC_BATCH", AddressToString(psession.get()), i);
+            replies.append(MakeCalcErrorReplyJson("malformed target"));
+            continue;
+        }
+        uint256 challenge = Uint256FromHex(target["challenge"].asString());
+        uint64_t iters = target["iters"].asUInt64();
+        uint256 group_hash = batch_group_hash;
+        uint64_t total_size = batch_total_size;
+        ParseNetspace(target, group_hash, total_size);
+
+        auto res = CalcTarget(psession, challenge, iters, group_hash, total_size);
+        // the netspace is only updated once for each group of the batch
+        if (res.calculating && total_size > 0 && updated_groups.insert(group_hash) && UpdateNetspace(group_hash, total_size)) {
+            new_group_reqs.push_back(MakeRequest(challenge, iters, group_hash, total_size));
+        }
+        replies.append(MakeCalcReplyJson(res.calculating, challenge, res.detail.get()));
+    }
+    // the targets over the limit are rejected, the replies are kept in the order of the targets
+    for (Json::ArrayIndex i = num_targets; i < targets.size(); ++i) {
+        replies.append(MakeCalcErrorReplyJson("batch too large"));
+    }
+    // the requests of the new groups are saved in one transaction
+    if (!new_group_reqs.empty()) {
+        bus_.Publish(CalcBatchRequestedEvent { std::move(new_group_reqs) });
+    }
+    send_replies();
+}
+
+Timelord::CalcResult Timelord::CalcTarget(FrontEndSessionPtr const& psession, uint256 const& challenge, uint64_t iters, uint256 const& group_hash, uint64_t total_size)
+{
+    if (iters == 0) {
+        return { false, nullptr };
+    }
 
     auto detail = vdf_client_man_.QueryExistingProof(challenge, iters);
-    if (detail.has_value()) {
+    if (detail) {
         PLOGD << tinyformat::format("the proof already exists, just send it back to miner, challenge: (iters=%s)%s", FormatNumberStr(std::to_string(iters)), Uint256ToHex(challenge));
-        SendMsg_CalcReply(psession, false, challenge, detail);
-        return;
+        return { false, detail };
     }
 
     PLOGD << "challenge: (iters=" << FormatNumberStr(std::to_string(iters)) << ")" << Uint256ToHex(challenge);
 
-    uint256 group_hash;
-    uint64_t total_size { 0 };
-    if (msg.isMember("netspace") && msg["netspace"].isObject()) {
-        Json::Value netspace = msg["netspace"];
-        group_hash = Uint256FromHex(netspace["group_hash"].asString());
-        total_size = netspace["total_size"].asUInt64();
-    }
-
     // mark the session that it is related with the challenge
-    auto it = challenge_reqs_.find(challenge);
-    if (it == std::cend(challenge_reqs_)) {
-        ChallengeRequestSession entry;
-        entry.pweak_session = std::weak_ptr(psession);
-        entry.iters = iters;
-        entry.group_hash = group_hash;
-        entry.total_size = total_size;
-        // mark session with the challenge
-        challenge_reqs_.insert(std::make_pair(challenge, std::vector<ChallengeRequestSession> { entry }));
-    } else {
-        // find the session first
-        auto it2 = std::find_if(std::begin(it->second), std::end(it->second), [psession, iters](ChallengeRequestSession const& req) {
-            return req.pweak_session.lock() == psession && req.iters == iters;
-        });
-        if (it2 == std::end(it->second)) {
-            // mark session with the challenge
-            it->second.push_back({ std::weak_ptr(psession), iters, group_hash, total_size });
-        }
-    }
+    challenge_reqs_.Add(challenge, psession, iters, group_hash, total_size);
+    num_requests_ = challenge_reqs_.GetSize();
 
     // reject when the challenge doesn't match
-    if (challenge != challenge_monitor_.GetCurrentChallenge()) {
+    if (challenge != curr_challenge_) {
         PLOGD << "the challenge doesn't match, but the request is saved";
-        SendMsg_CalcReply(psession, false, challenge, {});
-        return;
-    }
-
-    if (total_size > 0) {
-        uint64_t sum_size;
-        bool newly;
-        std::tie(sum_size, newly) = AddAndSumNetspace(group_hash, total_size);
-        if (newly) {
-            LogNetspace(group_hash, total_size, sum_size);
-            // update to local database
-            VDFRequest request;
-            request.challenge = challenge;
-            request.iters = iters;
-            request.estimated_seconds = iters_per_sec_ > 0 ? iters / iters_per_sec_ : 0;
-            request.group_hash = group_hash;
-            request.total_size = total_size;
-            try {
-                persist_operator_.AppendRequest(request);
-            } catch (std::exception const& e) {
-                PLOGE << tinyformat::format("cannot save request(group_hash: %s): %s", Uint256ToHex(group_hash), e.what());
-            }
-        }
+        return { false, nullptr };
     }
 
     vdf_client_man_.CalcIters(challenge, iters);
-    SendMsg_CalcReply(psession, true, challenge, {});
+    return { true, nullptr };
+}
+
+bool Timelord::UpdateNetspace(uint256 const& group_hash, uint64_t total_size)
+{
+    if (total_size == 0) {
+        return false;
+    }
+    auto [sum_size, new_group] = netspace_.Add(group_hash, total_size);
+    if (new_group) {
+        LogNetspace(group_hash, total_size, sum_size);
+    }
+    return new_group;
 }
 
-void Timelord::HandleVdfClient_ProofIsReceived(uint256 const& challenge, vdf_client::ProofDetail const& detail)
+void Timelord::HandleVdfClient_ProofIsReceived(uint256 const& challenge, vdf_client::ProofDetailPtr const& detail)
 {
+    num_proofs_.Inc();
     // calculate the VDF speed
-    if (detail.duration == 0) {
-        PLOGI << "proof is received from vdf_client, iters=" << detail.iters << ", n/a iters/second";
+    if (detail->duration == 0) {
+        PLOGI << "proof is received from vdf_client, iters=" << detail->iters << ", n/a iters/second";
     } else {
-        iters_per_sec_ = detail.iters / detail.duration;
-        PLOGI << "proof is received from vdf_client, iters=" << detail.iters << ", " << (iters_per_sec_ / 1000) << "k iters/second";
+        iters_per_sec_ = detail->iters / detail->duration;
+        iters_per_sec_gauge_.Set(iters_per_sec_);
+        PLOGI << "proof is received from vdf_client, iters=" << detail->iters << ", " << (iters_per_sec_ / 1000) << "k iters/second";
     }
     // submit to RPC server
-    vdf_proof_submitter_(challenge, detail.y, detail.proof, detail.witness_type, detail.iters, detail.duration);
+    SubmitProof(challenge, detail);
+    // the message is encoded only once and it is shared by all related sessions and the subscribers
+    FrontEndMessage proof_msg;
+    auto get_proof_msg = [&]() -> FrontEndMessage const& {
+        if (!proof_msg) {
+            proof_msg = MakeMsg_Proof(challenge, detail);
+        }
+        return proof_msg;
+    };
+    // the subscribers receive all proofs of the current challenge, the sessions those requested the proof are skipped
+    bool to_subscribers = challenge == curr_challenge_ && !subscribers_.empty();
+    FlatHashSet<uint64_t> sent_sessions;
     // find the related session
-    auto it = challenge_reqs_.find(challenge);
-    if (it == std::cend(challenge_reqs_)) {
-        // the proof is ready, but the session which requests for the proof cannot be found
-        PLOGE << "the session relates to the proof cannot be found";
-        return;
-    }
-    bool more_req { false };
-    int sent_count { 0 };
-    for (auto const& req : it->second) {
-        if (req.iters <= detail.iters) {
+    if (challenge_reqs_.Find(challenge) == nullptr) {
+        if (!to_subscribers) {
+            // the proof is ready, but the session which requests for the proof cannot be found
+            PLOGE << "the session relates to the proof cannot be found";
+            return;
+        }
+    } else {
+        int sent_count { 0 };
+        bool more_req = challenge_reqs_.ForEachUpTo(challenge, detail->iters, [&](ChallengeRequestIndex::Request const& req) {
             auto psession = req.pweak_session.lock();
             if (psession) {
                 PLOGI << tinyformat::format("sending proof to session %s...", AddressToString(psession.get()));
-                SendMsg_Proof(psession, challenge, detail);
+                psession->SendMessage(get_proof_msg(), [challenge, iters = detail->iters]() {
+                    ProofTracer::GetInstance().MarkRequest(challenge, iters, ProofStage::PROOF_WRITTEN);
+                });
+                if (to_subscribers) {
+                    sent_sessions.insert(req.session_id);
+                }
                 ++sent_count;
             } else {
                 PLOGE << "session is lost";
             }
-        } else {
-            more_req = true;
+        });
+        PLOGI << tinyformat::format("sent proof count %d", sent_count);
+        if (!more_req) {
+            // we need to close this vdf_client
+            PLOGI << "no more request, close related vdf_client";
+            vdf_client_man_.StopByChallenge(challenge);
         }
     }
-    PLOGI << tinyformat::format("sent proof count %d", sent_count);
-    if (!more_req) {
-        // we need to close this vdf_client
-        PLOGI << "no more request, close related vdf_client";
-        vdf_client_man_.StopByChallenge(challenge);
+    if (to_subscribers) {
+        int sent_count { 0 };
+        for (auto const& [session_id, pweak_session] : subscribers_) {
+            if (sent_sessions.contains(session_id)) {
+                continue;
+            }
+            auto psubscriber = pweak_session.lock();
+            if (psubscriber) {
+                psubscriber->SendMessage(get_proof_msg());
+                ++sent_count;
+            }
+        }
+        PLOGD << tinyformat::format("sent proof to %d subscriber(s)", sent_count);
     }
 }
 
-std::tuple<uint64_t, bool> Timelord::AddAndSumNetspace(uint256 const& group_hash, uint64_t total_size)
+void Timelord::SubmitProof(uint256 const& challenge, vdf_client::ProofDetailPtr const& detail)
 {
-    auto it = netspace_.find(group_hash);
-    bool newly = it == std::cend(netspace_);
-    if (newly) {
-        netspace_.insert(std::make_pair(group_hash, total_size));
-    }
-    // count the size every time the netspace is sent
-    uint64_t sum_size { 0 };
-    for (auto pa : netspace_) {
-        sum_size += pa.second;
-    }
-    return std::make_tuple(sum_size, newly);
+    // the subscriber submits the proof from the best-effort loop
+    bus_.Publish(ProofReadyEvent { challenge, detail });
+}
+
+VDFRequest Timelord::MakeRequest(uint256 const& challenge, uint64_t iters, uint256 const& group_hash, uint64_t total_size) const
+{
+    VDFRequest request;
+    request.challenge = challenge;
+    request.iters = iters;
+    request.estimated_seconds = iters_per_sec_ > 0 ? iters / iters_per_sec_ : 0;
+    request.group_hash = group_hash;
+    request.total_size = total_size;
+    return request;
 }
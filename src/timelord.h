@@ -1,8 +1,10 @@
 #ifndef TL_TIMELORD_HPP
 #define TL_TIMELORD_HPP
 
+#include <atomic>
 #include <functional>
 #include <map>
+#include <set>
 
 #include <string>
 #include <string_view>
@@ -15,34 +17,48 @@
 #include "block_info.h"
 
 #include "querier_defs.h"
+#include "timelord_events.h"
 #include "challenge_monitor.h"
+#include "challenge_request_index.h"
 #include "frontend.h"
 #include "vdf_client_man.h"
 
+#include "event_bus.hpp"
+#include "flat_hash_map.hpp"
+#include "instrumentation.h"
+#include "metrics.h"
+#include "proof_tracer.h"
 #include "local_sqlite_storage.h"
+#include "netspace_aggregator.h"
+#include "persist_worker.h"
 
 class MessageDispatcher
 {
 public:
     using Handler = std::function<void(FrontEndSessionPtr psession, Json::Value const& msg)>;
 
+    MessageDispatcher();
+
     void RegisterHandler(int id, Handler handler);
 
     void operator()(FrontEndSessionPtr psession, Json::Value const& msg) const;
 
 private:
     std::map<int, Handler> handlers_;
+    LatencyHistogram& latency_;
 };
 
+/**
+ * The handlers of timelord run on its own strand, the events from frontend, vdf_client and challenge monitor are posted to
+ * the strand. `QueryStatus` can be called from any thread
+ *
+ * Timelord, frontend and vdf_client run on the proof loop `ioc`, the challenge monitor and the proof submitting run on the
+ * best-effort loop `best_effort_ioc`, the events between the components are passed through the event bus
+ *
+ * The challenge is polled from all nodes in `rpcs`, the blocks are persisted from the first one
+ */
 class Timelord
 {
-    struct ChallengeRequestSession {
-        std::weak_ptr<FrontEndSession> pweak_session;
-        uint64_t iters;
-        uint256 group_hash;
-        uint64_t total_size;
-    };
-
 public:
     struct Status {
         uint256 challenge;
@@ -51,10 +67,28 @@ public:
         uint64_t iters_per_sec;
         uint64_t total_size;
         int num_connections;
+        std::size_t num_requests;
         std::string status_string;
     };
 
-    Timelord(asio::io_context& ioc, RPCClient& rpc, std::string_view vdf_client_path, std::string_view vdf_client_addr, unsigned short vdf_client_port, int fork_height, LocalSQLiteDatabaseKeeper& persist_operator, LocalSQLiteStorage& storage, VDFProofSubmitterType submitter);
+    Timelord(asio::io_context& ioc, asio::io_context& best_effort_ioc, std::vector<AsyncRPCClient*> const& rpcs, std::string_view vdf_client_path, std::string_view vdf_client_addr, unsigned short vdf_client_port, int fork_height, int max_challenge_depth, LocalSQLiteDatabaseKeeper& persist_operator, LocalSQLiteStorage& storage, NetspaceAggregator& netspace, VDFProofSubmitterType submitter);
+
+    /**
+     * Limit the send queues of the frontend sessions, it should be called before `Run`
+     */
+    void SetSendQueueLimit(std::size_t max_bytes, FrontEndSendQueuePolicy policy);
+
+    /**
+     * Accept the frontend sessions on the extra loops as well, see `FrontEnd::SetAcceptorLoops`, it should be called
+     * before `Run`
+     */
+    void SetFrontEndAcceptorLoops(std::vector<asio::io_context*> const& iocs);
+
+    /**
+     * Only accept the challenges pushed (NEW_CHALLENGE) from the sessions of the trusted addresses or the sessions carry
+     * the token, all pushes are rejected when neither is set. It should be called before `Run`
+     */
+    void SetChallengePushAuth(std::set<std::string> trusted_addrs, std::string token);
 
     void Run(std::string_view addr, unsigned short port);
 
@@ -62,42 +96,87 @@ public:
 
     Status QueryStatus() const;
 
+    std::vector<EventQueueStats> QueryEventQueueStats() const;
+
 private:
-    void HandleChallengeMonitor_NewChallenge(uint256 const& old_challenge, uint256 const& new_challenge, int height, uint64_t difficulty);
+    void HandleChallengeMonitor_NewChallenge(NewChallengeEvent const& event);
 
-    void HandleChallengeMonitor_NewVdfReqs(uint256 const& challenge, std::set<uint64_t> const& vdf_reqs);
+    void HandleChallengeMonitor_NewVdfReqs(NewVdfReqsEvent const& event);
 
     void HandleFrontEnd_NewSessionConnected(FrontEndSessionPtr psession);
 
-    void HandleFrontEnd_SessionError(FrontEndSessionPtr psession, FrontEndSessionErrorType type, std::string_view errs);
+    void HandleFrontEnd_SessionClosed(FrontEndSessionPtr psession, std::string const& errs);
+
+    void HandleFrontEnd_SessionPushChallenge(FrontEndSessionPtr psession, Json::Value const& msg);
+
+    bool IsChallengePushAllowed(FrontEndSessionPtr const& psession, Json::Value const& msg) const;
 
     void HandleFrontEnd_SessionRequestChallenge(FrontEndSessionPtr psession, Json::Value const& msg);
 
-    void HandleVdfClient_ProofIsReceived(uint256 const& challenge, vdf_client::ProofDetail const& detail);
+    /**
+     * The targets of CALC_BATCH are handled as CALC, the requests of the new groups are saved together and the replies are
+     * sent back in one CALC_BATCH_REPLY by the order of the targets
+     */
+    void HandleFrontEnd_SessionRequestBatch(FrontEndSessionPtr psession, Json::Value const& msg);
+
+    /**
+     * The session receives the new challenges and all proofs of the current challenge until it is closed
+     */
+    void HandleFrontEnd_SessionSubscribe(FrontEndSessionPtr psession, Json::Value const& msg);
+
+    void HandleVdfClient_ProofIsReceived(uint256 const& challenge, vdf_client::ProofDetailPtr const& detail);
 
-    std::tuple<uint64_t, bool> AddAndSumNetspace(uint256 const& group_hash, uint64_t total_size);
+    void SubmitProof(uint256 const& challenge, vdf_client::ProofDetailPtr const& detail);
+
+    struct CalcResult {
+        bool calculating;
+        vdf_client::ProofDetailPtr detail;
+    };
+
+    /**
+     * Find the existing proof or add the request, the netspace isn't updated
+     */
+    CalcResult CalcTarget(FrontEndSessionPtr const& psession, uint256 const& challenge, uint64_t iters, uint256 const& group_hash, uint64_t total_size);
+
+    /**
+     * @return true if the group is new to the current challenge
+     */
+    bool UpdateNetspace(uint256 const& group_hash, uint64_t total_size);
+
+    VDFRequest MakeRequest(uint256 const& challenge, uint64_t iters, uint256 const& group_hash, uint64_t total_size) const;
 
     asio::io_context& ioc_;
-    LocalSQLiteDatabaseKeeper& persist_operator_;
-    BlockInfoRangeQuerierType block_info_querier_;
-    BlockInfoSaverType block_info_saver_;
+    asio::strand<asio::io_context::executor_type> strand_;
+    EventBus bus_;
+    PersistWorker persist_worker_;
     VDFProofSubmitterType vdf_proof_submitter_;
 
     FrontEnd frontend_;
     MessageDispatcher msg_dispatcher_;
-    std::map<uint256, std::vector<ChallengeRequestSession>> challenge_reqs_;
+    ChallengeRequestIndex challenge_reqs_;
+    std::atomic<std::size_t> num_requests_ { 0 };
 
-    int fork_height_;
     ChallengeMonitor challenge_monitor_;
-    int height_ { 0 };
-    uint64_t difficulty_ { 0 };
+    std::set<std::string> push_trusted_addrs_;
+    std::string push_token_;
+    Counter& num_untrusted_pushes_;
+    uint256 curr_challenge_;
+    std::atomic_int height_ { 0 };
+    std::atomic_uint64_t difficulty_ { 0 };
 
     vdf_client::VdfClientMan vdf_client_man_;
 
     std::set<std::shared_ptr<asio::steady_timer>> ptimer_wait_close_vdf_set_;
-    uint64_t iters_per_sec_ { 0 };
+    std::atomic_uint64_t iters_per_sec_ { 0 };
+    Gauge& iters_per_sec_gauge_;
+    Counter& num_proofs_;
+    Counter& num_calcs_;
+
+    // the subscribers are keyed by the session ids, the close might be handled before the subscription
+    FlatHashMap<uint64_t, std::weak_ptr<FrontEndSession>> subscribers_;
+    Gauge& subscribers_gauge_;
 
-    std::map<uint256, uint64_t> netspace_;
+    NetspaceAggregator& netspace_;
 };
 
 #endif
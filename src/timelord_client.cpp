@@ -7,20 +7,72 @@
 using std::placeholders::_1;
 using std::placeholders::_2;
 
-TimelordClient::TimelordClient(asio::io_context& ioc)
+namespace
+{
+
+vdf_client::ProofDetailPtr ParseProofDetail(Json::Value const& msg)
+{
+    vdf_client::ProofDetail detail;
+    detail.y = FormFromHex(msg["y"].asString());
+    detail.proof = BytesFromHex(msg["proof"].asString());
+    detail.witness_type = msg["witness_type"].asInt();
+    detail.iters = msg["iters"].asInt64();
+    detail.duration = msg["duration"].asInt();
+    return std::make_shared<vdf_client::ProofDetail const>(std::move(detail));
+}
+
+} // namespace
+
+TimelordClient::TimelordClient(asio::io_context& ioc, FrontEndEncoding encoding)
     : ioc_(ioc)
+    , encoding_(encoding)
     , client_(ioc)
 {
+    msg_handlers_.insert(std::make_pair(static_cast<int>(TimelordMsgs::READY), [this](Json::Value const& msg) {
+        if (encoding_ == FrontEndEncoding::JSON) {
+            return;
+        }
+        // the old servers don't report the encodings, JSON is kept
+        for (auto const& encoding : msg["encodings"]) {
+            if (encoding.asString() == FrontEndEncodingToString(encoding_)) {
+                client_.RequestEncoding(encoding_);
+                return;
+            }
+        }
+    }));
     msg_handlers_.insert(std::make_pair(static_cast<int>(TimelordMsgs::PROOF), [this](Json::Value const& msg) {
         if (proof_receiver_) {
-            auto challenge = Uint256FromHex(msg["challenge"].asString());
-            vdf_client::ProofDetail detail;
-            detail.y = BytesFromHex(msg["y"].asString());
-            detail.proof = BytesFromHex(msg["proof"].asString());
-            detail.witness_type = msg["witness_type"].asInt();
-            detail.iters = msg["iters"].asInt64();
-            detail.duration = msg["duration"].asInt();
-            proof_receiver_(challenge, detail);
+            proof_receiver_(Uint256FromHex(msg["challenge"].asString()), ParseProofDetail(msg));
+        }
+    }));
+    msg_handlers_.insert(std::make_pair(static_cast<int>(TimelordMsgs::PONG), [this](Json::Value const& msg) {
+        if (pong_receiver_) {
+            pong_receiver_(msg["nonce"].asUInt64());
+        }
+    }));
+    msg_handlers_.insert(std::make_pair(static_cast<int>(TimelordMsgs::CALC_REPLY), [this](Json::Value const& msg) {
+        if (calc_reply_receiver_) {
+            auto detail = msg.isMember("y") ? ParseProofDetail(msg) : nullptr;
+            calc_reply_receiver_(Uint256FromHex(msg["challenge"].asString()), msg["calculating"].asBool(), detail);
+        }
+    }));
+    msg_handlers_.insert(std::make_pair(static_cast<int>(TimelordMsgs::CALC_BATCH_REPLY), [this](Json::Value const& msg) {
+        if (calc_batch_reply_receiver_) {
+            std::vector<CalcReply> replies;
+            for (auto const& reply : msg["replies"]) {
+                if (reply.isMember("error")) {
+                    replies.push_back({ uint256(), false, nullptr, reply["error"].asString() });
+                    continue;
+                }
+                auto detail = reply.isMember("y") ? ParseProofDetail(reply) : nullptr;
+                replies.push_back({ Uint256FromHex(reply["challenge"].asString()), reply["calculating"].asBool(), detail, "" });
+            }
+            calc_batch_reply_receiver_(replies);
+        }
+    }));
+    msg_handlers_.insert(std::make_pair(static_cast<int>(TimelordMsgs::CHALLENGE), [this](Json::Value const& msg) {
+        if (challenge_receiver_) {
+            challenge_receiver_(Uint256FromHex(msg["challenge"].asString()), msg["height"].asInt(), msg["difficulty"].asUInt64());
         }
     }));
 }
@@ -35,11 +87,44 @@ void TimelordClient::SetErrorHandler(ErrorHandler err_handler)
     err_handler_ = std::move(err_handler);
 }
 
+void TimelordClient::SetCloseHandler(CloseHandler close_handler)
+{
+    close_handler_ = std::move(close_handler);
+}
+
 void TimelordClient::SetProofReceiver(vdf_client::ProofReceiver proof_receiver)
 {
     proof_receiver_ = std::move(proof_receiver);
 }
 
+void TimelordClient::SetChallengeReceiver(ChallengeReceiver challenge_receiver)
+{
+    challenge_receiver_ = std::move(challenge_receiver);
+}
+
+void TimelordClient::SetPongReceiver(PongReceiver pong_receiver)
+{
+    pong_receiver_ = std::move(pong_receiver);
+}
+
+void TimelordClient::SetCalcReplyReceiver(CalcReplyReceiver calc_reply_receiver)
+{
+    calc_reply_receiver_ = std::move(calc_reply_receiver);
+}
+
+void TimelordClient::SetCalcBatchReplyReceiver(CalcBatchReplyReceiver calc_batch_reply_receiver)
+{
+    calc_batch_reply_receiver_ = std::move(calc_batch_reply_receiver);
+}
+
+void TimelordClient::Ping(uint64_t nonce)
+{
+    Json::Value msg;
+    msg["id"] = static_cast<Json::Int>(TimelordClientMsgs::PING);
+    msg["nonce"] = static_cast<Json::UInt64>(nonce);
+    client_.SendMessage(msg);
+}
+
 void TimelordClient::Calc(uint256 const& challenge, uint64_t iters)
 {
     Json::Value msg;
@@ -49,6 +134,57 @@ void TimelordClient::Calc(uint256 const& challenge, uint64_t iters)
     client_.SendMessage(msg);
 }
 
+void TimelordClient::Calc(uint256 const& challenge, uint64_t iters, uint256 const& group_hash, uint64_t total_size)
+{
+    Json::Value msg;
+    msg["id"] = static_cast<Json::Int>(TimelordClientMsgs::CALC);
+    msg["challenge"] = Uint256ToHex(challenge);
+    msg["iters"] = static_cast<Json::UInt64>(iters);
+    msg["netspace"]["group_hash"] = Uint256ToHex(group_hash);
+    msg["netspace"]["total_size"] = static_cast<Json::UInt64>(total_size);
+    client_.SendMessage(msg);
+}
+
+void TimelordClient::CalcBatch(std::vector<std::pair<uint256, uint64_t>> const& targets, uint256 const& group_hash, uint64_t total_size)
+{
+    Json::Value msg;
+    msg["id"] = static_cast<Json::Int>(TimelordClientMsgs::CALC_BATCH);
+    msg["netspace"]["group_hash"] = Uint256ToHex(group_hash);
+    msg["netspace"]["total_size"] = static_cast<Json::UInt64>(total_size);
+    msg["targets"] = Json::Value(Json::arrayValue);
+    for (auto const& [challenge, iters] : targets) {
+        Json::Value target;
+        target["challenge"] = Uint256ToHex(challenge);
+        target["iters"] = static_cast<Json::UInt64>(iters);
+        msg["targets"].append(std::move(target));
+    }
+    client_.SendMessage(msg);
+}
+
+void TimelordClient::PushChallenge(uint256 const& challenge, int height, uint64_t difficulty, std::set<uint64_t> const& vdf_reqs, std::string const& token)
+{
+    Json::Value msg;
+    msg["id"] = static_cast<Json::Int>(TimelordClientMsgs::NEW_CHALLENGE);
+    msg["challenge"] = Uint256ToHex(challenge);
+    msg["height"] = height;
+    msg["difficulty"] = static_cast<Json::UInt64>(difficulty);
+    msg["vdf_reqs"] = Json::Value(Json::arrayValue);
+    for (uint64_t iters : vdf_reqs) {
+        msg["vdf_reqs"].append(static_cast<Json::UInt64>(iters));
+    }
+    if (!token.empty()) {
+        msg["token"] = token;
+    }
+    client_.SendMessage(msg);
+}
+
+void TimelordClient::Subscribe()
+{
+    Json::Value msg;
+    msg["id"] = static_cast<Json::Int>(TimelordClientMsgs::SUBSCRIBE);
+    client_.SendMessage(msg);
+}
+
 void TimelordClient::RequestServiceShutdown()
 {
     client_.SendShutdown();
@@ -63,7 +199,10 @@ void TimelordClient::Connect(std::string_view host, unsigned short port)
     client_.Connect(host, port);
 }
 
-void TimelordClient::Exit() { }
+void TimelordClient::Exit()
+{
+    client_.Exit();
+}
 
 void TimelordClient::HandleConnect()
 {
@@ -88,4 +227,9 @@ void TimelordClient::HandleError(FrontEndSessionErrorType type, std::string_view
     }
 }
 
-void TimelordClient::HandleClose() { }
+void TimelordClient::HandleClose()
+{
+    if (close_handler_) {
+        close_handler_();
+    }
+}
@@ -2,6 +2,10 @@
 #define TIMELORD_CLIENT_H
 
 #include <functional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "asio_defs.hpp"
 
@@ -14,19 +18,78 @@ class TimelordClient
 {
 public:
     using ConnectionHandler = std::function<void()>;
+    using CloseHandler = std::function<void()>;
     using ErrorHandler = std::function<void(FrontEndSessionErrorType type, std::string_view errs)>;
     using MessageHandler = std::function<void(Json::Value const& msg)>;
-
-    explicit TimelordClient(asio::io_context& ioc);
+    using ChallengeReceiver = std::function<void(uint256 const& challenge, int height, uint64_t difficulty)>;
+    using PongReceiver = std::function<void(uint64_t nonce)>;
+    // the detail is only there when the proof already exists
+    using CalcReplyReceiver = std::function<void(uint256 const& challenge, bool calculating, vdf_client::ProofDetailPtr const& detail)>;
+
+    /**
+     * The reply of a target in CALC_BATCH, the error is only there when the target is malformed
+     */
+    struct CalcReply {
+        uint256 challenge;
+        bool calculating;
+        vdf_client::ProofDetailPtr detail;
+        std::string error;
+    };
+
+    // the replies are in the order of the targets
+    using CalcBatchReplyReceiver = std::function<void(std::vector<CalcReply> const& replies)>;
+
+    /**
+     * @param encoding The encoding is requested after READY when the server supports it
+     */
+    explicit TimelordClient(asio::io_context& ioc, FrontEndEncoding encoding = FrontEndEncoding::JSON);
 
     void SetConnectionHandler(ConnectionHandler conn_handler);
 
     void SetErrorHandler(ErrorHandler err_handler);
 
+    /**
+     * The handler is invoked after the connection is closed by either side
+     */
+    void SetCloseHandler(CloseHandler close_handler);
+
     void SetProofReceiver(vdf_client::ProofReceiver proof_receiver);
 
+    void SetChallengeReceiver(ChallengeReceiver challenge_receiver);
+
+    void SetPongReceiver(PongReceiver pong_receiver);
+
+    void SetCalcReplyReceiver(CalcReplyReceiver calc_reply_receiver);
+
+    void SetCalcBatchReplyReceiver(CalcBatchReplyReceiver calc_batch_reply_receiver);
+
+    /**
+     * The nonce is sent back with PONG
+     */
+    void Ping(uint64_t nonce);
+
     void Calc(uint256 const& challenge, uint64_t iters);
 
+    /**
+     * Request the proof and report the netspace of the group
+     */
+    void Calc(uint256 const& challenge, uint64_t iters, uint256 const& group_hash, uint64_t total_size);
+
+    /**
+     * Request the proofs of the targets in one CALC_BATCH, the netspace is reported for all targets
+     */
+    void CalcBatch(std::vector<std::pair<uint256, uint64_t>> const& targets, uint256 const& group_hash, uint64_t total_size);
+
+    /**
+     * @param token The token is required by the timelord when the address of the client isn't trusted
+     */
+    void PushChallenge(uint256 const& challenge, int height, uint64_t difficulty, std::set<uint64_t> const& vdf_reqs, std::string const& token = "");
+
+    /**
+     * Receive the new challenges and all proofs of the current challenge, the current challenge is received first
+     */
+    void Subscribe();
+
     void Connect(std::string_view host, unsigned short port);
 
     void Exit();
@@ -43,11 +106,17 @@ private:
     void HandleClose();
 
     asio::io_context& ioc_;
+    FrontEndEncoding encoding_;
     FrontEndClient client_;
     std::map<int, MessageHandler> msg_handlers_;
     ConnectionHandler conn_handler_;
     ErrorHandler err_handler_;
+    CloseHandler close_handler_;
     vdf_client::ProofReceiver proof_receiver_;
+    ChallengeReceiver challenge_receiver_;
+    PongReceiver pong_receiver_;
+    CalcReplyReceiver calc_reply_receiver_;
+    CalcBatchReplyReceiver calc_batch_reply_receiver_;
 };
 
 #endif
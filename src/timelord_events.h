@@ -0,0 +1,72 @@
+#ifndef TL_TIMELORD_EVENTS_H
+#define TL_TIMELORD_EVENTS_H
+
+#include <cstdint>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "common_types.h"
+
+#include "proof_detail.h"
+#include "vdf_record.h"
+
+/**
+ * The events are passed between the components through `EventBus`
+ *
+ * Only the events to the persist worker are droppable, the database is best-effort and the proof loop never waits on it.
+ * The challenges, the requirements and the proofs are never dropped, they overflow to the unbounded list of the subscriber
+ * when its queue is full, so the publishers never wait
+ */
+
+struct NewChallengeEvent {
+    static constexpr char const* NAME = "NewChallenge";
+    static constexpr bool DROPPABLE = false;
+    uint256 old_challenge;
+    uint256 challenge;
+    int height;
+    uint64_t difficulty;
+};
+
+struct NewVdfReqsEvent {
+    static constexpr char const* NAME = "NewVdfReqs";
+    static constexpr bool DROPPABLE = false;
+    uint256 challenge;
+    std::set<uint64_t> vdf_reqs;
+};
+
+struct ChallengeRecordedEvent {
+    static constexpr char const* NAME = "ChallengeRecorded";
+    static constexpr bool DROPPABLE = true;
+    VDFRecord record;
+    // the requests were received before the challenge is arrived
+    std::vector<VDFRequest> requests;
+};
+
+/**
+ * The request of a CALC which reports the netspace of its group for the first time on the challenge
+ */
+struct CalcRequestedEvent {
+    static constexpr char const* NAME = "CalcRequested";
+    static constexpr bool DROPPABLE = true;
+    VDFRequest request;
+};
+
+/**
+ * The requests of a CALC_BATCH, only the requests of the new groups are carried, they are saved in one transaction
+ */
+struct CalcBatchRequestedEvent {
+    static constexpr char const* NAME = "CalcBatchRequested";
+    static constexpr bool DROPPABLE = true;
+    std::vector<VDFRequest> requests;
+};
+
+struct ProofReadyEvent {
+    static constexpr char const* NAME = "ProofReady";
+    static constexpr bool DROPPABLE = false;
+    uint256 challenge;
+    vdf_client::ProofDetailPtr detail;
+};
+
+#endif
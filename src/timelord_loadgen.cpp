@@ -0,0 +1,774 @@
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include <fmt/core.h>
+
+#include <plog/Appenders/RollingFileAppender.h>
+#include <plog/Formatters/TxtFormatter.h>
+#include <plog/Init.h>
+#include <plog/Log.h>
+
+#include "asio_defs.hpp"
+
+#include "async_rpc_client.h"
+#include "fake_node.h"
+#include "instrumentation.h"
+#include "local_sqlite_storage.h"
+#include "metrics.h"
+#include "netspace_aggregator.h"
+#include "thread_utils.h"
+#include "timelord.h"
+#include "timelord_client.h"
+#include "timelord_utils.h"
+
+namespace fs = std::filesystem;
+
+char const* SZ_APP_NAME = "timelord_loadgen";
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+int64_t ToUsecs(Clock::duration d)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+/**
+ * A distribution of the integers from its spec: `fixed:N`, `uniform:MIN:MAX` or `exp:MEAN`
+ */
+class Distribution
+{
+    enum class Type { FIXED, UNIFORM, EXP };
+
+public:
+    static Distribution Parse(std::string const& spec)
+    {
+        std::vector<std::string> parts;
+        std::istringstream iss(spec);
+        for (std::string part; std::getline(iss, part, ':');) {
+            parts.push_back(part);
+        }
+        Distribution dist;
+        dist.spec_ = spec;
+        try {
+            if (parts.size() == 2 && parts[0] == "fixed") {
+                dist.type_ = Type::FIXED;
+                dist.a_ = std::stoull(parts[1]);
+                return dist;
+            } else if (parts.size() == 3 && parts[0] == "uniform") {
+                dist.type_ = Type::UNIFORM;
+                dist.a_ = std::stoull(parts[1]);
+                dist.b_ = std::stoull(parts[2]);
+                if (dist.a_ <= dist.b_) {
+                    return dist;
+                }
+            } else if (parts.size() == 2 && parts[0] == "exp") {
+                dist.type_ = Type::EXP;
+                dist.a_ = std::stoull(parts[1]);
+                if (dist.a_ > 0) {
+                    return dist;
+                }
+            }
+        } catch (std::exception const&) {
+            // the number is invalid, the error is thrown below
+        }
+        throw std::runtime_error(fmt::format("invalid distribution `{}', it should be fixed:N, uniform:MIN:MAX or exp:MEAN", spec));
+    }
+
+    uint64_t operator()(std::mt19937_64& rnd) const
+    {
+        switch (type_) {
+        case Type::FIXED:
+            return a_;
+        case Type::UNIFORM:
+            return std::uniform_int_distribution<uint64_t>(a_, b_)(rnd);
+        case Type::EXP:
+            return std::max<uint64_t>(std::llround(std::exponential_distribution<double>(1.0 / a_)(rnd)), 1);
+        }
+        return a_;
+    }
+
+    std::string const& GetSpec() const
+    {
+        return spec_;
+    }
+
+private:
+    Type type_ { Type::FIXED };
+    uint64_t a_ { 0 };
+    uint64_t b_ { 0 };
+    std::string spec_;
+};
+
+struct LoadOptions {
+    std::string host;
+    unsigned short port;
+    int num_sessions;
+    int num_threads;
+    double connect_rate;
+    double ping_rate;
+    double calc_rate;
+    Distribution iters;
+    int num_groups;
+    Distribution group_size;
+    FrontEndEncoding encoding;
+};
+
+/**
+ * The latencies are kept in microseconds, each loop has its own stats and they are merged after the loops are stopped
+ */
+struct LoadStats {
+    std::vector<int64_t> connect_usecs;
+    std::vector<int64_t> pong_usecs;
+    std::vector<int64_t> calc_reply_usecs;
+    std::vector<int64_t> proof_usecs;
+    uint64_t num_connected { 0 };
+    uint64_t num_connect_errors { 0 };
+    uint64_t num_disconnects { 0 };
+    uint64_t num_pings { 0 };
+    uint64_t num_calcs { 0 };
+    uint64_t num_rejected_calcs { 0 };
+    uint64_t num_proofs { 0 };
+    uint64_t num_waiting_replies { 0 };
+    uint64_t num_waiting_proofs { 0 };
+
+    void Merge(LoadStats const& rhs)
+    {
+        auto append = [](std::vector<int64_t>& dst, std::vector<int64_t> const& src) {
+            dst.insert(std::end(dst), std::begin(src), std::end(src));
+        };
+        append(connect_usecs, rhs.connect_usecs);
+        append(pong_usecs, rhs.pong_usecs);
+        append(calc_reply_usecs, rhs.calc_reply_usecs);
+        append(proof_usecs, rhs.proof_usecs);
+        num_connected += rhs.num_connected;
+        num_connect_errors += rhs.num_connect_errors;
+        num_disconnects += rhs.num_disconnects;
+        num_pings += rhs.num_pings;
+        num_calcs += rhs.num_calcs;
+        num_rejected_calcs += rhs.num_rejected_calcs;
+        num_proofs += rhs.num_proofs;
+        num_waiting_replies += rhs.num_waiting_replies;
+        num_waiting_proofs += rhs.num_waiting_proofs;
+    }
+};
+
+/**
+ * The state shared by the sessions of a loop
+ */
+struct LoadContext {
+    LoadOptions const& opts;
+    uint256 challenge;
+    std::mt19937_64 rnd;
+    LoadStats stats;
+};
+
+/**
+ * A simulated miner, it sends PING and CALC with the exponential intervals of the rates after it is connected. The CALC
+ * replies come back in order, so the send times are queued. A PROOF answers all waiting requests up to its iters
+ */
+class LoadSession
+{
+public:
+    LoadSession(asio::io_context& ioc, LoadContext& ctx, int index)
+        : ctx_(ctx)
+        , client_(ioc, ctx.opts.encoding)
+        , timer_(ioc)
+    {
+        if (ctx_.opts.num_groups > 0) {
+            // the sessions of a group report the same netspace
+            int group = index % ctx_.opts.num_groups;
+            std::mt19937_64 group_rnd(group);
+            MakeZero(group_hash_, 0);
+            for (int i = 0; i < 8; ++i) {
+                group_hash_[i] = static_cast<uint8_t>(group >> (i * 8));
+            }
+            group_hash_[31] = 0xff;
+            total_size_ = ctx_.opts.group_size(group_rnd);
+        }
+    }
+
+    void Connect()
+    {
+        client_.SetConnectionHandler([this, connect_time = Clock::now()]() {
+            connected_ = true;
+            ++ctx_.stats.num_connected;
+            ctx_.stats.connect_usecs.push_back(ToUsecs(Clock::now() - connect_time));
+            ScheduleNext();
+        });
+        client_.SetErrorHandler([this](FrontEndSessionErrorType type, std::string_view errs) {
+            if (stopped_) {
+                return;
+            }
+            if (type == FrontEndSessionErrorType::CONNECT) {
+                ++ctx_.stats.num_connect_errors;
+            }
+            PLOGD << "session error: " << errs;
+        });
+        client_.SetCloseHandler([this]() {
+            if (stopped_ || !connected_) {
+                return;
+            }
+            // the session isn't reconnected
+            ++ctx_.stats.num_disconnects;
+            connected_ = false;
+            error_code ignored_ec;
+            timer_.cancel(ignored_ec);
+        });
+        client_.SetPongReceiver([this](uint64_t nonce) {
+            ctx_.stats.pong_usecs.push_back(ToUsecs(Clock::now().time_since_epoch()) - static_cast<int64_t>(nonce));
+        });
+        client_.SetCalcReplyReceiver(std::bind(&LoadSession::HandleCalcReply, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+        client_.SetProofReceiver([this](uint256 const& challenge, vdf_client::ProofDetailPtr const& detail) {
+            if (challenge == ctx_.challenge) {
+                HandleProof(detail->iters);
+            }
+        });
+        client_.Connect(ctx_.opts.host, ctx_.opts.port);
+    }
+
+    void Stop()
+    {
+        stopped_ = true;
+        ctx_.stats.num_waiting_replies += calcs_.size();
+        ctx_.stats.num_waiting_proofs += waiting_proofs_.size();
+        error_code ignored_ec;
+        timer_.cancel(ignored_ec);
+        client_.Exit();
+    }
+
+private:
+    void ScheduleNext()
+    {
+        double rate = ctx_.opts.ping_rate + ctx_.opts.calc_rate;
+        if (rate <= 0) {
+            return;
+        }
+        double secs = std::exponential_distribution<double>(rate)(ctx_.rnd);
+        timer_.expires_after(std::chrono::microseconds(std::llround(secs * 1000000)));
+        timer_.async_wait([this, rate](error_code const& ec) {
+            if (ec || !connected_) {
+                return;
+            }
+            if (std::uniform_real_distribution<double>(0, rate)(ctx_.rnd) < ctx_.opts.ping_rate) {
+                SendPing();
+            } else {
+                SendCalc();
+            }
+            ScheduleNext();
+        });
+    }
+
+    void SendPing()
+    {
+        // the send time is carried by the nonce
+        ++ctx_.stats.num_pings;
+        client_.Ping(ToUsecs(Clock::now().time_since_epoch()));
+    }
+
+    void SendCalc()
+    {
+        uint64_t iters = ctx_.opts.iters(ctx_.rnd);
+        auto now = Clock::now();
+        calcs_.push_back(std::make_pair(iters, now));
+        waiting_proofs_.insert(std::make_pair(iters, now));
+        ++ctx_.stats.num_calcs;
+        if (ctx_.opts.num_groups > 0) {
+            client_.Calc(ctx_.challenge, iters, group_hash_, total_size_);
+        } else {
+            client_.Calc(ctx_.challenge, iters);
+        }
+    }
+
+    void HandleCalcReply(uint256 const& challenge, bool calculating, vdf_client::ProofDetailPtr const& detail)
+    {
+        if (calcs_.empty()) {
+            PLOGE << "received CALC_REPLY without a request";
+            return;
+        }
+        auto [iters, send_time] = calcs_.front();
+        calcs_.pop_front();
+        ctx_.stats.calc_reply_usecs.push_back(ToUsecs(Clock::now() - send_time));
+        if (detail) {
+            HandleProof(detail->iters);
+        } else if (!calculating) {
+            // the proof won't come
+            ++ctx_.stats.num_rejected_calcs;
+            auto it = waiting_proofs_.find(iters);
+            if (it != std::end(waiting_proofs_)) {
+                waiting_proofs_.erase(it);
+            }
+        }
+    }
+
+    void HandleProof(uint64_t iters)
+    {
+        ++ctx_.stats.num_proofs;
+        auto now = Clock::now();
+        auto end = waiting_proofs_.upper_bound(iters);
+        for (auto it = std::begin(waiting_proofs_); it != end; ++it) {
+            ctx_.stats.proof_usecs.push_back(ToUsecs(now - it->second));
+        }
+        waiting_proofs_.erase(std::begin(waiting_proofs_), end);
+    }
+
+    LoadContext& ctx_;
+    TimelordClient client_;
+    asio::steady_timer timer_;
+    uint256 group_hash_;
+    uint64_t total_size_ { 0 };
+    bool connected_ { false };
+    bool stopped_ { false };
+    std::deque<std::pair<uint64_t, Clock::time_point>> calcs_;
+    std::multimap<uint64_t, Clock::time_point> waiting_proofs_;
+};
+
+/**
+ * Runs a part of the sessions on its own loop and thread, the sessions are connected with the rate
+ */
+class LoadLoop
+{
+    static constexpr std::chrono::milliseconds CONNECT_INTERVAL { 10 };
+
+public:
+    LoadLoop(LoadOptions const& opts, uint256 const& challenge, int first_index, int num_sessions, double connect_rate)
+        : ctx_ { opts, challenge, std::mt19937_64(first_index), {} }
+        , connect_timer_(ioc_)
+        , connects_per_interval_(connect_rate * CONNECT_INTERVAL.count() / 1000)
+        , loop_(ioc_)
+    {
+        for (int i = 0; i < num_sessions; ++i) {
+            sessions_.push_back(std::make_unique<LoadSession>(ioc_, ctx_, first_index + i));
+        }
+    }
+
+    void Start()
+    {
+        asio::post(ioc_, [this]() {
+            DoConnectNext();
+        });
+    }
+
+    /**
+     * The loop is stopped after all sessions are closed, the stats can be read after it returns
+     */
+    void Stop()
+    {
+        std::promise<void> stopped;
+        asio::post(ioc_, [this, &stopped]() {
+            error_code ignored_ec;
+            connect_timer_.cancel(ignored_ec);
+            for (auto& psession : sessions_) {
+                psession->Stop();
+            }
+            stopped.set_value();
+        });
+        stopped.get_future().wait();
+        loop_.Stop();
+    }
+
+    std::chrono::nanoseconds GetCpuTime()
+    {
+        return loop_.GetCpuTime();
+    }
+
+    LoadStats const& GetStats() const
+    {
+        return ctx_.stats;
+    }
+
+private:
+    void DoConnectNext()
+    {
+        connect_credits_ += connects_per_interval_;
+        for (; connect_credits_ >= 1 && num_connecting_ < sessions_.size(); connect_credits_ -= 1) {
+            sessions_[num_connecting_++]->Connect();
+        }
+        if (num_connecting_ == sessions_.size()) {
+            return;
+        }
+        connect_timer_.expires_after(CONNECT_INTERVAL);
+        connect_timer_.async_wait([this](error_code const& ec) {
+            if (!ec) {
+                DoConnectNext();
+            }
+        });
+    }
+
+    asio::io_context ioc_;
+    LoadContext ctx_;
+    asio::steady_timer connect_timer_;
+    double connects_per_interval_;
+    double connect_credits_ { 0 };
+    std::size_t num_connecting_ { 0 };
+    std::vector<std::unique_ptr<LoadSession>> sessions_;
+    LoopThread loop_;
+};
+
+using CpuTimes = std::vector<std::pair<std::string, std::chrono::nanoseconds>>;
+
+/**
+ * A timelord on the loops of this process, the proofs come from the fake vdf_client and they aren't submitted. The
+ * challenge is polled from a fake node which always reports the given challenge, unless the RPC endpoint is given
+ */
+class EmbeddedServer
+{
+public:
+    EmbeddedServer(std::string const& vdf_client_path, unsigned short vdf_client_port, std::string const& rpc_url, uint256 const& challenge, std::string const& db_path, std::string const& addr, unsigned short port, std::size_t max_queued_bytes, FrontEndSendQueuePolicy policy, int num_acceptors)
+        : pnode_(rpc_url.empty() ? std::make_unique<FakeNode>(rpc_ioc_) : nullptr)
+        , rpc_(rpc_ioc_, pnode_ ? pnode_->GetUrl() : rpc_url, "", "", AsyncRPCClient::Options())
+        , db_(db_path)
+        , persist_operator_(db_)
+        , netspace_(NETSPACE_HISTORY)
+        , timelord_(proof_ioc_, ioc_, { &rpc_ }, vdf_client_path, "127.0.0.1", vdf_client_port, 0, CHALLENGE_DEPTH, persist_operator_, db_, netspace_, [](uint256 const&, vdf_client::ProofDetailPtr const&) {})
+        , proof_lag_probe_(proof_ioc_, "proof", std::chrono::milliseconds(1000))
+        , proof_loop_(proof_ioc_)
+        , io_loop_(ioc_)
+        , rpc_loop_(rpc_ioc_)
+    {
+        if (pnode_) {
+            pnode_->SetMethodHandler("querychallenge", [challenge](UniValue const&) {
+                UniValue result(UniValue::VOBJ);
+                result.pushKV("challenge", Uint256ToHex(challenge));
+                result.pushKV("difficulty", 1);
+                result.pushKV("target_height", 1);
+                return result;
+            });
+        }
+        timelord_.SetSendQueueLimit(max_queued_bytes, policy);
+        std::vector<asio::io_context*> iocs;
+        for (int i = 1; i < num_acceptors; ++i) {
+            frontend_iocs_.push_back(std::make_unique<asio::io_context>(1));
+            iocs.push_back(frontend_iocs_.back().get());
+        }
+        timelord_.SetFrontEndAcceptorLoops(iocs);
+        timelord_.Run(addr, port);
+        for (auto pioc : iocs) {
+            frontend_loops_.push_back(std::make_unique<LoopThread>(*pioc));
+        }
+        proof_lag_probe_.Run();
+    }
+
+    ~EmbeddedServer()
+    {
+        proof_lag_probe_.Exit();
+        timelord_.Exit();
+    }
+
+    CpuTimes GetCpuTimes()
+    {
+        CpuTimes times { { "proof loop", proof_loop_.GetCpuTime() }, { "io loop", io_loop_.GetCpuTime() }, { "rpc loop", rpc_loop_.GetCpuTime() } };
+        for (std::size_t i = 0; i < frontend_loops_.size(); ++i) {
+            times.emplace_back(fmt::format("frontend loop {}", i + 1), frontend_loops_[i]->GetCpuTime());
+        }
+        return times;
+    }
+
+private:
+    static constexpr int NETSPACE_HISTORY = 5000;
+    static constexpr int CHALLENGE_DEPTH = 10;
+
+    // the loops of the extra frontend acceptors, the sessions are released with the timelord
+    std::vector<std::unique_ptr<asio::io_context>> frontend_iocs_;
+    asio::io_context proof_ioc_ { 1 };
+    asio::io_context ioc_;
+    asio::io_context rpc_ioc_ { 1 };
+    std::unique_ptr<FakeNode> pnode_;
+    AsyncRPCClient rpc_;
+    LocalSQLiteStorage db_;
+    LocalSQLiteDatabaseKeeper persist_operator_;
+    NetspaceAggregator netspace_;
+    Timelord timelord_;
+    LoopLagProbe proof_lag_probe_;
+    LoopThread proof_loop_;
+    LoopThread io_loop_;
+    LoopThread rpc_loop_;
+    std::vector<std::unique_ptr<LoopThread>> frontend_loops_;
+};
+
+/**
+ * @return The cpu time of the process from `/proc/<pid>/stat`, zero when it cannot be read
+ */
+std::chrono::nanoseconds ReadProcessCpuTime(pid_t pid)
+{
+    std::ifstream in(fmt::format("/proc/{}/stat", pid));
+    std::string stat;
+    if (!std::getline(in, stat)) {
+        return std::chrono::nanoseconds(0);
+    }
+    // the name of the command is quoted by parentheses, it can contain spaces
+    std::istringstream iss(stat.substr(stat.rfind(')') + 2));
+    std::string field;
+    uint64_t utime { 0 }, stime { 0 };
+    // utime and stime are the 14th and 15th fields, the state is the 3rd one
+    for (int i = 3; i <= 15 && iss >> field; ++i) {
+        if (i == 14) {
+            utime = std::stoull(field);
+        } else if (i == 15) {
+            stime = std::stoull(field);
+        }
+    }
+    return std::chrono::nanoseconds((utime + stime) * 1000000000 / sysconf(_SC_CLK_TCK));
+}
+
+/**
+ * @return The value in kB of the field, e.g. `VmRSS`, from `/proc/<pid>/status`, -1 when it cannot be read
+ */
+int64_t ReadProcessMemoryKB(pid_t pid, std::string_view field)
+{
+    std::ifstream in(fmt::format("/proc/{}/status", pid));
+    for (std::string line; std::getline(in, line);) {
+        if (line.size() > field.size() && line.compare(0, field.size(), field) == 0 && line[field.size()] == ':') {
+            return std::stoll(line.substr(field.size() + 1));
+        }
+    }
+    return -1;
+}
+
+/**
+ * Each session holds a socket, and the embedded timelord holds another one
+ */
+void RaiseFileLimit()
+{
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+uint256 MakeRandomChallenge()
+{
+    std::random_device rd;
+    uint256 challenge;
+    for (auto& b : challenge) {
+        b = static_cast<uint8_t>(rd());
+    }
+    return challenge;
+}
+
+void PrintLatencies(std::string_view name, std::vector<int64_t>& usecs)
+{
+    if (usecs.empty()) {
+        fmt::print("{:>12} {:>10}\n", name, 0);
+        return;
+    }
+    std::sort(std::begin(usecs), std::end(usecs));
+    auto percentile = [&usecs](double p) {
+        auto idx = static_cast<std::size_t>(std::ceil(p / 100 * usecs.size()));
+        return usecs[std::clamp<std::size_t>(idx, 1, usecs.size()) - 1] / 1000.0;
+    };
+    fmt::print("{:>12} {:>10} {:>10.2f} {:>10.2f} {:>10.2f} {:>10.2f} {:>10.2f}\n", name, usecs.size(), percentile(50), percentile(90), percentile(99), percentile(99.9), usecs.back() / 1000.0);
+}
+
+void PrintCpuUsage(CpuTimes const& begin, CpuTimes const& end, double wall_secs)
+{
+    for (std::size_t i = 0; i < begin.size() && i < end.size(); ++i) {
+        double secs = std::chrono::duration<double>(end[i].second - begin[i].second).count();
+        fmt::print("{:>16} {:>10.2f}s cpu {:>8.1f}%\n", begin[i].first, secs, secs / wall_secs * 100);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    cxxopts::Options opts(SZ_APP_NAME);
+    opts.add_options() // All options here
+            ("help,h", "Show help document") // --help
+            ("logfile", "Store logs into file", cxxopts::value<std::string>()->default_value("./timelord_loadgen.log")) // --logfile
+            ("verbose,v", "Show more logs") // --verbose
+            ("external", "Connect to a running timelord instead of starting an embedded one") // --external
+            ("push-challenge", "Push a random challenge to the external timelord, the load runs with its current challenge by default") // --push-challenge
+            ("push-token", "The token to push the challenge when the load generator isn't trusted by the external timelord", cxxopts::value<std::string>()->default_value("")) // --push-token
+            ("server-pid", "The pid of the external timelord, its resource usage is reported", cxxopts::value<int>()->default_value("0")) // --server-pid
+            ("host", "The address of the timelord, the embedded one listens to it", cxxopts::value<std::string>()->default_value("127.0.0.1")) // --host
+            ("port", "The port of the timelord", cxxopts::value<unsigned short>()->default_value("19191")) // --port
+            ("vdf_client-path", "The vdf_client of the embedded timelord, `fake_vdf_client' next to this program by default", cxxopts::value<std::string>()->default_value("")) // --vdf_client-path
+            ("vdf_client-port", "The embedded timelord listens to this port for vdf_client", cxxopts::value<unsigned short>()->default_value("29292")) // --vdf_client-port
+            ("rpc", "The endpoint of btchd core for the embedded timelord, a fake node reports a random challenge by default", cxxopts::value<std::string>()->default_value("")) // --rpc
+            ("db", "The database of the embedded timelord", cxxopts::value<std::string>()->default_value(":memory:")) // --db
+            ("send-queue-kb", "Limit the queued messages of each session of the embedded timelord, 0 for no limit", cxxopts::value<int>()->default_value("4096")) // --send-queue-kb
+            ("frontend-acceptors", "The number of the frontend acceptors of the embedded timelord, each runs on its own loop", cxxopts::value<int>()->default_value("1")) // --frontend-acceptors
+            ("slow-consumer", "What the embedded timelord does with the slow sessions: drop-oldest, coalesce or disconnect", cxxopts::value<std::string>()->default_value("disconnect")) // --slow-consumer
+            ("sessions", "The number of the sessions", cxxopts::value<int>()->default_value("1000")) // --sessions
+            ("threads", "The number of the loops to run the sessions", cxxopts::value<int>()->default_value("2")) // --threads
+            ("connect-rate", "Connect this number of sessions per second", cxxopts::value<double>()->default_value("1000")) // --connect-rate
+            ("duration", "Keep sending requests for this number of seconds after the sessions are connected", cxxopts::value<int>()->default_value("30")) // --duration
+            ("ping-rate", "PINGs per second of each session", cxxopts::value<double>()->default_value("0.2")) // --ping-rate
+            ("calc-rate", "CALCs per second of each session", cxxopts::value<double>()->default_value("0.05")) // --calc-rate
+            ("iters", "The distribution of the iters of CALC: fixed:N, uniform:MIN:MAX or exp:MEAN, fake_vdf_client runs 100k iters per second", cxxopts::value<std::string>()->default_value("uniform:100000:2000000")) // --iters
+            ("groups", "The sessions are in this number of groups and each group reports its netspace with CALC, 0 to send no netspace", cxxopts::value<int>()->default_value("100")) // --groups
+            ("group-size", "The distribution of the total size reported by each group", cxxopts::value<std::string>()->default_value("uniform:1:1000")) // --group-size
+            ("encoding", "The encoding of the sessions: json or binary", cxxopts::value<std::string>()->default_value("json")) // --encoding
+            ;
+    auto parse_result = opts.parse(argc, argv);
+    if (parse_result.count("help")) {
+        std::cout << SZ_APP_NAME << ", simulate the miners to measure the latencies and the resource usage of timelord";
+        std::cout << opts.help();
+        return 0;
+    }
+
+    std::string logfile = ExpandEnvPath(parse_result["logfile"].as<std::string>());
+    plog::RollingFileAppender<plog::TxtFormatter> rollingfile_appender(logfile.c_str(), 1024 * 1024 * 10, 10);
+    bool verbose = parse_result.count("verbose") > 0;
+    plog::init((verbose ? plog::Severity::debug : plog::Severity::info), &rollingfile_appender);
+
+    try {
+        auto encoding = FrontEndEncodingFromString(parse_result["encoding"].as<std::string>());
+        if (!encoding) {
+            throw std::runtime_error(fmt::format("unknown encoding `{}'", parse_result["encoding"].as<std::string>()));
+        }
+        LoadOptions load_opts { parse_result["host"].as<std::string>(), parse_result["port"].as<unsigned short>(), std::max(parse_result["sessions"].as<int>(), 1), std::max(parse_result["threads"].as<int>(), 1), std::max(parse_result["connect-rate"].as<double>(), 1.0), std::max(parse_result["ping-rate"].as<double>(), 0.0), std::max(parse_result["calc-rate"].as<double>(), 0.0), Distribution::Parse(parse_result["iters"].as<std::string>()), std::max(parse_result["groups"].as<int>(), 0), Distribution::Parse(parse_result["group-size"].as<std::string>()), *encoding };
+        load_opts.num_threads = std::min(load_opts.num_threads, load_opts.num_sessions);
+        int duration = std::max(parse_result["duration"].as<int>(), 1);
+        RaiseFileLimit();
+
+        uint256 challenge = MakeRandomChallenge();
+        std::unique_ptr<EmbeddedServer> pserver;
+        pid_t server_pid = parse_result["server-pid"].as<int>();
+        if (parse_result.count("external") == 0) {
+            auto policy = FrontEndSendQueuePolicyFromString(parse_result["slow-consumer"].as<std::string>());
+            if (!policy) {
+                throw std::runtime_error(fmt::format("unknown slow consumer policy `{}'", parse_result["slow-consumer"].as<std::string>()));
+            }
+            std::string vdf_client_path = ExpandEnvPath(parse_result["vdf_client-path"].as<std::string>());
+            if (vdf_client_path.empty()) {
+                vdf_client_path = (fs::absolute(argv[0]).parent_path() / "fake_vdf_client").string();
+            }
+            fmt::print("starting the embedded timelord on {}:{}, vdf_client: {}\n", load_opts.host, load_opts.port, vdf_client_path);
+            pserver = std::make_unique<EmbeddedServer>(vdf_client_path, parse_result["vdf_client-port"].as<unsigned short>(), parse_result["rpc"].as<std::string>(), challenge, parse_result["db"].as<std::string>(), load_opts.host, load_opts.port, static_cast<std::size_t>(std::max(parse_result["send-queue-kb"].as<int>(), 0)) * 1024, *policy, std::max(parse_result["frontend-acceptors"].as<int>(), 1));
+            server_pid = getpid();
+        }
+
+        // the load starts with the current challenge of the timelord, the embedded one polls it from its node. The external
+        // one serves the real miners, its challenge is only replaced when it is asked explicitly, the random challenge is
+        // pushed on top of the current one so it passes the height and difficulty check
+        bool push_challenge = !pserver && parse_result.count("push-challenge") > 0;
+        std::string push_token = parse_result["push-token"].as<std::string>();
+        asio::io_context control_ioc;
+        TimelordClient control(control_ioc);
+        std::promise<uint256> challenge_applied;
+        bool applied { false }, pushed { false };
+        LoopThread control_loop(control_ioc);
+        asio::post(control_ioc, [&]() {
+            control.SetConnectionHandler([&]() {
+                control.Subscribe();
+            });
+            control.SetChallengeReceiver([&](uint256 const& new_challenge, int height, uint64_t difficulty) {
+                // the current challenge is received as the reply of SUBSCRIBE, then the new ones
+                if (push_challenge && !pushed) {
+                    pushed = true;
+                    control.PushChallenge(challenge, height + 1, difficulty, {}, push_token);
+                    return;
+                }
+                if (applied || (push_challenge && new_challenge != challenge)) {
+                    return;
+                }
+                applied = true;
+                challenge_applied.set_value(new_challenge);
+            });
+            control.SetErrorHandler([](FrontEndSessionErrorType, std::string_view errs) {
+                PLOGE << "control session error: " << errs;
+            });
+            control.Connect(load_opts.host, load_opts.port);
+        });
+        auto challenge_future = challenge_applied.get_future();
+        if (challenge_future.wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+            throw std::runtime_error("the challenge isn't applied by the timelord in 10 seconds");
+        }
+        challenge = challenge_future.get();
+        fmt::print("challenge: {}\n", Uint256ToHex(challenge));
+
+        auto cpu_times = [&]() -> CpuTimes {
+            if (pserver) {
+                return pserver->GetCpuTimes();
+            } else if (server_pid > 0) {
+                return { { "process", ReadProcessCpuTime(server_pid) } };
+            }
+            return {};
+        };
+        CpuTimes begin_cpu_times = cpu_times();
+        auto begin_time = Clock::now();
+
+        std::vector<std::unique_ptr<LoadLoop>> loops;
+        for (int i = 0, first_index = 0; i < load_opts.num_threads; ++i) {
+            int num_sessions = load_opts.num_sessions / load_opts.num_threads + (i < load_opts.num_sessions % load_opts.num_threads ? 1 : 0);
+            loops.push_back(std::make_unique<LoadLoop>(load_opts, challenge, first_index, num_sessions, load_opts.connect_rate / load_opts.num_threads));
+            first_index += num_sessions;
+        }
+        for (auto& ploop : loops) {
+            ploop->Start();
+        }
+        double ramp_secs = load_opts.num_sessions / load_opts.connect_rate;
+        fmt::print("{} sessions on {} loops, connecting in {:.1f}s, then running for {}s\n", load_opts.num_sessions, load_opts.num_threads, ramp_secs, duration);
+        std::this_thread::sleep_for(std::chrono::duration<double>(ramp_secs + duration));
+
+        // the cpu time of the load loops is read before they are stopped, it tells whether the load generator is saturated
+        CpuTimes end_cpu_times = cpu_times();
+        std::chrono::nanoseconds load_cpu_time { 0 };
+        for (auto& ploop : loops) {
+            load_cpu_time += ploop->GetCpuTime();
+        }
+        double wall_secs = std::chrono::duration<double>(Clock::now() - begin_time).count();
+        LoadStats stats;
+        for (auto& ploop : loops) {
+            ploop->Stop();
+            stats.Merge(ploop->GetStats());
+        }
+
+        fmt::print("\n{:.1f}s, ping-rate {}/s, calc-rate {}/s, iters {}, groups {}, group-size {}, encoding {}\n", wall_secs, load_opts.ping_rate, load_opts.calc_rate, load_opts.iters.GetSpec(), load_opts.num_groups, load_opts.group_size.GetSpec(), FrontEndEncodingToString(load_opts.encoding));
+        fmt::print("sessions: {} connected, {} connect errors, {} disconnected\n", stats.num_connected, stats.num_connect_errors, stats.num_disconnects);
+        fmt::print("requests: {} PING ({:.0f}/s), {} CALC ({:.0f}/s), {} rejected CALC\n", stats.num_pings, stats.num_pings / wall_secs, stats.num_calcs, stats.num_calcs / wall_secs, stats.num_rejected_calcs);
+        fmt::print("proofs: {} received, {} requests are still waiting for CALC_REPLY, {} for PROOF\n\n", stats.num_proofs, stats.num_waiting_replies, stats.num_waiting_proofs);
+        fmt::print("{:>12} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}\n", "latency(ms)", "count", "p50", "p90", "p99", "p99.9", "max");
+        PrintLatencies("connect", stats.connect_usecs);
+        PrintLatencies("PONG", stats.pong_usecs);
+        PrintLatencies("CALC_REPLY", stats.calc_reply_usecs);
+        PrintLatencies("PROOF", stats.proof_usecs);
+
+        fmt::print("\nload generator: {:.2f}s cpu of {} loops {:.1f}%\n", std::chrono::duration<double>(load_cpu_time).count(), loops.size(), std::chrono::duration<double>(load_cpu_time).count() / wall_secs * 100);
+        if (server_pid > 0) {
+            fmt::print("server (pid {}{}):\n", server_pid, pserver ? ", the memory includes the load generator" : "");
+            PrintCpuUsage(begin_cpu_times, end_cpu_times, wall_secs);
+            fmt::print("{:>16} {} kB, peak {} kB\n", "memory", ReadProcessMemoryKB(server_pid, "VmRSS"), ReadProcessMemoryKB(server_pid, "VmHWM"));
+        }
+        if (pserver) {
+            auto& registry = MetricsRegistry::GetInstance();
+            auto get_counter = [&registry](std::string_view name) {
+                return registry.GetCounter(name, "").Get();
+            };
+            fmt::print("{:>16} {} proofs produced, {} messages dropped, {} send queues full, {} idle timeouts\n", "timelord", get_counter("timelord_proofs_produced_total"), get_counter("timelord_frontend_dropped_messages_total"), get_counter("timelord_frontend_send_queue_full_total"), get_counter("timelord_frontend_idle_timeouts_total"));
+            auto lag = Instrumentation::GetInstance().GetLoopLag("proof").GetSnapshot();
+            fmt::print("{:>16} p50 {:.2f}ms, p99 {:.2f}ms, max {:.2f}ms\n", "proof loop lag", lag.p50_usecs / 1000.0, lag.p99_usecs / 1000.0, lag.max_usecs / 1000.0);
+        }
+
+        control_loop.Stop();
+    } catch (std::exception const& e) {
+        PLOGE << e.what();
+        fmt::print(stderr, "error: {}\n", e.what());
+        return 1;
+    }
+    return 0;
+}
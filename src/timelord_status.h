@@ -17,6 +17,7 @@ struct TimelordStatus {
     uint64_t total_size;
     uint64_t max_size;
     int num_connections;
+    std::size_t num_requests;
     std::string status_string;
     BlockInfo last_block_info;
     VDFRecordPack vdf_pack;
@@ -2,6 +2,7 @@
 
 #include <cstring>
 
+#include <algorithm>
 #include <sstream>
 
 #include <json/reader.h>
@@ -57,6 +58,24 @@ uint256 Uint256FromHex(std::string const& hex)
     return MakeUint256(BytesFromHex(hex));
 }
 
+std::string FormToHex(VdfForm const& form)
+{
+    return BytesToHex(Bytes(std::cbegin(form), std::cend(form)));
+}
+
+VdfForm FormFromHex(std::string const& hex)
+{
+    Bytes bytes = BytesFromHex(hex);
+    VdfForm form;
+    if (bytes.size() != form.size()) {
+        std::stringstream err_ss;
+        err_ss << "invalid size of the form (" << bytes.size() << "), " << form.size() << " bytes are required";
+        throw std::runtime_error(err_ss.str());
+    }
+    memcpy(form.data(), bytes.data(), form.size());
+    return form;
+}
+
 Bytes StrToBytes(std::string str)
 {
     Bytes b;
@@ -167,17 +186,26 @@ std::string MakeNumberTBStr(uint64_t n)
     return FormatNumberStr(std::to_string(n_tb));
 }
 
-Json::Value ParseStringToJson(std::string_view str)
+JsonReader::JsonReader()
+    : preader_(Json::CharReaderBuilder().newCharReader())
+{
+}
+
+JsonReader::~JsonReader() = default;
+
+Json::Value& JsonReader::Parse(std::string_view str)
 {
-    Json::CharReaderBuilder builder;
-    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
-    Json::Value root;
-    std::string errs;
-    bool succ = reader->parse(std::cbegin(str), std::cend(str), &root, &errs);
-    if (!succ) {
-        throw std::runtime_error(errs);
+    errs_.clear();
+    if (!preader_->parse(str.data(), str.data() + str.size(), &root_, &errs_)) {
+        throw std::runtime_error(errs_);
     }
-    return root;
+    return root_;
+}
+
+Json::Value ParseStringToJson(std::string_view str)
+{
+    thread_local JsonReader reader;
+    return reader.Parse(str);
 }
 
 std::string FormatTime(int seconds)
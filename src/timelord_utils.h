@@ -3,10 +3,17 @@
 
 #include <cassert>
 
+#include <memory>
 #include <string>
+#include <string_view>
 
 #include <json/value.h>
 
+namespace Json
+{
+class CharReader;
+} // namespace Json
+
 #include "common_types.h"
 
 std::string AddressToString(void const* p);
@@ -55,6 +62,10 @@ Bytes BytesFromHex(std::string hex);
 
 std::string BytesToHex(Bytes const& bytes);
 
+std::string FormToHex(VdfForm const& form);
+
+VdfForm FormFromHex(std::string const& hex);
+
 class BytesConnector
 {
     static void ConnectBytesList(BytesConnector& connector) { }
@@ -119,6 +130,34 @@ std::string FormatNumberStr(std::string const& num_str);
 
 std::string MakeNumberTBStr(uint64_t n);
 
+/**
+ * A JSON reader which is built once, the parsed value is reused by the next parsing, it isn't thread-safe
+ */
+class JsonReader
+{
+public:
+    JsonReader();
+
+    ~JsonReader();
+
+    /**
+     * Parse the string in place
+     *
+     * @return The value which is valid until the next call
+     *
+     * @exception std::runtime_error The string isn't a valid JSON
+     */
+    Json::Value& Parse(std::string_view str);
+
+private:
+    std::unique_ptr<Json::CharReader> preader_;
+    Json::Value root_;
+    std::string errs_;
+};
+
+/**
+ * Parse the string with the reader of the current thread
+ */
 Json::Value ParseStringToJson(std::string_view str);
 
 std::string FormatTime(int seconds);
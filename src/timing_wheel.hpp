@@ -0,0 +1,119 @@
+#ifndef TIMING_WHEEL_HPP
+#define TIMING_WHEEL_HPP
+
+#include <cassert>
+#include <cstdint>
+
+#include <limits>
+#include <list>
+#include <utility>
+#include <vector>
+
+/**
+ * A hashed timing wheel for the entries those share the same timeout, e.g. the idle timeouts of the sessions
+ *
+ * An entry is hashed into the slot of the tick when it is added or touched, the slot is reached again after a whole
+ * round, then the entries still in it are expired. Adding, touching and removing an entry are O(1), the node of an entry
+ * is allocated once and it is moved between the slots by splicing. An entry expires after `timeout_ticks` to
+ * `timeout_ticks + 1` ticks since it was added or touched, because the current tick is partial.
+ *
+ * It isn't thread-safe, the wheel and its entries should be accessed from the same strand
+ */
+template <typename T> class TimingWheel
+{
+    static constexpr std::size_t EXPIRING_SLOT = std::numeric_limits<std::size_t>::max();
+
+    struct Entry {
+        T value;
+        std::size_t slot;
+    };
+
+    using Slot = std::list<Entry>;
+
+public:
+    using Handle = typename Slot::iterator;
+
+    explicit TimingWheel(std::size_t timeout_ticks)
+        : slots_(timeout_ticks + 1)
+    {
+    }
+
+    TimingWheel(TimingWheel const&) = delete;
+
+    TimingWheel& operator=(TimingWheel const&) = delete;
+
+    /**
+     * @return The handle of the entry, it is valid until the entry is removed or expired
+     */
+    Handle Add(T value)
+    {
+        auto& slot = slots_[cursor_];
+        slot.push_back(Entry { std::move(value), cursor_ });
+        ++size_;
+        return std::prev(std::end(slot));
+    }
+
+    /**
+     * Restart the timeout of the entry
+     */
+    void Touch(Handle handle)
+    {
+        if (handle->slot == cursor_) {
+            // it has been touched during the tick
+            return;
+        }
+        slots_[cursor_].splice(std::end(slots_[cursor_]), GetSlot(handle), handle);
+        handle->slot = cursor_;
+    }
+
+    void Remove(Handle handle)
+    {
+        assert(size_ > 0);
+        GetSlot(handle).erase(handle);
+        --size_;
+    }
+
+    /**
+     * Advance the wheel by one tick and expire the entries of the slot
+     *
+     * An entry is removed before `expired_handler` is invoked with its value, the handler is free to add, touch or remove
+     * any entries, the expiring entries are kept from expiring by touching
+     *
+     * @return The number of the expired entries
+     */
+    template <typename Handler> std::size_t Tick(Handler&& expired_handler)
+    {
+        cursor_ = (cursor_ + 1) % slots_.size();
+        expiring_.splice(std::end(expiring_), slots_[cursor_]);
+        for (auto& entry : expiring_) {
+            entry.slot = EXPIRING_SLOT;
+        }
+        std::size_t num_expired { 0 };
+        while (!expiring_.empty()) {
+            T value = std::move(expiring_.front().value);
+            expiring_.pop_front();
+            --size_;
+            ++num_expired;
+            expired_handler(std::move(value));
+        }
+        return num_expired;
+    }
+
+    std::size_t GetSize() const
+    {
+        return size_;
+    }
+
+private:
+    Slot& GetSlot(Handle handle)
+    {
+        return handle->slot == EXPIRING_SLOT ? expiring_ : slots_[handle->slot];
+    }
+
+    std::vector<Slot> slots_;
+    Slot expiring_;
+    std::size_t cursor_ { 0 };
+    std::size_t size_ { 0 };
+};
+
+#endif
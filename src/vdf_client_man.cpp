@@ -20,6 +20,7 @@
 #include "vdf_types.h"
 #include "vdf_utils.h"
 
+#include "proof_tracer.h"
 #include "timelord_utils.h"
 #include "utils.h"
 
@@ -95,52 +96,48 @@ template <typename Int> std::tuple<Int, bool> IntFromBytes(Slice const& slice)
     return std::make_tuple(bswap_common(x), true);
 }
 
-struct Proof {
-    Bytes y;
-    Bytes proof;
-    uint8_t witness_type;
-};
-
-std::tuple<Proof, uint64_t> ParseProofIters(Bytes const& buf)
+/**
+ * Parse the proof from the buffer which is received from vdf_client
+ *
+ * @return The proof object, or nullptr when the buffer is invalid
+ */
+ProofDetailPtr ParseProof(Bytes const& buf, int duration)
 {
-    Proof proof;
+    ProofDetail detail;
     // Analyze proof from bytes
     bool succ;
     uint64_t offset { 0 };
     // Read iterators
-    uint64_t iters;
-    std::tie(iters, succ) = IntFromBytes<uint64_t>(MakeSlice(buf, 0));
+    std::tie(detail.iters, succ) = IntFromBytes<uint64_t>(MakeSlice(buf, 0));
     if (!succ) {
-        return std::make_tuple(proof, 0);
+        return nullptr;
     }
-    offset += sizeof(iters);
-    // Read y
+    offset += sizeof(detail.iters);
+    // Read y, the form always has a fixed size
     uint64_t y_size;
     std::tie(y_size, succ) = IntFromBytes<uint64_t>(MakeSlice(buf, offset));
     if (!succ) {
-        return std::make_tuple(proof, 0);
+        return nullptr;
     }
     offset += sizeof(y_size);
-    if (buf.size() - offset < y_size) {
-        return std::make_tuple(proof, 0);
+    if (y_size != detail.y.size() || buf.size() - offset < y_size) {
+        PLOGE << tinyformat::format("invalid size of y (%d) from the proof", y_size);
+        return nullptr;
     }
-    proof.y.resize(y_size);
-    std::memcpy(proof.y.data(), buf.data() + offset, y_size);
+    std::memcpy(detail.y.data(), buf.data() + offset, y_size);
     offset += y_size;
     // Read witness type
     if (buf.size() - offset == 0) {
-        return std::make_tuple(proof, 0);
+        return nullptr;
     }
-    proof.witness_type = buf.data()[offset++];
+    detail.witness_type = buf.data()[offset++];
     // Read proof
-    std::size_t remain_size = buf.size() - offset;
-    proof.proof.resize(remain_size);
-    std::memcpy(proof.proof.data(), buf.data() + offset, remain_size);
-    // Return proof
-    PLOGD << "== y(len=" << proof.y.size() << "): " << BytesToHex(proof.y);
-    PLOGD << "== proof(len=" << proof.proof.size() << "): " << BytesToHex(proof.proof);
-    PLOGD << "== witness_type: " << static_cast<int>(proof.witness_type);
-    return std::make_tuple(proof, iters);
+    detail.proof.assign(buf.data() + offset, buf.data() + buf.size());
+    detail.duration = duration;
+    PLOGD << "== y(len=" << detail.y.size() << "): " << FormToHex(detail.y);
+    PLOGD << "== proof(len=" << detail.proof.size() << "): " << BytesToHex(detail.proof);
+    PLOGD << "== witness_type: " << static_cast<int>(detail.witness_type);
+    return std::make_shared<ProofDetail const>(std::move(detail));
 }
 
 Bytes MakeChallengeBuf(uint256 const& challenge)
@@ -219,6 +216,7 @@ VdfClientProc::VdfClientProc(std::string vdf_client_path, std::string addr, unsi
     : vdf_client_path_(std::move(vdf_client_path))
     , addr_(std::move(addr))
     , port_(port)
+    , procs_gauge_(MetricsRegistry::GetInstance().GetGauge("timelord_vdf_client_processes", "The number of the running vdf_client processes"))
 {
 }
 
@@ -235,6 +233,8 @@ void VdfClientProc::NewProc(uint256 const& challenge)
     int ret = posix_spawn(&pid, vdf_client_path_.c_str(), nullptr, nullptr, const_cast<char**>(argv), nullptr);
     if (ret == 0) {
         pids_.insert(std::make_pair(challenge, pid));
+        ProofTracer::GetInstance().MarkChallenge(challenge, ProofStage::VDF_CLIENT_SPAWNED);
+        procs_gauge_.Set(pids_.size());
     } else {
         PLOGE << "cannot create a new vdf_client process, command: " << vdf_client_path_ << " " << addr_ << " " << port_str;
     }
@@ -258,6 +258,7 @@ void VdfClientProc::KillByChallenge(uint256 const& challenge)
         return;
     }
     pids_.erase(it);
+    procs_gauge_.Set(pids_.size());
 }
 
 void VdfClientProc::KillAll()
@@ -270,6 +271,7 @@ void VdfClientProc::KillAll()
         }
     }
     pids_.clear();
+    procs_gauge_.Set(0);
 }
 
 SocketWriter::SocketWriter(tcp::socket& s)
@@ -389,6 +391,9 @@ bool VdfClientSession::CalcIters(uint64_t iters)
         return false;
     }
     if (SendIters(iters)) {
+        if (iters > 0) {
+            ProofTracer::GetInstance().MarkRequest(challenge_, iters, ProofStage::ITERS_SENT);
+        }
         if (best_iters_ == 0) {
             best_iters_ = iters;
         } else if (best_iters_ > iters) {
@@ -474,6 +479,7 @@ void VdfClientSession::ExecuteCommand(Command const& cmd)
         PLOGD << "ready to send iters";
         start_time_ = std::chrono::system_clock::now();
         status_ = Status::READY;
+        ProofTracer::GetInstance().MarkChallenge(challenge_, ProofStage::VDF_CLIENT_READY);
         // start all waiting iters
         ready_handler_(shared_from_this());
     } else if (cmd.type == Command::CommandType::STOP) {
@@ -482,15 +488,12 @@ void VdfClientSession::ExecuteCommand(Command const& cmd)
     } else if (cmd.type == Command::CommandType::PROOF) {
         // Analyze the proof back and invoke the receiver
         PLOGD << "proof is ready";
-        Proof proof;
-        uint64_t iters;
-        std::tie(proof, iters) = ParseProofIters(BytesFromHex(cmd.body));
-        ProofDetail detail;
-        detail.y = proof.y;
-        detail.proof = proof.proof;
-        detail.witness_type = proof.witness_type;
-        detail.iters = iters;
-        detail.duration = GetCurrDuration();
+        auto detail = ParseProof(BytesFromHex(cmd.body), GetCurrDuration());
+        if (detail == nullptr) {
+            PLOGE << "cannot parse the proof from vdf_client";
+            return;
+        }
+        ProofTracer::GetInstance().MarkRequest(challenge_, detail->iters, ProofStage::PROOF_RECEIVED);
         proof_receiver_(challenge_, detail);
     }
 }
@@ -541,8 +544,10 @@ void VdfClientSession::SendStrCmd(std::string const& cmd)
 VdfClientMan::VdfClientMan(asio::io_context& ioc, TimeType type, std::string_view vdf_client_path, std::string_view addr, unsigned short port)
     : proc_man_(std::string(vdf_client_path), std::string(addr), port)
     , ioc_(ioc)
-    , acceptor_(ioc)
+    , strand_(asio::make_strand(ioc))
+    , acceptor_(strand_)
     , time_type_(type)
+    , latency_(Instrumentation::GetInstance().GetHandlerLatency("vdf_client"))
 {
     MakeZero(init_challenge_, 0);
 }
@@ -560,52 +565,72 @@ void VdfClientMan::Run()
     acceptor_.bind(endpoint);
     acceptor_.listen();
     PLOGD << "accept connection to " << proc_man_.GetAddress() << ":" << proc_man_.GetPort();
-    AcceptNext();
+    asio::dispatch(strand_, [this]() {
+        AcceptNext();
+    });
 }
 
 void VdfClientMan::StopByChallenge(uint256 const& challenge)
 {
-    for (auto psession : session_set_) {
-        if (psession->GetChallenge() == challenge) {
-            psession->Stop([this, challenge]() {
-                proc_man_.KillByChallenge(challenge);
-            });
-            break;
+    asio::dispatch(strand_, [this, challenge]() {
+        for (auto psession : session_set_) {
+            if (psession->GetChallenge() == challenge) {
+                psession->Stop([this, challenge]() {
+                    proc_man_.KillByChallenge(challenge);
+                });
+                break;
+            }
         }
-    }
+    });
 }
 
 void VdfClientMan::Exit()
 {
-    // Tell all client to stop
-    PLOGD << "stopping... total " << session_set_.size() << " session(s)";
-    error_code ignored_ec;
-    acceptor_.close(ignored_ec);
-    for (auto psession : session_set_) {
-        psession->Stop();
-    }
-    auto ptimer = std::make_unique<asio::steady_timer>(ioc_);
-    ptimer->expires_after(std::chrono::seconds(SECS_TO_WAIT_STOPPING));
-    ptimer->async_wait([this, ptimer = std::move(ptimer)](error_code const& ec) {
-        proc_man_.KillAll(); // so rude
+    asio::dispatch(strand_, [this]() {
+        // Tell all client to stop
+        PLOGD << "stopping... total " << session_set_.size() << " session(s)";
+        exiting_ = true;
+        error_code ignored_ec;
+        acceptor_.close(ignored_ec);
+        for (auto psession : session_set_) {
+            psession->Stop();
+        }
+        auto ptimer = std::make_unique<asio::steady_timer>(strand_);
+        ptimer->expires_after(std::chrono::seconds(SECS_TO_WAIT_STOPPING));
+        ptimer->async_wait([this, ptimer = std::move(ptimer)](error_code const& ec) {
+            proc_man_.KillAll(); // so rude
+        });
     });
 }
 
 void VdfClientMan::CalcIters(uint256 const& challenge, uint64_t iters)
 {
+    asio::dispatch(strand_, [this, challenge, iters]() {
+        // a new vdf_client is created from here, the discriminant is also created
+        ScopedHandlerTimer timer(latency_, "CalcIters");
+        DoCalcIters(challenge, iters);
+    });
+}
+
+void VdfClientMan::DoCalcIters(uint256 const& challenge, uint64_t iters)
+{
+    if (exiting_) {
+        // no more vdf_client after exiting, the one being created never connects and the retries would keep the loop busy
+        return;
+    }
     PLOGD << "request: " << Uint256ToHex(challenge) << ", iters=" << iters;
     auto exist_detail = QueryExistingProof(challenge, iters);
-    if (exist_detail.has_value()) {
+    if (exist_detail) {
         PLOGI << "the request is already calculated, skip";
         return;
     }
     if (!IsZero(init_challenge_) && challenge != init_challenge_) {
         // there is a running procedure to create a vdf_client, run it later
         PLOGE << "cannot run another vdf_client while there is already one creating, try it later";
-        auto ptimer = std::make_unique<asio::steady_timer>(ioc_);
+        auto ptimer = std::make_unique<asio::steady_timer>(strand_);
         ptimer->expires_after(std::chrono::milliseconds(100));
         ptimer->async_wait([this, challenge, iters, ptimer = std::move(ptimer)](error_code const& ec) {
-            CalcIters(challenge, iters);
+            DoCalcIters(challenge, iters);
         });
         return;
     }
@@ -633,18 +658,19 @@ void VdfClientMan::CalcIters(uint256 const& challenge, uint64_t iters)
     }
 }
 
-std::optional<ProofDetail> VdfClientMan::QueryExistingProof(uint256 const& challenge, uint64_t iters)
+ProofDetailPtr VdfClientMan::QueryExistingProof(uint256 const& challenge, uint64_t iters) const
 {
+    std::lock_guard<std::mutex> lg(saved_proofs_mtx_);
     auto it = saved_proofs_.find(challenge);
     if (it == std::cend(saved_proofs_)) {
-        return {};
+        return nullptr;
     }
-    for (auto const& proof_detail : it->second) {
-        if (proof_detail.iters >= iters) {
-            return proof_detail;
+    for (auto const& detail : it->second) {
+        if (detail->iters >= iters) {
+            return detail;
         }
     }
-    return {};
+    return nullptr;
 }
 
 void VdfClientMan::AcceptNext()
@@ -677,17 +703,15 @@ void VdfClientMan::AcceptNext()
             psession->SetFinishedHandler([this](VdfClientSessionPtr psession) {
                 session_set_.erase(psession);
             });
-            psession->SetProofReceiver([this](uint256 const& challenge, ProofDetail const& detail) {
-                // we need to save the proof to memories as well
-                auto it = saved_proofs_.find(challenge);
-                if (it == std::cend(saved_proofs_)) {
-                    saved_proofs_.insert(std::make_pair(challenge, std::vector<ProofDetail> { detail }));
-                } else {
-                    it->second.push_back(detail);
+            psession->SetProofReceiver([this](uint256 const& challenge, ProofDetailPtr const& detail) {
+                // we need to save the proof to memories as well, only the pointer is saved
+                {
+                    std::lock_guard<std::mutex> lg(saved_proofs_mtx_);
+                    saved_proofs_[challenge].push_back(detail);
                 }
                 // update vdf speed
-                if (detail.duration > 3) {
-                    vdf_speed_ = detail.iters / detail.duration;
+                if (detail->duration > 3) {
+                    vdf_speed_ = detail->iters / detail->duration;
                 }
                 // invoke callback
                 proof_receiver_(challenge, detail);
@@ -4,9 +4,8 @@
 #include <chrono>
 #include <deque>
 #include <functional>
-#include <map>
 #include <memory>
-#include <optional>
+#include <mutex>
 #include <set>
 #include <vector>
 
@@ -16,18 +15,14 @@
 #include "asio_defs.hpp"
 
 #include "common_types.h"
+#include "flat_hash_map.hpp"
+#include "instrumentation.h"
+#include "metrics.h"
+#include "proof_detail.h"
 
 namespace vdf_client
 {
 
-struct ProofDetail {
-    Bytes y;
-    Bytes proof;
-    uint8_t witness_type;
-    uint64_t iters;
-    int duration;
-};
-
 class VdfClientProc
 {
 public:
@@ -60,7 +55,8 @@ private:
     std::string vdf_client_path_;
     std::string addr_;
     unsigned short port_;
-    std::map<uint256, pid_t> pids_;
+    FlatHashMap<uint256, pid_t> pids_;
+    Gauge& procs_gauge_;
 };
 
 class SocketWriter
@@ -107,7 +103,7 @@ class VdfClientSession;
 using VdfClientSessionPtr = std::shared_ptr<VdfClientSession>;
 
 using SessionNotify = std::function<void(VdfClientSessionPtr)>;
-using ProofReceiver = std::function<void(uint256 const&, ProofDetail const&)>;
+using ProofReceiver = std::function<void(uint256 const&, ProofDetailPtr const&)>;
 
 enum class TimeType { S, N, T };
 
@@ -201,6 +197,9 @@ private:
     int answers_count_ { 0 };
 };
 
+/**
+ * Manages the vdf_client processes and sessions on its own strand, the public methods can be called from any thread
+ */
 class VdfClientMan
 {
 public:
@@ -216,24 +215,30 @@ public:
 
     void CalcIters(uint256 const& challenge, uint64_t iters);
 
-    std::optional<ProofDetail> QueryExistingProof(uint256 const& challenge, uint64_t iters);
+    ProofDetailPtr QueryExistingProof(uint256 const& challenge, uint64_t iters) const;
 
 private:
     void AcceptNext();
 
+    void DoCalcIters(uint256 const& challenge, uint64_t iters);
+
     void ShowTheBest(uint256 const& challenge, uint64_t best_iters, uint64_t curr_iters, int answer_count);
 
 private:
     VdfClientProc proc_man_;
     asio::io_context& ioc_;
+    asio::strand<asio::io_context::executor_type> strand_;
     tcp::acceptor acceptor_;
     TimeType time_type_;
+    LatencyHistogram& latency_;
     std::set<VdfClientSessionPtr> session_set_;
     uint256 init_challenge_;
+    bool exiting_ { false };
     ProofReceiver proof_receiver_;
 
-    std::map<uint256, std::set<uint64_t>> waiting_iters_;
-    std::map<uint256, std::vector<ProofDetail>> saved_proofs_;
+    FlatHashMap<uint256, std::set<uint64_t>> waiting_iters_;
+    mutable std::mutex saved_proofs_mtx_;
+    FlatHashMap<uint256, std::vector<ProofDetailPtr>> saved_proofs_;
 
     uint64_t vdf_speed_ { 100000 };
 };
@@ -1,32 +1,84 @@
 #ifndef VDF_PROOF_SUBMITTER
 #define VDF_PROOF_SUBMITTER
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <vector>
+
 #include <plog/Log.h>
 #include <tinyformat.h>
 
 #include "timelord_utils.h"
 #include "common_types.h"
-#include "rpc_client.h"
+#include "proof_detail.h"
+#include "proof_tracer.h"
+#include "async_rpc_client.h"
+#include "rpc_metrics.hpp"
 
+/**
+ * Submits the proofs to every healthy node in parallel, a proof is submitted when any of the nodes accepts it
+ */
 class VDFProofSubmitter
 {
 public:
-    explicit VDFProofSubmitter(RPCClient& rpc)
-        : rpc_(rpc)
+    explicit VDFProofSubmitter(std::vector<AsyncRPCClient*> rpcs)
+        : rpcs_(std::move(rpcs))
+        , rpc_latency_(GetRPCLatency("submitvdfproof"))
+        , num_submitted_(MetricsRegistry::GetInstance().GetCounter("timelord_proofs_submitted_total", "The number of the proofs submitted to RPC server", MakeMetricLabel("result", "ok")))
+        , num_failed_(MetricsRegistry::GetInstance().GetCounter("timelord_proofs_submitted_total", "The number of the proofs submitted to RPC server", MakeMetricLabel("result", "error")))
     {
     }
 
-    void operator()(uint256 const& challenge, Bytes const& y, Bytes const& proof, int witness_type, uint64_t iters, int duration)
+    /**
+     * The proof is submitted asynchronously, the results are logged from the strands of the RPC clients
+     */
+    void operator()(uint256 const& challenge, vdf_client::ProofDetailPtr const& detail)
     {
-        try {
-            rpc_.Call("submitvdfproof", Uint256ToHex(challenge), BytesToHex(y), BytesToHex(proof), witness_type, iters, duration);
-        } catch (std::exception const& e) {
-            PLOGE << tinyformat::format("%s: cannot submit vdf proof to RPC server, %s", __func__, e.what());
+        std::vector<AsyncRPCClient*> healthy_rpcs;
+        std::copy_if(std::cbegin(rpcs_), std::cend(rpcs_), std::back_inserter(healthy_rpcs), [](AsyncRPCClient* prpc) {
+            return prpc->GetBreakerState() != AsyncRPCClient::BreakerState::OPEN;
+        });
+        if (healthy_rpcs.empty()) {
+            // none of the nodes is healthy, the breakers decide whether the calls are made
+            healthy_rpcs = rpcs_;
+        }
+        auto pstate = std::make_shared<SubmitState>();
+        pstate->num_pending = static_cast<int>(healthy_rpcs.size());
+        auto challenge_hex = Uint256ToHex(challenge);
+        auto y_hex = FormToHex(detail->y);
+        auto proof_hex = BytesToHex(detail->proof);
+        for (auto prpc : healthy_rpcs) {
+            AsyncCallRPC(*prpc, rpc_latency_, "submitvdfproof", [&num_submitted = num_submitted_, &num_failed = num_failed_, pstate, prpc, challenge, iters = detail->iters](std::exception_ptr perr, UniValue const&) {
+                try {
+                    if (perr) {
+                        std::rethrow_exception(perr);
+                    }
+                    if (!pstate->submitted.exchange(true)) {
+                        num_submitted.Inc();
+                        ProofTracer::GetInstance().MarkRequest(challenge, iters, ProofStage::PROOF_SUBMITTED);
+                    }
+                } catch (std::exception const& e) {
+                    PLOGE << tinyformat::format("VDFProofSubmitter: cannot submit vdf proof to %s, %s", prpc->GetUrl(), e.what());
+                }
+                if (--pstate->num_pending == 0 && !pstate->submitted) {
+                    num_failed.Inc();
+                }
+            }, challenge_hex, y_hex, proof_hex, static_cast<int>(detail->witness_type), detail->iters, detail->duration);
         }
     }
 
 private:
-    RPCClient& rpc_;
+    struct SubmitState {
+        std::atomic_int num_pending { 0 };
+        std::atomic_bool submitted { false };
+    };
+
+    std::vector<AsyncRPCClient*> rpcs_;
+    LatencyHistogram& rpc_latency_;
+    Counter& num_submitted_;
+    Counter& num_failed_;
 };
 
 #endif
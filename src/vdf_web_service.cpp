@@ -2,12 +2,17 @@
 
 #include <json/json.h>
 
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <mutex>
 using std::placeholders::_1;
+using std::placeholders::_2;
 
 #include <boost/url.hpp>
 namespace urls = boost::urls;
 
+#include "metrics.h"
 #include "timelord_utils.h"
 
 #include "ip_addr_querier.hpp"
@@ -32,6 +37,58 @@ Json::Value MakeRequestJson(VDFRequest const& request)
     return res;
 }
 
+Json::Value MakeLatencyJson(LatencySnapshot const& snapshot)
+{
+    Json::Value res;
+    res["name"] = snapshot.name;
+    res["count"] = snapshot.count;
+    res["avg_usecs"] = static_cast<Json::Int64>(snapshot.count > 0 ? snapshot.sum_usecs / static_cast<int64_t>(snapshot.count) : 0);
+    res["max_usecs"] = snapshot.max_usecs;
+    res["p50_usecs"] = snapshot.p50_usecs;
+    res["p90_usecs"] = snapshot.p90_usecs;
+    res["p99_usecs"] = snapshot.p99_usecs;
+    Json::Value buckets_json(Json::arrayValue);
+    for (std::size_t i = 0; i < snapshot.bucket_counts.size(); ++i) {
+        Json::Value bucket_json;
+        bucket_json["le_usecs"] = snapshot.bucket_bounds[i];
+        bucket_json["count"] = snapshot.bucket_counts[i];
+        buckets_json.append(std::move(bucket_json));
+    }
+    res["buckets"] = buckets_json;
+    return res;
+}
+
+Json::Value MakeStageTimesJson(ProofStageTimes const& stages)
+{
+    Json::Value res(Json::arrayValue);
+    for (auto const& [stage, usecs] : stages) {
+        Json::Value stage_json;
+        stage_json["stage"] = ProofStageToString(stage);
+        stage_json["usecs"] = static_cast<Json::Int64>(usecs);
+        res.append(std::move(stage_json));
+    }
+    return res;
+}
+
+Json::Value MakeChallengeTraceJson(ChallengeTrace const& trace)
+{
+    Json::Value res;
+    res["challenge"] = Uint256ToHex(trace.challenge);
+    res["created_at"] = static_cast<Json::Int64>(trace.created_at);
+    res["stages"] = MakeStageTimesJson(trace.stages);
+    Json::Value requests_json(Json::arrayValue);
+    for (auto const& request : trace.requests) {
+        Json::Value request_json;
+        request_json["iters"] = request.iters;
+        request_json["stages"] = MakeStageTimesJson(request.stages);
+        request_json["num_written"] = static_cast<Json::UInt64>(request.num_written);
+        request_json["last_written_usecs"] = static_cast<Json::Int64>(request.last_written);
+        requests_json.append(std::move(request_json));
+    }
+    res["requests"] = requests_json;
+    return res;
+}
+
 Json::Value MakePackJson(VDFRecordPack const& pack)
 {
     Json::Value res;
@@ -46,6 +103,19 @@ Json::Value MakePackJson(VDFRecordPack const& pack)
     return res;
 }
 
+/**
+ * The results of the queries of the status, the last query which finishes makes the response
+ */
+struct StatusQueryResults {
+    std::atomic_int num_pending { 4 };
+    TimelordStatus status;
+    uint64_t estimated_netspace { 0 };
+    Supply supply {};
+    PledgeInfo pledge_info {};
+    std::mutex err_mtx;
+    std::string err;
+};
+
 std::tuple<std::string, bool> ParseUrlParameter(std::string_view target, std::string_view name)
 {
     auto req_path = urls::parse_origin_form(target);
@@ -56,8 +126,9 @@ std::tuple<std::string, bool> ParseUrlParameter(std::string_view target, std::st
     return std::make_tuple((*it).value, true);
 }
 
-VDFWebService::VDFWebService(asio::io_context& ioc, std::string_view addr, uint16_t port, int expired_after_secs, std::string api_path_prefix, int fork_height, NumHeightsByHoursQuerierType num_heights_by_hours_querier, BlockInfoRangeQuerierType block_info_range_querier, NetspaceQuerierType netspace_querier, TimelordStatusQuerierType status_querier, RankQuerierType rank_querier, SupplyQuerierType supply_querier, PledgeInfoQuerierType pledge_info_querier, RecentlyNetspaceSizeQuerierType recently_netspace_querier)
-    : web_service_(ioc, tcp::endpoint(asio::ip::address::from_string(std::string(addr)), port), expired_after_secs, std::bind(&VDFWebService::HandleRequest, this, _1))
+VDFWebService::VDFWebService(asio::io_context& ioc, std::string_view addr, uint16_t port, int expired_after_secs, std::string api_path_prefix, int fork_height, NumHeightsByHoursQuerierType num_heights_by_hours_querier, BlockInfoRangeQuerierType block_info_range_querier, NetspaceQuerierType netspace_querier, TimelordStatusQuerierType status_querier, RankQuerierType rank_querier, SupplyQuerierType supply_querier, PledgeInfoQuerierType pledge_info_querier, RecentlyNetspaceSizeQuerierType recently_netspace_querier, RPCPrefetcherType rpc_prefetcher, EventQueueStatsQuerierType event_queue_stats_querier, LatencyStatsQuerierType latency_stats_querier, MetricsQuerierType metrics_querier, ProofTraceQuerierType proof_trace_querier)
+    : web_service_(ioc, tcp::endpoint(asio::ip::address::from_string(std::string(addr)), port), expired_after_secs, std::bind(&VDFWebService::HandleRequest, this, _1, _2))
+    , latency_(Instrumentation::GetInstance().GetHandlerLatency("web"))
     , fork_height_(fork_height)
     , num_heights_by_hours_querier_(std::move(num_heights_by_hours_querier))
     , block_info_range_querier_(std::move(block_info_range_querier))
@@ -67,11 +138,20 @@ VDFWebService::VDFWebService(asio::io_context& ioc, std::string_view addr, uint1
     , supply_querier_(std::move(supply_querier))
     , pledge_info_querier_(std::move(pledge_info_querier))
     , recently_netspace_querier_(std::move(recently_netspace_querier))
+    , rpc_prefetcher_(std::move(rpc_prefetcher))
+    , event_queue_stats_querier_(std::move(event_queue_stats_querier))
+    , latency_stats_querier_(std::move(latency_stats_querier))
+    , metrics_querier_(std::move(metrics_querier))
+    , proof_trace_querier_(std::move(proof_trace_querier))
 {
-    web_req_handler_.Register(std::make_pair(http::verb::get, api_path_prefix + "/api/summary"), std::bind(&VDFWebService::Handle_API_Summary, this, _1));
-    web_req_handler_.Register(std::make_pair(http::verb::get, api_path_prefix + "/api/status"), std::bind(&VDFWebService::Handle_API_Status, this, _1));
-    web_req_handler_.Register(std::make_pair(http::verb::get, api_path_prefix + "/api/netspace"), std::bind(&VDFWebService::Handle_API_Netspace, this, _1));
-    web_req_handler_.Register(std::make_pair(http::verb::get, api_path_prefix + "/api/rank"), std::bind(&VDFWebService::Handle_API_Rank, this, _1));
+    RegisterAPI(api_path_prefix + "/api/summary", std::bind(&VDFWebService::Handle_API_Summary, this, _1));
+    RegisterAsyncAPI(api_path_prefix + "/api/status", std::bind(&VDFWebService::Handle_API_Status, this, _1, _2));
+    RegisterAPI(api_path_prefix + "/api/netspace", std::bind(&VDFWebService::Handle_API_Netspace, this, _1));
+    RegisterAPI(api_path_prefix + "/api/rank", std::bind(&VDFWebService::Handle_API_Rank, this, _1));
+    RegisterAPI(api_path_prefix + "/api/eventbus", std::bind(&VDFWebService::Handle_API_EventBus, this, _1));
+    RegisterAPI(api_path_prefix + "/api/latency", std::bind(&VDFWebService::Handle_API_Latency, this, _1));
+    RegisterAPI(api_path_prefix + "/api/traces", std::bind(&VDFWebService::Handle_API_Traces, this, _1));
+    RegisterAPI(api_path_prefix + "/metrics", std::bind(&VDFWebService::Handle_Metrics, this, _1));
 }
 
 void VDFWebService::Run()
@@ -84,14 +164,79 @@ void VDFWebService::Stop()
     return web_service_.Stop();
 }
 
-http::message_generator VDFWebService::HandleRequest(http::request<http::string_body> const& request)
+void VDFWebService::RegisterAPI(std::string const& path, RequestHandler handler)
+{
+    RegisterAsyncAPI(path, [handler = std::move(handler)](http::request<http::string_body> const& request, ResponseSender send) {
+        send(handler(request));
+    });
+}
+
+void VDFWebService::RegisterAsyncAPI(std::string const& path, AsyncRequestHandler handler)
 {
-    return web_req_handler_.Handle(request);
+    auto& latency = MetricsRegistry::GetInstance().GetHistogram("timelord_web_request_duration_seconds", "The duration of the web requests", MakeMetricLabel("endpoint", path));
+    web_req_handler_.Register(std::make_pair(http::verb::get, path), [&latency, handler = std::move(handler)](http::request<http::string_body> const& request, ResponseSender send) {
+        handler(request, [&latency, start = std::chrono::steady_clock::now(), send = std::move(send)](http::message_generator generator) {
+            latency.Record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+            send(std::move(generator));
+        });
+    });
+}
+
+void VDFWebService::HandleRequest(http::request<http::string_body> const& request, ResponseSender send)
+{
+    std::string target(request.target());
+    ScopedHandlerTimer timer(latency_, target);
+    web_req_handler_.Handle(request, std::move(send));
+}
+
+void VDFWebService::Handle_API_Status(http::request<http::string_body> const& request, ResponseSender send)
+{
+    rpc_prefetcher_();
+    auto presults = std::make_shared<StatusQueryResults>();
+    // the queries finish on the loop of the RPC client, the response is made on the strand of the web service
+    auto finish = [this, presults, version = request.version(), keep_alive = request.keep_alive(), send = std::move(send)](std::exception_ptr perr) {
+        try {
+            if (perr) {
+                std::rethrow_exception(perr);
+            }
+        } catch (std::exception const& e) {
+            std::lock_guard<std::mutex> lg(presults->err_mtx);
+            if (presults->err.empty()) {
+                presults->err = e.what();
+            }
+        }
+        if (--presults->num_pending > 0) {
+            return;
+        }
+        asio::post(web_service_.GetStrand(), [this, presults, version, keep_alive, send]() {
+            if (!presults->err.empty()) {
+                PLOGE << tinyformat::format("http request(status): %s", presults->err);
+                return send(PrepareResponseWithInternalError(presults->err, version, keep_alive));
+            }
+            send(MakeStatusResponse(*presults, version, keep_alive));
+        });
+    };
+    status_querier_([presults, finish](std::exception_ptr perr, TimelordStatus const& status) {
+        presults->status = status;
+        finish(perr);
+    });
+    recently_netspace_querier_([presults, finish](std::exception_ptr perr, uint64_t estimated_netspace) {
+        presults->estimated_netspace = estimated_netspace;
+        finish(perr);
+    });
+    supply_querier_([presults, finish](std::exception_ptr perr, Supply const& supply) {
+        presults->supply = supply;
+        finish(perr);
+    });
+    pledge_info_querier_([presults, finish](std::exception_ptr perr, PledgeInfo const& pledge_info) {
+        presults->pledge_info = pledge_info;
+        finish(perr);
+    });
 }
 
-http::message_generator VDFWebService::Handle_API_Status(http::request<http::string_body> const& request)
+http::message_generator VDFWebService::MakeStatusResponse(StatusQueryResults const& results, unsigned int version, bool keep_alive) const
 {
-    auto status = status_querier_();
+    auto const& status = results.status;
 
     Json::Value status_value;
     status_value["server_ip"] = status.hostip;
@@ -103,8 +248,9 @@ http::message_generator VDFWebService::Handle_API_Status(http::request<http::str
     status_value["total_size"] = status.total_size;
     status_value["max_size"] = status.max_size;
     status_value["num_connections"] = status.num_connections;
+    status_value["num_requests"] = static_cast<Json::UInt64>(status.num_requests);
     status_value["status_string"] = status.status_string;
-    status_value["estimated_netspace"] = recently_netspace_querier_();
+    status_value["estimated_netspace"] = results.estimated_netspace;
 
     Json::Value last_blk_info_value;
     last_blk_info_value["hash"] = Uint256ToHex(status.last_block_info.hash);
@@ -125,7 +271,7 @@ http::message_generator VDFWebService::Handle_API_Status(http::request<http::str
 
     status_value["vdf_pack"] = MakePackJson(status.vdf_pack);
 
-    Supply supply = supply_querier_();
+    auto const& supply = results.supply;
 
     Json::Value supply_json;
     supply_json["dist_height"] = supply.dist_height;
@@ -145,7 +291,7 @@ http::message_generator VDFWebService::Handle_API_Status(http::request<http::str
     supply_json["last"] = last_json;
     status_value["supply"] = supply_json;
 
-    PledgeInfo pledge_info = pledge_info_querier_();
+    auto const& pledge_info = results.pledge_info;
     Json::Value pledge_info_json;
     pledge_info_json["retarget_min_heights"] = pledge_info.retarget_min_heights;
     pledge_info_json["capacity_eval_window"] = pledge_info.capacity_eval_window;
@@ -161,7 +307,7 @@ http::message_generator VDFWebService::Handle_API_Status(http::request<http::str
     status_value["pledge_info"] = pledge_info_json;
 
     // prepare body
-    return PrepareResponseWithContent(http::status::ok, status_value, request.version(), request.keep_alive());
+    return PrepareResponseWithContent(http::status::ok, status_value, version, keep_alive);
 }
 
 http::message_generator VDFWebService::Handle_API_Summary(http::request<http::string_body> const& request)
@@ -313,3 +459,62 @@ http::message_generator VDFWebService::Handle_API_Rank(http::request<http::strin
 
     return PrepareResponseWithContent(http::status::ok, res_json, request.version(), request.keep_alive());
 }
+
+http::message_generator VDFWebService::Handle_API_EventBus(http::request<http::string_body> const& request)
+{
+    Json::Value res_json(Json::arrayValue);
+    for (auto const& stats : event_queue_stats_querier_()) {
+        Json::Value stats_json;
+        stats_json["subscriber"] = stats.subscriber;
+        stats_json["event"] = stats.event;
+        stats_json["depth"] = static_cast<Json::UInt64>(stats.depth);
+        stats_json["capacity"] = static_cast<Json::UInt64>(stats.capacity);
+        stats_json["overflow_depth"] = static_cast<Json::UInt64>(stats.overflow_depth);
+        stats_json["num_delivered"] = stats.num_delivered;
+        stats_json["num_drops"] = stats.num_drops;
+        stats_json["num_overflows"] = stats.num_overflows;
+        stats_json["last_lag_usecs"] = stats.last_lag_usecs;
+        stats_json["max_lag_usecs"] = stats.max_lag_usecs;
+        res_json.append(std::move(stats_json));
+    }
+    return PrepareResponseWithContent(http::status::ok, res_json, request.version(), request.keep_alive());
+}
+
+http::message_generator VDFWebService::Handle_API_Latency(http::request<http::string_body> const& request)
+{
+    auto stats = latency_stats_querier_();
+    Json::Value handlers_json(Json::arrayValue);
+    for (auto const& snapshot : stats.handlers) {
+        handlers_json.append(MakeLatencyJson(snapshot));
+    }
+    Json::Value loop_lags_json(Json::arrayValue);
+    for (auto const& snapshot : stats.loop_lags) {
+        loop_lags_json.append(MakeLatencyJson(snapshot));
+    }
+    Json::Value res_json;
+    res_json["handlers"] = handlers_json;
+    res_json["loop_lags"] = loop_lags_json;
+    return PrepareResponseWithContent(http::status::ok, res_json, request.version(), request.keep_alive());
+}
+
+http::message_generator VDFWebService::Handle_API_Traces(http::request<http::string_body> const& request)
+{
+    auto stats = proof_trace_querier_();
+    Json::Value stages_json(Json::arrayValue);
+    for (auto const& snapshot : stats.stages) {
+        stages_json.append(MakeLatencyJson(snapshot));
+    }
+    Json::Value recent_json(Json::arrayValue);
+    for (auto const& trace : stats.recent) {
+        recent_json.append(MakeChallengeTraceJson(trace));
+    }
+    Json::Value res_json;
+    res_json["stages"] = stages_json;
+    res_json["recent"] = recent_json;
+    return PrepareResponseWithContent(http::status::ok, res_json, request.version(), request.keep_alive());
+}
+
+http::message_generator VDFWebService::Handle_Metrics(http::request<http::string_body> const& request)
+{
+    return PrepareResponseWithText(http::status::ok, metrics_querier_(), "text/plain; version=0.0.4", request.version(), request.keep_alive());
+}
@@ -7,24 +7,43 @@
 
 #include "block_info.h"
 
+#include "instrumentation.h"
 #include "querier_defs.h"
 
 #include "web_req_handler.h"
 #include "web_service.hpp"
 
+struct StatusQueryResults;
+
 class VDFWebService
 {
 public:
-    VDFWebService(asio::io_context& ioc, std::string_view addr, uint16_t port, int expired_after_secs, std::string api_path_prefix, int fork_height, NumHeightsByHoursQuerierType num_heights_by_hours_querier, BlockInfoRangeQuerierType block_info_range_querier, NetspaceQuerierType netspace_querier, TimelordStatusQuerierType status_querier, RankQuerierType rank_querier, SupplyQuerierType supply_querier, PledgeInfoQuerierType pledge_info_querier, RecentlyNetspaceSizeQuerierType recently_netspace_querier);
+    VDFWebService(asio::io_context& ioc, std::string_view addr, uint16_t port, int expired_after_secs, std::string api_path_prefix, int fork_height, NumHeightsByHoursQuerierType num_heights_by_hours_querier, BlockInfoRangeQuerierType block_info_range_querier, NetspaceQuerierType netspace_querier, TimelordStatusQuerierType status_querier, RankQuerierType rank_querier, SupplyQuerierType supply_querier, PledgeInfoQuerierType pledge_info_querier, RecentlyNetspaceSizeQuerierType recently_netspace_querier, RPCPrefetcherType rpc_prefetcher, EventQueueStatsQuerierType event_queue_stats_querier, LatencyStatsQuerierType latency_stats_querier, MetricsQuerierType metrics_querier, ProofTraceQuerierType proof_trace_querier);
 
     void Run();
 
     void Stop();
 
 private:
-    http::message_generator HandleRequest(http::request<http::string_body> const& request);
+    /**
+     * Register the handler of the path, the duration of the requests to the path is recorded by its own histogram
+     */
+    void RegisterAPI(std::string const& path, RequestHandler handler);
+
+    /**
+     * Register the handler which sends the response later, the duration lasts until the response is sent
+     */
+    void RegisterAsyncAPI(std::string const& path, AsyncRequestHandler handler);
+
+    void HandleRequest(http::request<http::string_body> const& request, ResponseSender send);
+
+    /**
+     * The RPC queries of the status are started together, the response is made on the strand of the web service when the
+     * last one is received
+     */
+    void Handle_API_Status(http::request<http::string_body> const& request, ResponseSender send);
 
-    http::message_generator Handle_API_Status(http::request<http::string_body> const& request);
+    http::message_generator MakeStatusResponse(StatusQueryResults const& results, unsigned int version, bool keep_alive) const;
 
     http::message_generator Handle_API_Summary(http::request<http::string_body> const& request);
 
@@ -32,8 +51,17 @@ private:
 
     http::message_generator Handle_API_Rank(http::request<http::string_body> const& request);
 
+    http::message_generator Handle_API_EventBus(http::request<http::string_body> const& request);
+
+    http::message_generator Handle_API_Latency(http::request<http::string_body> const& request);
+
+    http::message_generator Handle_API_Traces(http::request<http::string_body> const& request);
+
+    http::message_generator Handle_Metrics(http::request<http::string_body> const& request);
+
     WebService web_service_;
     WebReqHandler web_req_handler_;
+    LatencyHistogram& latency_;
     int fork_height_;
     NumHeightsByHoursQuerierType num_heights_by_hours_querier_;
     BlockInfoRangeQuerierType block_info_range_querier_;
@@ -43,6 +71,11 @@ private:
     SupplyQuerierType supply_querier_;
     PledgeInfoQuerierType pledge_info_querier_;
     RecentlyNetspaceSizeQuerierType recently_netspace_querier_;
+    RPCPrefetcherType rpc_prefetcher_;
+    EventQueueStatsQuerierType event_queue_stats_querier_;
+    LatencyStatsQuerierType latency_stats_querier_;
+    MetricsQuerierType metrics_querier_;
+    ProofTraceQuerierType proof_trace_querier_;
 };
 
 #endif
@@ -55,6 +55,14 @@ http::response<http::string_body> PrepareResponseWithError(http::status status,
     return response;
 }
 
+http::response<http::string_body> PrepareResponseWithInternalError(std::string_view error, unsigned int version, bool keep_alive)
+{
+    auto response = PrepareResponse(http::status::internal_server_error, version, keep_alive);
+    response.body() = BodyInternalServerError(error);
+    response.prepare_payload();
+    return response;
+}
+
 http::response<http::string_body> PrepareResponseWithContent(http::status status, Json::Value const& json, unsigned int version, bool keep_alive)
 {
     http::response<http::string_body> response(status, version);
@@ -65,17 +73,28 @@ http::response<http::string_body> PrepareResponseWithContent(http::status status
     return response;
 }
 
+http::response<http::string_body> PrepareResponseWithText(http::status status, std::string body, std::string_view content_type, unsigned int version, bool keep_alive)
+{
+    http::response<http::string_body> response(status, version);
+    PrepareResponseHeaders(response);
+    response.set(http::field::content_type, content_type);
+    response.keep_alive(keep_alive);
+    response.body() = std::move(body);
+    response.prepare_payload();
+    return response;
+}
+
 bool ValidTarget(std::string_view target)
 {
     return !target.empty() && target[0] == '/' && target.find("..") == std::string_view::npos;
 }
 
-void WebReqHandler::Register(RequestTarget req_target, RequestHandler&& handler)
+void WebReqHandler::Register(RequestTarget req_target, AsyncRequestHandler&& handler)
 {
     handlers_.insert_or_assign(req_target, std::move(handler));
 }
 
-http::message_generator WebReqHandler::Handle(http::request<http::string_body> const& request) const
+void WebReqHandler::Handle(http::request<http::string_body> const& request, ResponseSender send) const
 {
     if (!ValidTarget(request.target())) {
         auto response = PrepareResponse(http::status::bad_request, request.version(), request.keep_alive());
@@ -83,7 +102,7 @@ http::message_generator WebReqHandler::Handle(http::request<http::string_body> c
             response.body() = BodyBadRequest();
             response.prepare_payload();
         }
-        return response;
+        return send(std::move(response));
     }
 
     auto path_result = urls::parse_origin_form(request.target());
@@ -96,16 +115,13 @@ http::message_generator WebReqHandler::Handle(http::request<http::string_body> c
             response.body() = BodyInvalidMethod();
             response.prepare_payload();
         }
-        return response;
+        return send(std::move(response));
     }
 
     try {
-        return it->second(request);
+        it->second(request, send);
     } catch (std::exception const& e) {
         PLOGE << tinyformat::format("http request(%s): %s", req_path, e.what());
-        auto response = PrepareResponse(http::status::internal_server_error, request.version(), request.keep_alive());
-        response.body() = BodyInternalServerError(e.what());
-        response.prepare_payload();
-        return response;
+        send(PrepareResponseWithInternalError(e.what(), request.version(), request.keep_alive()));
     }
 }
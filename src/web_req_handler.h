@@ -7,18 +7,25 @@
 
 struct WebReqHandler {
 public:
-    void Register(RequestTarget req_target, RequestHandler&& handler);
+    void Register(RequestTarget req_target, AsyncRequestHandler&& handler);
 
-    http::message_generator Handle(http::request<http::string_body> const& request) const;
+    /**
+     * Find the handler of the request, the response is sent by `send` when the handler finishes or it throws
+     */
+    void Handle(http::request<http::string_body> const& request, ResponseSender send) const;
 
 private:
-    std::map<RequestTarget, RequestHandler> handlers_;
+    std::map<RequestTarget, AsyncRequestHandler> handlers_;
 };
 
 http::response<http::string_body> PrepareResponse(http::status status, unsigned int version, bool keep_alive);
 
 http::response<http::string_body> PrepareResponseWithError(http::status status, std::string_view error, unsigned int version, bool keep_alive);
 
+http::response<http::string_body> PrepareResponseWithInternalError(std::string_view error, unsigned int version, bool keep_alive);
+
+http::response<http::string_body> PrepareResponseWithText(http::status status, std::string body, std::string_view content_type, unsigned int version, bool keep_alive);
+
 namespace Json {
 
 class Value;
@@ -16,10 +16,20 @@ using boost::system::error_code;
 
 using RequestHandler = std::function<http::message_generator(http::request<http::string_body> const&)>;
 
+/**
+ * Sends the response of the request, it can be invoked from any thread, the response is written on the strand of the session
+ */
+using ResponseSender = std::function<void(http::message_generator)>;
+
+/**
+ * The handler finishes the request by invoking the sender once, the request is alive until the response is sent
+ */
+using AsyncRequestHandler = std::function<void(http::request<http::string_body> const&, ResponseSender)>;
+
 class WebSession : public std::enable_shared_from_this<WebSession>
 {
 public:
-    WebSession(tcp::socket&& socket, int expired_after_secs, RequestHandler handler)
+    WebSession(tcp::socket&& socket, int expired_after_secs, AsyncRequestHandler handler)
         : stream_(std::move(socket))
         , expired_after_secs_(expired_after_secs)
         , handler_(std::move(handler))
@@ -65,9 +75,12 @@ private:
                 return self->Close();
             }
             PLOGI << tinyformat::format("request: (%s) %s", self->request_.method_string(), self->request_.target());
-            auto start_time = std::chrono::steady_clock::now();
-            self->SendResponse(self->handler_(self->request_));
-            PLOGI << tinyformat::format("%d msecs -> (%s) %s", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count(), self->request_.method_string(), self->request_.target());
+            self->handler_(self->request_, [self, start_time = std::chrono::steady_clock::now()](http::message_generator generator) {
+                asio::dispatch(self->stream_.get_executor(), [self, start_time, generator = std::move(generator)]() mutable {
+                    PLOGI << tinyformat::format("%d msecs -> (%s) %s", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count(), self->request_.method_string(), self->request_.target());
+                    self->SendResponse(std::move(generator));
+                });
+            });
         });
     }
 
@@ -75,15 +88,20 @@ private:
     int expired_after_secs_;
     beast::flat_buffer buffer_;
     http::request<http::string_body> request_;
-    RequestHandler handler_;
+    AsyncRequestHandler handler_;
 };
 
+/**
+ * The sessions are accepted on the strand of the service, so the requests are handled one by one, the handlers which wait
+ * on the others return at once and send their responses later, the strand is never blocked by them
+ */
 class WebService
 {
 public:
-    WebService(asio::io_context& ioc, tcp::endpoint const& endpoint, int expired_after_secs, RequestHandler handler)
+    WebService(asio::io_context& ioc, tcp::endpoint const& endpoint, int expired_after_secs, AsyncRequestHandler handler)
         : ioc_(ioc)
-        , acceptor_(ioc)
+        , strand_(asio::make_strand(ioc))
+        , acceptor_(strand_)
         , expired_after_secs_(expired_after_secs)
         , handler_(std::move(handler))
     {
@@ -95,13 +113,25 @@ public:
 
     void Run()
     {
-        AcceptNext();
+        asio::dispatch(strand_, [this]() {
+            AcceptNext();
+        });
     }
 
     void Stop()
     {
-        error_code ignored_ec;
-        acceptor_.cancel(ignored_ec);
+        asio::dispatch(strand_, [this]() {
+            error_code ignored_ec;
+            acceptor_.cancel(ignored_ec);
+        });
+    }
+
+    /**
+     * @return The strand which the sessions are running on
+     */
+    asio::strand<asio::io_context::executor_type> const& GetStrand() const
+    {
+        return strand_;
     }
 
 private:
@@ -118,9 +148,10 @@ private:
     }
 
     asio::io_context& ioc_;
+    asio::strand<asio::io_context::executor_type> strand_;
     tcp::acceptor acceptor_;
     int expired_after_secs_;
-    RequestHandler handler_;
+    AsyncRequestHandler handler_;
 };
 
 using RequestTarget = std::pair<http::verb, std::string>;